@@ -13,12 +13,24 @@
 #include <DisplayWindow.h>
 #include <algorithm>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RDRAM_TO_CB_NEON
+#endif
+
 using namespace graphics;
 
 RDRAMtoColorBuffer::RDRAMtoColorBuffer()
 	: m_pCurBuffer(nullptr)
 	, m_pTexture(nullptr)
-	, m_pbuf(nullptr) {
+	, m_pbuf(nullptr)
+	, m_dirtyAddress(0)
+	, m_dirtyWidth(0)
+	, m_dirtyMaxRow(0)
+	, m_dirty(false)
+	, m_dirtyOutside(false) {
 }
 
 RDRAMtoColorBuffer & RDRAMtoColorBuffer::get()
@@ -65,7 +77,13 @@ void RDRAMtoColorBuffer::init()
 	setParams.magFilter = textureParameters::FILTER_LINEAR;
 	gfxContext.setTextureParameters(setParams);
 
-	m_pbuf = (u8*)malloc(m_pTexture->textureBytes);
+	const u32 numPixels = m_pTexture->width * m_pTexture->height;
+	const u32 pixelBytes = fbTexFormats.colorType == datatype::FLOAT ? 16 : 4;
+	m_pbuf = (u8*)malloc(numPixels * pixelBytes);
+	m_pWriteBuffer.reset(gfxContext.createPixelWriteBuffer(numPixels * pixelBytes));
+
+	m_dirtyPixels.assign((numPixels + 31) / 32, 0);
+	m_dirtyBands.clear();
 }
 
 void RDRAMtoColorBuffer::destroy()
@@ -76,6 +94,9 @@ void RDRAMtoColorBuffer::destroy()
 	}
 	free(m_pbuf);
 	m_pbuf = nullptr;
+	m_pWriteBuffer.reset();
+	m_dirtyPixels.clear();
+	m_dirtyBands.clear();
 }
 
 void RDRAMtoColorBuffer::addAddress(u32 _address, u32 _size)
@@ -89,63 +110,34 @@ void RDRAMtoColorBuffer::addAddress(u32 _address, u32 _size)
 	const u32 pixelSize = 1 << m_pCurBuffer->m_size >> 1;
 	if (_size != pixelSize && (_address%pixelSize) > 0)
 		return;
-	m_vecAddress.push_back(_address);
+	if (!m_dirty) {
+		m_dirtyAddress = m_pCurBuffer->m_startAddress;
+		m_dirtyWidth = m_pCurBuffer->m_width;
+		m_dirty = true;
+	}
 	gDP.colorImage.changed = TRUE;
-}
 
-// Write the whole buffer
-template <typename TSrc>
-bool _copyBufferFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _x0, u32 _y0, u32 _width, u32 _height, bool _fullAlpha)
-{
-	if ((_address & 1) != 0)
-		return false;
-	TSrc * src = reinterpret_cast<TSrc*>(RDRAM + _address);
-	const u32 bound = (RDRAMSize + 1 - _address) >> (sizeof(TSrc) / 2);
-	TSrc col;
-	u32 idx;
-	u32 summ = 0;
-	u32 dsty = 0;
-	const u32 y1 = _y0 + _height;
-	for (u32 y = _y0; y < y1; ++y) {
-		for (u32 x = _x0; x < _width; ++x) {
-			idx = (x + y *_width) ^ _xor;
-			if (idx >= bound)
-				break;
-			col = src[idx];
-			summ += col;
-			_dst[x + dsty*_width] = converter(col, _fullAlpha);
-		}
-		++dsty;
+	if (_address < m_dirtyAddress) {
+		m_dirtyOutside = true;
+		return;
 	}
 
-	return summ != 0;
-}
-
-// Write only pixels provided with FBWrite
-template <typename TSrc>
-bool _copyPixelsFromRdram(u32 _address, const std::vector<u32> & _vecAddress, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _width, u32 _height, bool _fullAlpha)
-{
-	memset(_dst, 0, _width*_height*sizeof(u32));
-	TSrc * src = reinterpret_cast<TSrc*>(RDRAM + _address);
-	const u32 szPixel = sizeof(TSrc);
-	const size_t numPixels = _vecAddress.size();
-	TSrc col;
-	u32 summ = 0;
-	u32 idx, w, h;
-	for (size_t i = 0; i < numPixels; ++i) {
-		if (_vecAddress[i] < _address)
-			return false;
-		idx = (_vecAddress[i] - _address) / szPixel;
-		w = idx % _width;
-		h = idx / _width;
-		if (h > _height)
-			return false;
-		col = src[idx];
-		summ += col;
-		_dst[(w + h * _width) ^ _xor] = converter(col, _fullAlpha);
-	}
+	const u32 width = m_dirtyWidth;
+	const u32 idx = (_address - m_dirtyAddress) / pixelSize;
+	m_dirtyMaxRow = std::max(m_dirtyMaxRow, idx / width);
 
-	return summ != 0;
+	// The pixel lands where it is shown, 16-bit pixels are swapped in pairs in RDRAM
+	const u32 pixel = idx ^ (m_pCurBuffer->m_size == G_IM_SIZ_16b ? 1 : 0);
+	if ((pixel >> 5) >= m_dirtyPixels.size())
+		return;
+	m_dirtyPixels[pixel >> 5] |= 1U << (pixel & 31);
+
+	const u32 x = pixel % width;
+	const u32 band = pixel / width / m_bandHeight;
+	if (band >= m_dirtyBands.size())
+		m_dirtyBands.resize(band + 1, DirtyBand{ 0xFFFFFFFF, 0 });
+	m_dirtyBands[band].x0 = std::min(m_dirtyBands[band].x0, x);
+	m_dirtyBands[band].x1 = std::max(m_dirtyBands[band].x1, x + 1);
 }
 
 static
@@ -176,6 +168,180 @@ u32 RGBA32ToABGR32(u32 col, bool _fullAlpha)
 	return ((a << 24) | (b << 16) | (g << 8) | r);
 }
 
+// Converts _count pixels of a 16-bit buffer from pixel _start on.
+// Returns the sum of the source pixels.
+static
+u32 convertRow16(const u16 * _src, u32 _start, u32 _count, u32 * _dst, bool _fullAlpha)
+{
+	u32 summ = 0;
+	u32 x = 0;
+	if ((_start & 1) != 0 && _count > 0) {
+		const u16 col = _src[_start ^ 1];
+		summ += col;
+		_dst[x++] = RGBA16ToABGR32(col, _fullAlpha);
+	}
+
+	// From an even pixel on, 8 pixels are 4 swapped pairs of halfwords
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i maskR = _mm_set1_epi32(0xF8);
+	const __m128i maskG = _mm_set1_epi32(0xF800);
+	const __m128i maskB = _mm_set1_epi32(0xF80000);
+	const __m128i fullAlpha = _mm_set1_epi32(_fullAlpha ? 0xFF000000 : 0);
+	__m128i sum = zero;
+	for (; x + 8 <= _count; x += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(_src + _start + x));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		const __m128i c[2] = { _mm_unpacklo_epi16(v, zero), _mm_unpackhi_epi16(v, zero) };
+		for (u32 k = 0; k < 2; ++k) {
+			sum = _mm_add_epi32(sum, c[k]);
+			__m128i abgr = _mm_and_si128(_mm_srli_epi32(c[k], 8), maskR);
+			abgr = _mm_or_si128(abgr, _mm_and_si128(_mm_slli_epi32(c[k], 5), maskG));
+			abgr = _mm_or_si128(abgr, _mm_and_si128(_mm_slli_epi32(c[k], 18), maskB));
+			abgr = _mm_or_si128(abgr, _mm_srai_epi32(_mm_slli_epi32(c[k], 31), 7));
+			_mm_storeu_si128((__m128i*)(_dst + x + 4 * k), _mm_or_si128(abgr, fullAlpha));
+		}
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	summ += (u32)_mm_cvtsi128_si32(sum);
+#elif defined(RDRAM_TO_CB_NEON)
+	const uint32x4_t maskR = vdupq_n_u32(0xF8);
+	const uint32x4_t maskG = vdupq_n_u32(0xF800);
+	const uint32x4_t maskB = vdupq_n_u32(0xF80000);
+	const uint32x4_t fullAlpha = vdupq_n_u32(_fullAlpha ? 0xFF000000 : 0);
+	uint32x4_t sum = vdupq_n_u32(0);
+	for (; x + 8 <= _count; x += 8) {
+		const uint16x8_t v = vrev32q_u16(vld1q_u16(_src + _start + x));
+		const uint32x4_t c[2] = { vmovl_u16(vget_low_u16(v)), vmovl_u16(vget_high_u16(v)) };
+		for (u32 k = 0; k < 2; ++k) {
+			sum = vaddq_u32(sum, c[k]);
+			uint32x4_t abgr = vandq_u32(vshrq_n_u32(c[k], 8), maskR);
+			abgr = vorrq_u32(abgr, vandq_u32(vshlq_n_u32(c[k], 5), maskG));
+			abgr = vorrq_u32(abgr, vandq_u32(vshlq_n_u32(c[k], 18), maskB));
+			abgr = vorrq_u32(abgr, vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(vshlq_n_u32(c[k], 31)), 7)));
+			vst1q_u32(_dst + x + 4 * k, vorrq_u32(abgr, fullAlpha));
+		}
+	}
+	summ += vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+#endif
+
+	for (; x < _count; ++x) {
+		const u16 col = _src[(_start + x) ^ 1];
+		summ += col;
+		_dst[x] = RGBA16ToABGR32(col, _fullAlpha);
+	}
+	return summ;
+}
+
+// Converts _count pixels of a 32-bit buffer from pixel _start on.
+// Returns the sum of the source pixels.
+static
+u32 convertRow32(const u32 * _src, u32 _start, u32 _count, u32 * _dst, bool _fullAlpha)
+{
+	u32 summ = 0;
+	u32 x = 0;
+
+	// RGBA to ABGR is a byte swap
+#if defined(__SSE2__)
+	const __m128i fullAlpha = _mm_set1_epi32(_fullAlpha ? 0xFF000000 : 0);
+	__m128i sum = _mm_setzero_si128();
+	for (; x + 4 <= _count; x += 4) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)(_src + _start + x));
+		sum = _mm_add_epi32(sum, c);
+		__m128i abgr = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		abgr = _mm_or_si128(_mm_slli_epi16(abgr, 8), _mm_srli_epi16(abgr, 8));
+		_mm_storeu_si128((__m128i*)(_dst + x), _mm_or_si128(abgr, fullAlpha));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	summ += (u32)_mm_cvtsi128_si32(sum);
+#elif defined(RDRAM_TO_CB_NEON)
+	const uint32x4_t fullAlpha = vdupq_n_u32(_fullAlpha ? 0xFF000000 : 0);
+	uint32x4_t sum = vdupq_n_u32(0);
+	for (; x + 4 <= _count; x += 4) {
+		const uint32x4_t c = vld1q_u32(_src + _start + x);
+		sum = vaddq_u32(sum, c);
+		const uint32x4_t abgr = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(c)));
+		vst1q_u32(_dst + x, vorrq_u32(abgr, fullAlpha));
+	}
+	summ += vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+#endif
+
+	for (; x < _count; ++x) {
+		const u32 col = _src[_start + x];
+		summ += col;
+		_dst[x] = RGBA32ToABGR32(col, _fullAlpha);
+	}
+	return summ;
+}
+
+// Converts a row of the whole buffer, up to the end of RDRAM
+template <typename TSrc>
+u32 _copyRowFromRdram(const TSrc * _src, u32 _bound, u32 _start, u32 _count, u32 _xor, u32 * _dst,
+	u32(*converter)(TSrc _c, bool _bCFB), u32(*rowConverter)(const TSrc *, u32, u32, u32 *, bool), bool _fullAlpha)
+{
+	if (((_start + _count - 1) | _xor) < _bound)
+		return rowConverter(_src, _start, _count, _dst, _fullAlpha);
+
+	u32 summ = 0;
+	for (u32 x = 0; x < _count; ++x) {
+		const u32 idx = (_start + x) ^ _xor;
+		if (idx >= _bound)
+			break;
+		const TSrc col = _src[idx];
+		summ += col;
+		_dst[x] = converter(col, _fullAlpha);
+	}
+	return summ;
+}
+
+// Converts the pixels of a row written with FBWrite and clears the others
+template <typename TSrc>
+u32 _copyPixelsFromRdram(const TSrc * _src, const u32 * _dirty, u32 _start, u32 _count, u32 _xor, u32 * _dst,
+	u32(*converter)(TSrc _c, bool _bCFB), bool _fullAlpha)
+{
+	u32 summ = 0;
+	for (u32 x = 0; x < _count; ++x) {
+		const u32 pixel = _start + x;
+		if ((_dirty[pixel >> 5] & (1U << (pixel & 31))) == 0) {
+			_dst[x] = 0;
+			continue;
+		}
+		const TSrc col = _src[pixel ^ _xor];
+		summ += col;
+		_dst[x] = converter(col, _fullAlpha);
+	}
+	return summ;
+}
+
+bool RDRAMtoColorBuffer::_getDirtyRects(u32 _width, u32 _height, std::vector<Rect> & _rects) const
+{
+	if (m_dirtyOutside || m_dirtyMaxRow > _height)
+		return false;
+	if (m_pCurBuffer->m_startAddress != m_dirtyAddress || _width != m_dirtyWidth)
+		return false;
+
+	// Written bands next to each other make one rectangle
+	const u32 numBands = std::min(static_cast<u32>(m_dirtyBands.size()), (_height + m_bandHeight - 1) / m_bandHeight);
+	for (u32 i = 0; i < numBands; ++i) {
+		const DirtyBand & band = m_dirtyBands[i];
+		if (band.x0 >= band.x1)
+			continue;
+		const u32 y0 = i * m_bandHeight;
+		const u32 y1 = std::min(y0 + m_bandHeight, _height);
+		if (!_rects.empty() && _rects.back().y1 == y0) {
+			Rect & rect = _rects.back();
+			rect.x0 = std::min(rect.x0, band.x0);
+			rect.x1 = std::max(rect.x1, std::min(band.x1, _width));
+			rect.y1 = y1;
+		} else
+			_rects.push_back(Rect{ band.x0, y0, std::min(band.x1, _width), y1 });
+	}
+	return true;
+}
+
 void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 {
 	Cleaner cleaner(this);
@@ -183,53 +349,82 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 	const u32 width = m_pCurBuffer->m_width;
 	const u32 height = _height;
 
-	const u32 x0 = 0;
-	const u32 y0 = 0;
-	const u32 y1 = y0 + height;
-
 	const bool bUseAlpha = !_fullAlpha && m_pCurBuffer->m_changed;
 
 	const FramebufferTextureFormats & fbTexFormats = gfxContext.getFramebufferTextureFormats();
-
-	u32 * pDst = nullptr;
-	std::unique_ptr<u8[]> dstData;
+	const bool bFloat = fbTexFormats.colorType == datatype::FLOAT;
+	const bool b16 = m_pCurBuffer->m_size == G_IM_SIZ_16b;
+
+	// Without FBWrite the whole buffer is copied, else only the written rectangles
+	std::vector<Rect> rects;
+	bool bCopy = width * height <= m_pTexture->width * m_pTexture->height;
+	if (!m_dirty) {
+		bCopy = bCopy && (address & 1) == 0;
+		rects.push_back(Rect{ 0, 0, width, height });
+	} else if (bCopy)
+		bCopy = _getDirtyRects(width, height, rects);
+
+	u32 numPixels = 0;
+	for (const Rect & rect : rects)
+		numPixels += (rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+	if (numPixels == 0)
+		bCopy = false;
+
+	// Converted pixels go straight to the unpack buffer if there is one
+	const u32 pixelBytes = bFloat ? 16 : 4;
+	u8 * pStaging = nullptr;
+	if (bCopy && m_pWriteBuffer) {
+		m_pWriteBuffer->bind();
+		pStaging = reinterpret_cast<u8*>(m_pWriteBuffer->getWriteBuffer(numPixels * pixelBytes));
+		if (pStaging == nullptr)
+			m_pWriteBuffer->unbind();
+	}
+	const bool bWriteBuffer = pStaging != nullptr;
+	if (!bWriteBuffer)
+		pStaging = m_pbuf;
 
 	//If not using float, the initial coversion will already be correct
-	if (fbTexFormats.colorType == datatype::FLOAT) {
-		const u32 initialDataSize = width*height * 4;
-		dstData = std::unique_ptr<u8[]>(new u8[initialDataSize]);
-		pDst = reinterpret_cast<u32*>(dstData.get());
-	} else {
-		pDst = reinterpret_cast<u32*>(m_pbuf);
+	std::unique_ptr<u32[]> dstData;
+	u32 * pDst = reinterpret_cast<u32*>(pStaging);
+	if (bFloat && bCopy) {
+		dstData = std::unique_ptr<u32[]>(new u32[numPixels]);
+		pDst = dstData.get();
 	}
 
-	bool bCopy;
-	if (m_vecAddress.empty()) {
-		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
-			bCopy = _copyBufferFromRdram<u16>(address, pDst, RGBA16ToABGR32, 1, x0, y0, width, height, _fullAlpha);
-		else
-			bCopy = _copyBufferFromRdram<u32>(address, pDst, RGBA32ToABGR32, 0, x0, y0, width, height, _fullAlpha);
-	} else {
-		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
-			bCopy = _copyPixelsFromRdram<u16>(address, m_vecAddress, pDst, RGBA16ToABGR32, 1, width, height, _fullAlpha);
-		else
-			bCopy = _copyPixelsFromRdram<u32>(address, m_vecAddress, pDst, RGBA32ToABGR32, 0, width, height, _fullAlpha);
+	u32 summ = 0;
+	if (bCopy) {
+		const u32 xorPixel = b16 ? 1 : 0;
+		const u32 bound = (RDRAMSize + 1 - address) >> (b16 ? 1 : 2);
+		const u16 * src16 = reinterpret_cast<const u16*>(RDRAM + address);
+		const u32 * src32 = reinterpret_cast<const u32*>(RDRAM + address);
+		u32 * pRow = pDst;
+		for (const Rect & rect : rects) {
+			const u32 rectWidth = rect.x1 - rect.x0;
+			for (u32 y = rect.y0; y < rect.y1; ++y, pRow += rectWidth) {
+				const u32 start = rect.x0 + y * width;
+				if (!m_dirty && b16)
+					summ += _copyRowFromRdram<u16>(src16, bound, start, rectWidth, xorPixel, pRow, RGBA16ToABGR32, convertRow16, _fullAlpha);
+				else if (!m_dirty)
+					summ += _copyRowFromRdram<u32>(src32, bound, start, rectWidth, xorPixel, pRow, RGBA32ToABGR32, convertRow32, _fullAlpha);
+				else if (b16)
+					summ += _copyPixelsFromRdram<u16>(src16, m_dirtyPixels.data(), start, rectWidth, xorPixel, pRow, RGBA16ToABGR32, _fullAlpha);
+				else
+					summ += _copyPixelsFromRdram<u32>(src32, m_dirtyPixels.data(), start, rectWidth, xorPixel, pRow, RGBA32ToABGR32, _fullAlpha);
+			}
+		}
 	}
 
 	//Convert integer format to float
-	if (fbTexFormats.colorType == datatype::FLOAT) {
-		f32* floatData = reinterpret_cast<f32*>(m_pbuf);
-		u8* byteData = dstData.get();
-		const u32 widthPixels = width*4;
-		for (unsigned int heightIndex = 0; heightIndex < height; ++heightIndex) {
-			for (unsigned int widthIndex = 0; widthIndex < widthPixels; ++widthIndex) {
-				u8& src = *(byteData + heightIndex*widthPixels + widthIndex);
-				float& dst = *(floatData + heightIndex*widthPixels + widthIndex);
-				dst = src/255.0f;
-			}
-		}
+	if (bFloat && bCopy) {
+		f32* floatData = reinterpret_cast<f32*>(pStaging);
+		const u8* byteData = reinterpret_cast<const u8*>(dstData.get());
+		const u32 numComponents = numPixels * 4;
+		for (u32 i = 0; i < numComponents; ++i)
+			floatData[i] = byteData[i] / 255.0f;
 	}
 
+	const u8 * pData = bWriteBuffer ? m_pWriteBuffer->closeWriteBuffer() : m_pbuf;
+
 	if (!FBInfo::fbInfo.isSupported()) {
 		if (bUseAlpha && config.frameBufferEmulation.copyToRDRAM == Config::ctDisable) {
 			u32 totalBytes = (width * height) << m_pCurBuffer->m_size >> 1;
@@ -239,6 +434,27 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 		}
 	}
 
+	bCopy = bCopy && summ != 0;
+	if (bCopy) {
+		Context::UpdateTextureDataParams updateParams;
+		updateParams.handle = m_pTexture->name;
+		updateParams.textureUnitIndex = textureIndices::Tex[0];
+		updateParams.format = fbTexFormats.colorFormat;
+		updateParams.dataType = fbTexFormats.colorType;
+		for (const Rect & rect : rects) {
+			updateParams.x = rect.x0;
+			updateParams.y = rect.y0;
+			updateParams.width = rect.x1 - rect.x0;
+			updateParams.height = rect.y1 - rect.y0;
+			updateParams.data = pData;
+			gfxContext.update2DTexture(updateParams);
+			pData += updateParams.width * updateParams.height * pixelBytes;
+		}
+	}
+
+	if (bWriteBuffer)
+		m_pWriteBuffer->unbind();
+
 	if (!bCopy)
 		return;
 
@@ -247,16 +463,6 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 	CombinerInfo::get().setPolygonMode(DrawingState::TexRect);
 	CombinerInfo::get().update();
 
-	Context::UpdateTextureDataParams updateParams;
-	updateParams.handle = m_pTexture->name;
-	updateParams.textureUnitIndex = textureIndices::Tex[0];
-	updateParams.width = width;
-	updateParams.height = height;
-	updateParams.format = fbTexFormats.colorFormat;
-	updateParams.dataType = fbTexFormats.colorType;
-	updateParams.data = m_pbuf;
-	gfxContext.update2DTexture(updateParams);
-
 	m_pTexture->scaleS = 1.0f / (float)m_pTexture->width;
 	m_pTexture->scaleT = 1.0f / (float)m_pTexture->height;
 	m_pTexture->shiftScaleS = 1.0f;
@@ -278,10 +484,12 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 	gfxContext.bindFramebuffer(bufferTarget::DRAW_FRAMEBUFFER, m_pCurBuffer->m_FBO);
 
 	gfxContext.enable(enable::SCISSOR_TEST, false);
-	GraphicsDrawer::TexturedRectParams texRectParams((float)x0, (float)y0, (float)width, (float)height,
-										 1.0f, 1.0f, 0, 0,
-										 false, true, false, m_pCurBuffer);
-	dwnd().getDrawer().drawTexturedRect(texRectParams);
+	for (const Rect & rect : rects) {
+		GraphicsDrawer::TexturedRectParams texRectParams((float)rect.x0, (float)rect.y0, (float)rect.x1, (float)rect.y1,
+											 1.0f, 1.0f, s16(rect.x0 << 5), s16(rect.y0 << 5),
+											 false, true, false, m_pCurBuffer);
+		dwnd().getDrawer().drawTexturedRect(texRectParams);
+	}
 	gfxContext.enable(enable::SCISSOR_TEST, true);
 	gDP.otherMode.cycleType = cycleType;
 
@@ -298,7 +506,7 @@ void RDRAMtoColorBuffer::copyFromRDRAM(u32 _address, bool _bCFB)
 		if (_bCFB || (config.frameBufferEmulation.copyFromRDRAM != 0 && !FBInfo::fbInfo.isSupported()))
 			m_pCurBuffer = frameBufferList().findBuffer(_address);
 	} else {
-		if (m_vecAddress.empty()) {
+		if (!m_dirty) {
 			m_pCurBuffer = nullptr;
 			return;
 		}
@@ -330,6 +538,20 @@ void RDRAMtoColorBuffer::copyFromRDRAM(FrameBuffer * _pBuffer)
 
 void RDRAMtoColorBuffer::reset()
 {
+	if (m_dirty) {
+		// Clear the bits of the written bands only
+		const u32 bandPixels = m_dirtyWidth * m_bandHeight;
+		for (u32 i = 0; i < m_dirtyBands.size(); ++i) {
+			if (m_dirtyBands[i].x0 >= m_dirtyBands[i].x1)
+				continue;
+			const u32 first = i * bandPixels / 32;
+			const u32 last = std::min(((i + 1) * bandPixels + 31) / 32, static_cast<u32>(m_dirtyPixels.size()));
+			std::fill(m_dirtyPixels.begin() + first, m_dirtyPixels.begin() + last, 0);
+		}
+	}
+	m_dirtyBands.clear();
+	m_dirtyMaxRow = 0;
+	m_dirty = false;
+	m_dirtyOutside = false;
 	m_pCurBuffer = nullptr;
-	m_vecAddress.clear();
 }
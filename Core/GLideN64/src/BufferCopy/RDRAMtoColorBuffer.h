@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <Graphics/ObjectHandle.h>
+#include <Graphics/PixelBuffer.h>
 #include <FrameBuffer.h>
 
 struct CachedTexture;
@@ -26,7 +27,13 @@ private:
 	RDRAMtoColorBuffer();
 	RDRAMtoColorBuffer(const RDRAMtoColorBuffer &) = delete;
 
+	struct Rect
+	{
+		u32 x0, y0, x1, y1;
+	};
+
 	void _copyFromRDRAM(u32 _height, bool _fullAlpha);
+	bool _getDirtyRects(u32 _width, u32 _height, std::vector<Rect> & _rects) const;
 	void reset();
 
 	class Cleaner
@@ -45,8 +52,24 @@ private:
 
 	FrameBuffer * m_pCurBuffer;
 	CachedTexture * m_pTexture;
-	std::vector<u32> m_vecAddress;
 	u8* m_pbuf;
+	std::unique_ptr<graphics::PixelWriteBuffer> m_pWriteBuffer;
+
+	// Pixels written by the CPU since the last copy, reported with FBWrite.
+	// One bit per pixel of m_pCurBuffer plus the written columns of each
+	// band of m_bandHeight rows, so only those bands are converted and uploaded.
+	struct DirtyBand
+	{
+		u32 x0, x1;
+	};
+	static const u32 m_bandHeight = 16;
+	std::vector<u32> m_dirtyPixels;
+	std::vector<DirtyBand> m_dirtyBands;
+	u32 m_dirtyAddress;
+	u32 m_dirtyWidth;
+	u32 m_dirtyMaxRow;
+	bool m_dirty;
+	bool m_dirtyOutside;
 };
 
 #endif // RDRAMtoColorBuffer_H
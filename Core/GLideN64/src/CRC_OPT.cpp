@@ -1,7 +1,12 @@
+#include <string.h>
 #include "CRC.h"
 #define XXH_INLINE_ALL
 #include "xxHash/xxhash.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define CRC32_POLYNOMIAL     0x04C11DB7
 
 unsigned int CRCTable[ 256 ];
@@ -51,12 +56,34 @@ u64 CRC_Calculate( u64 crc, const void * buffer, u32 count )
 	return XXH3_64bits_withSeed(buffer, count, crc);
 }
 
+// Palette entries are 16 bit values 8 bytes apart in TMEM. They are gathered
+// into one block first, so that XXH3 runs once instead of once per entry.
 u64 CRC_CalculatePalette( u64 crc, const void * buffer, u32 count )
 {
-	u8 *p = (u8*) buffer;
-	while (count--) {
-		crc = XXH3_64bits_withSeed(p, 2, crc);
-		p += 8;
+	u16 entries[256];
+	const u8 *p = (const u8*) buffer;
+	while (count > 0) {
+		const u32 num = count < 256 ? count : 256;
+		u32 i = 0;
+#if defined(__SSE2__)
+		for (; i + 8 <= num; i += 8) {
+			// Each load holds two entries, in words 0 and 4: move them to the low dword
+			__m128i v[4];
+			for (u32 j = 0; j < 4; ++j) {
+				v[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + (i + j * 2) * 8));
+				v[j] = _mm_shuffle_epi32(v[j], _MM_SHUFFLE(3, 1, 2, 0));
+				v[j] = _mm_shufflelo_epi16(v[j], _MM_SHUFFLE(3, 1, 2, 0));
+			}
+			const __m128i lo = _mm_unpacklo_epi32(v[0], v[1]);
+			const __m128i hi = _mm_unpacklo_epi32(v[2], v[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(entries + i), _mm_unpacklo_epi64(lo, hi));
+		}
+#endif
+		for (; i < num; ++i)
+			memcpy(entries + i, p + i * 8, 2);
+		crc = XXH3_64bits_withSeed(entries, num * 2, crc);
+		p += num * 8;
+		count -= num;
 	}
 	return crc;
 }
@@ -20,6 +20,7 @@
 #include "FrameBuffer.h"
 #include "DepthBuffer.h"
 #include "DepthBufferRender.h"
+#include "DepthBufferSpan.h"
 
 static vertexi * max_vtx;                   // Max y vertex (ending vertex)
 static vertexi * start_vtx, *end_vtx;      // First and last vertex in array
@@ -226,16 +227,7 @@ void Rasterize(vertexi * vtx, int vertices, int dzdx)
 
 			int shift = x1 + y1*depthBufferWidth;
 			//draw to depth buffer
-			for (int x = 0; x < width; x++)	{
-				int trueZ = z / 8192;
-				if (trueZ < 0)
-					trueZ = 0;
-				u16 encodedZ = zLUT[trueZ];
-				int idx = (shift + x) ^ 1;
-				if (encodedZ < destptr[idx])
-					destptr[idx] = encodedZ;
-				z = isumm(z, dzdx);
-			}
+			DepthBufferSpan(destptr, shift, width, z, dzdx, zLUT);
 		}
 
 		//destptr += rdp.zi_width;
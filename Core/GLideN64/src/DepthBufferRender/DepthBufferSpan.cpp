@@ -0,0 +1,105 @@
+//****************************************************************
+//
+// Depth span writer for the software depth buffer renderer
+//
+// The SIMD path computes depth and the depth test for 8 pixels at a time.
+// Only the zLUT lookup stays per pixel, since SSE2 and NEON have no gather.
+//
+//****************************************************************
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DEPTH_SPAN_NEON
+#endif
+
+#include "DepthBufferSpan.h"
+
+static inline
+u16 encodeZ(int z, const u16 * zLUT)
+{
+	int trueZ = z / 8192;
+	if (trueZ < 0)
+		trueZ = 0;
+	return zLUT[trueZ];
+}
+
+void DepthBufferSpanScalar(u16 * dst, int start, int width, int z, int dzdx, const u16 * zLUT)
+{
+	for (int x = 0; x < width; x++) {
+		u16 encodedZ = encodeZ(z, zLUT);
+		int idx = (start + x) ^ 1;
+		if (encodedZ < dst[idx])
+			dst[idx] = encodedZ;
+		z = (int)((u32)z + (u32)dzdx);
+	}
+}
+
+void DepthBufferSpan(u16 * dst, int start, int width, int z, int dzdx, const u16 * zLUT)
+{
+#if defined(__SSE2__) || defined(DEPTH_SPAN_NEON)
+	if (width >= 9) {
+		// Start on an even pixel: the 8 pixels from there then fill an aligned
+		// group of 4 halfword pairs, each pair swapped in memory.
+		if (start & 1) {
+			u16 encodedZ = encodeZ(z, zLUT);
+			if (encodedZ < dst[start ^ 1])
+				dst[start ^ 1] = encodedZ;
+			z = (int)((u32)z + (u32)dzdx);
+			start++;
+			width--;
+		}
+
+		// Lane k holds z + k * dzdx with the same 32-bit wraparound as the
+		// scalar loop. z / 8192 clamped to 0 is max(z, 0) >> 13.
+		alignas(16) u32 trueZ[8];
+		alignas(16) u16 encodedZ[8];
+		const u32 step = (u32)dzdx;
+#if defined(__SSE2__)
+		__m128i z0 = _mm_setr_epi32(z, (int)((u32)z + step), (int)((u32)z + 2 * step), (int)((u32)z + 3 * step));
+		__m128i z1 = _mm_add_epi32(z0, _mm_set1_epi32((int)(4 * step)));
+		const __m128i step8 = _mm_set1_epi32((int)(8 * step));
+#else
+		const int32_t lanes[4] = { z, (int)((u32)z + step), (int)((u32)z + 2 * step), (int)((u32)z + 3 * step) };
+		int32x4_t z0 = vld1q_s32(lanes);
+		int32x4_t z1 = vaddq_s32(z0, vdupq_n_s32((int)(4 * step)));
+		const int32x4_t step8 = vdupq_n_s32((int)(8 * step));
+#endif
+		int x = 0;
+		for (; x + 8 <= width; x += 8) {
+			u16 * block = dst + start + x;
+#if defined(__SSE2__)
+			__m128i t0 = _mm_andnot_si128(_mm_srai_epi32(z0, 31), z0);
+			__m128i t1 = _mm_andnot_si128(_mm_srai_epi32(z1, 31), z1);
+			_mm_store_si128((__m128i*)trueZ, _mm_srli_epi32(t0, 13));
+			_mm_store_si128((__m128i*)(trueZ + 4), _mm_srli_epi32(t1, 13));
+			z0 = _mm_add_epi32(z0, step8);
+			z1 = _mm_add_epi32(z1, step8);
+#else
+			vst1q_u32(trueZ, vshrq_n_u32(vreinterpretq_u32_s32(vmaxq_s32(z0, vdupq_n_s32(0))), 13));
+			vst1q_u32(trueZ + 4, vshrq_n_u32(vreinterpretq_u32_s32(vmaxq_s32(z1, vdupq_n_s32(0))), 13));
+			z0 = vaddq_s32(z0, step8);
+			z1 = vaddq_s32(z1, step8);
+#endif
+			for (int k = 0; k < 8; k++)
+				encodedZ[k ^ 1] = zLUT[trueZ[k]];
+#if defined(__SSE2__)
+			// unsigned min: d - max(d - v, 0)
+			const __m128i v = _mm_load_si128((const __m128i*)encodedZ);
+			const __m128i d = _mm_loadu_si128((const __m128i*)block);
+			_mm_storeu_si128((__m128i*)block, _mm_sub_epi16(d, _mm_subs_epu16(d, v)));
+#else
+			vst1q_u16(block, vminq_u16(vld1q_u16(block), vld1q_u16(encodedZ)));
+#endif
+		}
+
+		if (x == width)
+			return;
+		start += x;
+		width -= x;
+		z = (int)((u32)z + (u32)x * step);
+	}
+#endif
+	DepthBufferSpanScalar(dst, start, width, z, dzdx, zLUT);
+}
@@ -0,0 +1,22 @@
+//****************************************************************
+//
+// Depth span writer for the software depth buffer renderer
+//
+//****************************************************************
+
+#ifndef DEPTH_BUFFER_SPAN_H
+#define DEPTH_BUFFER_SPAN_H
+
+#include "Types.h"
+
+// Writes width pixels of one span into an N64 depth buffer, starting at pixel
+// index start. z is the 16:16 depth of the first pixel and steps by dzdx.
+// Each pixel is encoded through zLUT and stored only where it is closer than
+// the value already there. The buffer is in RDRAM order, so pixel i is at
+// dst[i ^ 1].
+void DepthBufferSpan(u16 * dst, int start, int width, int z, int dzdx, const u16 * zLUT);
+
+// Pixel by pixel version, the reference for DepthBufferSpan.
+void DepthBufferSpanScalar(u16 * dst, int start, int width, int z, int dzdx, const u16 * zLUT);
+
+#endif //DEPTH_BUFFER_SPAN_H
@@ -0,0 +1,118 @@
+//****************************************************************
+//
+// Bit-exactness check of DepthBufferSpan against the original
+// per pixel span loop of Rasterize.
+//
+// Standalone program, not part of the core build:
+//   c++ -O2 -I.. -o depth-span-test DepthBufferSpan_test.cpp DepthBufferSpan.cpp
+//
+// Spans are random in start, width, depth and slope, including
+// slopes that wrap the 16:16 depth around. Each run is made with
+// the zLUT built by DepthBufferList and with a random one.
+//
+//****************************************************************
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "DepthBufferSpan.h"
+
+enum { LUT_SIZE = 0x40000, BUFFER_SIZE = 4096, ITERATIONS = 1000000 };
+
+static int isumm(int x, int y) // safe x + y
+{
+	return (int)((long long)x + (long long)y);
+}
+
+// The span loop as it was in Rasterize
+static void referenceSpan(u16 * destptr, int shift, int width, int z, int dzdx, const u16 * zLUT)
+{
+	for (int x = 0; x < width; x++)	{
+		int trueZ = z / 8192;
+		if (trueZ < 0)
+			trueZ = 0;
+		u16 encodedZ = zLUT[trueZ];
+		int idx = (shift + x) ^ 1;
+		if (encodedZ < destptr[idx])
+			destptr[idx] = encodedZ;
+		z = isumm(z, dzdx);
+	}
+}
+
+static void buildLUT(u16 * zLUT)
+{
+	for (u32 i = 0; i<LUT_SIZE; i++) {
+		u32 exponent = 0;
+		u32 testbit = 1 << 17;
+		while ((i & testbit) && (exponent < 7)) {
+			exponent++;
+			testbit = 1 << (17 - exponent);
+		}
+
+		const u32 mantissa = (i >> (6 - (6 < exponent ? 6 : exponent))) & 0x7ff;
+		zLUT[i] = static_cast<u16>(((exponent << 11) | mantissa) << 2);
+	}
+}
+
+static int run(const u16 * zLUT, std::mt19937 & rng, const char * name)
+{
+	std::vector<u16> expected(BUFFER_SIZE), actual(BUFFER_SIZE), scalar(BUFFER_SIZE);
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		const int width = rng() % 2 == 0 ? (int)(rng() % 24) : (int)(rng() % 1024);
+		const int start = (int)(rng() % (BUFFER_SIZE - 2 - width));
+		int z = (int)rng();
+		int dzdx;
+		switch (rng() % 4) {
+		case 0: dzdx = (int)rng(); break;                         // wraps around
+		case 1: dzdx = (int)(rng() % 0x20000) - 0x10000; break;   // small slope
+		case 2: dzdx = 0; break;
+		default: dzdx = (int)(rng() % 0x2000000) - 0x1000000; z &= 0x7fffffff; break;
+		}
+
+		if (i % 64 == 0) {
+			for (int j = 0; j < BUFFER_SIZE; j++)
+				expected[j] = (u16)rng();
+			actual = expected;
+			scalar = expected;
+		}
+
+		referenceSpan(expected.data(), start, width, z, dzdx, zLUT);
+		DepthBufferSpan(actual.data(), start, width, z, dzdx, zLUT);
+		DepthBufferSpanScalar(scalar.data(), start, width, z, dzdx, zLUT);
+
+		if (actual != expected || scalar != expected) {
+			const bool simd = actual != expected;
+			const std::vector<u16> & got = simd ? actual : scalar;
+			int j = 0;
+			while (got[j] == expected[j])
+				j++;
+			printf("%s: %s mismatch at iteration %d (start %d, width %d, z 0x%08x, dzdx 0x%08x): "
+				"dst[%d] = 0x%04x, expected 0x%04x\n", name, simd ? "DepthBufferSpan" : "DepthBufferSpanScalar",
+				i, start, width, (u32)z, (u32)dzdx, j, got[j], expected[j]);
+			return 1;
+		}
+	}
+
+	printf("%s: %d spans OK\n", name, ITERATIONS);
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	std::mt19937 rng(argc > 1 ? (u32)strtoul(argv[1], nullptr, 0) : 1234u);
+	std::vector<u16> zLUT(LUT_SIZE);
+	int failed = 0;
+
+	buildLUT(zLUT.data());
+	failed |= run(zLUT.data(), rng, "zLUT");
+
+	for (u32 i = 0; i < LUT_SIZE; i++)
+		zLUT[i] = (u16)rng();
+	failed |= run(zLUT.data(), rng, "random LUT");
+
+	return failed;
+}
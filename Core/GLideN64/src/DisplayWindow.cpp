@@ -33,6 +33,7 @@ bool DisplayWindow::start()
 
 void DisplayWindow::stop()
 {
+	m_capture.destroy();
 	m_drawer._destroyData();
 	gfxContext.destroy();
 	_stop();
@@ -46,6 +47,7 @@ void DisplayWindow::restart()
 
 void DisplayWindow::swapBuffers()
 {
+	m_capture.grab();
 	m_drawer.drawOSD();
 	m_drawer.clearStatistics();
 	_swapBuffers();
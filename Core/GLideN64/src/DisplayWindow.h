@@ -1,6 +1,7 @@
 #pragma once
 #include "Types.h"
 #include "GraphicsDrawer.h"
+#include "FrameCapture.h"
 
 class DisplayWindow
 {
@@ -73,6 +74,7 @@ protected:
 
 private:
 	GraphicsDrawer m_drawer;
+	FrameCapture m_capture;
 
 	virtual bool _start() = 0;
 	virtual void _stop() = 0;
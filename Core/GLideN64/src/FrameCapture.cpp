@@ -0,0 +1,83 @@
+#include <cstring>
+#include "FrameCapture.h"
+#include "DisplayWindow.h"
+#include "FrameBuffer.h"
+#include "Graphics/Context.h"
+#include "Graphics/Parameters.h"
+#include "Graphics/PixelBuffer.h"
+#include "main/capture.h"
+
+using namespace graphics;
+
+FrameCapture::FrameCapture()
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+}
+
+void FrameCapture::_collect(Frame & _frame)
+{
+	if (_frame.slot < 0)
+		return;
+
+	PixelBufferBinder<PixelReadBuffer> binder(_frame.buffer.get());
+	const u32 size = _frame.width * _frame.height * 4;
+	const void * data = _frame.buffer->getDataRange(0, size);
+	if (data != nullptr) {
+		memcpy(_frame.pixels, data, size);
+		_frame.buffer->closeReadBuffer();
+		capture_submit_frame(_frame.slot);
+	} else
+		capture_cancel_frame(_frame.slot);
+	_frame.slot = -1;
+}
+
+void FrameCapture::grab()
+{
+	if (!capture_enabled())
+		return;
+
+	Frame & frame = m_frames[m_current];
+	m_current = (m_current + 1) % FramesInFlight;
+	_collect(frame);
+
+	const u32 width = dwnd().getScreenWidth();
+	const u32 height = dwnd().getScreenHeight();
+	const size_t size = size_t(width) * height * 4;
+	if (!frame.buffer || frame.size < size) {
+		frame.buffer.reset(gfxContext.createPixelReadBuffer(size));
+		frame.size = size;
+	}
+	// No pixel buffer objects, e.g. on GLES2
+	if (!frame.buffer)
+		return;
+
+	frame.slot = capture_begin_frame(width, height, width * 4, CAPTURE_RGBA8888_BOTTOM_UP, &frame.pixels);
+	if (frame.slot < 0)
+		return;
+	frame.width = width;
+	frame.height = height;
+
+	gfxContext.bindFramebuffer(bufferTarget::READ_FRAMEBUFFER, ObjectHandle::defaultFramebuffer);
+	{
+		PixelBufferBinder<PixelReadBuffer> binder(frame.buffer.get());
+		frame.buffer->readPixels(0, dwnd().getHeightOffset(), width, height, colorFormat::RGBA, datatype::UNSIGNED_BYTE);
+	}
+	FrameBuffer * pBuffer = frameBufferList().getCurrent();
+	if (pBuffer != nullptr)
+		gfxContext.bindFramebuffer(bufferTarget::READ_FRAMEBUFFER, pBuffer->m_FBO);
+}
+
+void FrameCapture::destroy()
+{
+	for (u32 i = 0; i < FramesInFlight; ++i) {
+		Frame & frame = m_frames[(m_current + i) % FramesInFlight];
+		if (frame.buffer)
+			_collect(frame);
+		frame.buffer.reset();
+		frame.size = 0;
+	}
+	m_current = 0;
+}
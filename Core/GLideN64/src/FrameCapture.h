@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <memory>
+#include "Types.h"
+
+namespace graphics {
+	class PixelReadBuffer;
+}
+
+// Hands the displayed frames to the core's capture. Each frame is read into
+// one of a ring of pixel buffers and collected when the buffer comes round
+// again, so the readback has finished by then and never stalls rendering.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	// Reads the frame about to be displayed.
+	void grab();
+	// Collects the frames still in flight and frees the buffers.
+	void destroy();
+
+private:
+	struct Frame
+	{
+		std::unique_ptr<graphics::PixelReadBuffer> buffer;
+		size_t size = 0;
+		s32 slot = -1;
+		void * pixels = nullptr;
+		u32 width = 0;
+		u32 height = 0;
+	};
+
+	void _collect(Frame & _frame);
+
+	static const u32 FramesInFlight = 3;
+	std::array<Frame, FramesInFlight> m_frames;
+	u32 m_current = 0;
+};
@@ -244,6 +244,11 @@ PixelReadBuffer * Context::createPixelReadBuffer(size_t _sizeInBytes)
 	return m_impl->createPixelReadBuffer(_sizeInBytes);
 }
 
+PixelWriteBuffer * Context::createPixelWriteBuffer(size_t _sizeInBytes)
+{
+	return m_impl->createPixelWriteBuffer(_sizeInBytes);
+}
+
 ColorBufferReader * Context::createColorBufferReader(CachedTexture * _pTexture)
 {
 	return m_impl->createColorBufferReader(_pTexture);
@@ -347,6 +352,11 @@ void Context::drawLine(f32 _width, SPVertex * _vertices)
 	m_impl->drawLine(_width, _vertices);
 }
 
+void Context::flushDraws()
+{
+	m_impl->flushDraws();
+}
+
 f32 Context::getMaxLineWidth()
 {
 	return m_impl->getMaxLineWidth();
@@ -224,6 +224,8 @@ namespace graphics {
 
 		PixelReadBuffer * createPixelReadBuffer(size_t _sizeInBytes);
 
+		PixelWriteBuffer * createPixelWriteBuffer(size_t _sizeInBytes);
+
 		ColorBufferReader * createColorBufferReader(CachedTexture * _pTexture);
 
 		/*---------------Shaders-------------*/
@@ -289,6 +291,10 @@ namespace graphics {
 
 		void drawLine(f32 _width, SPVertex * _vertices);
 
+		// Submits draws held back to be merged with the next compatible one.
+		// Must be called before control goes back to the emulator.
+		void flushDraws();
+
 		f32 getMaxLineWidth();
 
 		/*---------------Misc-------------*/
@@ -50,6 +50,7 @@ namespace graphics {
 		virtual bool blitFramebuffers(const Context::BlitFramebuffersParams & _params) = 0;
 		virtual void setDrawBuffers(u32 _num) = 0;
 		virtual PixelReadBuffer * createPixelReadBuffer(size_t _sizeInBytes) = 0;
+		virtual PixelWriteBuffer * createPixelWriteBuffer(size_t _sizeInBytes) = 0;
 		virtual ColorBufferReader * createColorBufferReader(CachedTexture * _pTexture) = 0;
 		virtual bool isCombinerProgramBuilderObsolete() = 0;
 		virtual void resetCombinerProgramBuilder() = 0;
@@ -70,6 +71,7 @@ namespace graphics {
 		virtual void drawTriangles(const Context::DrawTriangleParameters & _params) = 0;
 		virtual void drawRects(const Context::DrawRectParameters & _params) = 0;
 		virtual void drawLine(f32 _width, SPVertex * _vertices) = 0;
+		virtual void flushDraws() = 0;
 		virtual f32 getMaxLineWidth() = 0;
 		virtual bool isSupported(SpecialFeatures _feature) const = 0;
 		virtual s32 getMaxMSAALevel() = 0;
@@ -208,6 +208,8 @@ PFNGLCREATEBUFFERSPROC ptrCreateBuffers;
 PFNGLCREATEFRAMEBUFFERSPROC ptrCreateFramebuffers;
 PFNGLNAMEDFRAMEBUFFERTEXTUREPROC ptrNamedFramebufferTexture;
 PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC ptrDrawRangeElementsBaseVertex;
+PFNGLMULTIDRAWARRAYSPROC ptrMultiDrawArrays;
+PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC ptrMultiDrawElementsBaseVertex;
 PFNGLFLUSHMAPPEDBUFFERRANGEPROC ptrFlushMappedBufferRange;
 PFNGLTEXTUREBARRIERPROC ptrTextureBarrier;
 PFNGLTEXTUREBARRIERNVPROC ptrTextureBarrierNV;
@@ -396,6 +398,8 @@ extern "C" void initGLFunctions()
 	GL_GET_PROC_ADR(PFNGLCREATEFRAMEBUFFERSPROC, CreateFramebuffers);
 	GL_GET_PROC_ADR(PFNGLNAMEDFRAMEBUFFERTEXTUREPROC, NamedFramebufferTexture);
 	ASSIGN_PROC_ADR(PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC, DrawRangeElementsBaseVertex);
+	GL_GET_PROC_ADR(PFNGLMULTIDRAWARRAYSPROC, MultiDrawArrays);
+	GL_GET_PROC_ADR(PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC, MultiDrawElementsBaseVertex);
 	ASSIGN_PROC_ADR(PFNGLFLUSHMAPPEDBUFFERRANGEPROC, FlushMappedBufferRange);
 	GL_GET_PROC_ADR(PFNGLTEXTUREBARRIERPROC, TextureBarrier);
 	GL_GET_PROC_ADR(PFNGLTEXTUREBARRIERNVPROC, TextureBarrierNV);
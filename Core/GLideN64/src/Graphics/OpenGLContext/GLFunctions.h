@@ -196,6 +196,8 @@ extern PFNGLCREATEBUFFERSPROC ptrCreateBuffers;
 extern PFNGLCREATEFRAMEBUFFERSPROC ptrCreateFramebuffers;
 extern PFNGLNAMEDFRAMEBUFFERTEXTUREPROC ptrNamedFramebufferTexture;
 extern PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC ptrDrawRangeElementsBaseVertex;
+extern PFNGLMULTIDRAWARRAYSPROC ptrMultiDrawArrays;
+extern PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC ptrMultiDrawElementsBaseVertex;
 extern PFNGLFLUSHMAPPEDBUFFERRANGEPROC ptrFlushMappedBufferRange;
 extern PFNGLTEXTUREBARRIERPROC ptrTextureBarrier;
 extern PFNGLTEXTUREBARRIERNVPROC ptrTextureBarrierNV;
@@ -346,6 +348,8 @@ extern "C" void initGLFunctions();
 #define glCreateFramebuffers(...) opengl::FunctionWrapper::wrCreateFramebuffers(__VA_ARGS__)
 #define glNamedFramebufferTexture(...) opengl::FunctionWrapper::wrNamedFramebufferTexture(__VA_ARGS__)
 #define glDrawRangeElementsBaseVertex(...) opengl::FunctionWrapper::wrDrawRangeElementsBaseVertex(__VA_ARGS__)
+#define glMultiDrawArrays(...) opengl::FunctionWrapper::wrMultiDrawArrays(__VA_ARGS__)
+#define glMultiDrawElementsBaseVertex(...) opengl::FunctionWrapper::wrMultiDrawElementsBaseVertex(__VA_ARGS__)
 #define glFlushMappedBufferRange(...) opengl::FunctionWrapper::wrFlushMappedBufferRange(__VA_ARGS__)
 #define glTextureBarrier(...) opengl::FunctionWrapper::wrTextureBarrier(__VA_ARGS__)
 #define glTextureBarrierNV(...) opengl::FunctionWrapper::wrTextureBarrierNV(__VA_ARGS__)
@@ -5,6 +5,7 @@
 #include "glsl_Utils.h"
 #include "glsl_CombinerInputs.h"
 #include "glsl_CombinerProgramImpl.h"
+#include "main/trace.h"
 #include "glsl_CombinerProgramBuilderAccurate.h"
 #include "glsl_CombinerProgramUniformFactoryAccurate.h"
 #include "GraphicsDrawer.h"
@@ -346,6 +347,7 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 																		Combiner & _alpha,
 																		const CombinerKey & _key)
 {
+	TRACE_SCOPE("shader compile");
 	CombinerProgramBuilder::s_cycleType = _key.getCycleType();
 	CombinerProgramBuilder::s_textureConvert.setMode(_key.getBilerp());
 
@@ -772,24 +772,24 @@ public:
 	}
 
 	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
-		GLenum format, GLenum type, const PoolBufferPointer& pixels)
+		GLenum format, GLenum type, const PoolBufferPointer& pixels, const void* offset)
 	{
 		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
 		auto ptr = getFromPool<GlTexSubImage2DUnbufferedCommand>(poolId);
-		ptr->set(target, level, xoffset, yoffset, width, height, format, type, pixels);
+		ptr->set(target, level, xoffset, yoffset, width, height, format, type, pixels, offset);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
 		ptrTexSubImage2D(m_target, m_level, m_xoffset, m_yoffset, m_width, m_height, m_format, m_type,
-			OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_pixels));
+			m_pixels.isValid() ? OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_pixels) : m_offset);
 		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_pixels);
 	}
 
 private:
 	void set(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
-		GLenum format, GLenum type, const PoolBufferPointer& pixels)
+		GLenum format, GLenum type, const PoolBufferPointer& pixels, const void* offset)
 	{
 		m_target = target;
 		m_level = level;
@@ -800,6 +800,7 @@ private:
 		m_format = format;
 		m_type = type;
 		m_pixels = pixels;
+		m_offset = offset;
 	}
 
 	GLenum m_target;
@@ -811,6 +812,7 @@ private:
 	GLenum m_format;
 	GLenum m_type;
 	PoolBufferPointer m_pixels;
+	const void* m_offset;
 };
 
 class GlDrawArraysCommand : public OpenGlCommand
@@ -3862,30 +3864,32 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	static std::shared_ptr<OpenGlCommand> get(GLsync sync, GLbitfield flags, GLuint64 timeout, GLenum& returnValue)
 	{
 		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
 		auto ptr = getFromPool<GlClientWaitSyncCommand>(poolId);
-		ptr->set(sync, flags, timeout);
+		ptr->set(sync, flags, timeout, returnValue);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrClientWaitSync(m_sync, m_flags, m_timeout);
+		*m_returnValue = ptrClientWaitSync(m_sync, m_flags, m_timeout);
 	}
 
 private:
-	void set(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	void set(GLsync sync, GLbitfield flags, GLuint64 timeout, GLenum& returnValue)
 	{
 		m_sync = sync;
 		m_flags = flags;
 		m_timeout = timeout;
+		m_returnValue = &returnValue;
 	}
 
 	GLsync m_sync;
 	GLbitfield m_flags;
 	GLuint64 m_timeout;
+	GLenum* m_returnValue;
 };
 
 class GlDeleteSyncCommand : public OpenGlCommand
@@ -4365,24 +4369,24 @@ public:
 	}
 
 	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
-		GLsizei height, GLenum format, GLenum type, const PoolBufferPointer& pixels)
+		GLsizei height, GLenum format, GLenum type, const PoolBufferPointer& pixels, const void* offset)
 	{
 		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
 		auto ptr = getFromPool<GlTextureSubImage2DUnbufferedCommand>(poolId);
-		ptr->set(texture, level, xoffset, yoffset, width, height, format, type, pixels);
+		ptr->set(texture, level, xoffset, yoffset, width, height, format, type, pixels, offset);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
 		ptrTextureSubImage2D(m_texture, m_level, m_xoffset, m_yoffset, m_width, m_height, m_format, m_type,
-			OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_pixels));
+			m_pixels.isValid() ? OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_pixels) : m_offset);
 		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_pixels);
 	}
 
 private:
 	void set(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
-		GLsizei height, GLenum format, GLenum type, const PoolBufferPointer& pixels)
+		GLsizei height, GLenum format, GLenum type, const PoolBufferPointer& pixels, const void* offset)
 	{
 		m_texture = texture;
 		m_level = level;
@@ -4393,6 +4397,7 @@ private:
 		m_format = format;
 		m_type = type;
 		m_pixels = pixels;
+		m_offset = offset;
 	}
 
 	GLuint m_texture;
@@ -4404,6 +4409,7 @@ private:
 	GLenum m_format;
 	GLenum m_type;
 	PoolBufferPointer m_pixels;
+	const void* m_offset;
 };
 
 class GlTextureStorage2DMultisampleCommand : public OpenGlCommand
@@ -4697,6 +4703,81 @@ private:
 	GLint m_basevertex;
 };
 
+class GlMultiDrawArraysCommand : public OpenGlCommand
+{
+public:
+	GlMultiDrawArraysCommand() :
+		OpenGlCommand(false, false, "glMultiDrawArrays")
+	{
+	}
+
+	static std::shared_ptr<OpenGlCommand> get(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount)
+	{
+		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
+		auto ptr = getFromPool<GlMultiDrawArraysCommand>(poolId);
+		ptr->set(mode, first, count, drawcount);
+		return ptr;
+	}
+
+	void commandToExecute() override
+	{
+		ptrMultiDrawArrays(m_mode, m_first.data(), m_count.data(), static_cast<GLsizei>(m_count.size()));
+	}
+
+private:
+	void set(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount)
+	{
+		m_mode = mode;
+		m_first.assign(first, first + drawcount);
+		m_count.assign(count, count + drawcount);
+	}
+
+	GLenum m_mode;
+	std::vector<GLint> m_first;
+	std::vector<GLsizei> m_count;
+};
+
+class GlMultiDrawElementsBaseVertexCommand : public OpenGlCommand
+{
+public:
+	GlMultiDrawElementsBaseVertexCommand() :
+		OpenGlCommand(false, false, "glMultiDrawElementsBaseVertex")
+	{
+	}
+
+	static std::shared_ptr<OpenGlCommand> get(GLenum mode, const GLsizei *count, GLenum type, const void *const*indices,
+		GLsizei drawcount, const GLint *basevertex)
+	{
+		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
+		auto ptr = getFromPool<GlMultiDrawElementsBaseVertexCommand>(poolId);
+		ptr->set(mode, count, type, indices, drawcount, basevertex);
+		return ptr;
+	}
+
+	void commandToExecute() override
+	{
+		ptrMultiDrawElementsBaseVertex(m_mode, m_count.data(), m_type, m_indices.data(),
+			static_cast<GLsizei>(m_count.size()), m_basevertex.data());
+	}
+
+private:
+	void set(GLenum mode, const GLsizei *count, GLenum type, const void *const*indices, GLsizei drawcount,
+		const GLint *basevertex)
+	{
+		m_mode = mode;
+		m_count.assign(count, count + drawcount);
+		m_type = type;
+		m_indices.assign(indices, indices + drawcount);
+		m_basevertex.assign(basevertex, basevertex + drawcount);
+	}
+
+	GLenum m_mode;
+	std::vector<GLsizei> m_count;
+	GLenum m_type;
+	std::vector<const void*> m_indices;
+	std::vector<GLint> m_basevertex;
+};
+
 class GlFlushMappedBufferRangeCommand : public OpenGlCommand
 {
 public:
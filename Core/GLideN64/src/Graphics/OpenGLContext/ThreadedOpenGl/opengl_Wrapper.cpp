@@ -20,6 +20,7 @@ namespace opengl {
 	bool FunctionWrapper::m_shutdown = false;
 	int FunctionWrapper::m_swapBuffersQueued = 0;
 	bool FunctionWrapper::m_fastVertexAttributes = false;
+	PendingDraws * FunctionWrapper::m_pendingDraws = nullptr;
 	std::thread FunctionWrapper::m_commandExecutionThread;
 	std::mutex FunctionWrapper::m_condvarMutex;
 	std::condition_variable FunctionWrapper::m_condition;
@@ -158,6 +159,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBlendFunc(GLenum sfactor, GLenum dfactor)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBlendFuncCommand::get(sfactor, dfactor));
 		else
@@ -166,6 +168,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBlendFuncSeparate(GLenum sfactorcolor, GLenum dfactorcolor, GLenum sfactoralpha, GLenum dfactoralpha)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBlendFuncSeparateCommand::get(sfactorcolor, dfactorcolor, sfactoralpha, dfactoralpha));
 		else
@@ -175,6 +178,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrPixelStorei(GLenum pname, GLint param)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlPixelStoreiCommand::get(pname, param));
 		else
@@ -183,6 +187,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlClearColorCommand::get(red, green, blue, alpha));
 		else
@@ -191,6 +196,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCullFace(GLenum mode)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlCullFaceCommand::get(mode));
 		else
@@ -199,6 +205,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDepthFunc(GLenum func)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDepthFuncCommand::get(func));
 		else
@@ -207,6 +214,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDepthMask(GLboolean flag)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDepthMaskCommand::get(flag));
 		else
@@ -215,6 +223,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDisable(GLenum cap)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDisableCommand::get(cap));
 		else
@@ -223,6 +232,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrEnable(GLenum cap)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlEnableCommand::get(cap));
 		else
@@ -231,6 +241,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDisablei(GLenum target, GLuint index)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDisableiCommand::get(target, index));
 		else
@@ -239,6 +250,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrEnablei(GLenum target, GLuint index)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlEnableiCommand::get(target, index));
 		else
@@ -247,6 +259,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrPolygonOffset(GLfloat factor, GLfloat units)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlPolygonOffsetCommand::get(factor, units));
 		else
@@ -255,6 +268,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrScissor(GLint x, GLint y, GLsizei width, GLsizei height)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlScissorCommand::get(x, y, width, height));
 		else
@@ -263,6 +277,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlViewportCommand::get(x, y, width, height));
 		else
@@ -271,6 +286,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindTexture(GLenum target, GLuint texture)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindTextureCommand::get(target, texture));
 		else
@@ -279,6 +295,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			int totalBytes = getTextureBytes(format, type, width, height);
 
@@ -300,6 +317,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexParameteri(GLenum target, GLenum pname, GLint param)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTexParameteriCommand::get(target, pname, param));
 		else
@@ -308,6 +326,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetIntegerv(GLenum pname, GLint* data)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetIntegervCommand::get(pname, data));
 		else
@@ -316,6 +335,7 @@ namespace opengl {
 
 	const GLubyte* FunctionWrapper::wrGetString(GLenum name)
 	{
+		flushPendingDraws();
 		const GLubyte* returnValue;
 
 		if (m_threaded_wrapper)
@@ -328,6 +348,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			if (pixels == nullptr) {
 				GlReadPixelsAsyncCommand::setBoundBuffer(GlBindBufferCommand::getBoundBuffer(GL_PIXEL_PACK_BUFFER));
@@ -341,11 +362,14 @@ namespace opengl {
 
 	void  FunctionWrapper::wrTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			int totalBytes = getTextureBytes(format, type, width, height);
 
 			PoolBufferPointer data;
-			if (totalBytes > 0 && pixels != nullptr) {
+			// With an unpack buffer bound pixels is an offset into it, pass it on as is
+			const bool unpackBuffer = GlBindBufferCommand::getBoundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+			if (totalBytes > 0 && pixels != nullptr && !unpackBuffer) {
 				data = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(pixels), totalBytes);
 			}
 
@@ -353,13 +377,15 @@ namespace opengl {
 				LOG(LOG_ERROR, "INVALID TEXTURE: format=%d type=%d total=%d", format, type, totalBytes);
 			}
 
-			executeCommand(GlTexSubImage2DUnbufferedCommand::get(target, level, xoffset, yoffset, width, height, format, type, data));
+			executeCommand(GlTexSubImage2DUnbufferedCommand::get(target, level, xoffset, yoffset, width, height, format, type, data,
+				unpackBuffer ? pixels : nullptr));
 		} else
 			ptrTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
 	}
 
 	void FunctionWrapper::wrDrawArrays(GLenum mode, GLint first, GLsizei count)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			if (m_fastVertexAttributes) {
 				executeCommand(GlDrawArraysCommand::get(mode, first, count));
@@ -375,6 +401,7 @@ namespace opengl {
 
 	GLenum FunctionWrapper::wrGetError()
 	{
+		flushPendingDraws();
 #ifdef GL_DEBUG
 		GLenum returnValue;
 
@@ -391,6 +418,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
 	{
+		flushPendingDraws();
 		if (!m_threaded_wrapper) {
 			ptrDrawElements(mode, count, type, indices);
 			return;
@@ -442,6 +470,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrLineWidth(GLfloat width)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlLineWidthCommand::get(width));
 		else
@@ -450,6 +479,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrClear(GLbitfield mask)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlClearCommand::get(mask));
 		else
@@ -458,6 +488,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrClearBufferfv(GLenum buffer, GLint drawbuffer, const GLfloat *value)
 	{
+		flushPendingDraws();
 		if (!m_threaded_wrapper) {
 			ptrClearBufferfv(buffer, drawbuffer, value);
 			return;
@@ -483,6 +514,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetFloatv(GLenum pname, GLfloat* data)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGetFloatvCommand::get(pname, data));
 		else
@@ -491,6 +523,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteTextures(GLsizei n, const GLuint *textures)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer texture = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(textures), n*sizeof(GLuint));
 			executeCommand(GlDeleteTexturesCommand::get(n, texture));
@@ -501,6 +534,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGenTextures(GLsizei n, GLuint* textures)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGenTexturesCommand::get(n, textures));
 		else
@@ -509,6 +543,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexParameterf(GLenum target, GLenum pname, GLfloat param)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTexParameterfCommand::get(target, pname, param));
 		else
@@ -517,6 +552,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrActiveTexture(GLenum texture)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlActiveTextureCommand::get(texture));
 		else
@@ -525,6 +561,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBlendColorCommand::get(red, green, blue, alpha));
 		else
@@ -533,6 +570,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrReadBuffer(GLenum src)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlReadBufferCommand::get(src));
 		else
@@ -541,6 +579,7 @@ namespace opengl {
 
 	GLuint FunctionWrapper::wrCreateShader(GLenum type)
 	{
+		flushPendingDraws();
 		GLuint returnValue;
 
 		if (m_threaded_wrapper)
@@ -553,6 +592,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCompileShader(GLuint shader)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlCompileShaderCommand::get(shader));
 		else
@@ -561,6 +601,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrShaderSource(GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			std::vector<std::string> stringData(count);
 
@@ -583,6 +624,7 @@ namespace opengl {
 
 	GLuint FunctionWrapper::wrCreateProgram()
 	{
+		flushPendingDraws();
 		GLuint returnValue;
 
 		if (m_threaded_wrapper)
@@ -595,6 +637,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrAttachShader(GLuint program, GLuint shader)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlAttachShaderCommand::get(program, shader));
 		else
@@ -603,6 +646,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrLinkProgram(GLuint program)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlLinkProgramCommand::get(program));
 		else
@@ -611,6 +655,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUseProgram(GLuint program)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUseProgramCommand::get(program));
 		else
@@ -619,6 +664,7 @@ namespace opengl {
 
 	GLint FunctionWrapper::wrGetUniformLocation(GLuint program, const GLchar *name)
 	{
+		flushPendingDraws();
 		GLint returnValue;
 
 		if (m_threaded_wrapper)
@@ -631,6 +677,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform1i(GLint location, GLint v0)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform1iCommand::get(location, v0));
 		else
@@ -639,6 +686,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform1f(GLint location, GLfloat v0)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform1fCommand::get(location, v0));
 		else
@@ -647,6 +695,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform2f(GLint location, GLfloat v0, GLfloat v1)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform2fCommand::get(location, v0, v1));
 		else
@@ -655,6 +704,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform2i(GLint location, GLint v0, GLint v1)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform2iCommand::get(location, v0, v1));
 		else
@@ -663,6 +713,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform4iCommand::get(location, v0, v1, v2, v3));
 		else
@@ -672,6 +723,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniform4fCommand::get(location, v0, v1, v2, v3));
 		else
@@ -680,6 +732,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform3fv(GLint location, GLsizei count, const GLfloat *value)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(value), 3 * sizeof(GLfloat) * count);
 			executeCommand(GlUniform3fvCommand::get(location, count, values));
@@ -689,6 +742,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform4fv(GLint location, GLsizei count, const GLfloat *value)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(value), 4 * sizeof(GLfloat) * count);
 			executeCommand(GlUniform4fvCommand::get(location, count, values));
@@ -698,6 +752,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDetachShader(GLuint program, GLuint shader)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDetachShaderCommand::get(program, shader));
 		else
@@ -706,6 +761,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteShader(GLuint shader)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDeleteShaderCommand::get(shader));
 		else
@@ -714,6 +770,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteProgram(GLuint program)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDeleteProgramCommand::get(program));
 		else
@@ -722,6 +779,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar *infoLog)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetProgramInfoLogCommand::get(program, bufSize, length, infoLog));
 		else
@@ -730,6 +788,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar *infoLog)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetShaderInfoLogCommand::get(shader, bufSize, length, infoLog));
 		else
@@ -738,6 +797,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetShaderiv(GLuint shader, GLenum pname, GLint* params)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetShaderivCommand::get(shader, pname, params));
 		else
@@ -746,6 +806,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetProgramiv(GLuint program, GLenum pname, GLint* params)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetProgramivCommand::get(program, pname, params));
 		else
@@ -754,6 +815,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrEnableVertexAttribArray(GLuint index)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			GlVertexAttribPointerManager::enableVertexAttributeIndex(index);
 			executeCommand(GlEnableVertexAttribArrayCommand::get(index));
@@ -764,6 +826,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDisableVertexAttribArray(GLuint index)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			GlVertexAttribPointerManager::disableVertexAttributeIndex(index);
 			executeCommand(GlDisableVertexAttribArrayCommand::get(index));
@@ -773,6 +836,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			if (m_fastVertexAttributes) {
 				executeCommand(GlVertexAttribPointerBufferedCommand::get(index, size, type, normalized, stride, pointer));
@@ -787,6 +851,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindAttribLocation(GLuint program, GLuint index, const GLchar *name)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindAttribLocationCommand::get(program, index, name));
 		else
@@ -795,6 +860,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrVertexAttrib1f(GLuint index, GLfloat x)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlVertexAttrib1fCommand::get(index, x));
 		else
@@ -803,6 +869,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlVertexAttrib4fCommand::get(index, x, y, z, w));
 		else
@@ -811,6 +878,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrVertexAttrib4fv(GLuint index, const GLfloat *v)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(v), 4 * sizeof(GLfloat));
 			executeCommand(GlVertexAttrib4fvCommand::get(index, values));
@@ -820,6 +888,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDepthRangef(GLfloat n, GLfloat f)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDepthRangefCommand::get(n, f));
 		else
@@ -828,6 +897,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrClearDepthf(GLfloat d)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlClearDepthfCommand::get(d));
 		else
@@ -836,6 +906,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDrawBuffers(GLsizei n, const GLenum *bufs)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer bufsPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(bufs), n*sizeof(GLenum));
 			executeCommand(GlDrawBuffersCommand::get(n, bufsPtr));
@@ -845,6 +916,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGenFramebuffers(GLsizei n, GLuint* framebuffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGenFramebuffersCommand::get(n, framebuffers));
 		else
@@ -853,6 +925,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindFramebuffer(GLenum target, GLuint framebuffer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindFramebufferCommand::get(target, framebuffer));
 		else
@@ -861,6 +934,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer framebuffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(framebuffers), n*sizeof(GLuint));
 			executeCommand(GlDeleteFramebuffersCommand::get(n, framebuffersPtr));
@@ -870,6 +944,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlFramebufferTexture2DCommand::get(target, attachment, textarget, texture, level));
 		else
@@ -878,6 +953,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexImage2DMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTexImage2DMultisampleCommand::get(target, samples, internalformat, width, height, fixedsamplelocations));
 		else
@@ -886,6 +962,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexStorage2DMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTexStorage2DMultisampleCommand::get(target, samples, internalformat, width, height, fixedsamplelocations));
 		else
@@ -894,6 +971,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGenRenderbuffersCommand::get(n, renderbuffers));
 		else
@@ -902,6 +980,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindRenderbuffer(GLenum target, GLuint renderbuffer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindRenderbufferCommand::get(target, renderbuffer));
 		else
@@ -910,6 +989,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlRenderbufferStorageCommand::get(target, internalformat, width, height));
 		else
@@ -918,6 +998,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer renderbuffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(renderbuffers), n*sizeof(GLuint));
 			executeCommand(GlDeleteRenderbuffersCommand::get(n, renderbuffersPtr));
@@ -927,6 +1008,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlFramebufferRenderbufferCommand::get(target, attachment, renderbuffertarget, renderbuffer));
 		else
@@ -935,6 +1017,7 @@ namespace opengl {
 
 	GLenum FunctionWrapper::wrCheckFramebufferStatus(GLenum target)
 	{
+		flushPendingDraws();
 #ifdef GL_DEBUG
 		GLenum returnValue;
 
@@ -951,6 +1034,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBlitFramebufferCommand::get(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter));
 		else
@@ -959,6 +1043,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGenVertexArrays(GLsizei n, GLuint* arrays)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGenVertexArraysCommand::get(n, arrays));
 		else
@@ -967,6 +1052,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindVertexArray(GLuint array)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindVertexArrayCommand::get(array));
 		else
@@ -975,6 +1061,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteVertexArrays(GLsizei n, const GLuint *arrays)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer arraysPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(arrays), n*sizeof(GLuint));
 			executeCommand(GlDeleteVertexArraysCommand::get(n, arraysPtr));
@@ -984,6 +1071,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGenBuffers(GLsizei n, GLuint* buffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlGenBuffersCommand::get(n, buffers));
 		else
@@ -992,6 +1080,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindBuffer(GLenum target, GLuint buffer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			GlBindBufferCommand::setBoundBuffer(target, buffer);
 			executeCommand(GlBindBufferCommand::get(target, buffer));
@@ -1002,6 +1091,7 @@ namespace opengl {
 
 	void  FunctionWrapper::wrBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER)
 				m_fastVertexAttributes = true;
@@ -1018,6 +1108,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrMapBuffer(GLenum target, GLenum access)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlMapBufferCommand::get(target, access));
 		else
@@ -1026,6 +1117,7 @@ namespace opengl {
 
 	void* FunctionWrapper::wrMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
 	{
+		flushPendingDraws();
 		void* returnValue;
 
 		if (m_threaded_wrapper) {
@@ -1053,6 +1145,7 @@ namespace opengl {
 
 	GLboolean FunctionWrapper::wrUnmapBuffer(GLenum target)
 	{
+		flushPendingDraws();
 		GLboolean returnValue = GL_TRUE;
 
 		if (m_threaded_wrapper) {
@@ -1080,6 +1173,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteBuffers(GLsizei n, const GLuint *buffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer buffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(buffers), n*sizeof(GLuint));
 			executeCommand(GlDeleteBuffersCommand::get(n, buffersPtr));
@@ -1090,6 +1184,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindImageTextureCommand::get(unit, texture, level, layered, layer, access, format));
 		else
@@ -1098,6 +1193,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrMemoryBarrier(GLbitfield barriers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlMemoryBarrierCommand::get(barriers));
 		else
@@ -1106,6 +1202,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTextureBarrier()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureBarrierCommand::get());
 		else
@@ -1114,6 +1211,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTextureBarrierNV()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureBarrierNVCommand::get());
 		else
@@ -1122,6 +1220,7 @@ namespace opengl {
 
 	const GLubyte* FunctionWrapper::wrGetStringi(GLenum name, GLuint index)
 	{
+		flushPendingDraws();
 		const GLubyte* returnValue;
 
 		if (m_threaded_wrapper)
@@ -1134,6 +1233,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum *attachments)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer attachmentsPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(attachments), numAttachments*sizeof(GLenum));
 			executeCommand(GlInvalidateFramebufferCommand::get(target, numAttachments, attachmentsPtr));
@@ -1143,6 +1243,7 @@ namespace opengl {
 
 	void  FunctionWrapper::wrBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER)
 				m_fastVertexAttributes = true;
@@ -1159,26 +1260,34 @@ namespace opengl {
 
 	GLsync FunctionWrapper::wrFenceSync(GLenum condition, GLbitfield flags)
 	{
+		flushPendingDraws();
 		GLsync returnValue;
 
+		// Not a priority command: the fence must follow the commands queued before it
 		if (m_threaded_wrapper)
-			executePriorityCommand(GlFenceSyncCommand::get(condition, flags, returnValue));
+			executeCommand(GlFenceSyncCommand::get(condition, flags, returnValue));
 		else
 			returnValue = ptrFenceSync(condition, flags);
 
 		return returnValue;
 	}
 
-	void FunctionWrapper::wrClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	GLenum FunctionWrapper::wrClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
 	{
+		flushPendingDraws();
+		GLenum returnValue;
+
 		if (m_threaded_wrapper)
-			executePriorityCommand(GlClientWaitSyncCommand::get(sync, flags, timeout));
+			executePriorityCommand(GlClientWaitSyncCommand::get(sync, flags, timeout, returnValue));
 		else
-			ptrClientWaitSync(sync, flags, timeout);
+			returnValue = ptrClientWaitSync(sync, flags, timeout);
+
+		return returnValue;
 	}
 
 	void FunctionWrapper::wrDeleteSync(GLsync sync)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDeleteSyncCommand::get(sync));
 		else
@@ -1187,6 +1296,7 @@ namespace opengl {
 
 	GLuint FunctionWrapper::wrGetUniformBlockIndex(GLuint program, GLchar *uniformBlockName)
 	{
+		flushPendingDraws();
 		GLuint returnValue;
 
 		if (m_threaded_wrapper)
@@ -1199,6 +1309,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlUniformBlockBindingCommand::get(program, uniformBlockIndex, uniformBlockBinding));
 		else
@@ -1207,6 +1318,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetActiveUniformBlockivCommand::get(program, uniformBlockIndex, pname, params));
 		else
@@ -1215,6 +1327,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetUniformIndices(GLuint program, GLsizei uniformCount, const GLchar *const*uniformNames, GLuint* uniformIndices)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetUniformIndicesCommand::get(program, uniformCount, uniformNames, uniformIndices));
 		else
@@ -1223,6 +1336,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetActiveUniformsiv(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices, GLenum pname, GLint* params)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetActiveUniformsivCommand::get(program, uniformCount, uniformIndices, pname, params));
 		else
@@ -1231,6 +1345,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrBindBufferBase(GLenum target, GLuint index, GLuint buffer)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlBindBufferBaseCommand::get(target, index, buffer));
 		else
@@ -1239,6 +1354,7 @@ namespace opengl {
 
 	void  FunctionWrapper::wrBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer dataPtr;
 			if (data != nullptr) {
@@ -1252,6 +1368,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void *binary)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlGetProgramBinaryCommand::get(program, bufSize, length, binaryFormat, binary));
 		else
@@ -1260,6 +1377,7 @@ namespace opengl {
 
 	void  FunctionWrapper::wrProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer binaryPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(binary), length);
 			executeCommand(GlProgramBinaryCommand::get(program, binaryFormat, binaryPtr, length));
@@ -1269,6 +1387,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrProgramParameteri(GLuint program, GLenum pname, GLint value)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlProgramParameteriCommand::get(program, pname, value));
 		else
@@ -1277,6 +1396,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTexStorage2DCommand::get(target, levels, internalformat, width, height));
 		else
@@ -1285,6 +1405,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTextureStorage2D(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureStorage2DCommand::get(texture, levels, internalformat, width, height));
 		else
@@ -1293,10 +1414,13 @@ namespace opengl {
 
 	void  FunctionWrapper::wrTextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			PoolBufferPointer data;
 			int totalBytes = getTextureBytes(format, type, width, height);
-			if (totalBytes > 0 && pixels != nullptr) {
+			// With an unpack buffer bound pixels is an offset into it, pass it on as is
+			const bool unpackBuffer = GlBindBufferCommand::getBoundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+			if (totalBytes > 0 && pixels != nullptr && !unpackBuffer) {
 				data = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(pixels), totalBytes);
 			}
 
@@ -1305,13 +1429,14 @@ namespace opengl {
 			}
 
 			executeCommand(GlTextureSubImage2DUnbufferedCommand::get(texture, level, xoffset, yoffset,
-				width, height, format, type, data));
+				width, height, format, type, data, unpackBuffer ? pixels : nullptr));
 		} else
 			ptrTextureSubImage2D(texture, level, xoffset, yoffset, width, height, format, type, pixels);
 	}
 
 	void FunctionWrapper::wrTextureStorage2DMultisample(GLuint texture, GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureStorage2DMultisampleCommand::get(texture, target, samples, internalformat, width, height, fixedsamplelocations));
 		else
@@ -1320,6 +1445,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTextureParameteri(GLuint texture, GLenum pname, GLint param)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureParameteriCommand::get(texture, pname, param));
 		else
@@ -1328,6 +1454,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrTextureParameterf(GLuint texture, GLenum pname, GLfloat param)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlTextureParameterfCommand::get(texture, pname, param));
 		else
@@ -1336,6 +1463,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCreateTextures(GLenum target, GLsizei n, GLuint* textures)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlCreateTexturesCommand::get(target, n, textures));
 		else
@@ -1344,6 +1472,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCreateBuffers(GLsizei n, GLuint* buffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlCreateBuffersCommand::get(n, buffers));
 		else
@@ -1352,6 +1481,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCreateFramebuffers(GLsizei n, GLuint* framebuffers)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executePriorityCommand(GlCreateFramebuffersCommand::get(n, framebuffers));
 		else
@@ -1360,6 +1490,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrNamedFramebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlNamedFramebufferTextureCommand::get(framebuffer, attachment, texture, level));
 		else
@@ -1369,14 +1500,35 @@ namespace opengl {
 	void FunctionWrapper::wrDrawRangeElementsBaseVertex(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type,
 		const u16* indices, GLint basevertex)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDrawRangeElementsBaseVertexCommand::get(mode, start, end, count, type, indices, basevertex));
 		else
 			ptrDrawRangeElementsBaseVertex(mode, start, end, count, type, indices, basevertex);
 	}
 
+	void FunctionWrapper::wrMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount)
+	{
+		flushPendingDraws();
+		if (m_threaded_wrapper)
+			executeCommand(GlMultiDrawArraysCommand::get(mode, first, count, drawcount));
+		else
+			ptrMultiDrawArrays(mode, first, count, drawcount);
+	}
+
+	void FunctionWrapper::wrMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type, const void *const*indices,
+		GLsizei drawcount, const GLint *basevertex)
+	{
+		flushPendingDraws();
+		if (m_threaded_wrapper)
+			executeCommand(GlMultiDrawElementsBaseVertexCommand::get(mode, count, type, indices, drawcount, basevertex));
+		else
+			ptrMultiDrawElementsBaseVertex(mode, count, type, indices, drawcount, basevertex);
+	}
+
 	void FunctionWrapper::wrFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlFlushMappedBufferRangeCommand::get(target, offset, length));
 		else
@@ -1385,6 +1537,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrFinish()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlFinishCommand::get());
 		else
@@ -1393,6 +1546,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrFlush()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlFlushCommand::get());
 		else
@@ -1401,6 +1555,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlCopyTexImage2DCommand::get(target, level, internalformat, x, y, width, height, border));
 		else
@@ -1409,6 +1564,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDebugMessageCallback(GLDEBUGPROC callback, const void *userParam)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDebugMessageCallbackCommand::get(callback, userParam));
 		else
@@ -1417,6 +1573,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrDebugMessageControl(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlDebugMessageControlCommand::get(source, type, severity, count, ids, enabled));
 		else
@@ -1425,6 +1582,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrEGLImageTargetTexture2DOES(GLenum target, void* image)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlEGLImageTargetTexture2DOESCommand::get(target, image));
 		else
@@ -1433,6 +1591,7 @@ namespace opengl {
 
 	void FunctionWrapper::wrEGLImageTargetRenderbufferStorageOES(GLenum target, void* image)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(GlEGLImageTargetRenderbufferStorageOESCommand::get(target, image));
 		else
@@ -1442,6 +1601,7 @@ namespace opengl {
 #if defined(OS_ANDROID)
 	EGLClientBuffer FunctionWrapper::ewrGetNativeClientBufferANDROID(const AHardwareBuffer *buffer)
 	{
+		flushPendingDraws();
 		EGLClientBuffer returnValue;
 
 		if (m_threaded_wrapper)
@@ -1457,6 +1617,7 @@ namespace opengl {
 #ifdef MUPENPLUSAPI
 	m64p_error FunctionWrapper::CoreVideo_Init()
 	{
+		flushPendingDraws();
 		m64p_error returnValue;
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoInitCommand::get(returnValue));
@@ -1467,6 +1628,7 @@ namespace opengl {
 
 	void FunctionWrapper::CoreVideo_Quit()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			executeCommand(CoreVideoQuitCommand::get());
 			executeCommand(ShutdownCommand::get());
@@ -1486,6 +1648,7 @@ namespace opengl {
 
 	m64p_error FunctionWrapper::CoreVideo_SetVideoMode(int screenWidth, int screenHeight, int bitsPerPixel, m64p_video_mode mode, m64p_video_flags flags)
 	{
+		flushPendingDraws();
 		m64p_error returnValue;
 
 		if (m_threaded_wrapper)
@@ -1498,6 +1661,7 @@ namespace opengl {
 
 	m64p_error FunctionWrapper::CoreVideo_SetVideoModeWithRate(int screenWidth, int screenHeight, int refreshRate, int bitsPerPixel, m64p_video_mode mode, m64p_video_flags flags)
 	{
+		flushPendingDraws();
 		m64p_error returnValue;
 
 		if (m_threaded_wrapper)
@@ -1510,6 +1674,7 @@ namespace opengl {
 
 	void FunctionWrapper::CoreVideo_GL_SetAttribute(m64p_GLattr attribute, int value)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoGLSetAttributeCommand::get(attribute, value));
 		else
@@ -1518,6 +1683,7 @@ namespace opengl {
 
 	void FunctionWrapper::CoreVideo_GL_GetAttribute(m64p_GLattr attribute, int *value)
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoGLGetAttributeCommand::get(attribute, value));
 		else
@@ -1526,6 +1692,7 @@ namespace opengl {
 
 	void FunctionWrapper::CoreVideo_GL_SwapBuffers()
 	{
+		flushPendingDraws();
 		++m_swapBuffersQueued;
 
 		if (m_threaded_wrapper)
@@ -1536,6 +1703,7 @@ namespace opengl {
 #else
 	bool FunctionWrapper::windowsStart()
 	{
+		flushPendingDraws();
 		bool returnValue;
 
 		if (m_threaded_wrapper)
@@ -1548,6 +1716,7 @@ namespace opengl {
 
 	void FunctionWrapper::windowsStop()
 	{
+		flushPendingDraws();
 		if (m_threaded_wrapper) {
 			executeCommand(WindowsStopCommand::get());
 			executeCommand(ShutdownCommand::get());
@@ -1566,6 +1735,7 @@ namespace opengl {
 
 	void FunctionWrapper::windowsSwapBuffers()
 	{
+		flushPendingDraws();
 		++m_swapBuffersQueued;
 
 		if (m_threaded_wrapper)
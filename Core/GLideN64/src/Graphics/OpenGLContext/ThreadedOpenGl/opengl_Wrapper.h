@@ -15,10 +15,32 @@ using namespace moodycamel;
 
 namespace opengl {
 
+	// Draws held back so that the next compatible draw can be merged with them.
+	class PendingDraws
+	{
+	public:
+		virtual ~PendingDraws() {}
+		virtual void submit() = 0;
+	};
+
 	class FunctionWrapper
 	{
     public:
 		static void commandLoop();
+
+		// Every wrapped call submits the pending draws before it runs,
+		// so GL always sees commands in the order they were issued.
+		static void setPendingDraws(PendingDraws * _draws) { m_pendingDraws = _draws; }
+
+		static void flushPendingDraws()
+		{
+			if (m_pendingDraws != nullptr) {
+				PendingDraws * draws = m_pendingDraws;
+				m_pendingDraws = nullptr;
+				draws->submit();
+			}
+		}
+
 	private:
 		static void executeCommand(std::shared_ptr<OpenGlCommand> _command);
 
@@ -32,6 +54,7 @@ namespace opengl {
 		static bool m_shutdown;
 		static int m_swapBuffersQueued;
 		static bool m_fastVertexAttributes;
+		static PendingDraws * m_pendingDraws;
 		static std::thread m_commandExecutionThread;
 		static std::mutex m_condvarMutex;
 		static std::condition_variable m_condition;
@@ -164,7 +187,7 @@ namespace opengl {
 		static void wrInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum *attachments);
 		static void wrBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
 		static GLsync wrFenceSync(GLenum condition, GLbitfield flags);
-		static void wrClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+		static GLenum wrClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
 		static void wrDeleteSync(GLsync sync);
 
 		static GLuint wrGetUniformBlockIndex(GLuint program, GLchar *uniformBlockName);
@@ -190,6 +213,8 @@ namespace opengl {
 		static void wrCreateFramebuffers(GLsizei n, GLuint* framebuffers);
 		static void wrNamedFramebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level);
 		static void wrDrawRangeElementsBaseVertex(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const u16* indices, GLint basevertex);
+		static void wrMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount);
+		static void wrMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type, const void *const*indices, GLsizei drawcount, const GLint *basevertex);
 		static void wrFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length);
 		static void wrFinish();
 		static void wrFlush();
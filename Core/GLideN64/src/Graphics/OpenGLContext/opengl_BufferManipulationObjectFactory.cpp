@@ -192,6 +192,170 @@ private:
 	CachedBindBuffer * m_bind;
 };
 
+/*---------------CreatePixelWriteBuffer-------------*/
+
+// Each fill maps the next free range of the buffer unsynchronized. When the
+// buffer is used up it is orphaned, so the driver hands out new storage
+// while earlier uploads from it are still pending.
+class PBOWriteBuffer : public graphics::PixelWriteBuffer
+{
+public:
+	PBOWriteBuffer(CachedBindBuffer * _bind, size_t _maxWriteSize)
+		: m_bind(_bind)
+		, m_size(_maxWriteSize * 2)
+		, m_offset(0)
+		, m_mapOffset(0)
+	{
+		glGenBuffers(1, &m_PBO);
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle(m_PBO));
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle::null);
+	}
+
+	~PBOWriteBuffer() {
+		glDeleteBuffers(1, &m_PBO);
+		m_PBO = 0;
+	}
+
+	void * getWriteBuffer(size_t _size) override
+	{
+		if (_size > m_size)
+			return nullptr;
+
+		if (m_offset + _size > m_size) {
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+			m_offset = 0;
+		}
+		m_mapOffset = m_offset;
+		m_offset = (m_offset + _size + 63) & ~size_t(63);
+		return glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, m_mapOffset, _size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	}
+
+	const u8 * closeWriteBuffer() override
+	{
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		return reinterpret_cast<const u8*>(m_mapOffset);
+	}
+
+	void bind() override {
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle(m_PBO));
+	}
+
+	void unbind() override {
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle::null);
+	}
+
+private:
+	CachedBindBuffer * m_bind;
+	size_t m_size;
+	size_t m_offset;
+	size_t m_mapOffset;
+	GLuint m_PBO;
+};
+
+// Persistently mapped ring of four segments, each as large as the biggest
+// fill. A segment is fenced when the writer leaves it, and only its own
+// fence is waited on before it is written again, so consecutive uploads
+// share one fence and never wait on the ones just issued.
+class PBOWriteRing : public graphics::PixelWriteBuffer
+{
+public:
+	static bool Check(const GLInfo & _glinfo) {
+		return _glinfo.bufferStorage;
+	}
+
+	PBOWriteRing(CachedBindBuffer * _bind, size_t _maxWriteSize)
+		: m_bind(_bind)
+		, m_segmentSize((_maxWriteSize + 63) & ~size_t(63))
+		, m_offset(0)
+		, m_mapOffset(0)
+		, m_segment(0)
+	{
+		for (GLsync & fence : m_fences)
+			fence = nullptr;
+		glGenBuffers(1, &m_PBO);
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle(m_PBO));
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_segmentSize * m_segmentsCount, nullptr, flags);
+		m_data = (GLubyte*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_segmentSize * m_segmentsCount, flags);
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle::null);
+	}
+
+	~PBOWriteRing() {
+		for (GLsync & fence : m_fences) {
+			if (fence != nullptr)
+				glDeleteSync(fence);
+		}
+		glDeleteBuffers(1, &m_PBO);
+		m_PBO = 0;
+	}
+
+	void * getWriteBuffer(size_t _size) override
+	{
+		if (_size > m_segmentSize || m_data == nullptr)
+			return nullptr;
+
+		if (m_offset + _size > (m_segment + 1) * m_segmentSize) {
+			if (m_fences[m_segment] != nullptr)
+				glDeleteSync(m_fences[m_segment]);
+			m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			m_segment = (m_segment + 1) % m_segmentsCount;
+			GLsync & fence = m_fences[m_segment];
+			if (fence != nullptr) {
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+			m_offset = m_segment * m_segmentSize;
+		}
+		m_mapOffset = m_offset;
+		m_offset = (m_offset + _size + 63) & ~size_t(63);
+		return m_data + m_mapOffset;
+	}
+
+	const u8 * closeWriteBuffer() override
+	{
+		return reinterpret_cast<const u8*>(m_mapOffset);
+	}
+
+	void bind() override {
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle(m_PBO));
+	}
+
+	void unbind() override {
+		m_bind->bind(graphics::Parameter(GL_PIXEL_UNPACK_BUFFER), graphics::ObjectHandle::null);
+	}
+
+private:
+	static const u32 m_segmentsCount = 4;
+	CachedBindBuffer * m_bind;
+	size_t m_segmentSize;
+	size_t m_offset;
+	size_t m_mapOffset;
+	u32 m_segment;
+	GLsync m_fences[m_segmentsCount];
+	GLubyte * m_data;
+	GLuint m_PBO;
+};
+
+template<typename T>
+class CreatePixelWriteBufferT : public CreatePixelWriteBuffer
+{
+public:
+	CreatePixelWriteBufferT(CachedBindBuffer * _bind)
+		: m_bind(_bind) {
+	}
+
+	graphics::PixelWriteBuffer * createPixelWriteBuffer(size_t _sizeInBytes) override
+	{
+		return new T(m_bind, _sizeInBytes);
+	}
+
+private:
+	CachedBindBuffer * m_bind;
+};
+
 /*---------------BlitFramebuffers-------------*/
 
 class BlitFramebuffersImpl : public BlitFramebuffers
@@ -444,6 +608,17 @@ CreatePixelReadBuffer * BufferManipulationObjectFactory::createPixelReadBuffer()
 	return new CreatePixelReadBufferT<PBOReadBuffer>(m_cachedFunctions.getCachedBindBuffer());
 }
 
+CreatePixelWriteBuffer * BufferManipulationObjectFactory::createPixelWriteBuffer() const
+{
+	if (m_glInfo.isGLES2)
+		return nullptr;
+
+	if (PBOWriteRing::Check(m_glInfo))
+		return new CreatePixelWriteBufferT<PBOWriteRing>(m_cachedFunctions.getCachedBindBuffer());
+
+	return new CreatePixelWriteBufferT<PBOWriteBuffer>(m_cachedFunctions.getCachedBindBuffer());
+}
+
 graphics::FramebufferTextureFormats * BufferManipulationObjectFactory::getFramebufferTextureFormats() const
 {
 	if (FramebufferTextureFormatsOpenGL::Check(m_glInfo))
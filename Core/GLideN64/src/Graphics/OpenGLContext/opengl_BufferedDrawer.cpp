@@ -7,7 +7,8 @@
 using namespace graphics;
 using namespace opengl;
 
-const u32 BufferedDrawer::m_bufMaxSize = 8 * 1024 * 1024; // 8 MB
+const u32 BufferedDrawer::m_bufInitSize = 8 * 1024 * 1024; // 8 MB
+const u32 BufferedDrawer::m_bufMaxSize = 64 * 1024 * 1024; // 64 MB
 #ifndef GL_DEBUG
 const GLbitfield BufferedDrawer::m_bufAccessBits = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
 const GLbitfield BufferedDrawer::m_bufMapBits = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
@@ -20,40 +21,51 @@ BufferedDrawer::BufferedDrawer(const GLInfo & _glinfo, CachedVertexAttribArray *
 : m_glInfo(_glinfo)
 , m_cachedAttribArray(_cachedAttribArray)
 , m_bindBuffer(_bindBuffer)
+, m_batchDraws(_glinfo.bufferStorage && _glinfo.multiDraw)
 {
 	m_vertices.resize(VERTBUFF_SIZE);
 	/* Init buffers for rects */
 	glGenVertexArrays(1, &m_rectsBuffers.vao);
 	glBindVertexArray(m_rectsBuffers.vao);
-	_initBuffer(m_rectsBuffers.vbo, m_bufMaxSize);
+	_initBuffer(m_rectsBuffers.vbo, m_bufInitSize);
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::position, true);
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::texcoord0, true);
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::texcoord1, true);
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::barycoords, true);
-	glVertexAttribPointer(rectAttrib::position, 4, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, x)));
-	glVertexAttribPointer(rectAttrib::texcoord0, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, s0)));
-	glVertexAttribPointer(rectAttrib::texcoord1, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, s1)));
-	if (_glinfo.coverage)
-		glVertexAttribPointer(rectAttrib::barycoords, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, bc0)));
+	_setRectAttribPointers();
 
 	/* Init buffers for triangles */
 	glGenVertexArrays(1, &m_trisBuffers.vao);
 	glBindVertexArray(m_trisBuffers.vao);
-	_initBuffer(m_trisBuffers.vbo, m_bufMaxSize);
-	_initBuffer(m_trisBuffers.ebo, m_bufMaxSize);
+	_initBuffer(m_trisBuffers.vbo, m_bufInitSize);
+	_initBuffer(m_trisBuffers.ebo, m_bufInitSize);
 	m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::position, true);
 	m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::color, true);
 	m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::texcoord, true);
 	m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::modify, true);
 	m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::numlights, false);
+	if (_glinfo.coverage)
+		m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::barycoords, true);
+	_setTrisAttribPointers();
+}
+
+void BufferedDrawer::_setRectAttribPointers()
+{
+	glVertexAttribPointer(rectAttrib::position, 4, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, x)));
+	glVertexAttribPointer(rectAttrib::texcoord0, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, s0)));
+	glVertexAttribPointer(rectAttrib::texcoord1, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, s1)));
+	if (m_glInfo.coverage)
+		glVertexAttribPointer(rectAttrib::barycoords, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), (const GLvoid *)(offsetof(RectVertex, bc0)));
+}
+
+void BufferedDrawer::_setTrisAttribPointers()
+{
 	glVertexAttribPointer(triangleAttrib::position, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)(offsetof(Vertex, x)));
 	glVertexAttribPointer(triangleAttrib::color, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)(offsetof(Vertex, r)));
 	glVertexAttribPointer(triangleAttrib::texcoord, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)(offsetof(Vertex, s)));
 	glVertexAttribPointer(triangleAttrib::modify, 4, GL_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid *)(offsetof(Vertex, modify)));
-	if (_glinfo.coverage) {
-		m_cachedAttribArray->enableVertexAttribArray(triangleAttrib::barycoords, true);
+	if (m_glInfo.coverage)
 		glVertexAttribPointer(triangleAttrib::barycoords, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)(offsetof(Vertex, bc0)));
-	}
 }
 
 void BufferedDrawer::_initBuffer(Buffer & _buffer, GLuint _bufSize)
@@ -71,6 +83,10 @@ void BufferedDrawer::_initBuffer(Buffer & _buffer, GLuint _bufSize)
 
 BufferedDrawer::~BufferedDrawer()
 {
+	FunctionWrapper::flushPendingDraws();
+	_deleteFences(m_rectsBuffers.vbo);
+	_deleteFences(m_trisBuffers.vbo);
+	_deleteFences(m_trisBuffers.ebo);
 	m_bindBuffer->bind(Parameter(GL_ARRAY_BUFFER), ObjectHandle::null);
 	m_bindBuffer->bind(Parameter(GL_ELEMENT_ARRAY_BUFFER), ObjectHandle::null);
 	GLuint buffers[3] = { m_rectsBuffers.vbo.handle, m_trisBuffers.vbo.handle, m_trisBuffers.ebo.handle };
@@ -80,12 +96,107 @@ BufferedDrawer::~BufferedDrawer()
 	glDeleteVertexArrays(2, arrays);
 }
 
-void BufferedDrawer::_updateBuffer(Buffer & _buffer, u32 _count, u32 _dataSize, const void * _data)
+void BufferedDrawer::_deleteFences(Buffer & _buffer)
 {
-	if (_buffer.offset + _dataSize >= _buffer.size) {
-		_buffer.offset = 0;
-		_buffer.pos = 0;
+	for (GLsync & fence : _buffer.fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
+
+void BufferedDrawer::_resizeBuffer(Buffer & _buffer, GLuint _bufSize)
+{
+	// Draws already issued keep the old storage alive until they complete.
+	const GLuint oldHandle = _buffer.handle;
+	_deleteFences(_buffer);
+	_initBuffer(_buffer, _bufSize);
+	if (&_buffer == &m_rectsBuffers.vbo)
+		_setRectAttribPointers();
+	else if (&_buffer == &m_trisBuffers.vbo)
+		_setTrisAttribPointers();
+	glDeleteBuffers(1, &oldHandle);
+
+	_buffer.offset = 0;
+	_buffer.pos = 0;
+	_buffer.segment = 0;
+	_buffer.reusedSegments = 0;
+	_buffer.stalled = false;
+	if (&_buffer == &m_rectsBuffers.vbo)
+		m_rectBufferOffsets.clear();
+}
+
+void BufferedDrawer::_waitSegment(Buffer & _buffer, u32 _segment)
+{
+	GLsync & fence = _buffer.fences[_segment];
+	if (fence == nullptr)
+		return;
+
+	if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+		// The GPU is still reading a whole ring behind: grow on the next wrap.
+		_buffer.stalled = true;
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void BufferedDrawer::_reserveBuffer(Buffer & _buffer, u32 _dataSize)
+{
+	GLuint segmentSize = _buffer.size / m_segmentsCount;
+	if (_dataSize + _buffer.stride > segmentSize) {
+		GLuint bufSize = _buffer.size;
+		while (_dataSize + _buffer.stride > bufSize / m_segmentsCount)
+			bufSize *= 2;
+		_resizeBuffer(_buffer, bufSize);
+		return;
+	}
+
+	const u32 lastSegment = static_cast<u32>((_buffer.offset + _dataSize - 1) / segmentSize);
+	if (lastSegment == _buffer.segment)
+		return;
+
+	// Leaving the current segment: fence it, together with older segments whose
+	// data was drawn again since their own fence.
+	const u32 fencedSegments = _buffer.reusedSegments | (1U << _buffer.segment);
+	for (u32 i = 0; i < m_segmentsCount; ++i) {
+		if ((fencedSegments & (1U << i)) == 0)
+			continue;
+		if (_buffer.fences[i] != nullptr)
+			glDeleteSync(_buffer.fences[i]);
+		_buffer.fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 	}
+	_buffer.reusedSegments = 0;
+
+	u32 segment = _buffer.segment + 1;
+	if (segment == m_segmentsCount) {
+		if (_buffer.stalled && _buffer.size < m_bufMaxSize) {
+			_resizeBuffer(_buffer, _buffer.size * 2);
+			return;
+		}
+		_buffer.stalled = false;
+		segment = 0;
+	}
+
+	_waitSegment(_buffer, segment);
+	_buffer.segment = segment;
+	_buffer.offset = (segment * segmentSize + _buffer.stride - 1) / _buffer.stride * _buffer.stride;
+	_buffer.pos = static_cast<GLint>(_buffer.offset / _buffer.stride);
+
+	if (&_buffer == &m_rectsBuffers.vbo) {
+		for (auto iter = m_rectBufferOffsets.begin(); iter != m_rectBufferOffsets.end();) {
+			if ((iter->second * _buffer.stride - 1) / segmentSize == segment)
+				iter = m_rectBufferOffsets.erase(iter);
+			else
+				++iter;
+		}
+	}
+}
+
+void BufferedDrawer::_updateBuffer(Buffer & _buffer, u32 _count, u32 _dataSize, const void * _data)
+{
+	_reserveBuffer(_buffer, _dataSize);
 
 	if (m_glInfo.bufferStorage) {
 		memcpy(&_buffer.data[_buffer.offset], _data, _dataSize);
@@ -120,14 +231,13 @@ void BufferedDrawer::_updateRectBuffer(const graphics::Context::DrawRectParamete
 	auto iter = m_rectBufferOffsets.find(crc);
 	if (iter != m_rectBufferOffsets.end()) {
 		buffer.pos = iter->second;
+		const u32 segment = static_cast<u32>((buffer.pos * buffer.stride - 1) / (buffer.size / m_segmentsCount));
+		if (segment != buffer.segment)
+			buffer.reusedSegments |= 1U << segment;
 		return;
 	}
 
-	const GLintptr prevOffset = buffer.offset;
 	_updateBuffer(buffer, _params.verticesCount, dataSize, _params.vertices);
-	if (buffer.offset < prevOffset)
-		m_rectBufferOffsets.clear();
-
 	buffer.pos = static_cast<GLint>(buffer.offset / sizeof(RectVertex));
 	m_rectBufferOffsets[crc] = buffer.pos;
 }
@@ -140,7 +250,7 @@ void BufferedDrawer::drawRects(const graphics::Context::DrawRectParameters & _pa
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::texcoord0, _params.texrect);
 	m_cachedAttribArray->enableVertexAttribArray(rectAttrib::texcoord1, _params.texrect);
 
-	glDrawArrays(GLenum(_params.mode), m_rectsBuffers.vbo.pos - _params.verticesCount, _params.verticesCount);
+	_drawArrays(GLenum(_params.mode), m_rectsBuffers.vbo.pos - _params.verticesCount, _params.verticesCount);
 }
 
 void BufferedDrawer::_convertFromSPVertex(bool _flatColors, u32 _count, const SPVertex * _data)
@@ -200,16 +310,21 @@ void BufferedDrawer::drawTriangles(const graphics::Context::DrawTriangleParamete
 {
 	_updateTrianglesBuffers(_params);
 
-	if (isHWLightingAllowed())
-		glVertexAttrib1f(triangleAttrib::numlights, GLfloat(_params.vertices[0].HWLight));
+	if (isHWLightingAllowed()) {
+		const GLfloat numLights = GLfloat(_params.vertices[0].HWLight);
+		if (numLights != m_numLights) {
+			glVertexAttrib1f(triangleAttrib::numlights, numLights);
+			m_numLights = numLights;
+		}
+	}
 
 	if (config.frameBufferEmulation.N64DepthCompare != Config::dcCompatible) {
 		if (_params.elements == nullptr) {
-			glDrawArrays(GLenum(_params.mode), m_trisBuffers.vbo.pos - _params.verticesCount, _params.verticesCount);
+			_drawArrays(GLenum(_params.mode), m_trisBuffers.vbo.pos - _params.verticesCount, _params.verticesCount);
 			return;
 		}
 
-		glDrawRangeElementsBaseVertex(GLenum(_params.mode), 0, _params.verticesCount - 1, _params.elementsCount, GL_UNSIGNED_SHORT,
+		_drawElements(GLenum(_params.mode), _params.verticesCount - 1, _params.elementsCount,
 			(u16*)nullptr + m_trisBuffers.ebo.pos - _params.elementsCount, m_trisBuffers.vbo.pos - _params.verticesCount);
 		return;
 	}
@@ -240,6 +355,69 @@ void BufferedDrawer::drawTriangles(const graphics::Context::DrawTriangleParamete
 	}
 }
 
+void BufferedDrawer::DrawBatch::submit()
+{
+	const GLsizei drawCount = static_cast<GLsizei>(count.size());
+	if (indexed) {
+		if (drawCount == 1)
+			glDrawRangeElementsBaseVertex(mode, 0, lastVertex, count[0], GL_UNSIGNED_SHORT, (const u16*)indices[0], first[0]);
+		else
+			glMultiDrawElementsBaseVertex(mode, count.data(), GL_UNSIGNED_SHORT, indices.data(), drawCount, first.data());
+	} else {
+		if (drawCount == 1)
+			glDrawArrays(mode, first[0], count[0]);
+		else
+			glMultiDrawArrays(mode, first.data(), count.data(), drawCount);
+	}
+
+	first.clear();
+	count.clear();
+	indices.clear();
+}
+
+void BufferedDrawer::_drawArrays(GLenum _mode, GLint _first, GLsizei _count)
+{
+	if (!m_batchDraws) {
+		glDrawArrays(_mode, _first, _count);
+		return;
+	}
+
+	if (!m_batch.count.empty() && (m_batch.indexed || m_batch.mode != _mode))
+		FunctionWrapper::flushPendingDraws();
+
+	m_batch.mode = _mode;
+	m_batch.indexed = false;
+	m_batch.first.push_back(_first);
+	m_batch.count.push_back(_count);
+	FunctionWrapper::setPendingDraws(&m_batch);
+}
+
+void BufferedDrawer::_drawElements(GLenum _mode, GLuint _lastVertex, GLsizei _count, const void * _indices, GLint _baseVertex)
+{
+	if (!m_batchDraws) {
+		glDrawRangeElementsBaseVertex(_mode, 0, _lastVertex, _count, GL_UNSIGNED_SHORT, (const u16*)_indices, _baseVertex);
+		return;
+	}
+
+	if (!m_batch.count.empty() && (!m_batch.indexed || m_batch.mode != _mode))
+		FunctionWrapper::flushPendingDraws();
+
+	m_batch.mode = _mode;
+	m_batch.indexed = true;
+	m_batch.lastVertex = _lastVertex;
+	m_batch.first.push_back(_baseVertex);
+	m_batch.count.push_back(_count);
+	m_batch.indices.push_back(_indices);
+	FunctionWrapper::setPendingDraws(&m_batch);
+}
+
+void BufferedDrawer::flush()
+{
+	FunctionWrapper::flushPendingDraws();
+	// The frontend may touch GL state before the next draw.
+	m_numLights = -1.0f;
+}
+
 void BufferedDrawer::drawLine(f32 _width, SPVertex * _vertices)
 {
 	const BuffersType type = BuffersType::triangles;
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <unordered_map>
 #include "opengl_GLInfo.h"
@@ -20,6 +21,8 @@ namespace opengl {
 
 		void drawLine(f32 _width, SPVertex * _vertices) override;
 
+		void flush() override;
+
 	private:
 		void _updateRectBuffer(const graphics::Context::DrawRectParameters & _params);
 		void _updateTrianglesBuffers(const graphics::Context::DrawTriangleParameters & _params);
@@ -30,39 +33,72 @@ namespace opengl {
 			triangles
 		};
 
+		struct Vertex
+		{
+			f32 x, y, z, w;
+			f32 r, g, b, a;
+			f32 s, t;
+			f32 bc0, bc1;
+			u32 modify;
+		};
+
+		static const u32 m_segmentsCount = 4;
+
+		// A ring of m_segmentsCount segments. Data never straddles two segments.
+		// A segment is fenced once the writer leaves it, and the writer waits
+		// only for the fence of the segment it is about to reuse.
 		struct Buffer {
-			Buffer(GLenum _type) : type(_type) {}
+			Buffer(GLenum _type, GLuint _stride) : type(_type), stride(_stride) {}
 
 			GLenum type;
+			GLuint stride;
 			GLuint handle = 0;
 			GLintptr offset = 0;
 			GLint pos = 0;
 			GLuint size = 0;
 			GLubyte * data = nullptr;
+			u32 segment = 0;
+			u32 reusedSegments = 0;
+			bool stalled = false;
+			std::array<GLsync, m_segmentsCount> fences = {};
 		};
 
 		struct RectBuffers {
 			GLuint vao = 0;
-			Buffer vbo = Buffer(GL_ARRAY_BUFFER);
+			Buffer vbo = Buffer(GL_ARRAY_BUFFER, sizeof(RectVertex));
 		};
 
 		struct TrisBuffers {
 			GLuint vao = 0;
-			Buffer vbo = Buffer(GL_ARRAY_BUFFER);
-			Buffer ebo = Buffer(GL_ELEMENT_ARRAY_BUFFER);
+			Buffer vbo = Buffer(GL_ARRAY_BUFFER, sizeof(Vertex));
+			Buffer ebo = Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort));
 		};
 
-		struct Vertex
+		// Consecutive draws of the same kind, submitted with one multi-draw call.
+		// A draw stays pending until the next GL call, so only draws with no
+		// state change in between can end up in the same batch.
+		struct DrawBatch : public PendingDraws
 		{
-			f32 x, y, z, w;
-			f32 r, g, b, a;
-			f32 s, t;
-			f32 bc0, bc1;
-			u32 modify;
+			void submit() override;
+
+			GLenum mode = GL_TRIANGLES;
+			bool indexed = false;
+			GLuint lastVertex = 0;
+			std::vector<GLint> first;
+			std::vector<GLsizei> count;
+			std::vector<const void*> indices;
 		};
 
+		void _drawArrays(GLenum _mode, GLint _first, GLsizei _count);
+		void _drawElements(GLenum _mode, GLuint _lastVertex, GLsizei _count, const void * _indices, GLint _baseVertex);
 		void _initBuffer(Buffer & _buffer, GLuint _bufSize);
+		void _resizeBuffer(Buffer & _buffer, GLuint _bufSize);
+		void _deleteFences(Buffer & _buffer);
+		void _waitSegment(Buffer & _buffer, u32 _segment);
+		void _reserveBuffer(Buffer & _buffer, u32 _dataSize);
 		void _updateBuffer(Buffer & _buffer, u32 _count, u32 _dataSize, const void * _data);
+		void _setRectAttribPointers();
+		void _setTrisAttribPointers();
 		void _convertFromSPVertex(bool _flatColors, u32 _count, const SPVertex * _data);
 
 		const GLInfo & m_glInfo;
@@ -72,12 +108,17 @@ namespace opengl {
 		RectBuffers m_rectsBuffers;
 		TrisBuffers m_trisBuffers;
 		BuffersType m_type = BuffersType::none;
+		GLfloat m_numLights = -1.0f;
+
+		bool m_batchDraws = false;
+		DrawBatch m_batch;
 
 		std::vector<Vertex> m_vertices;
 
 		typedef std::unordered_map<u64, u32> BufferOffsets;
 		BufferOffsets m_rectBufferOffsets;
 
+		static const u32 m_bufInitSize;
 		static const u32 m_bufMaxSize;
 		static const GLbitfield m_bufAccessBits;
 		static const GLbitfield m_bufMapBits;
@@ -68,6 +68,7 @@ void ContextImpl::init()
 		m_initRenderbuffer.reset(bufferObjectFactory.getInitRenderbuffer());
 		m_addFramebufferRenderTarget.reset(bufferObjectFactory.getAddFramebufferRenderTarget());
 		m_createPixelReadBuffer.reset(bufferObjectFactory.createPixelReadBuffer());
+		m_createPixelWriteBuffer.reset(bufferObjectFactory.createPixelWriteBuffer());
 		m_blitFramebuffers.reset(bufferObjectFactory.getBlitFramebuffers());
 	}
 
@@ -377,6 +378,13 @@ graphics::PixelReadBuffer * ContextImpl::createPixelReadBuffer(size_t _sizeInByt
 	return nullptr;
 }
 
+graphics::PixelWriteBuffer * ContextImpl::createPixelWriteBuffer(size_t _sizeInBytes)
+{
+	if (m_createPixelWriteBuffer)
+		return m_createPixelWriteBuffer->createPixelWriteBuffer(_sizeInBytes);
+	return nullptr;
+}
+
 graphics::ColorBufferReader * ContextImpl::createColorBufferReader(CachedTexture * _pTexture)
 {
 #if defined(EGL) && defined(OS_ANDROID)
@@ -507,6 +515,11 @@ void ContextImpl::drawLine(f32 _width, SPVertex * _vertices)
 	m_graphicsDrawer->drawLine(_width, _vertices);
 }
 
+void ContextImpl::flushDraws()
+{
+	m_graphicsDrawer->flush();
+}
+
 f32 ContextImpl::getMaxLineWidth()
 {
 	GLfloat lineWidthRange[2] = { 0.0f, 0.0f };
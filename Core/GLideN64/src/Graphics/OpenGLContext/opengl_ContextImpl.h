@@ -106,6 +106,8 @@ namespace opengl {
 
 		graphics::PixelReadBuffer * createPixelReadBuffer(size_t _sizeInBytes) override;
 
+		graphics::PixelWriteBuffer * createPixelWriteBuffer(size_t _sizeInBytes) override;
+
 		graphics::ColorBufferReader * createColorBufferReader(CachedTexture * _pTexture) override;
 
 		/*---------------Shaders-------------*/
@@ -148,6 +150,8 @@ namespace opengl {
 
 		void drawLine(f32 _width, SPVertex * _vertices) override;
 
+		void flushDraws() override;
+
 		f32 getMaxLineWidth() override;
 
 		bool isSupported(graphics::SpecialFeatures _feature) const override;
@@ -170,6 +174,7 @@ namespace opengl {
 		std::unique_ptr<InitRenderbuffer> m_initRenderbuffer;
 		std::unique_ptr<AddFramebufferRenderTarget> m_addFramebufferRenderTarget;
 		std::unique_ptr<CreatePixelReadBuffer> m_createPixelReadBuffer;
+		std::unique_ptr<CreatePixelWriteBuffer> m_createPixelWriteBuffer;
 		std::unique_ptr<BlitFramebuffers> m_blitFramebuffers;
 		std::unique_ptr<graphics::FramebufferTextureFormats> m_fbTexFormats;
 
@@ -129,6 +129,9 @@ void GLInfo::init() {
 	}
 #endif
 
+	multiDraw = !isGLESX && numericVersion >= 32 &&
+		IS_GL_FUNCTION_VALID(MultiDrawArrays) && IS_GL_FUNCTION_VALID(MultiDrawElementsBaseVertex);
+
 	bufferStorage = (!isGLESX && (numericVersion >= 44)) || Utils::isExtensionSupported(*this, "GL_ARB_buffer_storage") ||
 			Utils::isExtensionSupported(*this, "GL_EXT_buffer_storage");
 
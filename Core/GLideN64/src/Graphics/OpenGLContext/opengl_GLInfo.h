@@ -23,6 +23,7 @@ struct GLInfo {
 	bool imageTextures = false;
 	bool bufferStorage = false;
 	bool drawElementsBaseVertex = false;
+	bool multiDraw = false;
 	bool texStorage    = false;
 	bool shaderStorage = false;
 	bool msaa = false;
@@ -13,6 +13,9 @@ namespace opengl {
 		virtual void drawRects(const graphics::Context::DrawRectParameters & _params) = 0;
 
 		virtual void drawLine(f32 _width, SPVertex * _vertices) = 0;
+
+		// Submits draws the drawer holds back to merge them.
+		virtual void flush() {}
 	};
 }
 
@@ -14,6 +14,19 @@ namespace graphics {
 		virtual void unbind() = 0;
 	};
 
+	class PixelWriteBuffer
+	{
+	public:
+		virtual ~PixelWriteBuffer() {}
+		// Returns _size bytes to fill with texture data, or nullptr when _size is
+		// larger than the size the buffer was created for.
+		virtual void * getWriteBuffer(size_t _size) = 0;
+		// Returns what to pass as data to texture updates made while the buffer is bound.
+		virtual const u8 * closeWriteBuffer() = 0;
+		virtual void bind() = 0;
+		virtual void unbind() = 0;
+	};
+
 	template<class T>
 	class PixelBufferBinder
 	{
@@ -10,6 +10,8 @@
 #include "Config.h"
 #include "DebugDump.h"
 #include "DisplayWindow.h"
+#include <Graphics/Context.h>
+#include "main/trace.h"
 
 void RDP_Unknown( u32 w0, u32 w1 )
 {
@@ -570,6 +572,7 @@ inline u32 READ_RDP_DATA(u32 address)
 
 void RDP_ProcessRDPList()
 {
+	TRACE_SCOPE("GLideN64 RDP list");
 	if (ConfigOpen || dwnd().isResizeWindow()) {
 		dp_current = dp_end;
 		gDPFullSync();
@@ -624,4 +627,5 @@ void RDP_ProcessRDPList()
 	gDP.changed &= ~CHANGED_CPU_FB_WRITE;
 
 	dp_current = dp_end;
+	gfxContext.flushDraws();
 }
@@ -17,6 +17,9 @@
 #include "Config.h"
 #include "TextureFilterHandler.h"
 #include "DisplayWindow.h"
+#include <Graphics/Context.h>
+#include "main/trace.h"
+#include <mupen64plus-next_common.h>
 
 using namespace std;
 
@@ -109,9 +112,11 @@ void RSP_CheckDLCounter()
 
 void RSP_ProcessDList()
 {
+	TRACE_SCOPE("GLideN64 display list");
 	RSP.LLE = false;
 
-	if (ConfigOpen || dwnd().isResizeWindow()) {
+	// libretro_skip_rdp: run-ahead frame which is rolled back unseen
+	if (ConfigOpen || dwnd().isResizeWindow() || libretro_skip_rdp) {
 		*REG.MI_INTR |= MI_INTR_DP;
 		CheckInterrupts();
 		return;
@@ -185,6 +190,7 @@ void RSP_ProcessDList()
 
 	if (RSP.infloop && REG.SP_STATUS) {
 		*REG.SP_STATUS &= ~(SP_STATUS_TASKDONE | SP_STATUS_HALT | SP_STATUS_BROKE);
+		gfxContext.flushDraws();
 		return;
 	}
 
@@ -200,6 +206,7 @@ void RSP_ProcessDList()
 
 	RSP.busy = false;
 	gDP.changed |= CHANGED_COLORBUFFER;
+	gfxContext.flushDraws();
 }
 
 static
@@ -20,11 +20,17 @@
 #include "Graphics/Context.h"
 #include "Graphics/Parameters.h"
 #include "DisplayWindow.h"
+#include "main/trace.h"
 #include <mupen64plus-next_common.h>
 
 using namespace std;
 using namespace graphics;
 
+// Evicted texture objects kept for reuse
+static const size_t MaxPooledTextures = 64;
+// Largest mip level uploaded through the upload buffer, bigger ones go directly
+static const size_t MaxUploadBufferWrite = 1024 * 1024;
+
 u32 GetNone(u16 offset, u16 x, u16 i, u8 palette)
 {
 	return 0x00000000;
@@ -716,6 +722,7 @@ void TextureCache::_initDummyTexture(CachedTexture * _pDummy)
 void TextureCache::init()
 {
 	m_curUnpackAlignment = 0;
+	m_tileCRCValid[0] = m_tileCRCValid[1] = false;
 
 	u32 dummyTexture[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
@@ -738,6 +745,8 @@ void TextureCache::init()
 	activateDummy(1);
 	current[0] = current[1] = nullptr;
 
+	m_pUploadBuffer.reset(gfxContext.createPixelWriteBuffer(MaxUploadBufferWrite));
+
 
 	m_pMSDummy = nullptr;
 	if (config.video.multisampling != 0 && Context::Multisampling) {
@@ -770,6 +779,8 @@ void TextureCache::destroy()
 		gfxContext.deleteTexture(cur->name);
 	m_textures.clear();
 	m_lruTextureLocations.clear();
+	_clearTexturePool();
+	m_pUploadBuffer.reset();
 
 	for (FBTextures::const_iterator cur = m_fbTextures.cbegin(); cur != m_fbTextures.cend(); ++cur)
 		gfxContext.deleteTexture(cur->second.name);
@@ -809,18 +820,63 @@ void TextureCache::_checkCacheSize()
 		CachedTexture& clsTex = m_textures.back();
 		if (clsTex.bHDTexture)
 			m_hdTexCacheSize -= clsTex.textureBytes;
-		gfxContext.deleteTexture(clsTex.name);
+		_releaseTexture(clsTex);
 		m_lruTextureLocations.erase(clsTex.crc);
 		m_textures.pop_back();
 	}
 }
 
+// Evicted textures keep their texture object in a small pool, so a miss of
+// the same size and format reuses its storage instead of allocating anew.
+void TextureCache::_releaseTexture(const CachedTexture & _texture)
+{
+	if (_texture.storage.mipMapLevels == 0) {
+		gfxContext.deleteTexture(_texture.name);
+		return;
+	}
+
+	if (m_texturePool.size() >= MaxPooledTextures) {
+		gfxContext.deleteTexture(m_texturePool.front().name);
+		m_texturePool.erase(m_texturePool.begin());
+	}
+	m_texturePool.push_back({ _texture.name, _texture.storage });
+}
+
+bool TextureCache::_takePooledTexture(CachedTexture * _pTexture)
+{
+	for (auto iter = m_texturePool.rbegin(); iter != m_texturePool.rend(); ++iter) {
+		if (iter->storage == _pTexture->storage) {
+			// The new texture's own object has no storage yet, keep it for the next miss
+			m_freeNames.push_back(_pTexture->name);
+			_pTexture->name = iter->name;
+			m_texturePool.erase(std::next(iter).base());
+			return true;
+		}
+	}
+	return false;
+}
+
+void TextureCache::_clearTexturePool()
+{
+	for (const PooledTexture & pooled : m_texturePool)
+		gfxContext.deleteTexture(pooled.name);
+	m_texturePool.clear();
+	for (ObjectHandle name : m_freeNames)
+		gfxContext.deleteTexture(name);
+	m_freeNames.clear();
+}
+
 CachedTexture * TextureCache::_addTexture(u64 _crc64)
 {
 	if (m_curUnpackAlignment == 0)
 		m_curUnpackAlignment = gfxContext.getTextureUnpackAlignment();
 	_checkCacheSize();
-	m_textures.emplace_front(gfxContext.createTexture(textureTarget::TEXTURE_2D));
+	if (m_freeNames.empty()) {
+		m_textures.emplace_front(gfxContext.createTexture(textureTarget::TEXTURE_2D));
+	} else {
+		m_textures.emplace_front(m_freeNames.back());
+		m_freeNames.pop_back();
+	}
 	Textures::iterator new_iter = m_textures.begin();
 	new_iter->crc = _crc64;
 	m_lruTextureLocations.insert(std::pair<u64, Textures::iterator>(_crc64, new_iter));
@@ -1397,6 +1453,71 @@ void doubleTexture(T* pTex, u32 width, u32 height)
 	}
 }
 
+// Uploads one mip level of decoded texels from m_tempTextureHolder. Level 0
+// takes a pooled texture object of the same shape or allocates all levels;
+// the texels are then copied to the upload buffer, from which the driver
+// transfers them without stalling the caller.
+void TextureCache::_uploadTexture(u32 _tile, CachedTexture * _pTexture, u32 _mipLevel, u32 _mipMapLevels,
+	u16 _width, u16 _height, InternalColorFormatParam _internalFormat, DatatypeParam _dataType)
+{
+	if (_mipLevel == 0) {
+		_pTexture->storage.width = _width;
+		_pTexture->storage.height = _height;
+		_pTexture->storage.internalFormat = u32(_internalFormat);
+		_pTexture->storage.dataType = u32(_dataType);
+		_pTexture->storage.mipMapLevels = _mipMapLevels;
+		if (!_takePooledTexture(_pTexture)) {
+			Context::InitTextureParams params;
+			params.handle = _pTexture->name;
+			params.textureUnitIndex = textureIndices::Tex[_tile];
+			params.mipMapLevels = _mipMapLevels;
+			params.msaaLevel = 0;
+			params.width = _width;
+			params.height = _height;
+			params.internalFormat = _internalFormat;
+			params.format = colorFormat::RGBA;
+			params.dataType = _dataType;
+			for (u32 level = 0; level < _mipMapLevels; ++level) {
+				params.mipMapLevel = level;
+				gfxContext.init2DTexture(params);
+				if (params.width > 1)
+					params.width >>= 1;
+				if (params.height > 1)
+					params.height >>= 1;
+			}
+		}
+	}
+
+	Context::UpdateTextureDataParams params;
+	params.handle = _pTexture->name;
+	params.textureUnitIndex = textureIndices::Tex[_tile];
+	params.mipMapLevel = _mipLevel;
+	params.width = _width;
+	params.height = _height;
+	params.format = colorFormat::RGBA;
+	params.dataType = _dataType;
+	params.data = m_tempTextureHolder.data();
+
+	const size_t numBytes = size_t(_width) * _height * (_dataType == datatype::UNSIGNED_BYTE ? 4 : 2);
+	void * pStaging = nullptr;
+	if (m_pUploadBuffer) {
+		m_pUploadBuffer->bind();
+		pStaging = m_pUploadBuffer->getWriteBuffer(numBytes);
+		if (pStaging == nullptr)
+			m_pUploadBuffer->unbind();
+	}
+
+	if (pStaging == nullptr) {
+		gfxContext.update2DTexture(params);
+		return;
+	}
+
+	memcpy(pStaging, m_tempTextureHolder.data(), numBytes);
+	params.data = m_pUploadBuffer->closeWriteBuffer();
+	gfxContext.update2DTexture(params);
+	m_pUploadBuffer->unbind();
+}
+
 void TextureCache::_loadFast(u32 _tile, CachedTexture *_pTexture)
 {
 	u64 ricecrc = 0;
@@ -1563,19 +1684,8 @@ void TextureCache::_loadFast(u32 _tile, CachedTexture *_pTexture)
 				glInternalFormat != internalcolorFormat::RGBA8 &&
 				m_curUnpackAlignment > 1)
 				gfxContext.setTextureUnpackAlignment(2);
-			Context::InitTextureParams params;
-			params.handle = _pTexture->name;
-			params.textureUnitIndex = textureIndices::Tex[_tile];
-			params.mipMapLevel = mipLevel;
-			params.mipMapLevels = _pTexture->max_level + 1;
-			params.msaaLevel = 0;
-			params.width = tmptex.width;
-			params.height = tmptex.height;
-			params.internalFormat = gfxContext.convertInternalTextureFormat(u32(glInternalFormat));
-			params.format = colorFormat::RGBA;
-			params.dataType = glType;
-			params.data = m_tempTextureHolder.data();
-			gfxContext.init2DTexture(params);
+			_uploadTexture(_tile, _pTexture, mipLevel, _pTexture->max_level + 1, tmptex.width, tmptex.height,
+				gfxContext.convertInternalTextureFormat(u32(glInternalFormat)), glType);
 		}
 		if (mipLevel == _pTexture->max_level)
 			break;
@@ -1717,21 +1827,12 @@ void TextureCache::_loadAccurate(u32 _tile, CachedTexture *_pTexture)
 			_pTexture->textureBytes += (tmptex.width * tmptex.height) << sizeShift;
 		}
 
-		Context::InitTextureParams params;
-		params.handle = _pTexture->name;
-		params.textureUnitIndex = textureIndices::Tex[_tile];
-		params.mipMapLevel = 0;
-		params.mipMapLevels =1;
-		params.msaaLevel = 0;
-		params.width = std::min(texDataOffset, MIPMAP_TILE_WIDTH);
-		params.height = (texDataOffset / MIPMAP_TILE_WIDTH) + ((texDataOffset % MIPMAP_TILE_WIDTH) ? 1 : 0);
-		params.internalFormat = gfxContext.convertInternalTextureFormat(u32(glInternalFormat));
-		params.format = colorFormat::RGBA;
-		params.dataType = glType;
-		params.data = m_tempTextureHolder.data();
-		gfxContext.init2DTexture(params);
-		_pTexture->mipmapAtlasWidth = params.width;
-		_pTexture->mipmapAtlasHeight = params.height;
+		const u16 atlasWidth = static_cast<u16>(std::min(texDataOffset, MIPMAP_TILE_WIDTH));
+		const u16 atlasHeight = static_cast<u16>((texDataOffset / MIPMAP_TILE_WIDTH) + ((texDataOffset % MIPMAP_TILE_WIDTH) ? 1 : 0));
+		_uploadTexture(_tile, _pTexture, 0, 1, atlasWidth, atlasHeight,
+			gfxContext.convertInternalTextureFormat(u32(glInternalFormat)), glType);
+		_pTexture->mipmapAtlasWidth = atlasWidth;
+		_pTexture->mipmapAtlasHeight = atlasHeight;
 	}
 	else
 	{
@@ -1809,19 +1910,8 @@ void TextureCache::_loadAccurate(u32 _tile, CachedTexture *_pTexture)
 				glInternalFormat != internalcolorFormat::RGBA8 &&
 				m_curUnpackAlignment > 1)
 				gfxContext.setTextureUnpackAlignment(2);
-			Context::InitTextureParams params;
-			params.handle = _pTexture->name;
-			params.textureUnitIndex = textureIndices::Tex[_tile];
-			params.mipMapLevel = 0;
-			params.mipMapLevels = 1;
-			params.msaaLevel = 0;
-			params.width = tmptex.width;
-			params.height = tmptex.height;
-			params.internalFormat = gfxContext.convertInternalTextureFormat(u32(glInternalFormat));
-			params.format = colorFormat::RGBA;
-			params.dataType = glType;
-			params.data = m_tempTextureHolder.data();
-			gfxContext.init2DTexture(params);
+			_uploadTexture(_tile, _pTexture, 0, 1, tmptex.width, tmptex.height,
+				gfxContext.convertInternalTextureFormat(u32(glInternalFormat)), glType);
 		}
 	}
 	if (m_curUnpackAlignment > 1)
@@ -1994,6 +2084,7 @@ void TextureCache::_updateBackground()
 	}
 
 	m_misses++;
+	TRACE_SCOPE("background texture cache miss");
 
 	CachedTexture * pCurrent = _addTexture(crc);
 
@@ -2045,6 +2136,7 @@ void TextureCache::clear()
 	}
 	m_textures.clear();
 	m_lruTextureLocations.clear();
+	_clearTexturePool();
 	m_hdTexCacheSize = 0u;
 }
 
@@ -2110,7 +2202,22 @@ void TextureCache::update(u32 _t)
 	params.width = sizes.width;
 	params.height = sizes.height;
 
-	const u64 crc = _calculateCRC(_t, params, sizes.bytes);
+	TileCRCKey crcKey;
+	crcKey.tmemGeneration = gDP.tmemGeneration;
+	crcKey.tmem = pTile->tmem;
+	crcKey.line = pTile->line;
+	crcKey.palette = pTile->palette;
+	crcKey.flags = params.flags;
+	crcKey.bytes = sizes.bytes;
+	crcKey.lodLevel = config.generalEmulation.enableLOD != 0 ? gSP.texture.level : 0;
+	crcKey.width = params.width;
+	crcKey.height = params.height;
+	if (!m_tileCRCValid[_t] || memcmp(&crcKey, &m_tileCRCKeys[_t], sizeof(TileCRCKey)) != 0) {
+		m_tileCRCKeys[_t] = crcKey;
+		m_tileCRCs[_t] = _calculateCRC(_t, params, sizes.bytes);
+		m_tileCRCValid[_t] = true;
+	}
+	const u64 crc = m_tileCRCs[_t];
 
 	if (current[_t] != nullptr && current[_t]->crc == crc) {
 		activateTexture(_t, current[_t]);
@@ -2135,12 +2242,13 @@ void TextureCache::update(u32 _t)
 
 		if (currentTex.bHDTexture)
 			m_hdTexCacheSize -= currentTex.textureBytes;
-		gfxContext.deleteTexture(currentTex.name);
+		_releaseTexture(currentTex);
 		m_lruTextureLocations.erase(locations_iter);
 		m_textures.erase(iter);
 	}
 
 	m_misses++;
+	TRACE_SCOPE("texture cache miss");
 
 	CachedTexture * pCurrent = _addTexture(crc);
 
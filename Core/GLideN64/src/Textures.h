@@ -4,6 +4,7 @@
 #include <array>
 #include <list>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <stddef.h> // for size_t
@@ -12,11 +13,29 @@
 #include "convert.h"
 #include "Graphics/ObjectHandle.h"
 #include "Graphics/Parameter.h"
+#include "Graphics/PixelBuffer.h"
 
 typedef u32 (*GetTexelFunc)(u16 offset, u16 x, u16 i, u8 palette);
 typedef u32 (*GetTexelFuncBG)(u64 *src, u16 x, u16 i, u8 palette);
 struct GHQTexInfo;
 
+// Shape of the GL storage of a cached texture. Textures of the same shape
+// can take over each other's texture object.
+struct TextureStorage
+{
+	u16 width = 0;
+	u16 height = 0;
+	u32 internalFormat = 0;
+	u32 dataType = 0;
+	u32 mipMapLevels = 0;
+
+	bool operator==(const TextureStorage & _other) const {
+		return width == _other.width && height == _other.height &&
+			internalFormat == _other.internalFormat && dataType == _other.dataType &&
+			mipMapLevels == _other.mipMapLevels;
+	}
+};
+
 struct CachedTexture
 {
 	CachedTexture(graphics::ObjectHandle _name) : name(_name), max_level(0), frameBufferTexture(fbNone), bHDTexture(false) {}
@@ -51,6 +70,7 @@ struct CachedTexture
 		fbMultiSample = 2
 	} frameBufferTexture;
 	bool bHDTexture;
+	TextureStorage storage;		  // Set when the texture object can be recycled
 };
 
 struct TextureCache
@@ -81,6 +101,7 @@ private:
 	{
 		current[0] = nullptr;
 		current[1] = nullptr;
+		m_tileCRCValid[0] = m_tileCRCValid[1] = false;
 		CRC_Init();
 	}
 	TextureCache(const TextureCache &) = delete;
@@ -88,6 +109,11 @@ private:
 	void _checkCacheSize();
 	void _checkHdTexLimit();
 	CachedTexture * _addTexture(u64 _crc64);
+	void _releaseTexture(const CachedTexture & _texture);
+	bool _takePooledTexture(CachedTexture * _pTexture);
+	void _clearTexturePool();
+	void _uploadTexture(u32 _tile, CachedTexture * _pTexture, u32 _mipLevel, u32 _mipMapLevels,
+		u16 _width, u16 _height, graphics::InternalColorFormatParam _internalFormat, graphics::DatatypeParam _dataType);
 	void _loadFast(u32 _tile, CachedTexture *_pTexture);
 	void _loadAccurate(u32 _tile, CachedTexture *_pTexture);
 	bool _loadHiresTexture(u32 _tile, CachedTexture *_pTexture, u64 & _ricecrc, u64 & _strongcrc);
@@ -111,7 +137,34 @@ private:
 	s32 m_curUnpackAlignment;
 	bool m_toggleDumpTex;
 	std::vector<u32> m_tempTextureHolder;
-	
+
+	// Everything the CRC of a tile depends on besides the contents of TMEM,
+	// which only change when gDP.tmemGeneration does.
+	struct TileCRCKey
+	{
+		u32 tmemGeneration;
+		u32 tmem;
+		u32 line;
+		u32 palette;
+		u32 flags;
+		u32 bytes;
+		u32 lodLevel;
+		u16 width;
+		u16 height;
+	};
+	TileCRCKey m_tileCRCKeys[2];
+	u64 m_tileCRCs[2];
+	bool m_tileCRCValid[2];
+
+	struct PooledTexture
+	{
+		graphics::ObjectHandle name;
+		TextureStorage storage;
+	};
+	std::vector<PooledTexture> m_texturePool;
+	std::vector<graphics::ObjectHandle> m_freeNames;
+	std::unique_ptr<graphics::PixelWriteBuffer> m_pUploadBuffer;
+
 	u64 m_hdTexCacheSize = 0u;
 };
 
@@ -483,6 +483,7 @@ void gDPLoadTile32b(u32 uls, u32 ult, u32 lrs, u32 lrt)
 
 void gDPLoadTile(u32 tile, u32 uls, u32 ult, u32 lrs, u32 lrt)
 {
+	++gDP.tmemGeneration;
 	gDPSetTileSize( tile, uls, ult, lrs, lrt );
 	gDP.loadTileIdx = tile;
 	gDP.loadTile = &gDP.tiles[tile];
@@ -638,6 +639,7 @@ void gDPLoadBlock32(u32 uls,u32 lrs, u32 dxt)
 
 void gDPLoadBlock(u32 tile, u32 uls, u32 ult, u32 lrs, u32 dxt)
 {
+	++gDP.tmemGeneration;
 	gDPSetTileSize( tile, uls, ult, lrs, dxt );
 	gDP.loadTileIdx = tile;
 	gDP.loadTile = &gDP.tiles[tile];
@@ -731,6 +733,7 @@ void gDPLoadBlock(u32 tile, u32 uls, u32 ult, u32 lrs, u32 dxt)
 
 void gDPLoadTLUT( u32 tile, u32 uls, u32 ult, u32 lrs, u32 lrt )
 {
+	++gDP.tmemGeneration;
 	gDPSetTileSize( tile, uls, ult, lrs, lrt );
 	if (gDP.tiles[tile].tmem < 256) {
 		DebugMsg(DEBUG_NORMAL | DEBUG_ERROR, "gDPLoadTLUT wrong tile tmem addr: tile[%d].tmem=%04x;\n", tile, gDP.tiles[tile].tmem);
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 #include "N64.h"
 #include "GLideN64.h"
 #include "DebugDump.h"
@@ -927,7 +928,7 @@ void gSPProcessVertex(u32 v, SPVertex * spVtx)
 		gSPPointLightVertexAcclaim<VNUM>(v, spVtx);
 	} else {
 		for(u32 i = 0; i < VNUM; ++i)
-			spVtx[v].HWLight = 0;
+			spVtx[v+i].HWLight = 0;
 	}
 
 	for(u32 i = 0; i < VNUM; ++i) {
@@ -974,6 +975,109 @@ u32 gSPLoadVertexData(const Vertex *orgVtx, SPVertex * spVtx, u32 v0, u32 vi, u3
 	return vi;
 }
 
+/*---------------------------------Vertex Cache------------------------------------*/
+
+// Static geometry is loaded from the same vertices with the same transform and lighting state
+// frame after frame. gSPVertex keeps the processed vertices of recent loads, keyed by a hash of
+// the RDRAM vertex data and of all state gSPProcessVertex reads, and copies them back on a match.
+// Since the key covers the vertex data itself, CPU writes to it simply miss.
+static const u32 VertexCacheSize = 1024U;
+static const u32 VertexCacheMaxLoad = 32U;
+
+struct VertexCacheEntry
+{
+	u64 key;
+	u32 v0, n;
+	SPVertex vertices[VertexCacheMaxLoad];
+};
+
+static std::vector<VertexCacheEntry> g_vertexCache;
+
+static
+void gSPClearVertexCache()
+{
+	for (VertexCacheEntry & entry : g_vertexCache)
+		entry.n = 0;
+}
+
+static
+bool gSPVertexCacheAllowed(u32 n)
+{
+	if (n > VertexCacheMaxLoad || gSP.matrix.billboard != 0 || g_ConkerUcode)
+		return false;
+	if ((gSP.geometryMode & G_ACCLAIM_LIGHTING) != 0)
+		return false;
+	if ((gSP.geometryMode & G_LIGHTING) == 0)
+		return true;
+	if (!GBI.isLegacyVertexPipeline())
+		return false;
+	// F3DFLX2 texgen reads its alpha table from RDRAM
+	return (gSP.geometryMode & G_TEXTURE_GEN) == 0 || GBI.getMicrocodeType() != F3DFLX2;
+}
+
+static
+u64 gSPVertexCacheKey(const Vertex *vertex, u32 v0, u32 n)
+{
+	const bool lighting = (gSP.geometryMode & G_LIGHTING) != 0;
+	const u32 numLights = std::min(gSP.numLights, 11U);
+	struct {
+		u32 v0, n;
+		u32 geometryMode;
+		u32 hwLighting;
+		u32 numLights;
+		u32 lookatEnable;
+		f32 adjustScale;
+	} params;
+	params.v0 = v0;
+	params.n = n;
+	params.geometryMode = gSP.geometryMode;
+	params.hwLighting = lighting && isHWLightingAllowed() ? 1 : 0;
+	params.numLights = lighting ? numLights : 0;
+	params.lookatEnable = lighting && gSP.lookatEnable ? 1 : 0;
+	params.adjustScale = dwnd().getAdjustScale();
+
+	u64 key = CRC_Calculate(0, &params, sizeof(params));
+	key = CRC_Calculate(key, gSP.matrix.combined, sizeof(gSP.matrix.combined));
+	if (lighting) {
+		const u32 count = numLights + 1;
+		key = CRC_Calculate(key, gSP.matrix.modelView[gSP.matrix.modelViewi], sizeof(gSP.matrix.modelView[0]));
+		key = CRC_Calculate(key, gSP.lights.rgb, count * sizeof(gSP.lights.rgb[0]));
+		key = CRC_Calculate(key, gSP.lights.rgb2, count * sizeof(gSP.lights.rgb2[0]));
+		key = CRC_Calculate(key, gSP.lights.i_xyz, count * sizeof(gSP.lights.i_xyz[0]));
+		if ((gSP.geometryMode & G_POINT_LIGHTING) != 0) {
+			key = CRC_Calculate(key, gSP.lights.pos_xyzw, count * sizeof(gSP.lights.pos_xyzw[0]));
+			key = CRC_Calculate(key, gSP.lights.ca, count * sizeof(gSP.lights.ca[0]));
+			key = CRC_Calculate(key, gSP.lights.la, count * sizeof(gSP.lights.la[0]));
+			key = CRC_Calculate(key, gSP.lights.qa, count * sizeof(gSP.lights.qa[0]));
+		}
+		if ((gSP.geometryMode & G_TEXTURE_GEN) != 0)
+			key = CRC_Calculate(key, gSP.lookat.i_xyz, sizeof(gSP.lookat.i_xyz));
+	}
+	return CRC_Calculate(key, vertex, n * sizeof(Vertex));
+}
+
+// Copies the fields gSPLoadVertexData and gSPProcessVertex write.
+static
+void gSPCopyProcessedVertex(const SPVertex & src, SPVertex & dst)
+{
+	dst.x = src.x;
+	dst.y = src.y;
+	dst.z = src.z;
+	dst.w = src.w;
+	dst.nx = src.nx;
+	dst.ny = src.ny;
+	dst.nz = src.nz;
+	dst.r = src.r;
+	dst.g = src.g;
+	dst.b = src.b;
+	dst.a = src.a;
+	dst.s = src.s;
+	dst.t = src.t;
+	dst.modify = src.modify;
+	dst.HWLight = src.HWLight;
+	dst.clip = src.clip;
+}
+
 void gSPVertex(u32 a, u32 n, u32 v0)
 {
 	DebugMsg(DEBUG_NORMAL, "gSPVertex n = %i, v0 = %i, from %08x\n", n, v0, a);
@@ -1002,9 +1106,34 @@ void gSPVertex(u32 a, u32 n, u32 v0)
 
 	const Vertex *vertex = (Vertex*)&RDRAM[address];
 	SPVertex * spVtx = dwnd().getDrawer().getVertexPtr(0);
+
+	VertexCacheEntry * entry = nullptr;
+	u64 key = 0;
+	if (gSPVertexCacheAllowed(n)) {
+		if (gSP.changed & CHANGED_MATRIX)
+			_gSPCombineMatrices();
+		if (g_vertexCache.empty())
+			g_vertexCache.resize(VertexCacheSize);
+		key = gSPVertexCacheKey(vertex, v0, n);
+		entry = &g_vertexCache[key & (VertexCacheSize - 1)];
+		if (entry->key == key && entry->v0 == v0 && entry->n == n) {
+			for (u32 j = 0; j < n; ++j)
+				gSPCopyProcessedVertex(entry->vertices[j], spVtx[v0 + j]);
+			return;
+		}
+	}
+
 	u32 i = gSPLoadVertexData<VEC_OPT>(vertex, spVtx, v0, v0, n);
 	if (i < n + v0)
 		gSPLoadVertexData<1>(vertex + (i - v0), spVtx, v0, i, n);
+
+	if (entry != nullptr) {
+		entry->key = key;
+		entry->v0 = v0;
+		entry->n = n;
+		for (u32 j = 0; j < n; ++j)
+			gSPCopyProcessedVertex(spVtx[v0 + j], entry->vertices[j]);
+	}
 }
 
 template <u32 VNUM>
@@ -2181,4 +2310,5 @@ void(*gSPTransformVector)(float vtx[4], float mtx[4][4]) = gSPTransformVector_NE
 void gSPSetupFunctions()
 {
 	g_ConkerUcode = GBI.getMicrocodeType() == F3DEX2CBFD;
+	gSPClearVertexCache();
 }
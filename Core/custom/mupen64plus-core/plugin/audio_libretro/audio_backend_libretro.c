@@ -25,6 +25,9 @@
 #include "../../../../mupen64plus-core/src/main/main.h"
 #include "../../../../mupen64plus-core/src/device/device.h"
 #include "../../../../mupen64plus-core/src/main/rom.h"
+#include "../../../../mupen64plus-core/src/main/capture.h"
+#include "../../../../mupen64plus-core/src/main/trace.h"
+#include "osal/atomic.h"
 #include "plugin/plugin.h"
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rcp/vi/vi_controller.h"
@@ -40,24 +43,48 @@
 #include <audio/conversion/s16_to_float.h>
 #include <audio/audio_resampler.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_NEON
+#endif
+
+#include "audio_plugin.h"
+
 extern retro_audio_sample_batch_t audio_batch_cb;
+extern bool libretro_skip_audio;
 
 static unsigned MAX_AUDIO_FRAMES = 2048;
 
-#define VI_INTR_TIME 500000
-
 /* Read header for type definition */
 static int GameFreq = 33600;
-static unsigned CountsPerSecond;
-static unsigned BytesPerSecond;
-static unsigned CountsPerByte;
+static unsigned OutputFreq = 44100;
+
+/* In native mode OutputFreq follows GameFreq.  The DAC rate is set on the
+ * emulation thread, which may not be the one that can talk to the frontend,
+ * so the change is only flagged here. */
+static int native_output;
+static osal_atomic_int output_rate_changed;
 
+static enum audio_resampler_mode resampler_mode = AUDIO_RESAMPLER_SINC;
 static const retro_resampler_t *resampler;
 static void *resampler_audio_data;
 static float *audio_in_buffer_float;
 static float *audio_out_buffer_float;
 static int16_t *audio_out_buffer_s16;
 
+/* State of the linear and cubic resamplers between two AI DMAs: the last
+ * input frames, oldest first, and the fractional position of the next
+ * output frame in 32.32 fixed point.  Each DMA is swapped into
+ * audio_in_buffer_s16 behind these frames, so that every output frame
+ * finds its taps in one place. */
+#define PHASE_ONE ((uint64_t)1 << 32)
+#define HISTORY_FRAMES 4
+static int16_t history[HISTORY_FRAMES][2];
+static uint64_t phase;
+static int16_t *audio_in_buffer_s16;
+
 void (*audio_convert_s16_to_float_arm)(float *out,
       const int16_t *in, size_t samples, float gain);
 void (*audio_convert_float_to_s16_arm)(int16_t *out,
@@ -73,33 +100,57 @@ void deinit_audio_libretro(void)
       free(audio_in_buffer_float);
       free(audio_out_buffer_float);
       free(audio_out_buffer_s16);
+      free(audio_in_buffer_s16);
    }
 }
 
-void init_audio_libretro(unsigned max_audio_frames)
+void init_audio_libretro(unsigned max_audio_frames, unsigned output_rate)
 {
    retro_resampler_realloc(&resampler_audio_data, &resampler, "sinc", RESAMPLER_QUALITY_DONTCARE, 1.0);
 
    MAX_AUDIO_FRAMES = max_audio_frames;
+   native_output    = (output_rate == 0);
+   OutputFreq       = native_output ? (unsigned)GameFreq : output_rate;
+   osal_atomic_store(&output_rate_changed, 0);
 
    audio_in_buffer_float  = malloc(2 * MAX_AUDIO_FRAMES * sizeof(float));
    audio_out_buffer_float = malloc(2 * MAX_AUDIO_FRAMES * sizeof(float));
    audio_out_buffer_s16   = malloc(2 * MAX_AUDIO_FRAMES * sizeof(int16_t));
+   audio_in_buffer_s16    = malloc(2 * (MAX_AUDIO_FRAMES + HISTORY_FRAMES) * sizeof(int16_t));
 
    convert_s16_to_float_init_simd();
    convert_float_to_s16_init_simd();
 }
 
+void set_audio_resampler_libretro(enum audio_resampler_mode mode)
+{
+   if (mode == resampler_mode)
+      return;
+
+   resampler_mode = mode;
+   memset(history, 0, sizeof(history));
+   phase = 0;
+}
+
+unsigned get_audio_output_rate_libretro(void)
+{
+   return OutputFreq;
+}
+
+int audio_output_rate_changed_libretro(void)
+{
+   return osal_atomic_exchange(&output_rate_changed, 0);
+}
+
 static void aiDacrateChanged(void *user_data, unsigned int frequency)
 {
-   GameFreq        = frequency;
-   BytesPerSecond  = frequency * 4;
-   CountsPerSecond = VI_INTR_TIME * 60 /* TODO/FIXME - dehardcode */;
-   CountsPerByte   = CountsPerSecond / BytesPerSecond;
+   GameFreq = frequency;
 
-#if 0
-   printf("CountsPerByte: %d, GameFreq: %d\n", CountsPerByte, GameFreq);
-#endif
+   if (native_output && OutputFreq != frequency)
+   {
+      OutputFreq = frequency;
+      osal_atomic_store(&output_rate_changed, 1);
+   }
 }
 
 /* A fully compliant implementation is not really possible with just the zilmar spec.
@@ -120,31 +171,281 @@ void set_audio_format_via_libretro(void* user_data,
    ai->regs[AI_DACRATE_REG] = saved_ai_dacrate;
 }
 
+/* Samples come out of RDRAM as one 32-bit word per frame, with the two
+ * channels in the wrong halves.  These read them in place, rather than
+ * swapping RDRAM itself, and write interleaved left/right frames. */
+static void swap_s16(int16_t *out, const int16_t *in, size_t frames)
+{
+   size_t i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 4 <= frames; i += 4)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(in + 2 * i));
+      x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+      x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+      _mm_storeu_si128((__m128i*)(out + 2 * i), x);
+   }
+#elif defined(AUDIO_NEON)
+   for (; i + 4 <= frames; i += 4)
+      vst1q_s16(out + 2 * i, vrev32q_s16(vld1q_s16(in + 2 * i)));
+#endif
+
+   for (; i < frames; i++)
+   {
+      out[2 * i + 0] = in[2 * i + 1];
+      out[2 * i + 1] = in[2 * i + 0];
+   }
+}
+
+static void swap_s16_to_float(float *out, const int16_t *in, size_t frames)
+{
+   size_t i = 0;
+
+#if defined(__SSE2__)
+   const __m128 gain = _mm_set1_ps(1.0f / 0x8000);
+
+   for (; i + 4 <= frames; i += 4)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(in + 2 * i));
+      x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+      x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+      _mm_storeu_ps(out + 2 * i + 0, _mm_mul_ps(gain,
+            _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16))));
+      _mm_storeu_ps(out + 2 * i + 4, _mm_mul_ps(gain,
+            _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16))));
+   }
+#elif defined(AUDIO_NEON)
+   for (; i + 4 <= frames; i += 4)
+   {
+      int16x8_t x = vrev32q_s16(vld1q_s16(in + 2 * i));
+      vst1q_f32(out + 2 * i + 0, vmulq_n_f32(
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 0x8000));
+      vst1q_f32(out + 2 * i + 4, vmulq_n_f32(
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 0x8000));
+   }
+#endif
+
+   for (; i < frames; i++)
+   {
+      out[2 * i + 0] = in[2 * i + 1] * (1.0f / 0x8000);
+      out[2 * i + 1] = in[2 * i + 0] * (1.0f / 0x8000);
+   }
+}
+
+static int16_t clamp_s16(float x)
+{
+   if (x > 32767.0f)
+      return 32767;
+   if (x < -32768.0f)
+      return -32768;
+   return (int16_t)x;
+}
+
+/* Linear and Catmull-Rom interpolation to s16 frames.  ext holds
+ * HISTORY_FRAMES frames followed by the frames of the DMA, left channel
+ * first.  Output frame k sits at phase + k * step, between the input frames
+ * pos >> 32 - 1 and pos >> 32 of the DMA.  Both return the number of frames
+ * written; the vector loops give the same results as the scalar ones. */
+static size_t resample_linear(int16_t *out, const int16_t *ext, size_t frames, uint64_t step)
+{
+   const uint64_t end = (uint64_t)frames << 32;
+   const int16_t *in  = ext + 2 * (HISTORY_FRAMES - 1);
+   uint64_t pos       = phase;
+   size_t n           = 0;
+
+#if defined(__SSE2__)
+   for (; pos + 3 * step < end; pos += 4 * step, n += 4)
+   {
+      const uint64_t p1 = pos + step, p2 = pos + 2 * step, p3 = pos + 3 * step;
+      const int16_t t0 = (int16_t)((uint32_t)pos >> 17), t1 = (int16_t)((uint32_t)p1 >> 17);
+      const int16_t t2 = (int16_t)((uint32_t)p2 >> 17), t3 = (int16_t)((uint32_t)p3 >> 17);
+      /* a + (((b - a) * t) >> 15) == ((a << 15) + b * t - a * t) >> 15 */
+      __m128i x01 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64((const __m128i*)(in + 2 * (pos >> 32))),
+            _mm_loadl_epi64((const __m128i*)(in + 2 * (p1 >> 32))));
+      __m128i x23 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64((const __m128i*)(in + 2 * (p2 >> 32))),
+            _mm_loadl_epi64((const __m128i*)(in + 2 * (p3 >> 32))));
+
+      /* al ar bl br -> bl al br ar */
+      x01 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x01, _MM_SHUFFLE(1, 3, 0, 2)), _MM_SHUFFLE(1, 3, 0, 2));
+      x23 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x23, _MM_SHUFFLE(1, 3, 0, 2)), _MM_SHUFFLE(1, 3, 0, 2));
+
+      x01 = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(_mm_srai_epi32(x01, 16), 15),
+            _mm_madd_epi16(x01, _mm_set_epi16(-t1, t1, -t1, t1, -t0, t0, -t0, t0))), 15);
+      x23 = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(_mm_srai_epi32(x23, 16), 15),
+            _mm_madd_epi16(x23, _mm_set_epi16(-t3, t3, -t3, t3, -t2, t2, -t2, t2))), 15);
+
+      _mm_storeu_si128((__m128i*)(out + 2 * n), _mm_packs_epi32(x01, x23));
+   }
+#elif defined(AUDIO_NEON)
+   for (; pos + 3 * step < end; pos += 4 * step, n += 4)
+   {
+      int32x2_t y[4];
+      unsigned k;
+
+      for (k = 0; k < 4; k++)
+      {
+         const uint64_t p  = pos + k * step;
+         const int32x4_t x = vmovl_s16(vld1_s16(in + 2 * (p >> 32)));
+         const int32x2_t a = vget_low_s32(x);
+         y[k] = vadd_s32(a, vshr_n_s32(vmul_n_s32(vsub_s32(vget_high_s32(x), a),
+                  (int32_t)((uint32_t)p >> 17)), 15));
+      }
+
+      vst1q_s16(out + 2 * n, vcombine_s16(
+            vmovn_s32(vcombine_s32(y[0], y[1])), vmovn_s32(vcombine_s32(y[2], y[3]))));
+   }
+#endif
+
+   for (; pos < end; pos += step, n++)
+   {
+      const int16_t *x = in + 2 * (pos >> 32);
+      const int32_t t  = (int32_t)((uint32_t)pos >> 17);
+      out[2 * n + 0]   = (int16_t)(x[0] + (((x[2] - x[0]) * t) >> 15));
+      out[2 * n + 1]   = (int16_t)(x[1] + (((x[3] - x[1]) * t) >> 15));
+   }
+
+   phase = pos - end;
+   return n;
+}
+
+static size_t resample_cubic(int16_t *out, const int16_t *ext, size_t frames, uint64_t step)
+{
+   const uint64_t end = (uint64_t)frames << 32;
+   const int16_t *in  = ext + 2 * (HISTORY_FRAMES - 3);
+   uint64_t pos       = phase;
+   size_t n           = 0;
+
+#if defined(__SSE2__)
+   for (; pos + 3 * step < end; pos += 4 * step, n += 4)
+   {
+      const uint64_t p1 = pos + step, p2 = pos + 2 * step, p3 = pos + 3 * step;
+      const __m128 t  = _mm_set_ps((uint32_t)p3 * (1.0f / 4294967296.0f), (uint32_t)p2 * (1.0f / 4294967296.0f),
+            (uint32_t)p1 * (1.0f / 4294967296.0f), (uint32_t)pos * (1.0f / 4294967296.0f));
+      const __m128 t2 = _mm_mul_ps(t, t), t3 = _mm_mul_ps(t2, t);
+      const __m128 half = _mm_set1_ps(0.5f);
+      __m128 w[4], l, r;
+      __m128i x[4], lo, hi;
+      unsigned j;
+
+      w[0] = _mm_mul_ps(half, _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.0f), t2), t3), t));
+      w[1] = _mm_mul_ps(half, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), t3),
+                  _mm_mul_ps(_mm_set1_ps(5.0f), t2)), _mm_set1_ps(2.0f)));
+      w[2] = _mm_mul_ps(half, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(4.0f), t2),
+                  _mm_mul_ps(_mm_set1_ps(3.0f), t3)), t));
+      w[3] = _mm_mul_ps(half, _mm_sub_ps(t3, t2));
+
+      /* the 4 taps of each output frame, then transposed to one tap of
+       * each output frame per register */
+      x[0] = _mm_loadu_si128((const __m128i*)(in + 2 * (pos >> 32)));
+      x[1] = _mm_loadu_si128((const __m128i*)(in + 2 * (p1 >> 32)));
+      x[2] = _mm_loadu_si128((const __m128i*)(in + 2 * (p2 >> 32)));
+      x[3] = _mm_loadu_si128((const __m128i*)(in + 2 * (p3 >> 32)));
+      lo   = _mm_unpacklo_epi32(x[0], x[1]);
+      hi   = _mm_unpacklo_epi32(x[2], x[3]);
+      x[0] = _mm_unpackhi_epi32(x[0], x[1]);
+      x[1] = _mm_unpackhi_epi32(x[2], x[3]);
+      x[2] = _mm_unpacklo_epi64(x[0], x[1]);
+      x[3] = _mm_unpackhi_epi64(x[0], x[1]);
+      x[0] = _mm_unpacklo_epi64(lo, hi);
+      x[1] = _mm_unpackhi_epi64(lo, hi);
+
+      l = _mm_setzero_ps();
+      r = _mm_setzero_ps();
+      for (j = 0; j < 4; j++)
+      {
+         const __m128 xl = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(x[j], 16), 16));
+         const __m128 xr = _mm_cvtepi32_ps(_mm_srai_epi32(x[j], 16));
+         l = j ? _mm_add_ps(l, _mm_mul_ps(w[j], xl)) : _mm_mul_ps(w[j], xl);
+         r = j ? _mm_add_ps(r, _mm_mul_ps(w[j], xr)) : _mm_mul_ps(w[j], xr);
+      }
+
+      lo = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(l, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f)));
+      hi = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(r, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f)));
+      _mm_storeu_si128((__m128i*)(out + 2 * n), _mm_packs_epi32(
+            _mm_unpacklo_epi32(lo, hi), _mm_unpackhi_epi32(lo, hi)));
+   }
+#elif defined(AUDIO_NEON)
+   for (; pos + 3 * step < end; pos += 4 * step, n += 4)
+   {
+      const uint64_t p1 = pos + step, p2 = pos + 2 * step, p3 = pos + 3 * step;
+      const float tv[4] = { (uint32_t)pos * (1.0f / 4294967296.0f), (uint32_t)p1 * (1.0f / 4294967296.0f),
+            (uint32_t)p2 * (1.0f / 4294967296.0f), (uint32_t)p3 * (1.0f / 4294967296.0f) };
+      const float32x4_t t  = vld1q_f32(tv);
+      const float32x4_t t2 = vmulq_f32(t, t), t3 = vmulq_f32(t2, t);
+      float32x4_t w[4], l, r;
+      int32x4_t x[4];
+      int32x4x2_t x01, x23;
+      int16x4x2_t lr;
+      unsigned j;
+
+      w[0] = vmulq_n_f32(vsubq_f32(vsubq_f32(vmulq_n_f32(t2, 2.0f), t3), t), 0.5f);
+      w[1] = vmulq_n_f32(vaddq_f32(vsubq_f32(vmulq_n_f32(t3, 3.0f), vmulq_n_f32(t2, 5.0f)),
+                  vdupq_n_f32(2.0f)), 0.5f);
+      w[2] = vmulq_n_f32(vaddq_f32(vsubq_f32(vmulq_n_f32(t2, 4.0f), vmulq_n_f32(t3, 3.0f)), t), 0.5f);
+      w[3] = vmulq_n_f32(vsubq_f32(t3, t2), 0.5f);
+
+      x01  = vtrnq_s32(vreinterpretq_s32_s16(vld1q_s16(in + 2 * (pos >> 32))),
+            vreinterpretq_s32_s16(vld1q_s16(in + 2 * (p1 >> 32))));
+      x23  = vtrnq_s32(vreinterpretq_s32_s16(vld1q_s16(in + 2 * (p2 >> 32))),
+            vreinterpretq_s32_s16(vld1q_s16(in + 2 * (p3 >> 32))));
+      x[0] = vcombine_s32(vget_low_s32(x01.val[0]), vget_low_s32(x23.val[0]));
+      x[1] = vcombine_s32(vget_low_s32(x01.val[1]), vget_low_s32(x23.val[1]));
+      x[2] = vcombine_s32(vget_high_s32(x01.val[0]), vget_high_s32(x23.val[0]));
+      x[3] = vcombine_s32(vget_high_s32(x01.val[1]), vget_high_s32(x23.val[1]));
+
+      l = vdupq_n_f32(0.0f);
+      r = vdupq_n_f32(0.0f);
+      for (j = 0; j < 4; j++)
+      {
+         const float32x4_t xl = vcvtq_f32_s32(vshrq_n_s32(vshlq_n_s32(x[j], 16), 16));
+         const float32x4_t xr = vcvtq_f32_s32(vshrq_n_s32(x[j], 16));
+         l = j ? vaddq_f32(l, vmulq_f32(w[j], xl)) : vmulq_f32(w[j], xl);
+         r = j ? vaddq_f32(r, vmulq_f32(w[j], xr)) : vmulq_f32(w[j], xr);
+      }
+
+      l  = vminq_f32(vmaxq_f32(l, vdupq_n_f32(-32768.0f)), vdupq_n_f32(32767.0f));
+      r  = vminq_f32(vmaxq_f32(r, vdupq_n_f32(-32768.0f)), vdupq_n_f32(32767.0f));
+      lr = vzip_s16(vmovn_s32(vcvtq_s32_f32(l)), vmovn_s32(vcvtq_s32_f32(r)));
+      vst1q_s16(out + 2 * n, vcombine_s16(lr.val[0], lr.val[1]));
+   }
+#endif
+
+   for (; pos < end; pos += step, n++)
+   {
+      const int16_t *x = in + 2 * (pos >> 32);
+      const float t  = (uint32_t)pos * (1.0f / 4294967296.0f);
+      const float t2 = t * t, t3 = t2 * t;
+      const float w0 = 0.5f * (-t3 + 2.0f * t2 - t);
+      const float w1 = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+      const float w2 = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+      const float w3 = 0.5f * (t3 - t2);
+
+      out[2 * n + 0] = clamp_s16(w0 * x[0] + w1 * x[2] + w2 * x[4] + w3 * x[6]);
+      out[2 * n + 1] = clamp_s16(w0 * x[1] + w1 * x[3] + w2 * x[5] + w3 * x[7]);
+   }
+
+   phase = pos - end;
+   return n;
+}
+
 static void aiLenChanged(void* user_data, const void* buffer, size_t size)
 {
    size_t max_frames, remain_frames;
-   uint32_t i;
    double ratio;
    struct resampler_data data = {0};
    int16_t *out      = NULL;
-   int16_t *raw_data = (int16_t*)buffer;
+   const int16_t *raw_data = (const int16_t*)buffer;
    size_t frames     = size / 4;
-   uint8_t *p        = (uint8_t*)buffer;
-
-   for (i = 0; i < size; i += 4)
-   {
-      p[i ] ^= p[i + 2];
-      p[i + 2] ^= p[i ];
-      p[i ] ^= p[i + 2];
-      p[i + 1] ^= p[i + 3];
-      p[i + 3] ^= p[i + 1];
-      p[i + 1] ^= p[i + 3];
-   }
+   size_t out_frames;
+   int64_t zone_start;
 
 audio_batch:
    out               = NULL;
-   ratio             = 44100.0 / GameFreq;
-   max_frames        = (GameFreq > 44100) ? MAX_AUDIO_FRAMES : (size_t)(MAX_AUDIO_FRAMES / ratio - 1);
+   ratio             = (double)OutputFreq / GameFreq;
+   max_frames        = (GameFreq > (int)OutputFreq) ? MAX_AUDIO_FRAMES : (size_t)(MAX_AUDIO_FRAMES / ratio - 1);
    remain_frames     = 0;
 
    if (frames > max_frames)
@@ -153,21 +454,49 @@ audio_batch:
       frames = max_frames;
    }
 
-   data.data_in      = audio_in_buffer_float;
-   data.data_out     = audio_out_buffer_float;
-   data.input_frames = frames;
-   data.ratio        = ratio;
+   zone_start = trace_enabled() ? trace_now() : 0;
+
+   /* the game already plays at the output rate */
+   if (GameFreq == (int)OutputFreq)
+   {
+      swap_s16(audio_out_buffer_s16, raw_data, frames);
+      out_frames = frames;
+   }
+   else if (resampler_mode == AUDIO_RESAMPLER_LINEAR || resampler_mode == AUDIO_RESAMPLER_CUBIC)
+   {
+      const uint64_t step = ((uint64_t)GameFreq << 32) / OutputFreq;
+
+      memcpy(audio_in_buffer_s16, history, sizeof(history));
+      swap_s16(audio_in_buffer_s16 + 2 * HISTORY_FRAMES, raw_data, frames);
+      if (resampler_mode == AUDIO_RESAMPLER_LINEAR)
+         out_frames = resample_linear(audio_out_buffer_s16, audio_in_buffer_s16, frames, step);
+      else
+         out_frames = resample_cubic(audio_out_buffer_s16, audio_in_buffer_s16, frames, step);
+      memcpy(history, audio_in_buffer_s16 + 2 * frames, sizeof(history));
+   }
+   else
+   {
+      data.data_in      = audio_in_buffer_float;
+      data.data_out     = audio_out_buffer_float;
+      data.input_frames = frames;
+      data.ratio        = ratio;
+
+      swap_s16_to_float(audio_in_buffer_float, raw_data, frames);
+      resampler->process(resampler_audio_data, &data);
+      convert_float_to_s16(audio_out_buffer_s16, audio_out_buffer_float, data.output_frames * 2);
+      out_frames = data.output_frames;
+   }
+   TRACE_END(zone_start, "audio resample");
 
-   convert_s16_to_float(audio_in_buffer_float, raw_data, frames * 2, 1.0f);
-   resampler->process(resampler_audio_data, &data);
-   convert_float_to_s16(audio_out_buffer_s16, audio_out_buffer_float, data.output_frames * 2);
+   if (capture_enabled())
+      capture_audio(audio_out_buffer_s16, out_frames, OutputFreq);
 
    out                    = audio_out_buffer_s16;
 
-   while (data.output_frames)
+   while (out_frames)
    {
-      size_t ret          = audio_batch_cb(out, data.output_frames);
-      data.output_frames -= ret;
+      size_t ret          = audio_batch_cb(out, out_frames);
+      out_frames         -= ret;
       out                += ret * 2;
    }
    if (remain_frames)
@@ -185,6 +514,10 @@ void push_audio_samples_via_libretro(void* user_data, const void* buffer, size_t
    uint32_t saved_ai_length = ai->regs[AI_LEN_REG];
    uint32_t saved_ai_dram = ai->regs[AI_DRAM_ADDR_REG];
 
+   /* samples of a run-ahead frame would be discarded anyway */
+   if (libretro_skip_audio)
+      return;
+
    /* notify plugin of new samples to play.
     * Exploit the fact that buffer points in ai->ri->rdram.dram to retrieve dram_addr_reg value */
    ai->regs[AI_DRAM_ADDR_REG] = (uint8_t*)buffer - (uint8_t*)g_dev.ri.rdram->dram;
@@ -24,7 +24,21 @@
 
 #include <stddef.h>
 
-void init_audio_libretro(unsigned max_frames);
+enum audio_resampler_mode
+{
+   AUDIO_RESAMPLER_SINC,
+   AUDIO_RESAMPLER_CUBIC,
+   AUDIO_RESAMPLER_LINEAR
+};
+
+/* An output_rate of 0 hands the samples over at the game's own rate. */
+void init_audio_libretro(unsigned max_frames, unsigned output_rate);
 void deinit_audio_libretro(void);
+void set_audio_resampler_libretro(enum audio_resampler_mode mode);
+
+/* Rate the samples are handed over at, and whether it changed since the
+ * last call, in which case the frontend has to be told. */
+unsigned get_audio_output_rate_libretro(void);
+int audio_output_rate_changed_libretro(void);
 
 #endif
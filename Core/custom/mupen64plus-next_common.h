@@ -55,6 +55,9 @@ void plugin_connect_rsp_api(enum rsp_plugin_type type);
 void plugin_connect_rdp_api(enum rdp_plugin_type type);
 void plugin_connect_all();
 
+// Asynchronous RDP command processing (mupen64plus-video-angrylion)
+void angrylion_sync(void);
+
 uint32_t get_retro_screen_width();
 uint32_t get_retro_screen_height();
 
@@ -63,6 +66,12 @@ extern enum rsp_plugin_type current_rsp_type;
 extern retro_environment_t environ_cb;
 extern bool libretro_swap_buffer;
 
+// Run-ahead, output of the frame being emulated is discarded
+extern bool libretro_skip_video;
+extern bool libretro_skip_audio;
+// Run-ahead, the frame being emulated is rolled back and can't be seen
+extern bool libretro_skip_rdp;
+
 // Misc Globals
 extern CONTROL Controls[4];
 extern struct xoshiro256pp_state l_mpk_idgen;
@@ -128,6 +137,9 @@ extern uint32_t EnableEnhancedHighResStorage;
 extern uint32_t EnableTxCacheCompression;
 extern uint32_t ForceDisableExtraMem;
 extern uint32_t IgnoreTLBExceptions;
+extern uint32_t IdleLoopDetection;
+extern uint32_t RunAheadFrames;
+extern uint32_t EnableAsyncHLEAudio;
 extern uint32_t EnableNativeResFactor;
 extern uint32_t EnableN64DepthCompare;
 extern uint32_t EnableThreadedRenderer;
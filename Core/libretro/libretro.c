@@ -48,6 +48,8 @@
 #include "main/version.h"
 #include "main/util.h"
 #include "main/savestates.h"
+#include "main/trace.h"
+#include "main/capture.h"
 #include "main/mupen64plus.ini.h"
 #include "api/m64p_config.h"
 #include "osal_files.h"
@@ -78,6 +80,8 @@ void angrylion_set_vi_blur(unsigned value);
 void angrylion_set_threads(unsigned value);
 void angrylion_set_overscan(unsigned value);
 void angrylion_set_synclevel(unsigned value);
+void angrylion_set_async(unsigned value);
+void angrylion_set_binning(unsigned value);
 void angrylion_set_vi_dedither(unsigned value);
 void angrylion_set_vi(unsigned value);
 
@@ -129,6 +133,7 @@ static uint32_t game_size = 0;
 
 static bool     emu_initialized     = false;
 static unsigned audio_buffer_size   = 2048;
+static unsigned audio_output_rate   = 44100;
 
 static unsigned retro_filtering      = 0;
 static bool     first_context_reset  = false;
@@ -138,6 +143,9 @@ static bool     load_game_successful = false;
 static bool     context_setup_first_init = false;
 
 bool libretro_swap_buffer;
+bool libretro_skip_video = false;
+bool libretro_skip_audio = false;
+bool libretro_skip_rdp = false;
 
 uint32_t *blitter_buf = NULL;
 uint32_t *blitter_buf_lock = NULL;
@@ -153,6 +161,13 @@ static char rdp_plugin_last[32] = {0};
 bool retro_savestate_complete = false;
 int  retro_savestate_result = 0;
 
+// Run-ahead globals
+static uint8_t* run_ahead_state = NULL;
+static bool     run_ahead_active = false;           // emulation is ahead, real state is in run_ahead_state
+static bool     run_ahead_restore_pending = false;  // rollback to run_ahead_state is queued
+static bool     run_ahead_saving = false;           // game thread yields once run_ahead_state is saved
+static bool     run_ahead_failed = false;           // couldn't save, run-ahead is off until unload
+
 // 64DD globals
 char* retro_dd_path_img = NULL;
 char* retro_dd_path_rom = NULL;
@@ -218,6 +233,9 @@ uint32_t CountPerOpDenomPot = 0;
 uint32_t CountPerScanlineOverride = 0;
 uint32_t ForceDisableExtraMem = 0;
 uint32_t IgnoreTLBExceptions = 0;
+uint32_t IdleLoopDetection = 0;
+uint32_t RunAheadFrames = 0;
+uint32_t EnableAsyncHLEAudio = 0;
 
 extern struct device g_dev;
 extern unsigned int r4300_emumode;
@@ -392,6 +410,15 @@ static void cleanup_global_paths()
     }
 }
 
+// Run-ahead frames are thrown away, the audio backend and the RSP plugin
+// (for HLE audio tasks) both get told to skip their work
+static void set_skip_audio(bool skip)
+{
+    libretro_skip_audio = skip;
+    if (rsp.setSkipAudio)
+        rsp.setSkipAudio(skip);
+}
+
 static void n64StateCallback(void *Context, m64p_core_param param_type, int new_value)
 {
     if(param_type == M64CORE_STATE_LOADCOMPLETE || param_type == M64CORE_STATE_SAVECOMPLETE)
@@ -399,6 +426,20 @@ static void n64StateCallback(void *Context, m64p_core_param param_type, int new_
         retro_savestate_complete = true;
         retro_savestate_result = new_value;
     }
+
+    // Run-ahead rollback done, from now on audio belongs to the real frame
+    if(param_type == M64CORE_STATE_LOADCOMPLETE && run_ahead_restore_pending)
+    {
+        run_ahead_restore_pending = false;
+        set_skip_audio(false);
+    }
+
+    // Run-ahead state saved, let retro_run_ahead check it before emulating ahead
+    if(param_type == M64CORE_STATE_SAVECOMPLETE && run_ahead_saving)
+    {
+        run_ahead_saving = false;
+        co_switch(retro_thread);
+    }
 }
 
 static bool emu_step_load_data()
@@ -669,7 +710,7 @@ void retro_get_system_av_info(struct retro_system_av_info *info)
         parallel_get_geometry(&info->geometry);
 #endif
     info->timing.fps = vi_expected_refresh_rate_from_tv_standard(ROM_PARAMS.systemtype);
-    info->timing.sample_rate = 44100.0;
+    info->timing.sample_rate = get_audio_output_rate_libretro();
 }
 
 unsigned retro_get_region (void)
@@ -874,12 +915,15 @@ static void update_variables(bool startup)
              {
 #if defined(HAVE_PARALLEL_RSP)
                 plugin_connect_rsp_api(RSP_PLUGIN_PARALLEL);
-                log_cb(RETRO_LOG_INFO, "Selected HLE RSP with Angrylion, falling back to Parallel RSP!\n");
+                if (log_cb)
+                   log_cb(RETRO_LOG_INFO, "Selected HLE RSP with Angrylion, falling back to Parallel RSP!\n");
 #elif defined(HAVE_LLE)
                 plugin_connect_rsp_api(RSP_PLUGIN_CXD4);
-                log_cb(RETRO_LOG_INFO, "Selected HLE RSP with Angrylion, falling back to CXD4!\n");
+                if (log_cb)
+                   log_cb(RETRO_LOG_INFO, "Selected HLE RSP with Angrylion, falling back to CXD4!\n");
 #else
-                log_cb(RETRO_LOG_INFO, "Requested Angrylion but no LLE RSP available, falling back to GLideN64!\n");
+                if (log_cb)
+                   log_cb(RETRO_LOG_INFO, "Requested Angrylion but no LLE RSP available, falling back to GLideN64!\n");
                 plugin_connect_rsp_api(RSP_PLUGIN_HLE);
                 plugin_connect_rdp_api(RDP_PLUGIN_GLIDEN64);
 #endif 
@@ -907,7 +951,8 @@ static void update_variables(bool startup)
 #elif defined(HAVE_LLE)
              plugin_connect_rsp_api(RSP_PLUGIN_CXD4);
 #else
-             log_cb(RETRO_LOG_INFO, "Requested Angrylion but no LLE RSP available, falling back to GLideN64!\n");
+             if (log_cb)
+                log_cb(RETRO_LOG_INFO, "Requested Angrylion but no LLE RSP available, falling back to GLideN64!\n");
              plugin_connect_rdp_api(RDP_PLUGIN_GLIDEN64);
              plugin_connect_rsp_api(RSP_PLUGIN_HLE);
 #endif 
@@ -922,9 +967,11 @@ static void update_variables(bool startup)
           {
 #if defined(HAVE_LLE)
              plugin_connect_rsp_api(RSP_PLUGIN_CXD4);
-             log_cb(RETRO_LOG_INFO, "Selected Parallel RSP without JIT, falling back to CXD4!\n");
+             if (log_cb)
+                log_cb(RETRO_LOG_INFO, "Selected Parallel RSP without JIT, falling back to CXD4!\n");
 #else
-             log_cb(RETRO_LOG_INFO, "Selected Parallel RSP without JIT, falling back to GLideN64!\n");
+             if (log_cb)
+                log_cb(RETRO_LOG_INFO, "Selected Parallel RSP without JIT, falling back to GLideN64!\n");
              plugin_connect_rsp_api(RSP_PLUGIN_HLE);
              plugin_connect_rdp_api(RDP_PLUGIN_GLIDEN64);
 #endif
@@ -932,6 +979,13 @@ static void update_variables(bool startup)
        }
 #endif
 
+       var.key = CORE_NAME "-AudioOutputRate";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          audio_output_rate = !strcmp(var.value, "native") ? 0 : strtol(var.value, NULL, 10);
+       }
+
        var.key = CORE_NAME "-ThreadedRenderer";
        var.value = NULL;
        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1530,6 +1584,18 @@ static void update_variables(bool startup)
           else if (!strcmp(var.value, "AlwaysIgnoreTLB"))
              IgnoreTLBExceptions = 2;
        }
+
+       var.key = CORE_NAME "-IdleLoopDetection";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          if (!strcmp(var.value, "Trivial"))
+             IdleLoopDetection = 1;
+          else if (!strcmp(var.value, "Polling"))
+             IdleLoopDetection = 2;
+          else
+             IdleLoopDetection = 0;
+       }
     }
 
 #ifdef HAVE_PARALLEL_RDP
@@ -1740,6 +1806,22 @@ static void update_variables(bool startup)
         else
            angrylion_set_threads(0);
 
+        var.key = CORE_NAME "-angrylion-async";
+        var.value = NULL;
+
+        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+           angrylion_set_async(!strcmp(var.value, "enabled"));
+        else
+           angrylion_set_async(0);
+
+        var.key = CORE_NAME "-angrylion-binning";
+        var.value = NULL;
+
+        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+           angrylion_set_binning(!strcmp(var.value, "enabled"));
+        else
+           angrylion_set_binning(0);
+
         var.key = CORE_NAME "-angrylion-overscan";
         var.value = NULL;
 
@@ -1759,6 +1841,52 @@ static void update_variables(bool startup)
     }
 #endif // HAVE_THR_AL
 
+    var.key = CORE_NAME "-RunAhead";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+       RunAheadFrames = !strcmp(var.value, "Disabled") ? 0 : atoi(var.value);
+    }
+
+    var.key = CORE_NAME "-AsyncHLEAudio";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+       EnableAsyncHLEAudio = !strcmp(var.value, "True") ? 1 : 0;
+    }
+
+    var.key = CORE_NAME "-Trace";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+       // only act on changes, so that a trace started with M64P_TRACE keeps going
+       static bool trace_option;
+       bool enable = !strcmp(var.value, "enabled");
+       if (enable != trace_option)
+       {
+          const char* trace_path = getenv("M64P_TRACE");
+          trace_option = enable;
+          if (!enable)
+             trace_stop();
+          else if (trace_path != NULL && trace_path[0] != '\0')
+             trace_start(trace_path);
+          else
+             trace_start(ConfigGetSharedDataFilepath("trace.json"));
+       }
+    }
+
+    var.key = CORE_NAME "-AudioResampler";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+       if (!strcmp(var.value, "cubic"))
+          set_audio_resampler_libretro(AUDIO_RESAMPLER_CUBIC);
+       else if (!strcmp(var.value, "linear"))
+          set_audio_resampler_libretro(AUDIO_RESAMPLER_LINEAR);
+       else
+          set_audio_resampler_libretro(AUDIO_RESAMPLER_SINC);
+    }
+
     update_controllers();
 
     // Hide irrelevant options
@@ -1937,7 +2065,7 @@ bool retro_load_game(const struct retro_game_info *game)
        game_thread = co_create(65536 * sizeof(void*) * 16, gln64_thr_gl_invoke_command_loop);
     }
 
-    init_audio_libretro(audio_buffer_size);
+    init_audio_libretro(audio_buffer_size, audio_output_rate);
 
     params.context_reset         = context_reset;
     params.context_destroy       = context_destroy;
@@ -2018,12 +2146,97 @@ void retro_unload_game(void)
 
     // Reset savestate job var
     retro_savestate_complete = false;
+
+    free(run_ahead_state);
+    run_ahead_state = NULL;
+    run_ahead_active = false;
+    run_ahead_failed = false;
+}
+
+#ifdef HAVE_THR_AL
+static void capture_software_frame(const void *pixels, unsigned width, unsigned height, unsigned pitch)
+{
+    void *dst;
+    int slot = capture_begin_frame(width, height, pitch, CAPTURE_BGRA8888, &dst);
+    if (slot < 0)
+       return;
+
+    memcpy(dst, pixels, (size_t)height * pitch);
+    capture_submit_frame(slot);
+}
+#endif // HAVE_THR_AL
+
+static bool run_ahead_enabled(void)
+{
+    if (!RunAheadFrames || initializing || run_ahead_failed)
+       return false;
+
+    // The threaded renderer doesn't return to us on VI
+    if (current_rdp_type == RDP_PLUGIN_GLIDEN64 && EnableThreadedRenderer)
+       return false;
+
+    if (!run_ahead_state)
+       run_ahead_state = (uint8_t*)malloc(retro_serialize_size());
+
+    return run_ahead_state != NULL;
+}
+
+static void retro_run_ahead(void)
+{
+    unsigned i;
+
+    // Real frame, only its audio is kept
+    libretro_skip_video = true;
+    co_switch(game_thread);
+    libretro_skip_video = false;
+
+    // Save the real state when resuming on VI. The game thread comes back
+    // as soon as it is saved, or on the next VI if it couldn't be saved
+    // during a whole frame, in which case that frame just ran normally.
+    retro_savestate_complete = false;
+    run_ahead_saving = true;
+    savestates_set_job(savestates_job_save, savestates_type_m64p, (const char*)run_ahead_state);
+    co_switch(game_thread);
+    run_ahead_saving = false;
+
+    if (!retro_savestate_complete || !retro_savestate_result)
+    {
+       if (log_cb)
+          log_cb(RETRO_LOG_WARN, CORE_NAME ": Run-ahead state couldn't be saved, disabling run-ahead\n");
+
+       run_ahead_failed = true;
+       if (retro_savestate_complete)
+          gfx.updateScreen();
+       else
+          savestates_set_job(savestates_job_nothing, savestates_type_unknown, NULL);
+       return;
+    }
+
+    // Emulate the frames which only serve to present the future; their
+    // audio is thrown away and only the last one is drawn. The RDP only
+    // runs for the last two, the presented frame usually scans out the
+    // buffer drawn during the one before.
+    set_skip_audio(true);
+
+    for (i = 0; i < RunAheadFrames; i++)
+    {
+       libretro_skip_video = (i + 1 < RunAheadFrames);
+       libretro_skip_rdp = (i + 2 < RunAheadFrames);
+       libretro_swap_buffer = false;
+       co_switch(game_thread);
+    }
+
+    libretro_skip_video = false;
+    libretro_skip_rdp = false;
+    set_skip_audio(false);
+    run_ahead_active = true;
 }
 
 void retro_run (void)
 {
     libretro_swap_buffer = false;
     static bool updated = false;
+    TRACE_BEGIN(zone_start);
 
     if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated) {
        update_variables(false);
@@ -2044,7 +2257,32 @@ void retro_run (void)
        glsm_ctl(GLSM_CTL_STATE_BIND, NULL);
     }
 
-    co_switch(game_thread);
+    if (run_ahead_active)
+    {
+       // Roll back to the real timeline first, whatever runs before
+       // the load job gets picked up must stay silent
+       run_ahead_active = false;
+       run_ahead_restore_pending = true;
+       set_skip_audio(true);
+       savestates_set_job(savestates_job_load, savestates_type_m64p, (const char*)run_ahead_state);
+    }
+
+    if (run_ahead_enabled())
+    {
+       retro_run_ahead();
+    }
+    else
+    {
+       co_switch(game_thread);
+    }
+
+    // In native mode the game changed its DAC rate during the frame
+    if (audio_output_rate_changed_libretro())
+    {
+       struct retro_system_av_info info;
+       retro_get_system_av_info(&info);
+       environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &info);
+    }
 
     if(current_rdp_type == RDP_PLUGIN_GLIDEN64)
     {
@@ -2060,6 +2298,8 @@ void retro_run (void)
 #ifdef HAVE_THR_AL
        else if(current_rdp_type == RDP_PLUGIN_ANGRYLION)
        {
+          if (capture_enabled())
+             capture_software_frame(prescale, retro_screen_width, retro_screen_height, screen_pitch);
           video_cb(prescale, retro_screen_width, retro_screen_height, screen_pitch);
        }
 #endif // HAVE_THR_AL
@@ -2078,10 +2318,17 @@ void retro_run (void)
         // screen_pitch will be 0 for GLN
         video_cb(NULL, retro_screen_width, retro_screen_height, screen_pitch);
     }
+
+    // The frontend keeps showing the last frame
+    if (!libretro_swap_buffer)
+        capture_repeat_frame();
+
+    TRACE_END(zone_start, "retro_run");
 }
 
 void retro_reset (void)
 {
+    run_ahead_active = false;
     CoreDoCommand(M64CMD_RESET, 0, (void*)0);
 }
 
@@ -2120,6 +2367,13 @@ bool retro_serialize(void *data, size_t size)
    if (initializing)
       return false;
 
+   // Emulation is running ahead, the real state is already serialized
+   if (run_ahead_active)
+   {
+      memcpy(data, run_ahead_state, retro_serialize_size());
+      return true;
+   }
+
    retro_savestate_complete = false;
    retro_savestate_result = 0;
 
@@ -2153,6 +2407,8 @@ bool retro_unserialize(const void *data, size_t size)
    if (initializing)
       return false;
 
+   run_ahead_active = false;
+
    retro_savestate_complete = false;
    retro_savestate_result = 0;
 
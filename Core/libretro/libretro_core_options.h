@@ -1355,6 +1355,34 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "all threads"
     },
+    {
+        CORE_NAME "-angrylion-async",
+        "Asynchronous RDP",
+        NULL,
+        "(AL) Run RDP commands in the background while emulation continues. Waits at full sync and VI updates. Requires multi-threading.",
+        "Run RDP commands in the background while emulation continues. Waits at full sync and VI updates. Requires multi-threading.",
+        "angrylion",
+        {
+            {"disabled", NULL},
+            {"enabled", NULL},
+            { NULL, NULL },
+        },
+        "disabled"
+    },
+    {
+        CORE_NAME "-angrylion-binning",
+        "Screen Bin Work Split",
+        NULL,
+        "(AL) Split rendering between threads by bands of scanlines, so threads skip primitives outside their bands. Can help with many threads. Not used with Asynchronous RDP.",
+        "Split rendering between threads by bands of scanlines, so threads skip primitives outside their bands. Can help with many threads. Not used with Asynchronous RDP.",
+        "angrylion",
+        {
+            {"disabled", NULL},
+            {"enabled", NULL},
+            { NULL, NULL },
+        },
+        "disabled"
+    },
     {
         CORE_NAME "-angrylion-overscan",
         "Hide overscan",
@@ -1428,6 +1456,83 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         "False"
 #endif
     },
+    {
+        CORE_NAME "-RunAhead",
+        "Run-Ahead",
+        NULL,
+        "Emulate frames ahead and roll back to hide the game's internal input lag. Each frame costs an extra savestate and emulated frame, only use as many as the game lags.",
+        NULL,
+        NULL,
+        {
+            {"Disabled", NULL},
+            {"1", NULL},
+            {"2", NULL},
+            {"3", NULL},
+            {"4", NULL},
+            { NULL, NULL },
+        },
+        "Disabled"
+    },
+    {
+        CORE_NAME "-AsyncHLEAudio",
+        "Threaded HLE Audio",
+        NULL,
+        "Process HLE audio lists on a separate thread while the CPU keeps running, the CPU only waits when it touches memory the list uses. Only used with the HLE RSP plugin and the interpreters.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+    {
+        CORE_NAME "-Trace",
+        "Record Trace",
+        NULL,
+        "Record a timeline of the emulation, audio and renderer threads while enabled. It is written as Chrome trace JSON when disabled or when the game is closed, to M64P_TRACE if set or to Mupen64plus/trace.json in the system directory.",
+        NULL,
+        NULL,
+        {
+            {"disabled", NULL},
+            {"enabled", NULL},
+            { NULL, NULL },
+        },
+        "disabled"
+    },
+    {
+        CORE_NAME "-AudioOutputRate",
+        "Audio Output Rate",
+        NULL,
+        "Sample rate handed to the frontend. Games which already play at this rate skip resampling. Native never resamples and makes the frontend follow the game, which reinitialises its audio each time the game changes rate. Requires a restart.",
+        NULL,
+        NULL,
+        {
+            {"native", "Native"},
+            {"44100", "44100 Hz"},
+            {"48000", "48000 Hz"},
+            {"32000", "32000 Hz"},
+            {"22050", "22050 Hz"},
+            { NULL, NULL },
+        },
+        "44100"
+    },
+    {
+        CORE_NAME "-AudioResampler",
+        "Audio Resampler",
+        NULL,
+        "Sinc sounds best, Cubic and Linear cost far less CPU time.",
+        NULL,
+        NULL,
+        {
+            {"sinc", "Sinc"},
+            {"cubic", "Cubic"},
+            {"linear", "Linear"},
+            { NULL, NULL },
+        },
+        "sinc"
+    },
     {
         CORE_NAME "-Framerate",
         "Framerate",
@@ -1486,6 +1591,21 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "False"
     },
+    {
+        CORE_NAME "-IdleLoopDetection",
+        "Idle Loop Detection",
+        NULL,
+        "Which busy-wait loops skip ahead to the next interrupt. Auto uses the embedded Database (trivial branch-to-self loops unless the game enables more). Polling also skips loops that only poll RDRAM, which saves host CPU on low-power devices.",
+        NULL,
+        NULL,
+        {
+            {"Auto", NULL},
+            {"Trivial", NULL},
+            {"Polling", NULL},
+            { NULL, NULL },
+        },
+        "Auto"
+    },
     {
         CORE_NAME "-CountPerOp",
         "Count Per Op",
@@ -71,6 +71,11 @@ typedef struct {
     void (*ShowCFB)(void);
 } RSP_INFO;
 
+typedef struct {
+    unsigned int address;   /* RDRAM offset */
+    unsigned int length;    /* in bytes */
+} RSP_DRAM_RANGE;
+
 typedef struct {
     unsigned char * HEADER;  /* This is the rom header (first 40h bytes of the rom) */
     unsigned char * RDRAM;
@@ -288,9 +293,15 @@ EXPORT void CALL SetVRUWordMask(uint8_t length, uint8_t *mask);
 /* RSP plugin function pointers */
 typedef unsigned int (*ptr_DoRspCycles)(unsigned int Cycles);
 typedef void (*ptr_InitiateRSP)(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+typedef void (*ptr_SetSkipAudio)(int Skip);
+typedef int  (*ptr_StartAsyncTask)(RSP_DRAM_RANGE *Ranges, int MaxRanges);
+typedef void (*ptr_WaitAsyncTask)(void);
 #if defined(M64P_PLUGIN_PROTOTYPES)
 EXPORT unsigned int CALL DoRspCycles(unsigned int Cycles);
 EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+EXPORT void CALL SetSkipAudio(int Skip);
+EXPORT int  CALL StartAsyncTask(RSP_DRAM_RANGE *Ranges, int MaxRanges);
+EXPORT void CALL WaitAsyncTask(void);
 #endif
 
 #ifdef __cplusplus
@@ -287,6 +287,7 @@ typedef struct
    unsigned int countperop; /* Number of CPU cycles per instruction. */
    unsigned int sidmaduration; /* Default SI DMA duration */
    unsigned int aidmamodifier; /* Percentage modifier for AI DMA duration */
+   unsigned char idleloopdetection; /* 0 - Trivial idle loops only, 1 - Also polling loops */
 } m64p_rom_settings;
 
 /* ----------------------------------------- */
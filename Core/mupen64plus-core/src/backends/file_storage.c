@@ -21,7 +21,15 @@
 
 #include "file_storage.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
@@ -32,6 +40,294 @@
 
 #include <libretro_private.h>
 #include <mupen64plus-next_common.h>
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+
+/* Save media is written behind the emulation thread.  The save callback
+ * only copies the written bytes into a shadow copy of the file and queues
+ * the storage; a writer thread replaces the file with the shadow once the
+ * game has not written for WRITE_DELAY_USEC, or at the latest
+ * WRITE_MAX_DELAY_USEC after the first unsaved write, so a burst of small
+ * writes costs a single file write.
+ *
+ * Media larger than ATOMIC_REPLACE_MAX_SIZE (64DD disks) are only replaced
+ * as a whole the first time; afterwards the WRITE_CHUNK_SIZE chunks dirtied
+ * since the last write are written in place. */
+#define WRITE_DELAY_USEC        500000
+#define WRITE_MAX_DELAY_USEC    2000000
+#define WRITE_CHUNK_SIZE        0x4000
+#define ATOMIC_REPLACE_MAX_SIZE 0x40000
+
+static slock_t* writer_lock;
+static scond_t* writer_cond;
+static sthread_t* writer_thread;
+static struct file_storage* dirty_list;
+static int writer_quit;
+
+static void reset_write_behind(struct file_storage* fstorage)
+{
+    fstorage->shadow = NULL;
+    fstorage->dirty_chunks = NULL;
+    fstorage->synced = 0;
+    fstorage->first_dirty = 0;
+    fstorage->last_dirty = 0;
+    fstorage->queued = 0;
+    fstorage->writing = 0;
+    fstorage->next_dirty = NULL;
+}
+
+static int replace_file(const char* tmp_filename, const char* filename)
+{
+#ifdef _WIN32
+    return MoveFileExA(tmp_filename, filename, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(tmp_filename, filename);
+#endif
+}
+
+static size_t chunk_count(const struct file_storage* fstorage)
+{
+    return (fstorage->size + WRITE_CHUNK_SIZE - 1) / WRITE_CHUNK_SIZE;
+}
+
+static void mark_dirty_chunks(struct file_storage* fstorage, size_t start, size_t size)
+{
+    size_t chunk;
+
+    if (fstorage->dirty_chunks == NULL || size == 0)
+        return;
+
+    for (chunk = start / WRITE_CHUNK_SIZE; chunk <= (start + size - 1) / WRITE_CHUNK_SIZE; ++chunk)
+        fstorage->dirty_chunks[chunk >> 3] |= (uint8_t)(1 << (chunk & 7));
+}
+
+/* Writes the shadow of fstorage to a temporary file next to it and moves
+ * it over the old file, so a crash never leaves a half written save.
+ * The lock is only taken to copy each chunk out of the shadow. */
+static int replace_storage_file(struct file_storage* fstorage)
+{
+    uint8_t chunk[WRITE_CHUNK_SIZE];
+    size_t offset, size = fstorage->size;
+    char* tmp_filename;
+    int ok;
+    FILE* f;
+
+    tmp_filename = malloc(strlen(fstorage->filename) + 5);
+    if (tmp_filename == NULL)
+        return 0;
+
+    strcpy(tmp_filename, fstorage->filename);
+    strcat(tmp_filename, ".tmp");
+    f = fopen(tmp_filename, "wb");
+
+    if (f == NULL) {
+        log_cb(RETRO_LOG_WARN, "Couldn't open storage file '%s' for writing\n", fstorage->filename);
+        free(tmp_filename);
+        return 0;
+    }
+
+    ok = 1;
+    for (offset = 0; ok && offset < size; offset += WRITE_CHUNK_SIZE) {
+        size_t n = (size - offset < WRITE_CHUNK_SIZE) ? size - offset : WRITE_CHUNK_SIZE;
+
+        slock_lock(writer_lock);
+        memcpy(chunk, fstorage->shadow + offset, n);
+        slock_unlock(writer_lock);
+
+        ok = (fwrite(chunk, 1, n, f) == n);
+    }
+
+    ok = (fflush(f) == 0) && ok;
+#ifndef _WIN32
+    ok = ok && (fsync(fileno(f)) == 0);
+#endif
+    ok = (fclose(f) == 0) && ok;
+    ok = ok && (replace_file(tmp_filename, fstorage->filename) == 0);
+    if (!ok)
+        remove(tmp_filename);
+    free(tmp_filename);
+
+    return ok;
+}
+
+/* Writes the dirty chunks of the shadow of fstorage over the file, which
+ * has to hold the shadow content everywhere else. Runs of consecutive
+ * chunks are written without seeking. */
+static int update_storage_file(struct file_storage* fstorage)
+{
+    uint8_t buffer[WRITE_CHUNK_SIZE];
+    size_t chunk, count = chunk_count(fstorage);
+    size_t position = 0;
+    int ok = 1;
+    FILE* f;
+
+    f = fopen(fstorage->filename, "r+b");
+    if (f == NULL)
+        return 0;
+
+    for (chunk = 0; ok && chunk < count; ++chunk) {
+        size_t offset = chunk * WRITE_CHUNK_SIZE;
+        size_t n = (fstorage->size - offset < WRITE_CHUNK_SIZE) ? fstorage->size - offset : WRITE_CHUNK_SIZE;
+        uint8_t bit = (uint8_t)(1 << (chunk & 7));
+        int dirty;
+
+        slock_lock(writer_lock);
+        dirty = (fstorage->dirty_chunks[chunk >> 3] & bit) != 0;
+        if (dirty) {
+            fstorage->dirty_chunks[chunk >> 3] &= ~bit;
+            memcpy(buffer, fstorage->shadow + offset, n);
+        }
+        slock_unlock(writer_lock);
+
+        if (!dirty)
+            continue;
+
+        if (position != offset)
+            ok = (fseek(f, (long)offset, SEEK_SET) == 0);
+        ok = ok && (fwrite(buffer, 1, n, f) == n);
+        position = offset + n;
+    }
+
+    ok = (fflush(f) == 0) && ok;
+#ifndef _WIN32
+    ok = ok && (fsync(fileno(f)) == 0);
+#endif
+    ok = (fclose(f) == 0) && ok;
+
+    return ok;
+}
+
+/* Puts the shadow of fstorage on disk. Called with writer_lock held; the
+ * lock is dropped during file I/O. */
+static void write_storage_locked(struct file_storage* fstorage)
+{
+    struct file_storage** link;
+    int in_place, ok;
+
+    for (link = &dirty_list; *link != NULL; link = &(*link)->next_dirty) {
+        if (*link == fstorage) {
+            *link = fstorage->next_dirty;
+            break;
+        }
+    }
+    fstorage->next_dirty = NULL;
+    fstorage->queued = 0;
+    fstorage->writing = 1;
+
+    /* the whole shadow is written, so are the chunks dirty until now */
+    in_place = fstorage->synced && fstorage->dirty_chunks != NULL;
+    if (!in_place && fstorage->dirty_chunks != NULL)
+        memset(fstorage->dirty_chunks, 0, (chunk_count(fstorage) + 7) / 8);
+    slock_unlock(writer_lock);
+
+    ok = in_place ? update_storage_file(fstorage) : replace_storage_file(fstorage);
+    if (!ok)
+        log_cb(RETRO_LOG_WARN, "Failed to write storage file '%s'\n", fstorage->filename);
+
+    slock_lock(writer_lock);
+    /* the next write replaces the whole file again if this one failed */
+    fstorage->synced = ok;
+    fstorage->writing = 0;
+    scond_broadcast(writer_cond);
+}
+
+static void file_storage_writer(void* userdata)
+{
+    (void)userdata;
+
+    slock_lock(writer_lock);
+    while (!writer_quit || dirty_list != NULL)
+    {
+        struct file_storage* fstorage;
+        struct file_storage* due = NULL;
+        int64_t now = cpu_features_get_time_usec();
+        int64_t wait = -1;
+
+        for (fstorage = dirty_list; fstorage != NULL; fstorage = fstorage->next_dirty) {
+            int64_t deadline = fstorage->last_dirty + WRITE_DELAY_USEC;
+            if (deadline > fstorage->first_dirty + WRITE_MAX_DELAY_USEC)
+                deadline = fstorage->first_dirty + WRITE_MAX_DELAY_USEC;
+
+            if (writer_quit || now >= deadline) {
+                due = fstorage;
+                break;
+            }
+            if (wait < 0 || deadline - now < wait)
+                wait = deadline - now;
+        }
+
+        if (due != NULL)
+            write_storage_locked(due);
+        else if (wait < 0)
+            scond_wait(writer_cond, writer_lock);
+        else
+            scond_wait_timeout(writer_cond, writer_lock, wait);
+    }
+    slock_unlock(writer_lock);
+}
+
+static int start_file_storage_writer(void)
+{
+    if (writer_thread != NULL)
+        return 1;
+
+    writer_lock = slock_new();
+    writer_cond = scond_new();
+    writer_quit = 0;
+    if (writer_lock != NULL && writer_cond != NULL)
+        writer_thread = sthread_create(file_storage_writer, NULL);
+
+    if (writer_thread == NULL) {
+        if (writer_cond != NULL)
+            scond_free(writer_cond);
+        if (writer_lock != NULL)
+            slock_free(writer_lock);
+        writer_cond = NULL;
+        writer_lock = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void stop_file_storage_writer(void)
+{
+    if (writer_thread == NULL)
+        return;
+
+    slock_lock(writer_lock);
+    writer_quit = 1;
+    scond_broadcast(writer_cond);
+    slock_unlock(writer_lock);
+
+    sthread_join(writer_thread);
+    scond_free(writer_cond);
+    slock_free(writer_lock);
+    writer_thread = NULL;
+    writer_cond = NULL;
+    writer_lock = NULL;
+}
+
+void flush_file_storage(struct file_storage* fstorage)
+{
+    if (fstorage->shadow == NULL)
+        return;
+
+    if (writer_thread != NULL) {
+        slock_lock(writer_lock);
+        while (fstorage->writing)
+            scond_wait(writer_cond, writer_lock);
+        if (fstorage->queued)
+            write_storage_locked(fstorage);
+        slock_unlock(writer_lock);
+    }
+
+    free(fstorage->shadow);
+    free(fstorage->dirty_chunks);
+    fstorage->shadow = NULL;
+    fstorage->dirty_chunks = NULL;
+    fstorage->synced = 0;
+    fstorage->first_access = 1;
+}
 
 int open_file_storage(struct file_storage* fstorage, size_t size, const char* filename)
 {
@@ -39,6 +335,7 @@ int open_file_storage(struct file_storage* fstorage, size_t size, const char* fi
     fstorage->filename = filename;
     fstorage->size = size;
     fstorage->first_access = 1;
+    reset_write_behind(fstorage);
 
     /* allocate memory for holding data */
     fstorage->data = malloc(fstorage->size);
@@ -63,6 +360,7 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
     fstorage->size = 0;
     fstorage->filename = NULL;
     fstorage->first_access = 1;
+    reset_write_behind(fstorage);
 
     file_status_t err = load_file(filename, (void**)&fstorage->data, &fstorage->size);
 
@@ -76,6 +374,8 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
 
 void close_file_storage(struct file_storage* fstorage)
 {
+    flush_file_storage(fstorage);
+
     if(fstorage->data)
     {
         free((void*)fstorage->data);
@@ -102,13 +402,8 @@ static size_t file_storage_size(const void* storage)
     return fstorage->size;
 }
 
-static void file_storage_save(void* storage, size_t start, size_t size)
+static void file_storage_save_sync(struct file_storage* fstorage, size_t start, size_t size)
 {
-    if (netplay_is_init() && netplay_get_controller(0) == -1)
-        return;
-    
-    struct file_storage* fstorage = (struct file_storage*)storage;
-
     file_status_t err;
 
     /* On first save access ignore start/size and write full storage content,
@@ -134,6 +429,60 @@ static void file_storage_save(void* storage, size_t start, size_t size)
     }
 }
 
+static void file_storage_save(void* storage, size_t start, size_t size)
+{
+    if (netplay_is_init() && netplay_get_controller(0) == -1)
+        return;
+    
+    struct file_storage* fstorage = (struct file_storage*)storage;
+    int64_t now;
+
+    if (start >= fstorage->size)
+        return;
+    if (size > fstorage->size - start)
+        size = fstorage->size - start;
+
+    /* Fall back to writing in place if the writer can't be set up */
+    if (!start_file_storage_writer()) {
+        file_storage_save_sync(fstorage, start, size);
+        return;
+    }
+
+    now = cpu_features_get_time_usec();
+    slock_lock(writer_lock);
+
+    /* On first save access take a shadow of the full storage content,
+     * otherwise copy only the updated chunk */
+    if (fstorage->shadow == NULL) {
+        fstorage->shadow = malloc(fstorage->size);
+        if (fstorage->shadow == NULL) {
+            slock_unlock(writer_lock);
+            file_storage_save_sync(fstorage, start, size);
+            return;
+        }
+        memcpy(fstorage->shadow, fstorage->data, fstorage->size);
+        fstorage->first_access = 0;
+        /* without it the whole file is replaced on every write */
+        if (fstorage->size > ATOMIC_REPLACE_MAX_SIZE)
+            fstorage->dirty_chunks = calloc((chunk_count(fstorage) + 7) / 8, 1);
+    }
+    else {
+        memcpy(fstorage->shadow + start, fstorage->data + start, size);
+        mark_dirty_chunks(fstorage, start, size);
+    }
+
+    if (!fstorage->queued) {
+        fstorage->first_dirty = now;
+        fstorage->queued = 1;
+        fstorage->next_dirty = dirty_list;
+        dirty_list = fstorage;
+        scond_broadcast(writer_cond);
+    }
+    fstorage->last_dirty = now;
+
+    slock_unlock(writer_lock);
+}
+
 static void file_storage_parent_save(void* storage, size_t start, size_t size)
 {
     struct file_storage* fstorage = (struct file_storage*)((struct file_storage*)storage)->filename;
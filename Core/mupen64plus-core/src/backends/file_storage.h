@@ -31,6 +31,16 @@ struct file_storage
     size_t size;
     const char* filename;
     int first_access;
+
+    /* write-behind state, see file_storage.c */
+    uint8_t* shadow;
+    uint8_t* dirty_chunks;
+    int synced;
+    int64_t first_dirty;
+    int64_t last_dirty;
+    int queued;
+    int writing;
+    struct file_storage* next_dirty;
 };
 
 
@@ -38,6 +48,13 @@ int open_file_storage(struct file_storage* storage, size_t size, const char* fil
 int open_rom_file_storage(struct file_storage* storage, const char* filename);
 void close_file_storage(struct file_storage* storage);
 
+/* Puts any pending writes of storage on disk and drops its shadow copy.
+ * Must be called before the storage data is released. */
+void flush_file_storage(struct file_storage* storage);
+
+/* Flushes every storage and stops the background writer. */
+void stop_file_storage_writer(void);
+
 extern const struct storage_backend_interface g_ifile_storage;
 extern const struct storage_backend_interface g_ifile_storage_ro;
 extern const struct storage_backend_interface g_isubfile_storage;
@@ -199,6 +199,7 @@ void init_device(struct device* dev,
     unsigned int count_per_op_denom_pot,
     int no_compiled_jump,
     int randomize_interrupt,
+    int idle_loop_detection,
     uint32_t start_address,
     /* ai */
     void* aout, const struct audio_out_backend_interface* iaout, float dma_modifier,
@@ -295,7 +296,7 @@ void init_device(struct device* dev,
     init_rdram(&dev->rdram, mem_base_u32(base, MM_RDRAM_DRAM), dram_size, &dev->r4300);
 
     init_r4300(&dev->r4300, &dev->mem, &dev->mi, &dev->rdram, interrupt_handlers,
-            emumode, count_per_op, count_per_op_denom_pot, no_compiled_jump, randomize_interrupt, start_address);
+            emumode, count_per_op, count_per_op_denom_pot, no_compiled_jump, randomize_interrupt, idle_loop_detection, start_address);
     init_rdp(&dev->dp, &dev->sp, &dev->mi, &dev->mem, &dev->rdram, &dev->r4300);
     init_rsp(&dev->sp, mem_base_u32(base, MM_RSP_MEM), &dev->mi, &dev->dp, &dev->ri);
     init_ai(&dev->ai, &dev->mi, &dev->ri, &dev->vi, aout, iaout, dma_modifier);
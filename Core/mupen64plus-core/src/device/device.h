@@ -124,6 +124,7 @@ void init_device(struct device* dev,
     unsigned int count_per_op_denom_pot,
     int no_compiled_jump,
     int randomize_interrupt,
+    int idle_loop_detection,
     uint32_t start_address,
     /* ai */
     void* aout, const struct audio_out_backend_interface* iaout, float dma_modifier,
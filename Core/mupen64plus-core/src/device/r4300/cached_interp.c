@@ -34,6 +34,7 @@
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/r4300/idec.h"
+#include "device/r4300/idle_loop.h"
 #include "main/main.h"
 #include "osal/preproc.h"
 
@@ -360,6 +361,50 @@ static int infer_jump_sub_type(uint32_t target, uint32_t pc, uint32_t next_iw, c
     return 0;
 }
 
+/* promote side-effect free polling loops to the idle variant of their closing branch */
+static void infer_idle_loop(struct precomp_instr* inst, const struct r4300_core* r4300, enum r4300_opcode opcode, const uint32_t* iw, const struct precomp_block* block)
+{
+    uint32_t target;
+
+    if (r4300->idle_loop_detection != IDLE_LOOP_DETECTION_POLLING) {
+        return;
+    }
+
+    switch (opcode)
+    {
+    case R4300_OP_J:
+        target = (inst->addr & ~UINT32_C(0xfffffff)) | (inst->f.j.inst_index << 2);
+        break;
+
+    case R4300_OP_BEQ:
+    case R4300_OP_BEQL:
+    case R4300_OP_BNE:
+    case R4300_OP_BNEL:
+    case R4300_OP_BLEZ:
+    case R4300_OP_BLEZL:
+    case R4300_OP_BGTZ:
+    case R4300_OP_BGTZL:
+    case R4300_OP_BLTZ:
+    case R4300_OP_BLTZL:
+    case R4300_OP_BGEZ:
+    case R4300_OP_BGEZL:
+        target = inst->addr + inst->f.i.immediate*4 + 4;
+        break;
+
+    default:
+        return;
+    }
+
+    /* only backward jumps inside the block can be loops */
+    if (target < block->start || target > inst->addr) {
+        return;
+    }
+
+    if (r4300_is_idle_loop(iw + (target - block->start) / 4, (inst->addr - target) / 4 + 2)) {
+        inst->ops = ci_table[opcode + 1];
+    }
+}
+
 enum r4300_opcode r4300_decode(struct precomp_instr* inst, struct r4300_core* r4300, const struct r4300_idec* idec, uint32_t iw, uint32_t next_iw, const struct precomp_block* block)
 {
     /* assume instr->addr is already setup */
@@ -860,6 +905,7 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
 
         /* decode instruction */
         opcode = r4300_decode(inst, r4300, r4300_get_idec(iw[i]), iw[i], iw[i+1], block);
+        infer_idle_loop(inst, r4300, opcode, iw, block);
 
         /* decode ending conditions */
         if (i >= length2) { finished = 2; }
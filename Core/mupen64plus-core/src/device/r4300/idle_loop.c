@@ -0,0 +1,325 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - idle_loop.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "idle_loop.h"
+
+#include "device/r4300/idec.h"
+#include "device/r4300/r4300_core.h"
+
+#include <string.h>
+
+#define RS_OF(iw) (((iw) >> 21) & 0x1f)
+#define RT_OF(iw) (((iw) >> 16) & 0x1f)
+#define RD_OF(iw) (((iw) >> 11) & 0x1f)
+
+#define REG_BIT(r) (UINT32_C(1) << (r))
+
+/* RDRAM spans the physical addresses below its registers */
+#define IDLE_LOOP_RDRAM_END UINT32_C(0x03f00000)
+
+/* Returns non-zero if address is an unmapped (kseg0/kseg1) RDRAM address.
+ * Anything else may be a MMIO register (VI_CURRENT, AI_STATUS, ...) whose
+ * value changes as Count advances, so fast-forwarding could skip the value
+ * the loop waits for. */
+static int idle_loop_is_rdram(uint32_t address)
+{
+    return (address & UINT32_C(0xc0000000)) == R4300_KSEG0
+        && (address & UINT32_C(0x1fffffff)) < IDLE_LOOP_RDRAM_END;
+}
+
+/* Propagate the register values that are known inside the loop
+ * (computed from r0 and immediates) and check that iw, if it is a load,
+ * reads RDRAM at a known address.
+ * Returns 0 if iw may load from anywhere else. */
+static int idle_loop_track_values(uint32_t iw, uint32_t writes, uint32_t* known, uint32_t* values)
+{
+    uint32_t rs = RS_OF(iw);
+    int known_rs = (*known & REG_BIT(rs)) != 0;
+    uint32_t value = 0;
+    int is_known = 0;
+
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_LB:
+    case R4300_OP_LBU:
+    case R4300_OP_LH:
+    case R4300_OP_LHU:
+    case R4300_OP_LW:
+    case R4300_OP_LWU:
+    case R4300_OP_LD:
+        if (!known_rs || !idle_loop_is_rdram(values[rs] + (uint32_t)(int16_t)iw)) {
+            return 0;
+        }
+        break;
+
+    case R4300_OP_LUI:
+        value = iw << 16;
+        is_known = 1;
+        break;
+
+    case R4300_OP_ADDI:
+    case R4300_OP_ADDIU:
+    case R4300_OP_DADDI:
+    case R4300_OP_DADDIU:
+        value = values[rs] + (uint32_t)(int16_t)iw;
+        is_known = known_rs;
+        break;
+
+    case R4300_OP_ORI:
+        value = values[rs] | (uint16_t)iw;
+        is_known = known_rs;
+        break;
+
+    default:
+        break;
+    }
+
+    /* writes has at most one register, r0 is hardwired to zero */
+    *known = (*known & ~writes) | REG_BIT(0);
+    if (is_known && writes != REG_BIT(0)) {
+        *known |= writes;
+        values[RT_OF(iw)] = value;
+    }
+
+    return 1;
+}
+
+/* Get the GPRs read and written by a loop body instruction.
+ * Returns 0 if the instruction may have side effects (or is not supported). */
+static int idle_loop_body_regs(uint32_t iw, uint32_t* reads, uint32_t* writes)
+{
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_NOP:
+        *reads = 0;
+        *writes = 0;
+        return 1;
+
+    /* loads are the whole point of a polling loop */
+    case R4300_OP_LB:
+    case R4300_OP_LBU:
+    case R4300_OP_LH:
+    case R4300_OP_LHU:
+    case R4300_OP_LW:
+    case R4300_OP_LWU:
+    case R4300_OP_LD:
+    /* i-type ALU */
+    case R4300_OP_ADDI:
+    case R4300_OP_ADDIU:
+    case R4300_OP_DADDI:
+    case R4300_OP_DADDIU:
+    case R4300_OP_SLTI:
+    case R4300_OP_SLTIU:
+    case R4300_OP_ANDI:
+    case R4300_OP_ORI:
+    case R4300_OP_XORI:
+        *reads = REG_BIT(RS_OF(iw));
+        *writes = REG_BIT(RT_OF(iw));
+        return 1;
+
+    case R4300_OP_LUI:
+        *reads = 0;
+        *writes = REG_BIT(RT_OF(iw));
+        return 1;
+
+    /* r-type ALU */
+    case R4300_OP_ADD:
+    case R4300_OP_ADDU:
+    case R4300_OP_SUB:
+    case R4300_OP_SUBU:
+    case R4300_OP_DADD:
+    case R4300_OP_DADDU:
+    case R4300_OP_DSUB:
+    case R4300_OP_DSUBU:
+    case R4300_OP_AND:
+    case R4300_OP_OR:
+    case R4300_OP_XOR:
+    case R4300_OP_NOR:
+    case R4300_OP_SLT:
+    case R4300_OP_SLTU:
+    case R4300_OP_SLLV:
+    case R4300_OP_SRLV:
+    case R4300_OP_SRAV:
+    case R4300_OP_DSLLV:
+    case R4300_OP_DSRLV:
+    case R4300_OP_DSRAV:
+        *reads = REG_BIT(RS_OF(iw)) | REG_BIT(RT_OF(iw));
+        *writes = REG_BIT(RD_OF(iw));
+        return 1;
+
+    case R4300_OP_SLL:
+    case R4300_OP_SRL:
+    case R4300_OP_SRA:
+    case R4300_OP_DSLL:
+    case R4300_OP_DSRL:
+    case R4300_OP_DSRA:
+    case R4300_OP_DSLL32:
+    case R4300_OP_DSRL32:
+    case R4300_OP_DSRA32:
+        *reads = REG_BIT(RT_OF(iw));
+        *writes = REG_BIT(RD_OF(iw));
+        return 1;
+
+    /* HI/LO can't be modified inside the loop, so they are invariant */
+    case R4300_OP_MFHI:
+    case R4300_OP_MFLO:
+        *reads = 0;
+        *writes = REG_BIT(RD_OF(iw));
+        return 1;
+
+    default:
+        /* stores, cop0/cop1 accesses (including Count reads),
+         * mult/div, traps, nested branches, ... */
+        return 0;
+    }
+}
+
+/* Get the GPRs read by the loop closing branch.
+ * Returns 0 if the instruction is not a supported loop branch. */
+static int idle_loop_branch_regs(uint32_t iw, uint32_t* reads)
+{
+    switch (r4300_get_idec(iw)->opcode)
+    {
+    case R4300_OP_BEQ:
+    case R4300_OP_BEQL:
+    case R4300_OP_BNE:
+    case R4300_OP_BNEL:
+        *reads = REG_BIT(RS_OF(iw)) | REG_BIT(RT_OF(iw));
+        return 1;
+
+    case R4300_OP_BLEZ:
+    case R4300_OP_BLEZL:
+    case R4300_OP_BGTZ:
+    case R4300_OP_BGTZL:
+    case R4300_OP_BLTZ:
+    case R4300_OP_BLTZL:
+    case R4300_OP_BGEZ:
+    case R4300_OP_BGEZL:
+        *reads = REG_BIT(RS_OF(iw));
+        return 1;
+
+    case R4300_OP_J:
+        *reads = 0;
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+int r4300_is_idle_loop(const uint32_t* iw, size_t count)
+{
+    size_t i;
+    uint32_t reads, writes;
+    uint32_t written = 0;        /* registers written so far in the iteration */
+    uint32_t live_in = 0;        /* registers read before being written */
+    uint32_t known = REG_BIT(0); /* registers with a known value, see idle_loop_track_values */
+    uint32_t values[32];
+
+    memset(values, 0, sizeof(values));
+
+    if (count < 2 || count > IDLE_LOOP_MAX_LENGTH) {
+        return 0;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (i == count - 2) {
+            if (!idle_loop_branch_regs(iw[i], &reads)) {
+                return 0;
+            }
+            writes = 0;
+        }
+        else if (!idle_loop_body_regs(iw[i], &reads, &writes)
+              || !idle_loop_track_values(iw[i], writes, &known, values)) {
+            return 0;
+        }
+
+        live_in |= reads & ~written;
+        written |= writes;
+    }
+
+    /* r0 is hardwired to zero */
+    live_in &= ~REG_BIT(0);
+    written &= ~REG_BIT(0);
+
+    /* An iteration must not depend on values computed by the previous one,
+     * otherwise the loop is a delay/counter loop and not a polling loop. */
+    return (live_in & written) == 0;
+}
+
+void idle_loop_cache_clear(struct idle_loop_cache* cache)
+{
+    memset(cache->addr, 0xff, sizeof(cache->addr));
+    cache->start = UINT32_MAX;
+    cache->end = 0;
+}
+
+void idle_loop_cache_invalidate(struct idle_loop_cache* cache, uint32_t address, size_t size)
+{
+    if (size == 0 || (address < cache->end && address + size > cache->start)) {
+        idle_loop_cache_clear(cache);
+    }
+}
+
+int r4300_is_idle_loop_at(struct r4300_core* r4300, uint32_t addr, uint32_t target)
+{
+    struct idle_loop_cache* cache = &r4300->idle_loop_cache;
+    size_t slot = (addr >> 2) % IDLE_LOOP_CACHE_SIZE;
+    const uint32_t* iw;
+    int idle;
+
+    if (r4300->idle_loop_detection != IDLE_LOOP_DETECTION_POLLING) {
+        return 0;
+    }
+
+    /* only consider short backward loops */
+    if (target > addr || (addr - target) / 4 + 2 > IDLE_LOOP_MAX_LENGTH) {
+        return 0;
+    }
+
+    if (cache->addr[slot] == addr && cache->target[slot] == target) {
+        return cache->idle[slot];
+    }
+
+    /* loop (with its delay slot) must fit in a page to be contiguous in memory */
+    if ((target ^ (addr + 4)) & ~UINT32_C(0xfff)) {
+        return 0;
+    }
+
+    iw = fast_mem_access(r4300, target);
+    if (iw == NULL) {
+        return 0;
+    }
+
+    idle = r4300_is_idle_loop(iw, (addr - target) / 4 + 2);
+
+    cache->addr[slot] = addr;
+    cache->target[slot] = target;
+    cache->idle[slot] = (uint8_t)idle;
+    if (target < cache->start) {
+        cache->start = target;
+    }
+    if (addr + 8 > cache->end) {
+        cache->end = addr + 8;
+    }
+
+    return idle;
+}
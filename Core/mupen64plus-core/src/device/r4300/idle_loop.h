@@ -0,0 +1,76 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - idle_loop.h                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_IDLE_LOOP_H
+#define M64P_DEVICE_R4300_IDLE_LOOP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct r4300_core;
+
+/* Idle loop detection levels (selected per ROM via the rom database) */
+enum r4300_idle_loop_detection
+{
+    IDLE_LOOP_DETECTION_TRIVIAL, /* only "branch to self with nop in delay slot" */
+    IDLE_LOOP_DETECTION_POLLING  /* also side-effect free polling loops */
+};
+
+/* Maximum number of instructions (including the delay slot)
+ * a polling loop can span to be considered by the detector. */
+enum { IDLE_LOOP_MAX_LENGTH = 16 };
+
+/* Results of r4300_is_idle_loop_at by branch address, so the pure interpreter
+ * doesn't rescan a loop each time its closing branch is executed. */
+enum { IDLE_LOOP_CACHE_SIZE = 64 };
+
+struct idle_loop_cache
+{
+    uint32_t addr[IDLE_LOOP_CACHE_SIZE];    /* branch address, ~0 if unused */
+    uint32_t target[IDLE_LOOP_CACHE_SIZE];
+    uint8_t idle[IDLE_LOOP_CACHE_SIZE];
+    /* range covered by the cached loops, [start, end) */
+    uint32_t start;
+    uint32_t end;
+};
+
+void idle_loop_cache_clear(struct idle_loop_cache* cache);
+
+/* Drops the cached results if [address, address+size) overlaps a cached loop,
+ * or unconditionally if size is 0. */
+void idle_loop_cache_invalidate(struct idle_loop_cache* cache, uint32_t address, size_t size);
+
+/* Returns non-zero if iw[0..count-1] is a side-effect free polling loop,
+ * ie: iw[count-2] is a branch back to iw[0], iw[count-1] is its delay slot,
+ * and the loop body only computes values which do not depend on a previous
+ * iteration and loads from RDRAM at addresses built inside the loop (lui/ori/
+ * addiu). Such a loop can only be left once RDRAM changes, which requires an
+ * interrupt event to occur, so Count can be safely fast-forwarded to the next
+ * scheduled event. Loops polling MMIO registers are never idle loops, as those
+ * (VI_CURRENT, AI_STATUS, ...) change as Count advances. */
+int r4300_is_idle_loop(const uint32_t* iw, size_t count);
+
+/* Same as above, but fetches the loop code from the r4300 address space.
+ * addr is the address of the branch and target the address of the loop start.
+ * Returns 0 if polling loop detection is disabled for the current ROM.
+ * Results are cached in r4300->idle_loop_cache. */
+int r4300_is_idle_loop_at(struct r4300_core* r4300, uint32_t addr, uint32_t target);
+
+#endif
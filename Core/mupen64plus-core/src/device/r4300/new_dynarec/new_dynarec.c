@@ -42,6 +42,7 @@
 #include "device/r4300/interrupt.h"
 #include "device/r4300/tlb.h"
 #include "device/r4300/fpu.h"
+#include "device/r4300/idle_loop.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rsp/rsp_core.h"
 
@@ -4459,6 +4460,18 @@ static void emit_extjump_ds(intptr_t addr, int target)
   emit_extjump2(addr, target, (intptr_t)dyna_linker_ds);
 }
 
+// Side-effect free polling loop closed by the branch at i (see idle_loop.h)
+static int polling_loop(int i)
+{
+  int t;
+  if(g_dev.r4300.idle_loop_detection!=IDLE_LOOP_DETECTION_POLLING) return 0;
+  if(itype[i]!=UJUMP&&itype[i]!=CJUMP&&itype[i]!=SJUMP) return 0;
+  if((u_int)ba[i]<start||(u_int)ba[i]>=start+i*4) return 0;
+  t=(ba[i]-start)>>2;
+  if(is_ds[t]) return 0;
+  return r4300_is_idle_loop(&source[t],i-t+2);
+}
+
 static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
 {
   int count;
@@ -4480,6 +4493,15 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
     *adj=0;
   }
   count=ccadj[i];
+  if(taken==TAKEN && polling_loop(i)) {
+    // Polling loop, skip to the next event
+    emit_test(HOST_CCREG,HOST_CCREG);
+#if NEW_DYNAREC >= NEW_DYNAREC_ARM
+    emit_cmovs_imm(0,HOST_CCREG);
+#else
+    emit_cmovs(&const_zero,HOST_CCREG);
+#endif
+  }
   if(taken==TAKEN && i==(ba[i]-start)>>2 && source[i+1]==0) {
     // Idle loop
     idle=(intptr_t)out;
@@ -9756,7 +9778,7 @@ int new_recompile_block(int addr)
                 if(rs2[i]) alloc_reg64(&current,i,rs2[i]);
               }
             }
-            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0))
+            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0) && !polling_loop(i))
             {
               ooo[i]=1;
               delayslot_alloc(&current,i+1);
@@ -9784,7 +9806,7 @@ int new_recompile_block(int addr)
                 if(rs1[i]) alloc_reg64(&current,i,rs1[i]);
               }
             }
-            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0))
+            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0) && !polling_loop(i))
             {
               ooo[i]=1;
               delayslot_alloc(&current,i+1);
@@ -9861,7 +9883,7 @@ int new_recompile_block(int addr)
                 if(rs1[i]) alloc_reg64(&current,i,rs1[i]);
               }
             }
-            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0))
+            else if((i!=(ba[i]-start)>>2 || source[i+1]!=0) && !polling_loop(i))
             {
               ooo[i]=1;
               delayslot_alloc(&current,i+1);
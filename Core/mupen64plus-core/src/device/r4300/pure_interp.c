@@ -29,6 +29,7 @@
 #include "api/callbacks.h"
 #include "api/debugger.h"
 #include "api/m64p_types.h"
+#include "device/r4300/idle_loop.h"
 #include "device/r4300/r4300_core.h"
 #include "osal/preproc.h"
 
@@ -106,18 +107,23 @@ static void InterpretOpcode(struct r4300_core* r4300);
 /* Determines whether a relative jump in a 16-bit immediate goes back to the
  * same instruction without doing any work in its delay slot. The jump is
  * relative to the instruction in the delay slot, so 1 instruction backwards
- * (-1) goes back to the jump. */
+ * (-1) goes back to the jump. Jumps further backwards are checked for
+ * side-effect free polling loops (see idle_loop.h). */
 #define IS_RELATIVE_IDLE_LOOP(r4300, op, addr) \
-	(IMM16S_OF(op) == -1 && *fast_mem_access((r4300), (addr) + 4) == 0)
+	((IMM16S_OF(op) == -1 && *fast_mem_access((r4300), (addr) + 4) == 0) \
+	 || (IMM16S_OF(op) < -1 \
+	     && r4300_is_idle_loop_at((r4300), (addr), (addr) + 4 + IMM16S_OF(op) * 4)))
 
 /* Determines whether an absolute jump in a 26-bit immediate goes back to the
  * same instruction without doing any work in its delay slot. The jump is
  * in the same 256 MiB segment as the delay slot, so if the jump instruction
  * is at the last address in its segment, it does not jump back to itself. */
 #define IS_ABSOLUTE_IDLE_LOOP(r4300, op, addr) \
-	(JUMP_OF(op) == ((addr) & UINT32_C(0x0FFFFFFF)) >> 2 \
-	 && ((addr) & UINT32_C(0x0FFFFFFF)) != UINT32_C(0x0FFFFFFC) \
-	 && *fast_mem_access((r4300), (addr) + 4) == 0)
+	((JUMP_OF(op) == ((addr) & UINT32_C(0x0FFFFFFF)) >> 2 \
+	  && ((addr) & UINT32_C(0x0FFFFFFF)) != UINT32_C(0x0FFFFFFC) \
+	  && *fast_mem_access((r4300), (addr) + 4) == 0) \
+	 || r4300_is_idle_loop_at((r4300), (addr), \
+	     (((addr) + 4) & UINT32_C(0xF0000000)) | (JUMP_OF(op) << 2)))
 
 /* These macros parse opcode fields. */
 #define rrt r4300_regs(r4300)[RT_OF(op)]
@@ -41,7 +41,7 @@
 #include <time.h>
 
 void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers,
-    unsigned int emumode, unsigned int count_per_op, unsigned int count_per_op_denom_pot, int no_compiled_jump, int randomize_interrupt, uint32_t start_address)
+    unsigned int emumode, unsigned int count_per_op, unsigned int count_per_op_denom_pot, int no_compiled_jump, int randomize_interrupt, int idle_loop_detection, uint32_t start_address)
 {
     struct new_dynarec_hot_state* new_dynarec_hot_state =
 #ifdef NEW_DYNAREC
@@ -63,6 +63,7 @@ void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controll
     r4300->mi = mi;
     r4300->rdram = rdram;
     r4300->randomize_interrupt = randomize_interrupt;
+    r4300->idle_loop_detection = idle_loop_detection;
     r4300->start_address = start_address;
     srand((unsigned int) time(NULL));
 }
@@ -79,6 +80,7 @@ void poweron_r4300(struct r4300_core* r4300)
     r4300->delay_slot = 0;
     r4300->skip_jump = 0;
     r4300->reset_hard_job = 0;
+    idle_loop_cache_clear(&r4300->idle_loop_cache);
 
 
     /* recomp init */
@@ -407,7 +409,11 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
 
 void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, size_t size)
 {
-    if (r4300->emumode != EMUMODE_PURE_INTERPRETER)
+    if (r4300->emumode == EMUMODE_PURE_INTERPRETER)
+    {
+        idle_loop_cache_invalidate(&r4300->idle_loop_cache, address, size);
+    }
+    else
     {
 #ifdef NEW_DYNAREC
         if (r4300->emumode == EMUMODE_DYNAREC)
@@ -32,6 +32,7 @@
 #include "cp0.h"
 #include "cp1.h"
 #include "cp2.h"
+#include "idle_loop.h"
 
 #include "recomp_types.h" /* for precomp_instr, regcache_state */
 
@@ -199,6 +200,10 @@ struct r4300_core
 
     uint32_t randomize_interrupt;
 
+    /* see enum r4300_idle_loop_detection */
+    uint32_t idle_loop_detection;
+    struct idle_loop_cache idle_loop_cache;
+
     uint32_t start_address;
 };
 
@@ -214,7 +219,7 @@ struct r4300_core
     offsetof(struct new_dynarec_hot_state, regs))
 #endif
 
-void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers, unsigned int emumode, unsigned int count_per_op, unsigned int count_per_op_denom_pot, int no_compiled_jump, int randomize_interrupt, uint32_t start_address);
+void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers, unsigned int emumode, unsigned int count_per_op, unsigned int count_per_op_denom_pot, int no_compiled_jump, int randomize_interrupt, int idle_loop_detection, uint32_t start_address);
 void poweron_r4300(struct r4300_core* r4300);
 
 void run_r4300(struct r4300_core* r4300);
@@ -34,6 +34,7 @@
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rdp/rdp_core.h"
 #include "device/rcp/ri/ri_controller.h"
+#include "device/rdram/rdram.h"
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -69,6 +70,7 @@ static void dma_pi_read(struct pi_controller* pi)
     }
 
     pre_framebuffer_read(&pi->dp->fb, dram_addr);
+    rdram_fence(pi->ri->rdram, dram_addr, length + 1);
 
     /* PI seems to treat the first 128 bytes differently, see https://n64brew.dev/wiki/Peripheral_Interface#Unaligned_DMA_transfer */
     if (length >= 0x7f && (length & 1))
@@ -111,6 +113,7 @@ static void dma_pi_write(struct pi_controller* pi)
         length += 1;
     if (length <= 0x80)
         length -= dram_addr & 0x7;
+    rdram_fence(pi->ri->rdram, dram_addr, length);
     unsigned int cycles = handler->dma_write(opaque, dram, dram_addr, cart_addr, length);
 
     post_framebuffer_write(&pi->dp->fb, dram_addr, length);
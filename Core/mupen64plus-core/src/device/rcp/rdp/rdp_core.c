@@ -27,6 +27,7 @@
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rsp/rsp_core.h"
 #include "plugin/plugin.h"
+#include <mupen64plus-next_common.h>
 
 static void update_dpc_status(struct rdp_core* dp, uint32_t w)
 {
@@ -41,7 +42,7 @@ static void update_dpc_status(struct rdp_core* dp, uint32_t w)
 
         if (dp->do_on_unfreeze & DELAY_DP_INT)
             signal_rcp_interrupt(dp->mi, MI_INTR_DP);
-        if (dp->do_on_unfreeze & DELAY_UPDATESCREEN)
+        if ((dp->do_on_unfreeze & DELAY_UPDATESCREEN) && !libretro_skip_video)
             gfx.updateScreen();
         dp->do_on_unfreeze = 0;
     }
@@ -114,6 +115,14 @@ void write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
         dp->dpc_regs[DPC_CURRENT_REG] = dp->dpc_regs[DPC_START_REG];
         break;
     case DPC_END_REG:
+        if (libretro_skip_rdp) {
+            /* run-ahead frame which is rolled back unseen, drop the list */
+            dp->dpc_regs[DPC_START_REG] = dp->dpc_regs[DPC_CURRENT_REG] = dp->dpc_regs[DPC_END_REG];
+            signal_rcp_interrupt(dp->mi, MI_INTR_DP);
+            break;
+        }
+        /* the RDP can read any part of RDRAM */
+        rsp_wait_async_task(dp->sp);
         unprotect_framebuffers(&dp->fb);
         gfx.processRDPList();
         protect_framebuffers(&dp->fb);
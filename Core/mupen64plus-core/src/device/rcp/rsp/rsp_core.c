@@ -30,12 +30,112 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
 #include "main/main.h"
+#include "main/netplay.h"
+#include "main/trace.h"
 #if defined(PROFILE)
 #include "main/profile.h"
 #endif
 #include "plugin/plugin.h"
 #include "api/callbacks.h"
 
+#include <mupen64plus-next_common.h>
+
+static int async_ranges_overlap(const struct rsp_core* sp, uint32_t address, uint32_t length)
+{
+    int i;
+
+    for (i = 0; i < sp->async_ranges_count; ++i) {
+        const RSP_DRAM_RANGE* range = &sp->async_ranges[i];
+
+        if (address < range->address + range->length && range->address < address + length)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* RDRAM handlers of the regions an asynchronous task uses, an access
+ * to one of its ranges waits for the task, others go straight through */
+static void read_rdram_async(void* opaque, uint32_t address, uint32_t* value)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+    const struct mem_handler handler = sp->async_saved_handlers[address >> 16];
+
+    if (async_ranges_overlap(sp, address & 0xffffff, 4))
+        rsp_wait_async_task(sp);
+
+    mem_read32(&handler, address, value);
+}
+
+static void write_rdram_async(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+    const struct mem_handler handler = sp->async_saved_handlers[address >> 16];
+
+    if (async_ranges_overlap(sp, address & 0xffffff, 4))
+        rsp_wait_async_task(sp);
+
+    mem_write32(&handler, address, value, mask);
+}
+
+static void fence_rdram_async(void* opaque, uint32_t address, uint32_t length)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+
+    if (async_ranges_overlap(sp, address & 0xffffff, length))
+        rsp_wait_async_task(sp);
+}
+
+static int start_async_task(struct rsp_core* sp)
+{
+    struct memory* mem = sp->mi->r4300->mem;
+    struct rdram* rdram = sp->ri->rdram;
+    uint32_t regions = (uint32_t)(rdram->dram_size >> 16);
+    uint32_t region;
+    int count;
+    int i;
+
+    /* dynarecs access RDRAM directly, so they can't be fenced */
+    if (!EnableAsyncHLEAudio || rsp.startAsyncTask == NULL
+        || sp->mi->r4300->emumode == EMUMODE_DYNAREC || netplay_is_init())
+        return 0;
+
+    count = rsp.startAsyncTask(sp->async_ranges, SP_ASYNC_RANGES_MAX);
+    if (count < 0)
+        return 0;
+
+    if (regions > SP_ASYNC_REGIONS_COUNT)
+        regions = SP_ASYNC_REGIONS_COUNT;
+
+    for (i = 0; i < count; ++i) {
+        const RSP_DRAM_RANGE* range = &sp->async_ranges[i];
+
+        if (range->length == 0)
+            continue;
+
+        for (region = range->address >> 16;
+             region <= ((range->address + range->length - 1) >> 16) && region < regions;
+             ++region) {
+            if (sp->async_fenced[region])
+                continue;
+
+            sp->async_saved_handlers[region] = mem->handlers[region];
+            mem->handlers[region].opaque = sp;
+            mem->handlers[region].read32 = read_rdram_async;
+            mem->handlers[region].write32 = write_rdram_async;
+            sp->async_fenced[region] = 1;
+        }
+    }
+
+    sp->async_ranges_count = count;
+    sp->async_task = 1;
+
+    rdram->fence = fence_rdram_async;
+    rdram->fence_opaque = sp;
+
+    return 1;
+}
+
 static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
 {
     unsigned int i,j;
@@ -52,6 +152,8 @@ static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
     unsigned char *spmem = (unsigned char*)sp->mem + (dma->memaddr & 0x1000);
     unsigned char *dram = (unsigned char*)sp->ri->rdram->dram;
 
+    rsp_wait_async_task(sp);
+
     if (dma->dir == SP_DMA_READ)
     {
         for(j=0; j<count; j++) {
@@ -221,10 +323,16 @@ void init_rsp(struct rsp_core* sp,
     sp->mi = mi;
     sp->dp = dp;
     sp->ri = ri;
+
+    sp->async_task = 0;
+    sp->async_ranges_count = 0;
+    memset(sp->async_fenced, 0, sizeof(sp->async_fenced));
 }
 
 void poweron_rsp(struct rsp_core* sp)
 {
+    rsp_wait_async_task(sp);
+
     memset(sp->mem, 0, SP_MEM_SIZE);
     memset(sp->regs, 0, SP_REGS_COUNT*sizeof(uint32_t));
     memset(sp->regs2, 0, SP_REGS2_COUNT*sizeof(uint32_t));
@@ -243,6 +351,8 @@ void read_rsp_mem(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_async_task(sp);
+
     *value = sp->mem[addr];
 }
 
@@ -251,6 +361,8 @@ void write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_async_task(sp);
+
     masked_write(&sp->mem[addr], value, mask);
 }
 
@@ -327,6 +439,9 @@ void do_SP_Task(struct rsp_core* sp)
     uint32_t save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
 
     uint32_t sp_delay_time;
+    TRACE_BEGIN(zone_start);
+
+    rsp_wait_async_task(sp);
 
     if (sp->mem[0xfc0/4] == 1)
     {
@@ -342,6 +457,7 @@ void do_SP_Task(struct rsp_core* sp)
         timed_section_end(TIMED_SECTION_GFX);
 #endif
         sp->regs2[SP_PC_REG] |= save_pc;
+        TRACE_END(zone_start, "SP gfx task");
         new_frame();
 
         if (sp->mi->regs[MI_INTR_REG] & MI_INTR_DP)
@@ -365,11 +481,14 @@ void do_SP_Task(struct rsp_core* sp)
 #if defined(PROFILE)
         timed_section_start(TIMED_SECTION_AUDIO);
 #endif
-        rsp.doRspCycles(0xffffffff);
+        /* completes later, when something touches what the task uses */
+        if (!start_async_task(sp))
+            rsp.doRspCycles(0xffffffff);
 #if defined(PROFILE)
         timed_section_end(TIMED_SECTION_AUDIO);
 #endif
         sp->regs2[SP_PC_REG] |= save_pc;
+        TRACE_END(zone_start, "SP audio task");
 
         sp_delay_time = 4000;
     }
@@ -378,6 +497,7 @@ void do_SP_Task(struct rsp_core* sp)
         sp->regs2[SP_PC_REG] &= 0xfff;
         rsp.doRspCycles(0xffffffff);
         sp->regs2[SP_PC_REG] |= save_pc;
+        TRACE_END(zone_start, "SP task");
 
         sp_delay_time = 0;
     }
@@ -401,6 +521,33 @@ void do_SP_Task(struct rsp_core* sp)
         ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
 }
 
+void rsp_wait_async_task(struct rsp_core* sp)
+{
+    struct memory* mem;
+    uint32_t region;
+
+    if (!sp->async_task)
+        return;
+
+    rsp.waitAsyncTask();
+
+    mem = sp->mi->r4300->mem;
+    for (region = 0; region < SP_ASYNC_REGIONS_COUNT; ++region) {
+        if (!sp->async_fenced[region])
+            continue;
+
+        /* keep any mapping applied to the region in the meantime */
+        if (mem->handlers[region].read32 == read_rdram_async)
+            mem->handlers[region] = sp->async_saved_handlers[region];
+        sp->async_fenced[region] = 0;
+    }
+
+    sp->ri->rdram->fence = NULL;
+    sp->ri->rdram->fence_opaque = NULL;
+    sp->async_ranges_count = 0;
+    sp->async_task = 0;
+}
+
 void rsp_interrupt_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
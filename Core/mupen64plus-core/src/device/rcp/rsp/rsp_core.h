@@ -24,6 +24,8 @@
 
 #include <stdint.h>
 
+#include "api/m64p_plugin.h"
+#include "device/memory/memory.h"
 #include "osal/preproc.h"
 
 struct mi_controller;
@@ -83,6 +85,10 @@ enum sp_dma_dir
 
 enum { SP_DMA_FIFO_SIZE = 2} ;
 
+enum { SP_ASYNC_RANGES_MAX = 64 };
+/* 64KB memory regions covering the largest RDRAM */
+enum { SP_ASYNC_REGIONS_COUNT = 0x80 };
+
 struct sp_dma
 {
     uint32_t dir;
@@ -102,6 +108,14 @@ struct rsp_core
     struct rdp_core* dp;
     struct ri_controller* ri;
     struct sp_dma fifo[SP_DMA_FIFO_SIZE];
+
+    /* task running asynchronously in the RSP plugin, the RDRAM it uses
+     * is fenced until it completes, see rsp_wait_async_task */
+    int async_task;
+    int async_ranges_count;
+    RSP_DRAM_RANGE async_ranges[SP_ASYNC_RANGES_MAX];
+    unsigned char async_fenced[SP_ASYNC_REGIONS_COUNT];
+    struct mem_handler async_saved_handlers[SP_ASYNC_REGIONS_COUNT];
 };
 
 static osal_inline uint32_t rsp_mem_address(uint32_t address)
@@ -137,6 +151,7 @@ void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value);
 void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
 
 void do_SP_Task(struct rsp_core* sp);
+void rsp_wait_async_task(struct rsp_core* sp);
 
 void rsp_interrupt_event(void* opaque);
 void rsp_end_of_dma_event(void* opaque);
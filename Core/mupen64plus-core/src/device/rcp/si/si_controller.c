@@ -59,6 +59,8 @@ static void copy_pif_rdram(struct si_controller* si)
     uint32_t* pif_ram = (uint32_t*)si->pif->ram;
     uint32_t* dram = (uint32_t*)(&si->ri->rdram->dram[rdram_dram_address(dram_addr)]);
 
+    rdram_fence(si->ri->rdram, dram_addr, PIF_RAM_SIZE);
+
     if (si->dma_dir == SI_DMA_WRITE) {
         for(i = 0; i < (PIF_RAM_SIZE / 4); ++i) {
             pif_ram[i] = fromhl(dram[i]);
@@ -27,6 +27,7 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "main/main.h"
 #include "plugin/plugin.h"
 #include <mupen64plus-next_common.h>
@@ -58,6 +59,50 @@ unsigned int vi_expected_refresh_rate_from_tv_standard(m64p_system_type tv_stand
     }
 }
 
+/* Line length in VI clocks, less one, that libultra programs for the
+ * standard running at this clock */
+static unsigned int default_h_sync(unsigned int clock)
+{
+    switch (clock)
+    {
+    case 49656530:
+        return 0xc69;
+    case 48628316:
+        return 0xc11;
+    default:
+        return 0xc15;
+    }
+}
+
+/* Field rate the VI is programmed for, as num/den Hz.  H_SYNC holds the
+ * line length in VI clocks and V_SYNC the half-lines in a field, less one
+ * each.  Software that leaves H_SYNC alone gets the standard line length,
+ * and the nominal rate is returned until V_SYNC is set. */
+void vi_field_rate(const struct vi_controller* vi, unsigned int* num, unsigned int* den)
+{
+    uint32_t h_sync = vi->regs[VI_H_SYNC_REG] & 0xfff;
+    uint32_t v_sync = vi->regs[VI_V_SYNC_REG] & 0x3ff;
+    uint64_t n, d, a, b;
+
+    if (v_sync == 0) {
+        *num = vi->expected_refresh_rate;
+        *den = 1;
+        return;
+    }
+    if (h_sync == 0)
+        h_sync = default_h_sync(vi->clock);
+
+    n = 2 * (uint64_t)vi->clock;
+    d = (uint64_t)(h_sync + 1) * (v_sync + 1);
+    for (a = n, b = d; b != 0; ) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    *num = (unsigned int)(n / a);
+    *den = (unsigned int)(d / a);
+}
+
 void set_vi_vertical_interrupt(struct vi_controller* vi)
 {
     if (!get_event(&vi->mi->r4300->cp0.q, VI_INT) && (vi->regs[VI_V_INTR_REG] < vi->regs[VI_V_SYNC_REG]))
@@ -167,9 +212,14 @@ void write_vi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
 void vi_vertical_interrupt_event(void* opaque)
 {
     struct vi_controller* vi = (struct vi_controller*)opaque;
+
+    /* the frame is shown and the frontend gets control back,
+     * nothing may run in the background past this point */
+    rsp_wait_async_task(vi->dp->sp);
+
     if (vi->dp->do_on_unfreeze & DELAY_DP_INT)
         vi->dp->do_on_unfreeze |= DELAY_UPDATESCREEN;
-    else
+    else if (!libretro_skip_video)
         gfx.updateScreen();
 
     /* allow main module to do things on VI event */
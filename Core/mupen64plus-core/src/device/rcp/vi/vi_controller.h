@@ -70,6 +70,7 @@ static osal_inline uint32_t vi_reg(uint32_t address)
 
 unsigned int vi_clock_from_tv_standard(m64p_system_type tv_standard);
 unsigned int vi_expected_refresh_rate_from_tv_standard(m64p_system_type tv_standard);
+void vi_field_rate(const struct vi_controller* vi, unsigned int* num, unsigned int* den);
 void set_vi_vertical_interrupt(struct vi_controller* vi);
 
 void init_vi(struct vi_controller* vi, unsigned int clock, unsigned int expected_refresh_rate,
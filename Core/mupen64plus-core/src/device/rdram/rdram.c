@@ -115,6 +115,9 @@ static void map_corrupt_rdram(struct rdram* rdram, int corrupt)
         : read_rdram_dram;
     mapping.handler.write32 = write_rdram_dram;
 
+    /* don't let the mapping replace the handlers of a fenced range */
+    rdram_fence(rdram, MM_RDRAM_DRAM, (uint32_t)rdram->dram_size);
+
     apply_mem_mapping(rdram->r4300->mem, &mapping);
 #ifndef NEW_DYNAREC
     rdram->r4300->recomp.fast_memory = (corrupt) ? 0 : 1;
@@ -130,6 +133,8 @@ void init_rdram(struct rdram* rdram,
 {
     rdram->dram = dram;
     rdram->dram_size = dram_size;
+    rdram->fence = NULL;
+    rdram->fence_opaque = NULL;
     rdram->r4300 = r4300;
 }
 
@@ -54,6 +54,10 @@ struct rdram
     uint32_t* dram;
     size_t dram_size;
 
+    /* set while an asynchronous RSP task may be using part of dram */
+    void (*fence)(void* opaque, uint32_t address, uint32_t length);
+    void* fence_opaque;
+
     struct r4300_core* r4300;
 };
 
@@ -67,6 +71,15 @@ static osal_inline uint32_t rdram_dram_address(uint32_t address)
     return (address & 0xffffff) >> 2;
 }
 
+/* Must be called before a DMA engine accesses dram directly,
+ * so that a pending asynchronous task using that range completes first */
+static osal_inline void rdram_fence(struct rdram* rdram, uint32_t address, uint32_t length)
+{
+    if (rdram->fence != NULL) {
+        rdram->fence(rdram->fence_opaque, address, length);
+    }
+}
+
 void init_rdram(struct rdram* rdram,
                 uint32_t* dram,
                 size_t dram_size,
@@ -0,0 +1,638 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - capture.c                                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "osal/atomic.h"
+#include "trace.h"
+
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+
+/* Frames are captured into a ring of slots, reserved in display order.  A
+ * slot goes FILLING (owned by the capturing thread) -> QUEUED -> CONVERTING
+ * (owned by a worker) -> READY -> WRITING -> FREE.  Workers convert any
+ * queued slot, but only one of them writes at a time, strictly in slot
+ * order, so the files see the frames in the order they were displayed. */
+#define CAPTURE_SLOTS           8
+#define CAPTURE_MAX_WORKERS     4
+#define CAPTURE_MAX_AUDIO       (1 << 20)
+
+enum slot_state
+{
+    SLOT_FREE,
+    SLOT_FILLING,
+    SLOT_QUEUED,
+    SLOT_CONVERTING,
+    SLOT_READY,
+    SLOT_CANCELLED,
+    SLOT_WRITING
+};
+
+struct capture_slot
+{
+    uint8_t* pixels;
+    size_t pixels_size;
+    uint8_t* yuv;
+    unsigned int width;
+    unsigned int height;
+    unsigned int pitch;
+    enum capture_format format;
+    unsigned int seq;
+    unsigned int repeats;   /* times the frame was displayed again */
+    enum slot_state state;
+};
+
+/* written on the emulation thread, read from the video and audio threads */
+static osal_atomic_int capture_running;
+
+static slock_t* capture_lock;
+static scond_t* capture_cond;
+static sthread_t* workers[CAPTURE_MAX_WORKERS];
+static unsigned int worker_count;
+static int capture_quit;
+
+static struct capture_slot slots[CAPTURE_SLOTS];
+static unsigned int next_seq;
+static unsigned int write_seq;
+static unsigned int late_repeats;   /* repeats of a frame already written */
+static int writing;
+
+static unsigned int stream_width;
+static unsigned int stream_height;
+static unsigned int stream_rate_num;
+static unsigned int stream_rate_den;
+static unsigned int vi_rate_num;
+static unsigned int vi_rate_den;
+static int vi_rate_warned;
+static unsigned int audio_rate;
+static int audio_rate_warned;
+
+static uint8_t* audio_pending;
+static size_t audio_pending_size;
+static unsigned int dropped_frames;
+static size_t dropped_audio;
+
+/* only touched by the thread that writes */
+static FILE* video_file;
+static FILE* audio_file;
+static int video_header_written;
+static uint8_t* last_yuv;
+static uint8_t* audio_out;
+static uint32_t audio_bytes;
+static unsigned int written_frames;
+
+static void put_le32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void write_wav_header(uint32_t data_bytes)
+{
+    uint8_t header[44];
+
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, 36 + data_bytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    header[20] = 1;     /* PCM */
+    header[21] = 0;
+    header[22] = 2;     /* stereo */
+    header[23] = 0;
+    put_le32(header + 24, audio_rate);
+    put_le32(header + 28, audio_rate * 4);
+    header[32] = 4;     /* bytes per sample frame */
+    header[33] = 0;
+    header[34] = 16;    /* bits per sample */
+    header[35] = 0;
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_bytes);
+
+    fseek(audio_file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), audio_file);
+    fseek(audio_file, 0, SEEK_END);
+}
+
+/* BT.601 full range (as in JFIF), 16 bits of fraction.  The chroma is
+ * biased by 128 before the shift so every sum is positive, and rounded
+ * down from one half so it stays within 0..255. */
+static void convert_slot(struct capture_slot* slot, unsigned int width, unsigned int height)
+{
+    const size_t plane = (size_t)width * height;
+    const unsigned int w = slot->width < width ? slot->width : width;
+    const unsigned int h = slot->height < height ? slot->height : height;
+    const int ri = (slot->format == CAPTURE_BGRA8888) ? 2 : 0;
+    const int bi = 2 - ri;
+    unsigned int x, y;
+
+    if (slot->yuv == NULL)
+        slot->yuv = malloc(plane * 3);
+    if (slot->yuv == NULL)
+        return;
+
+    /* a frame of another size than the stream is cropped or padded */
+    if (w < width || h < height) {
+        memset(slot->yuv, 0, plane);
+        memset(slot->yuv + plane, 128, plane * 2);
+    }
+
+    for (y = 0; y < h; y++)
+    {
+        const unsigned int src_y = (slot->format == CAPTURE_RGBA8888_BOTTOM_UP) ? slot->height - 1 - y : y;
+        const uint8_t* src = slot->pixels + (size_t)src_y * slot->pitch;
+        uint8_t* dst_y = slot->yuv + (size_t)y * width;
+        uint8_t* dst_u = dst_y + plane;
+        uint8_t* dst_v = dst_u + plane;
+
+        for (x = 0; x < w; x++, src += 4)
+        {
+            const int r = src[ri], g = src[1], b = src[bi];
+            dst_y[x] = (uint8_t)((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+            dst_u[x] = (uint8_t)((-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32767) >> 16);
+            dst_v[x] = (uint8_t)((32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32767) >> 16);
+        }
+    }
+}
+
+static void write_frames(const uint8_t* yuv, unsigned int count)
+{
+    const size_t size = (size_t)stream_width * stream_height * 3;
+
+    if (yuv == NULL || video_file == NULL)
+        return;
+
+    if (!video_header_written) {
+        fprintf(video_file, "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C444 XCOLORRANGE=FULL\n",
+                stream_width, stream_height, stream_rate_num, stream_rate_den);
+        video_header_written = 1;
+    }
+
+    for (; count != 0; count--)
+    {
+        fputs("FRAME\n", video_file);
+        fwrite(yuv, 1, size, video_file);
+        written_frames++;
+    }
+}
+
+/* Swaps the pending audio out and writes it.  Called with capture_lock
+ * held, which is dropped during file I/O. */
+static void write_audio_locked(void)
+{
+    uint8_t* data = audio_pending;
+    size_t size = audio_pending_size;
+
+    if (size == 0)
+        return;
+
+    audio_pending = audio_out;
+    audio_pending_size = 0;
+    audio_out = data;
+    slock_unlock(capture_lock);
+
+    if (audio_file != NULL) {
+        if (audio_bytes == 0)
+            write_wav_header(0);
+        audio_bytes += (uint32_t)fwrite(data, 1, size, audio_file);
+    }
+
+    slock_lock(capture_lock);
+}
+
+static int can_write_locked(void)
+{
+    const struct capture_slot* slot = &slots[write_seq % CAPTURE_SLOTS];
+
+    if (late_repeats != 0 || audio_pending_size != 0)
+        return 1;
+    return write_seq != next_seq && (slot->state == SLOT_READY || slot->state == SLOT_CANCELLED);
+}
+
+/* Writes every frame that is next in display order.  Called with
+ * capture_lock held, which is dropped during file I/O. */
+static void write_ready_locked(void)
+{
+    writing = 1;
+    for (;;)
+    {
+        struct capture_slot* slot;
+        unsigned int count;
+        int64_t zone_start;
+
+        write_audio_locked();
+
+        if (late_repeats != 0) {
+            count = late_repeats;
+            late_repeats = 0;
+            slock_unlock(capture_lock);
+            write_frames(last_yuv, count);
+            slock_lock(capture_lock);
+            continue;
+        }
+
+        slot = &slots[write_seq % CAPTURE_SLOTS];
+        if (write_seq == next_seq || (slot->state != SLOT_READY && slot->state != SLOT_CANCELLED))
+            break;
+
+        /* a cancelled frame is replaced by the previous one */
+        if (slot->state == SLOT_READY && slot->yuv != NULL) {
+            uint8_t* yuv = last_yuv;
+            last_yuv = slot->yuv;
+            slot->yuv = yuv;
+        }
+        slot->state = SLOT_WRITING;
+
+        count = 1;
+        do {
+            slock_unlock(capture_lock);
+            zone_start = trace_enabled() ? trace_now() : 0;
+            write_frames(last_yuv, count);
+            TRACE_END(zone_start, "capture write");
+            slock_lock(capture_lock);
+
+            count = slot->repeats;
+            slot->repeats = 0;
+        } while (count != 0);
+
+        slot->state = SLOT_FREE;
+        write_seq++;
+    }
+    writing = 0;
+}
+
+static struct capture_slot* next_queued_locked(void)
+{
+    struct capture_slot* next = NULL;
+    unsigned int i;
+
+    for (i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        struct capture_slot* slot = &slots[i];
+        if (slot->state == SLOT_QUEUED && (next == NULL || (int)(slot->seq - next->seq) < 0))
+            next = slot;
+    }
+    return next;
+}
+
+static void capture_worker(void* data)
+{
+    (void)data;
+    trace_set_thread_name("capture");
+
+    slock_lock(capture_lock);
+    for (;;)
+    {
+        struct capture_slot* slot = next_queued_locked();
+
+        if (slot != NULL) {
+            const unsigned int width = stream_width, height = stream_height;
+            int64_t zone_start;
+
+            slot->state = SLOT_CONVERTING;
+            slock_unlock(capture_lock);
+
+            zone_start = trace_enabled() ? trace_now() : 0;
+            convert_slot(slot, width, height);
+            TRACE_END(zone_start, "capture convert");
+
+            slock_lock(capture_lock);
+            slot->state = SLOT_READY;
+        }
+
+        if (!writing && can_write_locked()) {
+            write_ready_locked();
+            continue;
+        }
+
+        if (slot == NULL) {
+            if (capture_quit)
+                break;
+            scond_wait(capture_cond, capture_lock);
+        }
+    }
+    slock_unlock(capture_lock);
+}
+
+static FILE* open_output(const char* path, const char* extension)
+{
+    char* filename = malloc(strlen(path) + strlen(extension) + 1);
+    FILE* f = NULL;
+
+    if (filename != NULL) {
+        strcpy(filename, path);
+        strcat(filename, extension);
+        f = fopen(filename, "wb");
+        if (f == NULL)
+            DebugMessage(M64MSG_WARNING, "Couldn't open capture file %s", filename);
+        free(filename);
+    }
+    return f;
+}
+
+void capture_start(const char* path, unsigned int rate_num, unsigned int rate_den)
+{
+    unsigned int threads;
+
+    if (capture_enabled())
+        return;
+
+    capture_lock = slock_new();
+    capture_cond = scond_new();
+    video_file = open_output(path, ".y4m");
+    audio_file = open_output(path, ".wav");
+    if (capture_lock == NULL || capture_cond == NULL || video_file == NULL || audio_file == NULL)
+        goto fail;
+
+    memset(slots, 0, sizeof(slots));
+    next_seq = write_seq = late_repeats = 0;
+    writing = capture_quit = 0;
+    stream_width = stream_height = 0;
+    stream_rate_num = 0;
+    stream_rate_den = 0;
+    vi_rate_num = rate_num;
+    vi_rate_den = rate_den;
+    vi_rate_warned = 0;
+    audio_rate = 0;
+    audio_rate_warned = 0;
+    audio_pending_size = 0;
+    dropped_frames = 0;
+    dropped_audio = 0;
+    video_header_written = 0;
+    audio_bytes = 0;
+    written_frames = 0;
+
+    threads = cpu_features_get_core_amount() / 2;
+    if (threads < 1)
+        threads = 1;
+    if (threads > CAPTURE_MAX_WORKERS)
+        threads = CAPTURE_MAX_WORKERS;
+
+    for (worker_count = 0; worker_count < threads; worker_count++)
+    {
+        workers[worker_count] = sthread_create(capture_worker, NULL);
+        if (workers[worker_count] == NULL)
+            break;
+    }
+    if (worker_count == 0)
+        goto fail;
+
+    /* publishes everything set up above */
+    osal_atomic_store(&capture_running, 1);
+    DebugMessage(M64MSG_INFO, "Capturing to %s.y4m and %s.wav", path, path);
+    return;
+
+fail:
+    DebugMessage(M64MSG_WARNING, "Couldn't start capture to %s", path);
+    if (video_file != NULL)
+        fclose(video_file);
+    if (audio_file != NULL)
+        fclose(audio_file);
+    video_file = audio_file = NULL;
+    if (capture_cond != NULL)
+        scond_free(capture_cond);
+    if (capture_lock != NULL)
+        slock_free(capture_lock);
+    capture_cond = NULL;
+    capture_lock = NULL;
+}
+
+/* Writes what is left and closes the files.  Must be called once nothing
+ * captures anymore; slots reserved but never submitted are skipped. */
+void capture_stop(void)
+{
+    unsigned int i;
+
+    if (!osal_atomic_exchange(&capture_running, 0))
+        return;
+
+    slock_lock(capture_lock);
+    for (i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        if (slots[i].state == SLOT_FILLING)
+            slots[i].state = SLOT_CANCELLED;
+    }
+    capture_quit = 1;
+    scond_broadcast(capture_cond);
+    slock_unlock(capture_lock);
+
+    for (i = 0; i < worker_count; i++)
+        sthread_join(workers[i]);
+    worker_count = 0;
+
+    /* the workers leave once nothing is queued, the rest is written here */
+    slock_lock(capture_lock);
+    write_ready_locked();
+    slock_unlock(capture_lock);
+
+    if (audio_bytes != 0)
+        write_wav_header(audio_bytes);
+    fclose(video_file);
+    fclose(audio_file);
+    video_file = audio_file = NULL;
+
+    DebugMessage(M64MSG_INFO, "Captured %u frames (%u dropped) and %u bytes of audio (%u dropped)",
+                 written_frames, dropped_frames, audio_bytes, (unsigned int)dropped_audio);
+
+    for (i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        free(slots[i].pixels);
+        free(slots[i].yuv);
+        slots[i].pixels = slots[i].yuv = NULL;
+    }
+    free(last_yuv);
+    free(audio_pending);
+    free(audio_out);
+    last_yuv = audio_pending = audio_out = NULL;
+
+    scond_free(capture_cond);
+    slock_free(capture_lock);
+    capture_cond = NULL;
+    capture_lock = NULL;
+}
+
+int capture_enabled(void)
+{
+    return osal_atomic_load(&capture_running);
+}
+
+void capture_set_frame_rate(unsigned int num, unsigned int den)
+{
+    if (!capture_enabled() || num == 0 || den == 0)
+        return;
+
+    slock_lock(capture_lock);
+    if ((unsigned long long)num * vi_rate_den != (unsigned long long)vi_rate_num * den) {
+        vi_rate_num = num;
+        vi_rate_den = den;
+        if (stream_rate_num != 0 && !vi_rate_warned) {
+            DebugMessage(M64MSG_WARNING, "Capture frame rate changed to %u/%u Hz, the Y4M file keeps %u/%u Hz",
+                         num, den, stream_rate_num, stream_rate_den);
+            vi_rate_warned = 1;
+        }
+    }
+    slock_unlock(capture_lock);
+}
+
+static void repeat_frame_locked(void)
+{
+    struct capture_slot* last;
+
+    if (next_seq == 0)
+        return;
+
+    last = &slots[(next_seq - 1) % CAPTURE_SLOTS];
+    if (last->state != SLOT_FREE) {
+        last->repeats++;
+    }
+    else {
+        late_repeats++;
+        scond_signal(capture_cond);
+    }
+}
+
+int capture_begin_frame(unsigned int width, unsigned int height, unsigned int pitch,
+                        enum capture_format format, void** pixels)
+{
+    struct capture_slot* slot;
+    const size_t size = (size_t)height * pitch;
+    unsigned int index;
+
+    if (!capture_enabled() || width == 0 || height == 0)
+        return -1;
+
+    slock_lock(capture_lock);
+    index = next_seq % CAPTURE_SLOTS;
+    slot = &slots[index];
+    if (slot->state != SLOT_FREE) {
+        /* the workers are behind, keep the timing with a repeat */
+        dropped_frames++;
+        repeat_frame_locked();
+        slock_unlock(capture_lock);
+        return -1;
+    }
+
+    if (stream_width == 0) {
+        stream_width = width;
+        stream_height = height;
+        stream_rate_num = vi_rate_num;
+        stream_rate_den = vi_rate_den;
+    }
+    slot->state = SLOT_FILLING;
+    slot->seq = next_seq++;
+    slot->repeats = 0;
+    slock_unlock(capture_lock);
+
+    if (slot->pixels_size < size) {
+        free(slot->pixels);
+        slot->pixels = malloc(size);
+        slot->pixels_size = (slot->pixels != NULL) ? size : 0;
+        if (slot->pixels == NULL) {
+            capture_cancel_frame((int)index);
+            return -1;
+        }
+    }
+
+    slot->width = width;
+    slot->height = height;
+    slot->pitch = pitch;
+    slot->format = format;
+    *pixels = slot->pixels;
+    return (int)index;
+}
+
+void capture_submit_frame(int index)
+{
+    if (!capture_enabled() || index < 0 || index >= CAPTURE_SLOTS)
+        return;
+
+    slock_lock(capture_lock);
+    if (slots[index].state == SLOT_FILLING) {
+        slots[index].state = SLOT_QUEUED;
+        scond_signal(capture_cond);
+    }
+    slock_unlock(capture_lock);
+}
+
+void capture_cancel_frame(int index)
+{
+    if (!capture_enabled() || index < 0 || index >= CAPTURE_SLOTS)
+        return;
+
+    slock_lock(capture_lock);
+    if (slots[index].state == SLOT_FILLING) {
+        slots[index].state = SLOT_CANCELLED;
+        scond_signal(capture_cond);
+    }
+    slock_unlock(capture_lock);
+}
+
+void capture_repeat_frame(void)
+{
+    if (!capture_enabled())
+        return;
+
+    slock_lock(capture_lock);
+    repeat_frame_locked();
+    slock_unlock(capture_lock);
+}
+
+void capture_audio(const int16_t* samples, size_t frames, unsigned int rate)
+{
+    const size_t size = frames * 4;
+
+    if (!capture_enabled() || frames == 0)
+        return;
+
+    slock_lock(capture_lock);
+    if (audio_rate == 0) {
+        audio_rate = rate;
+    }
+    else if (rate != audio_rate && !audio_rate_warned) {
+        DebugMessage(M64MSG_WARNING, "Capture audio rate changed from %u to %u Hz, the WAV file keeps %u Hz",
+                     audio_rate, rate, audio_rate);
+        audio_rate_warned = 1;
+    }
+
+    if (audio_pending == NULL) {
+        audio_pending = malloc(CAPTURE_MAX_AUDIO);
+        audio_out = malloc(CAPTURE_MAX_AUDIO);
+    }
+
+    if (audio_pending == NULL || audio_out == NULL || audio_pending_size + size > CAPTURE_MAX_AUDIO) {
+        dropped_audio += size;
+    }
+    else {
+        memcpy(audio_pending + audio_pending_size, samples, size);
+        audio_pending_size += size;
+        /* otherwise it goes out with the next frame */
+        if (audio_pending_size > CAPTURE_MAX_AUDIO / 2)
+            scond_signal(capture_cond);
+    }
+    slock_unlock(capture_lock);
+}
@@ -0,0 +1,81 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - capture.h                                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_CAPTURE_H
+#define M64P_MAIN_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Recording of the displayed video and the output audio.
+ *
+ * Set M64P_CAPTURE to a path without extension and every frame the
+ * frontend is handed while a ROM runs goes to <path>.y4m (full-range YUV
+ * 4:4:4, at the field rate the VI is programmed for) and the audio to
+ * <path>.wav (16-bit stereo).  The emulation thread only copies a frame
+ * into a free slot; workers convert and write the slots in order.  When every slot is still busy the frame is dropped and the
+ * previous one is written again in its place, so the recording keeps its
+ * timing and emulation never waits for the disk. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum capture_format
+{
+    CAPTURE_BGRA8888,           /* top row first */
+    CAPTURE_RGBA8888_BOTTOM_UP  /* bottom row first, as read from OpenGL */
+};
+
+/* The frame rate is num/den Hz until capture_set_frame_rate says otherwise. */
+void capture_start(const char* path, unsigned int rate_num, unsigned int rate_den);
+void capture_stop(void);
+
+/* Called on each VI with the rate the VI is programmed for; the stream
+ * takes the rate current at its first frame. */
+void capture_set_frame_rate(unsigned int num, unsigned int den);
+
+/* Nonzero while a capture runs, safe to call from any thread. */
+int capture_enabled(void);
+
+/* Reserves the slot for the next displayed frame and points *pixels at
+ * height rows of pitch bytes to fill.  Returns the slot to pass to
+ * capture_submit_frame, or -1 when capture is off or every slot is busy. */
+int capture_begin_frame(unsigned int width, unsigned int height, unsigned int pitch,
+                        enum capture_format format, void** pixels);
+
+/* Hands a filled slot to the workers.  A slot may be submitted late, as
+ * long as it is from the same capture. */
+void capture_submit_frame(int slot);
+
+/* Gives up a reserved slot; the previous frame is written in its place. */
+void capture_cancel_frame(int slot);
+
+/* Records that the previous frame is displayed again. */
+void capture_repeat_frame(void);
+
+/* Appends interleaved stereo samples at rate Hz. */
+void capture_audio(const int16_t* samples, size_t frames, unsigned int rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M64P_MAIN_CAPTURE_H */
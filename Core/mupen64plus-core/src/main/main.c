@@ -66,6 +66,7 @@
 #include "eventloop.h"
 #include "main.h"
 #include "callbacks.h"
+#include "capture.h"
 #include "plugin/plugin.h"
 #if defined(PROFILE)
 #include "profile.h"
@@ -73,6 +74,7 @@
 #include "rom.h"
 #include "savestates.h"
 #include "screenshot.h"
+#include "trace.h"
 #include "util.h"
 #include "netplay.h"
 
@@ -816,6 +818,10 @@ static void pause_loop(void)
  * Allow the core to perform various things */
 void new_vi(void)
 {
+    /* the r4300 zone spans the emulation of one frame, between two returns
+     * to the frontend */
+    static int64_t r4300_start;
+
 #if defined(PROFILE)
     timed_sections_refresh();
 #endif
@@ -826,7 +832,16 @@ void new_vi(void)
     main_check_inputs();
 
     netplay_check_sync(&g_dev.r4300.cp0);
+
+    if (capture_enabled()) {
+        unsigned int num, den;
+        vi_field_rate(&g_dev.vi, &num, &den);
+        capture_set_frame_rate(num, den);
+    }
+
+    TRACE_END(r4300_start, "r4300");
     retro_return();
+    r4300_start = trace_enabled() ? trace_now() : 0;
 }
 
 static void main_switch_pak(int control_id)
@@ -1048,7 +1063,7 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     }
 
     struct file_storage* fstorage = malloc(sizeof(struct file_storage));
-    struct file_storage* fstorage_save = malloc(sizeof(struct file_storage));
+    struct file_storage* fstorage_save = calloc(1, sizeof(struct file_storage));
     if (fstorage == NULL || fstorage_save == NULL) {
         DebugMessage(M64MSG_ERROR, "Failed to allocate DD file_storage");
         if (fstorage != NULL)      { free(fstorage);      fstorage = NULL; }
@@ -1205,7 +1220,9 @@ no_disk:
 static void close_dd_disk(struct dd_disk* disk)
 {
     if (disk->save_storage != NULL) {
-        /* no need to close save_storage as it is a child of disk->storage */
+        /* no need to close save_storage as it is a child of disk->storage,
+         * but its pending writes must reach the disk first */
+        flush_file_storage(disk->save_storage);
         free(disk->save_storage);
         disk->save_storage = NULL;
     }
@@ -1373,6 +1390,7 @@ m64p_error main_run(void)
     int32_t si_dma_duration;
     int32_t no_compiled_jump;
     int32_t randomize_interrupt;
+    int32_t idle_loop_detection;
     struct file_storage eep;
     struct file_storage fla;
     struct file_storage sra;
@@ -1429,6 +1447,11 @@ m64p_error main_run(void)
     if (count_per_op_denom_pot > 20)
         count_per_op_denom_pot = 20;
 
+    /* the core option overrides the rom database, 0 keeps it */
+    idle_loop_detection = (IdleLoopDetection > 0)
+        ? (int32_t)IdleLoopDetection - 1
+        : ROM_SETTINGS.idleloopdetection;
+
     si_dma_duration = ROM_SETTINGS.sidmaduration;
 
     //During netplay, player 1 is the source of truth for these settings
@@ -1686,6 +1709,7 @@ m64p_error main_run(void)
                 count_per_op_denom_pot,
                 no_compiled_jump,
                 randomize_interrupt,
+                idle_loop_detection,
                 g_start_address,
                 &g_dev.ai, &audio_out_backend_libretro, ((float)ROM_SETTINGS.aidmamodifier / 100.0),
                 si_dma_duration,
@@ -1721,6 +1745,17 @@ m64p_error main_run(void)
     // setup rendering callback from video plugin to the core, for screenshots and On-Screen-Display
     gfx.setRenderingCallback(video_plugin_render_callback);
 
+    /* M64P_TRACE=<file> records a timeline of this run */
+    const char* trace_path = getenv("M64P_TRACE");
+    if (trace_path != NULL && trace_path[0] != '\0')
+        trace_start(trace_path);
+    trace_set_thread_name("emulation");
+
+    /* M64P_CAPTURE=<path> records the displayed frames and the audio */
+    const char* capture_path = getenv("M64P_CAPTURE");
+    if (capture_path != NULL && capture_path[0] != '\0')
+        capture_start(capture_path, vi_expected_refresh_rate_from_tv_standard(ROM_PARAMS.systemtype), 1);
+
     g_EmulatorRunning = 1;
     StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
 
@@ -1750,12 +1785,16 @@ m64p_error main_run(void)
     /* reset pif */
     close_pif();
     close_dd_disk(&dd_disk);
+    stop_file_storage_writer();
+    trace_stop();
 
     /* Emulation stopped */
     rsp.romClosed();
     input.romClosed();
     audio.romClosed();
     gfx.romClosed();
+    /* after the video plugin handed over its frames in flight */
+    capture_stop();
 
     // clean up
     g_EmulatorRunning = 0;
@@ -1806,6 +1845,7 @@ on_gfx_open_failure:
 
     /* reset pif */
     close_pif();
+    stop_file_storage_writer();
 
     return failure_rval;
 }
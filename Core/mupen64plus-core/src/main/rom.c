@@ -38,6 +38,7 @@
 #include "device/dd/disk.h"
 #include "backends/file_storage.h"
 #include "device/device.h"
+#include "device/r4300/idle_loop.h"
 #include "main.h"
 #include "md5.h"
 #include "osal/preproc.h"
@@ -55,6 +56,9 @@ enum { DEFAULT_DISABLE_EXTRA_MEM = 0 };
 enum { DEFAULT_SI_DMA_DURATION = 0x900 };
 /* Default AI DMA modifier */
 enum { DEFAULT_AI_DMA_MODIFIER = 100 };
+/* by default, only trivial idle loops are fast-forwarded,
+ * polling loop detection has to be enabled per ROM */
+enum { DEFAULT_IDLE_LOOP_DETECTION = IDLE_LOOP_DETECTION_TRIVIAL };
 
 static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5);
 
@@ -194,6 +198,7 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
         ROM_SETTINGS.disableextramem = entry->disableextramem;
         ROM_SETTINGS.sidmaduration = entry->sidmaduration;
         ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
+        ROM_SETTINGS.idleloopdetection = entry->idleloopdetection;
         ROM_PARAMS.cheats = entry->cheats;
     }
     else
@@ -210,6 +215,7 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
         ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
         ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
         ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+        ROM_SETTINGS.idleloopdetection = DEFAULT_IDLE_LOOP_DETECTION;
         ROM_PARAMS.cheats = NULL;
 
         /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
@@ -331,6 +337,7 @@ m64p_error open_disk(void)
         ROM_SETTINGS.disableextramem = entry->disableextramem;
         ROM_SETTINGS.sidmaduration = entry->sidmaduration;
         ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
+        ROM_SETTINGS.idleloopdetection = entry->idleloopdetection;
         ROM_PARAMS.cheats = entry->cheats;
     }
     else
@@ -348,6 +355,7 @@ m64p_error open_disk(void)
         ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
         ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
         ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+        ROM_SETTINGS.idleloopdetection = DEFAULT_IDLE_LOOP_DETECTION;
         ROM_PARAMS.cheats = NULL;
     }
 
@@ -552,6 +560,12 @@ static size_t romdatabase_resolve_round(void)
             entry->entry.set_flags |= ROMDATABASE_ENTRY_AIDMAMODIFIER;
         }
 
+        if (!isset_bitmask(entry->entry.set_flags, ROMDATABASE_ENTRY_IDLELOOP) &&
+            isset_bitmask(ref->set_flags, ROMDATABASE_ENTRY_IDLELOOP)) {
+            entry->entry.idleloopdetection = ref->idleloopdetection;
+            entry->entry.set_flags |= ROMDATABASE_ENTRY_IDLELOOP;
+        }
+
         free(entry->entry.refmd5);
         entry->entry.refmd5 = NULL;
     }
@@ -649,6 +663,7 @@ void romdatabase_open(void)
             search->entry.biopak = 0;
             search->entry.sidmaduration = DEFAULT_SI_DMA_DURATION;
             search->entry.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+            search->entry.idleloopdetection = DEFAULT_IDLE_LOOP_DETECTION;
             search->entry.set_flags = ROMDATABASE_ENTRY_NONE;
 
             search->next_entry = NULL;
@@ -854,6 +869,15 @@ void romdatabase_open(void)
                     DebugMessage(M64MSG_WARNING, "ROM Database: Invalid AiDmaModifier on line %i", lineno);
                 }
             }
+            else if(!strcmp(l.name, "IdleLoopDetection"))
+            {
+                if (string_to_int(l.value, &value) && value >= IDLE_LOOP_DETECTION_TRIVIAL && value <= IDLE_LOOP_DETECTION_POLLING) {
+                    search->entry.idleloopdetection = value;
+                    search->entry.set_flags |= ROMDATABASE_ENTRY_IDLELOOP;
+                } else {
+                    DebugMessage(M64MSG_WARNING, "ROM Database: Invalid IdleLoopDetection on line %i", lineno);
+                }
+            }
             else
             {
                 DebugMessage(M64MSG_WARNING, "ROM Database: Unknown property on line %i", lineno);
@@ -117,6 +117,7 @@ typedef struct
    unsigned char biopak; /* 0 - No, 1 - Yes boolean for biopak support. */
    unsigned int sidmaduration;
    unsigned int aidmamodifier;
+   unsigned char idleloopdetection; /* 0 - Trivial idle loops only, 1 - Also polling loops */
    uint32_t set_flags;
 } romdatabase_entry;
 
@@ -135,6 +136,7 @@ typedef struct
 #define ROMDATABASE_ENTRY_BIOPAK        BIT(11)
 #define ROMDATABASE_ENTRY_SIDMADURATION BIT(12)
 #define ROMDATABASE_ENTRY_AIDMAMODIFIER BIT(13)
+#define ROMDATABASE_ENTRY_IDLELOOP      BIT(14)
 
 typedef struct _romdatabase_search
 {
@@ -45,6 +45,7 @@
 #include "device/device.h"
 #include "main/list.h"
 #include "main/main.h"
+#include "main/trace.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "plugin/plugin.h"
@@ -56,6 +57,8 @@
 #include <unzip.h>
 #include <zip.h>
 
+#include <mupen64plus-next_common.h>
+
 enum { GB_CART_FINGERPRINT_SIZE = 0x1c };
 enum { GB_CART_FINGERPRINT_OFFSET = 0x134 };
 
@@ -86,9 +89,6 @@ struct savestate_work {
     char *data;
     size_t size;
     struct work_struct work;
-#ifdef __LIBRETRO__
-    void *mempointer;
-#endif
 };
 
 /* Returns the malloc'd full path of the currently selected savestate. */
@@ -225,6 +225,15 @@ int savestates_load_m64p(struct device* dev, const void *data)
 
     uint32_t* cp0_regs = r4300_cp0_regs(&dev->r4300.cp0);
 
+#ifdef HAVE_THR_AL
+    /* don't let pending RDP commands write into the loaded RDRAM */
+    if (current_rdp_type == RDP_PLUGIN_ANGRYLION)
+        angrylion_sync();
+#endif
+
+    /* nor a pending RSP task write into the loaded RDRAM and SP memory */
+    rsp_wait_async_task(&dev->sp);
+
 #ifdef USE_SDL
     SDL_LockMutex(savestates_lock);
 #else
@@ -311,6 +320,12 @@ int savestates_load_m64p(struct device* dev, const void *data)
 
     /* Read the rest of the savestate */
     savestateSize = 16788244;
+#if defined(__LIBRETRO__) && !defined(M64P_BIG_ENDIAN)
+    /* GETARRAY doesn't touch the buffer on little endian hosts,
+     * so parse the state directly from the frontend buffer. */
+    savestateData = NULL;
+    curr = (unsigned char *)data + 44;
+#else
     savestateData = curr = (unsigned char *)malloc(savestateSize);
     if (savestateData == NULL)
     {
@@ -325,6 +340,7 @@ int savestates_load_m64p(struct device* dev, const void *data)
 #endif
         return 0;
     }
+#endif
     if (version == 0x00010000) /* original savestate version */
     {
 #ifndef __LIBRETRO__
@@ -340,7 +356,8 @@ int savestates_load_m64p(struct device* dev, const void *data)
             return 0;
         }
 #else
-        memcpy(savestateData, data + 44, savestateSize);
+        if (savestateData != NULL)
+            memcpy(savestateData, data + 44, savestateSize);
         memcpy(queue, data + 44 + savestateSize, sizeof(queue));
 #endif
     }
@@ -360,7 +377,8 @@ int savestates_load_m64p(struct device* dev, const void *data)
             return 0;
         }
 #else
-        memcpy(savestateData, data + 44, savestateSize);
+        if (savestateData != NULL)
+            memcpy(savestateData, data + 44, savestateSize);
         memcpy(queue, data + 44 + savestateSize, sizeof(queue));
         memcpy(using_tlb_data, data + 44 + savestateSize + sizeof(queue), sizeof(using_tlb_data));
 #endif
@@ -382,7 +400,8 @@ int savestates_load_m64p(struct device* dev, const void *data)
             return 0;
         }
 #else
-        memcpy(savestateData, data + 44, savestateSize);
+        if (savestateData != NULL)
+            memcpy(savestateData, data + 44, savestateSize);
         memcpy(queue, data + 44 + savestateSize, sizeof(queue));
         memcpy(using_tlb_data, data + 44 + savestateSize + sizeof(queue), sizeof(using_tlb_data));
         memcpy(data_0001_0200, data + 44 + savestateSize + sizeof(queue) + sizeof(using_tlb_data), sizeof(data_0001_0200));
@@ -1499,6 +1518,7 @@ int savestates_load(void)
 {
     int ret = 0;
     struct device* dev = &g_dev;
+    TRACE_BEGIN(zone_start);
 
 #ifndef __LIBRETRO__
     FILE *fPtr = NULL;
@@ -1581,6 +1601,7 @@ int savestates_load(void)
     StateChanged(M64CORE_STATE_LOADCOMPLETE, ret);
 
     savestates_clear_job();
+    TRACE_END(zone_start, "savestate load");
 
     return ret;
 }
@@ -1621,11 +1642,7 @@ static void savestates_save_m64p_work(struct work_struct *work)
 
     gzclose(f);
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
-#else
-    memcpy(save->mempointer, save->data, save->size);
-#endif
     free(save->data);
-#ifndef __LIBRETRO__
     free(save->filepath);
 #endif
     free(save);
@@ -1655,6 +1672,15 @@ int savestates_save_m64p(const struct device* dev, void *data)
     /* OK to cast away const qualifier */
     const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
 
+#ifdef HAVE_THR_AL
+    /* make sure RDRAM holds the results of all submitted RDP commands */
+    if (current_rdp_type == RDP_PLUGIN_ANGRYLION)
+        angrylion_sync();
+#endif
+
+    /* and of the last RSP task, OK to cast away const qualifier */
+    rsp_wait_async_task((struct rsp_core*)&dev->sp);
+
     save = malloc(sizeof(*save));
     if (!save) {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
@@ -1664,8 +1690,6 @@ int savestates_save_m64p(const struct device* dev, void *data)
 
 #ifndef __LIBRETRO__
     save->filepath = strdup(filepath);
-#else
-    save->mempointer = data;
 #endif
 
     if(autoinc_save_slot)
@@ -1673,8 +1697,9 @@ int savestates_save_m64p(const struct device* dev, void *data)
 
     save_eventqueue_infos(&dev->r4300.cp0, queue);
 
-    // Allocate memory for the save state data
     save->size = 16788288 + sizeof(queue) + 4 + 4096;
+#ifndef __LIBRETRO__
+    // Allocate memory for the save state data
     save->data = curr = malloc(save->size);
     if (save->data == NULL)
     {
@@ -1684,8 +1709,10 @@ int savestates_save_m64p(const struct device* dev, void *data)
         StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
         return 0;
     }
-
-    memset(save->data, 0, save->size);
+#else
+    // Serialize straight into the frontend buffer, it is at least save->size bytes
+    save->data = curr = data;
+#endif
 
     // Write the save state data to memory
     PUTARRAY(savestate_magic, curr, unsigned char, 8);
@@ -1843,7 +1870,8 @@ int savestates_save_m64p(const struct device* dev, void *data)
     PUTARRAY(dev->pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
     PUTDATA(curr, int32_t, dev->cart.use_flashram);
-    curr += 4+8+4+4; // Here used to be flashram state
+    memset(curr, 0, 4+8+4+4); // Here used to be flashram state
+    curr += 4+8+4+4;
 
     PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
     PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
@@ -1982,6 +2010,7 @@ int savestates_save_m64p(const struct device* dev, void *data)
 
     if (disk_id == NULL) {
         PUTDATA(curr, uint32_t, 0);
+        memset(curr, 0, (3+DD_ASIC_REGS_COUNT)*sizeof(uint32_t) + 0x100 + 0x40 + 2*sizeof(int64_t) + 2*sizeof(uint32_t));
         curr += (3+DD_ASIC_REGS_COUNT)*sizeof(uint32_t) + 0x100 + 0x40 + 2*sizeof(int64_t) + 2*sizeof(uint32_t);
     }
     else {
@@ -2044,6 +2073,9 @@ int savestates_save_m64p(const struct device* dev, void *data)
     PUTDATA(curr, uint64_t, *r4300_cp0_latch((struct cp0*)&dev->r4300.cp0));
     PUTDATA(curr, uint64_t, *r4300_cp2_latch((struct cp2*)&dev->r4300.cp2));
 
+    /* zero the unused part of the extra state area */
+    memset(curr, 0, save->size - (curr - save->data));
+
     init_work(&save->work, savestates_save_m64p_work);
     queue_work(&save->work);
 
@@ -2293,6 +2325,7 @@ int savestates_save(void)
 {
     int ret = 0;
     const struct device* dev = &g_dev;
+    TRACE_BEGIN(zone_start);
 
 #ifndef __LIBRETRO__
     char *filepath;
@@ -2339,6 +2372,7 @@ int savestates_save(void)
 #endif // __LIBRETRO__
 
     savestates_clear_job();
+    TRACE_END(zone_start, "savestate save");
 
     return ret;
 }
@@ -0,0 +1,277 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - trace.c                                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+
+#include <rthreads/rthreads.h>
+
+#if defined(WIN32) && !defined(__MINGW32__)
+  #include <windows.h>
+
+  #define TRACE_THREAD_LOCAL __declspec(thread)
+
+  int64_t trace_now(void)
+  {
+      static LARGE_INTEGER freq = { 0 };
+      LARGE_INTEGER counter;
+      if (freq.QuadPart == 0)
+          QueryPerformanceFrequency(&freq);
+      QueryPerformanceCounter(&counter);
+      return (int64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+  }
+
+#else  /* Not WIN32 */
+  #include <time.h>
+
+  #define TRACE_THREAD_LOCAL __thread
+
+  int64_t trace_now(void)
+  {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  }
+#endif
+
+/* Each thread fills chunks of events it owns, taking no lock once it is
+ * registered.  A thread that records more than TRACE_MAX_CHUNKS chunks
+ * between start and stop drops its further zones.  recording is set while
+ * a thread touches its chunks; trace_stop clears g_trace_enabled, then waits
+ * for it before reading or freeing them. */
+#define TRACE_CHUNK_EVENTS  16384
+#define TRACE_MAX_CHUNKS    64
+
+struct trace_event
+{
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+struct trace_thread
+{
+    struct trace_event* chunks[TRACE_MAX_CHUNKS];
+    unsigned int count;
+    unsigned int dropped;
+    unsigned int tid;
+    osal_atomic_int recording;
+    char name[32];
+    struct trace_thread* next;
+};
+
+osal_atomic_int g_trace_enabled;
+
+static char* trace_path;
+static int64_t trace_base;
+static slock_t* threads_lock;
+static struct trace_thread* threads;
+static unsigned int next_tid;
+
+static TRACE_THREAD_LOCAL struct trace_thread* this_thread;
+static TRACE_THREAD_LOCAL char this_thread_name[32];
+
+static struct trace_thread* register_thread(void)
+{
+    struct trace_thread* thread = calloc(1, sizeof(*thread));
+    if (thread == NULL)
+        return NULL;
+
+    slock_lock(threads_lock);
+    thread->tid = ++next_tid;
+    if (this_thread_name[0] != '\0')
+        strcpy(thread->name, this_thread_name);
+    else
+        snprintf(thread->name, sizeof(thread->name), "thread %u", thread->tid);
+    thread->next = threads;
+    threads = thread;
+    slock_unlock(threads_lock);
+
+    return thread;
+}
+
+void trace_set_thread_name(const char* name)
+{
+    snprintf(this_thread_name, sizeof(this_thread_name), "%s", name);
+    if (this_thread != NULL) {
+        slock_lock(threads_lock);
+        strcpy(this_thread->name, this_thread_name);
+        slock_unlock(threads_lock);
+    }
+}
+
+void trace_zone(const char* name, int64_t start)
+{
+    struct trace_thread* thread = this_thread;
+    struct trace_event* event;
+    unsigned int chunk, index;
+    int64_t end;
+
+    if (!trace_enabled())
+        return;
+    end = trace_now();
+
+    if (thread == NULL) {
+        thread = this_thread = register_thread();
+        if (thread == NULL)
+            return;
+    }
+
+    /* pairs with the exchange in trace_stop: either the stop sees this
+     * thread recording and waits, or this thread sees tracing is off */
+    osal_atomic_store(&thread->recording, 1);
+    if (!osal_atomic_load(&g_trace_enabled))
+        goto done;
+
+    chunk = thread->count / TRACE_CHUNK_EVENTS;
+    index = thread->count % TRACE_CHUNK_EVENTS;
+    if (chunk >= TRACE_MAX_CHUNKS) {
+        thread->dropped++;
+        goto done;
+    }
+    if (thread->chunks[chunk] == NULL) {
+        thread->chunks[chunk] = malloc(TRACE_CHUNK_EVENTS * sizeof(struct trace_event));
+        if (thread->chunks[chunk] == NULL) {
+            thread->dropped++;
+            goto done;
+        }
+    }
+
+    event = &thread->chunks[chunk][index];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    thread->count++;
+
+done:
+    osal_atomic_store(&thread->recording, 0);
+}
+
+void trace_start(const char* path)
+{
+    if (trace_enabled())
+        return;
+
+    if (threads_lock == NULL) {
+        threads_lock = slock_new();
+        if (threads_lock == NULL)
+            return;
+    }
+
+    slock_lock(threads_lock);
+    if (!trace_enabled()) {
+        free(trace_path);
+        trace_path = strdup(path);
+        if (trace_path != NULL) {
+            trace_base = trace_now();
+            osal_atomic_store(&g_trace_enabled, 1);
+            DebugMessage(M64MSG_INFO, "Tracing to %s", trace_path);
+        }
+    }
+    slock_unlock(threads_lock);
+}
+
+static void write_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/* Writes the trace and empties every thread's buffers.  Zones still being
+ * recorded by other threads are waited for, later ones are dropped. */
+void trace_stop(void)
+{
+    struct trace_thread* thread;
+    unsigned int i, events = 0, dropped = 0;
+    FILE* f;
+
+    if (!trace_enabled())
+        return;
+
+    slock_lock(threads_lock);
+    if (!osal_atomic_exchange(&g_trace_enabled, 0)) {
+        slock_unlock(threads_lock);
+        return;
+    }
+
+    /* new threads register under threads_lock and see tracing is off */
+    for (thread = threads; thread != NULL; thread = thread->next)
+    {
+        while (osal_atomic_load(&thread->recording))
+            ;
+    }
+
+    f = fopen(trace_path, "w");
+    if (f == NULL)
+        DebugMessage(M64MSG_WARNING, "Couldn't open trace file %s", trace_path);
+    else
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+
+    for (thread = threads; thread != NULL; thread = thread->next)
+    {
+        if (f != NULL && thread->count != 0) {
+            fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    thread->tid);
+            write_json_string(f, thread->name);
+            fputs("}},\n", f);
+        }
+
+        for (i = 0; i < thread->count; i++)
+        {
+            const struct trace_event* event = &thread->chunks[i / TRACE_CHUNK_EVENTS][i % TRACE_CHUNK_EVENTS];
+            if (f == NULL)
+                break;
+
+            fputs("{\"ph\":\"X\",\"name\":", f);
+            write_json_string(f, event->name);
+            fprintf(f, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", thread->tid,
+                    (double)(event->start - trace_base) * 1e-3, (double)(event->end - event->start) * 1e-3);
+        }
+
+        events += thread->count;
+        dropped += thread->dropped;
+        thread->count = 0;
+        thread->dropped = 0;
+        for (i = 0; i < TRACE_MAX_CHUNKS; i++) {
+            free(thread->chunks[i]);
+            thread->chunks[i] = NULL;
+        }
+    }
+
+    if (f != NULL) {
+        /* closes the array with an event every viewer ignores */
+        fputs("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"mupen64plus\"}}\n]}\n", f);
+        fclose(f);
+        DebugMessage(M64MSG_INFO, "Wrote %u trace events to %s (%u dropped)", events, trace_path, dropped);
+    }
+    slock_unlock(threads_lock);
+}
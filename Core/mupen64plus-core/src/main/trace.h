@@ -0,0 +1,94 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - trace.h                                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_TRACE_H
+#define M64P_MAIN_TRACE_H
+
+#include <stdint.h>
+
+#include "osal/atomic.h"
+
+/* Timeline tracing shared by the core and the plugins.
+ *
+ * Set M64P_TRACE to a file path, or turn on the "Record Trace" core option,
+ * and every zone recorded until tracing is stopped or the ROM is closed is
+ * written as Chrome trace event JSON; open it in chrome://tracing or
+ * ui.perfetto.dev.  Each thread records into its own buffers, so a zone
+ * costs two clock reads and a few stores.  With tracing off a zone is a
+ * single test of trace_enabled(). */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern osal_atomic_int g_trace_enabled;
+
+/* Start and stop may be called from any thread, also while other threads
+ * record zones. */
+void trace_start(const char* path);
+void trace_stop(void);
+
+static inline int trace_enabled(void)
+{
+    /* a zone racing with start or stop is dropped, see trace_zone */
+    return osal_atomic_load_relaxed(&g_trace_enabled);
+}
+
+/* Names the calling thread in the exported timeline. */
+void trace_set_thread_name(const char* name);
+
+int64_t trace_now(void);
+
+/* Records a zone from start to now on the calling thread.
+ * name must stay valid until the trace is stopped, use string literals. */
+void trace_zone(const char* name, int64_t start);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define TRACE_BEGIN(start) \
+    int64_t start = trace_enabled() ? trace_now() : 0
+
+#define TRACE_END(start, name) \
+    do { if (start) trace_zone(name, start); } while (0)
+
+#ifdef __cplusplus
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+        : m_name(name), m_start(trace_enabled() ? trace_now() : 0) {}
+    ~TraceScope() { TRACE_END(m_start, m_name); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+#define TRACE_SCOPE_CONCAT2(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_SCOPE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+#endif /* M64P_MAIN_TRACE_H */
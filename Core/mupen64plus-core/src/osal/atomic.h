@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/atomic.h                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* this header file is for the few atomic flags shared between threads.
+ * Only an int with sequentially consistent load, store and exchange, plus
+ * a relaxed load for polling, is provided. It is included from C and C++,
+ * so an osal_atomic_int has the same layout in both, and it stays away from
+ * preproc.h whose macros would leak into the plugins. */
+
+#if !defined (OSAL_ATOMIC_H)
+#define OSAL_ATOMIC_H
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+  /* MSVC only has C11 atomics behind an experimental switch */
+  #include <intrin.h>
+
+  typedef volatile long osal_atomic_int;
+
+  static __inline int osal_atomic_load_relaxed(osal_atomic_int* p) { return (int)*p; }
+  static __inline int osal_atomic_load(osal_atomic_int* p) { return (int)_InterlockedOr(p, 0); }
+  static __inline void osal_atomic_store(osal_atomic_int* p, int v) { _InterlockedExchange(p, v); }
+  static __inline int osal_atomic_exchange(osal_atomic_int* p, int v) { return (int)_InterlockedExchange(p, v); }
+
+#elif !defined(__cplusplus) && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+
+  #include <stdatomic.h>
+
+  typedef atomic_int osal_atomic_int;
+
+  static inline int osal_atomic_load_relaxed(osal_atomic_int* p) { return atomic_load_explicit(p, memory_order_relaxed); }
+  static inline int osal_atomic_load(osal_atomic_int* p) { return atomic_load(p); }
+  static inline void osal_atomic_store(osal_atomic_int* p, int v) { atomic_store(p, v); }
+  static inline int osal_atomic_exchange(osal_atomic_int* p, int v) { return atomic_exchange(p, v); }
+
+#elif defined(__GNUC__)
+
+  /* C99 and C++ translation units, these builtins are what <stdatomic.h>
+   * expands to so both sides agree on the layout */
+  typedef int osal_atomic_int;
+
+  static inline int osal_atomic_load_relaxed(osal_atomic_int* p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+  static inline int osal_atomic_load(osal_atomic_int* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  static inline void osal_atomic_store(osal_atomic_int* p, int v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline int osal_atomic_exchange(osal_atomic_int* p, int v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+
+#else
+  #error "no atomic operations for this compiler"
+#endif
+
+#endif /* OSAL_ATOMIC_H */
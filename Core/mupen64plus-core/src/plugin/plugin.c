@@ -169,7 +169,7 @@ static void EmptyFunc(void)
 {
 }
 /* RSP */
-#define DEFINE_RSP(X) \
+#define DEFINE_RSP(X, SETSKIPAUDIO, STARTASYNCTASK, WAITASYNCTASK) \
     EXPORT m64p_error CALL X##PluginGetVersion(m64p_plugin_type *, int *, int *, const char **, int *); \
     EXPORT unsigned int CALL X##DoRspCycles(unsigned int Cycles); \
     EXPORT void CALL X##InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount); \
@@ -179,18 +179,24 @@ static void EmptyFunc(void)
         X##PluginGetVersion, \
         X##DoRspCycles, \
         X##InitiateRSP, \
-        X##RomClosed \
+        X##RomClosed, \
+        SETSKIPAUDIO, \
+        STARTASYNCTASK, \
+        WAITASYNCTASK \
     }
 
 // Define RSP Interfaces
-DEFINE_RSP(hle);
+EXPORT void CALL hleSetSkipAudio(int Skip);
+EXPORT int  CALL hleStartAsyncTask(RSP_DRAM_RANGE *Ranges, int MaxRanges);
+EXPORT void CALL hleWaitAsyncTask(void);
+DEFINE_RSP(hle, hleSetSkipAudio, hleStartAsyncTask, hleWaitAsyncTask);
 
 #ifdef HAVE_PARALLEL_RSP
-DEFINE_RSP(parallelRSP);
+DEFINE_RSP(parallelRSP, NULL, NULL, NULL);
 #endif // HAVE_PARALLEL_RSP
 
 #if HAVE_LLE
-DEFINE_RSP(cxd4);
+DEFINE_RSP(cxd4, NULL, NULL, NULL);
 #endif // HAVE_LLE
 
 static void                     (*l_mainRenderCallback)(int) = NULL;
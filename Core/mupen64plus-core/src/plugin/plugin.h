@@ -122,6 +122,9 @@ typedef struct _rsp_plugin_functions
 	ptr_DoRspCycles         doRspCycles;
 	ptr_InitiateRSP         initiateRSP;
 	ptr_RomClosed           romClosed;
+	ptr_SetSkipAudio        setSkipAudio; /* optional, may be NULL */
+	ptr_StartAsyncTask      startAsyncTask; /* optional, may be NULL */
+	ptr_WaitAsyncTask       waitAsyncTask;  /* optional, may be NULL */
 } rsp_plugin_functions;
 
 extern rsp_plugin_functions rsp;
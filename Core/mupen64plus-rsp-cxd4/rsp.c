@@ -25,6 +25,7 @@
 #include "vu/logical.c"
 #include "vu/multiply.c"
 #include "vu/select.c"
+#include "vu/sse41.c"
 #include "vu/vu.c"
 #include "su.c"
 #include "module.c"
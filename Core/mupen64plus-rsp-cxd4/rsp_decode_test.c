@@ -0,0 +1,353 @@
+/******************************************************************************\
+* Project:  Lock-Step Check of the Pre-Decoded SP Interpreter                  *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+/*
+ * Runs random RSP tasks through run_task() and run_task_uncached() from the
+ * same state and compares everything they leave behind.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -I../mupen64plus-core/src -I../mupen64plus-core/src/api \
+ *      -I../mupen64plus-core/subprojects/md5 -I../libretro-common/include \
+ *      -I../xxHash -DM64P_PLUGIN_API \
+ *      -o rsp-decode-test rsp_decode_test.c
+ *
+ * Programs only ever branch forwards so every task ends at the BREAK in the
+ * last IMEM word.  Some of them DMA more code over the IMEM that is still to
+ * run, and a small pool of programs is reused so decoded copies get evicted
+ * and looked up again.
+ */
+
+#include "rsp.c"
+
+#include <stdlib.h>
+
+enum { TASKS = 20000, PROGRAMS = 12, IMEM_WORDS = 0x1000 / 4 };
+
+/* DRAM offset of the code that the programs DMA into IMEM */
+#define OVERLAY_DRAM 0x00100000
+
+pu8 DMEM;
+pu8 IMEM;
+
+static u8 sp_mem[0x2000];
+static u8 rdram[0x00800000];
+static u32 regs[32];
+static unsigned messages;
+
+void DebugMessage(int level, const char *message, ...)
+{
+    ++messages;
+}
+
+static void check_interrupts(void)
+{
+}
+
+static u32 rnd_state = 0xc0ffee;
+
+static u32 rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/*
+ * Scalar registers the random instructions may write.  $29 and $30 are left
+ * for the DMA and JR sequences, so their values are always known.
+ */
+static unsigned rnd_reg(void)
+{
+    unsigned r = rnd() % 32;
+    return (r == 29 || r == 30) ? 31 : r;
+}
+
+#define R_TYPE(op, rs, rt, rd, sa, fn) \
+    ((u32)(op) << 26 | (u32)(rs) << 21 | (u32)(rt) << 16 | (u32)(rd) << 11 \
+   | (u32)(sa) << 6 | (u32)(fn))
+#define I_TYPE(op, rs, rt, imm) \
+    ((u32)(op) << 26 | (u32)(rs) << 21 | (u32)(rt) << 16 | ((u32)(imm) & 0xFFFF))
+
+/*
+ * Where sequence[] is non-zero a fixed sequence of instructions starts (1) or
+ * continues (2 and up), the same in every program.
+ */
+static u8 sequence[IMEM_WORDS];
+
+/*
+ * a random word index in [at + 2, IMEM_WORDS - 1] which isn't in the middle
+ * of a sequence
+ */
+static unsigned rnd_target(unsigned at)
+{
+    unsigned target;
+
+    if (at + 2 >= IMEM_WORDS - 1)
+        return IMEM_WORDS - 1;
+    do {
+        target = at + 2 + rnd() % (IMEM_WORDS - 1 - (at + 2) + 1);
+    } while (sequence[target] > 1);
+    return target;
+}
+
+static u32 rnd_instruction(unsigned at)
+{
+    static const unsigned special[] = {
+        000, 002, 003, 004, 006, 007, 040, 041, 042, 043,
+        044, 045, 046, 047, 052, 053, 001, 005, 030,
+    };
+    static const unsigned memory[] = {
+        040, 041, 043, 044, 045, 050, 051, 053,
+    };
+    const unsigned target = rnd_target(at);
+    unsigned kind = rnd() % 16;
+    unsigned op;
+
+    if ((at & 1) && kind >= 7 && kind <= 9)
+        kind = 0; /* branches only in even words, see make_program() */
+
+    switch (kind) {
+    case 0:
+    case 1:
+    case 2:
+        return R_TYPE(000, rnd() % 32, rnd() % 32, rnd_reg(), rnd() % 32,
+            special[rnd() % (sizeof(special) / sizeof(special[0]))]);
+    case 3:
+    case 4:
+        return I_TYPE(010 + rnd() % 8, rnd() % 32, rnd_reg(), rnd());
+    case 5:
+    case 6:
+        op = memory[rnd() % 8];
+        return I_TYPE(op, rnd() % 32, (op >= 050) ? rnd() % 32 : rnd_reg(),
+            rnd());
+    case 7: /* BEQ, BNE, BLEZ, BGTZ */
+        return I_TYPE(004 + rnd() % 4, rnd() % 32, rnd() % 32,
+            target - at - 1);
+    case 8: /* BLTZ, BGEZ, BLTZAL, BGEZAL */
+        return I_TYPE(001, rnd() % 32, (rnd() & 1) | (rnd() & 020),
+            target - at - 1);
+    case 9: /* J, JAL */
+        return (u32)(002 + rnd() % 2) << 26 | target;
+    case 10: /* MFC2, CFC2, MTC2, CTC2 */
+        return R_TYPE(022, 2*(rnd() % 4), rnd_reg(), rnd() % 32,
+            rnd() % 32, 0);
+    case 11:
+    case 12: /* vector computational, any element */
+        return R_TYPE(022, 020 | rnd() % 16, rnd() % 32, rnd() % 32,
+            rnd() % 32, rnd() % 64);
+    case 13: /* LWC2 and SWC2 */
+        return (u32)((rnd() & 1) ? 062 : 072) << 26 | (rnd() % (1 << 26));
+    case 14: /* MFC0, and MTC0 to the semaphore or (rarely) the status */
+        if (rnd() % 4)
+            return R_TYPE(020, 000, rnd_reg(), rnd() % 16, 0, 0);
+        return R_TYPE(020, 004, rnd() % 32, (rnd() % 8) ? 7 : 4, 0, 0);
+    default: /* reserved, or COP0 with a reserved format */
+        return (rnd() & 1) ? R_TYPE(020, 1 + rnd() % 3, 0, 0, 0, 0)
+                           : I_TYPE(063 + rnd() % 4, 0, 0, rnd());
+    }
+}
+
+static void layout_sequences(void)
+{
+    unsigned i, j;
+
+    memset(sequence, 0, sizeof(sequence));
+    for (i = 8; i + 16 < IMEM_WORDS; i += 24 + rnd() % 48)
+        for (j = 0; j < 8; j++)
+            sequence[i + j] = 1 + j;
+}
+
+static void emit_sequence(u32* code, unsigned at)
+{
+    unsigned dst = rnd_target(at + 8);
+    unsigned length = 8 * (1 + rnd() % 32);
+    unsigned i;
+
+    dst = (dst + 1) & ~1u; /* DMA works in 8-byte units */
+    while (dst < IMEM_WORDS && sequence[dst] > 1)
+        dst += 2;
+    if (4*dst + length > 0x1000 - 8) /* keeps the BREAK */
+        length = (4*dst < 0x1000 - 8) ? 0x1000 - 8 - 4*dst : 0;
+    while (length != 0 && sequence[dst + length/4] > 1)
+        length -= 8; /* nor may it end in the middle of a sequence */
+
+    if (rnd() % 3 == 0 || length == 0) { /* ORI $30, JR $30 and a delay slot */
+        code[at + 0] = I_TYPE(015, 0, 30, 4 * rnd_target(at + 7));
+        code[at + 1] = R_TYPE(000, 30, 0, 0, 0, 010);
+        for (i = 2; i < 8; i++)
+            code[at + i] = R_TYPE(000, 0, 0, 0, 0, 000);
+        return;
+    }
+    code[at + 0] = I_TYPE(015, 0, 29, 0x1000 + 4*dst);
+    code[at + 1] = R_TYPE(020, 004, 29, 0x0, 0, 0);
+    code[at + 2] = I_TYPE(017, 0, 29, OVERLAY_DRAM >> 16);
+    code[at + 3] = I_TYPE(015, 29, 29, 4*dst);
+    code[at + 4] = R_TYPE(020, 004, 29, 0x1, 0, 0);
+    code[at + 5] = I_TYPE(015, 0, 29, length - 1);
+    code[at + 6] = R_TYPE(020, 004, 29, 0x2, 0, 0);
+    code[at + 7] = R_TYPE(000, 0, 0, 0, 0, 000);
+}
+
+/*
+ * A branch in a delay slot goes relative to the target of the first one, so
+ * forward branches only stay forward when no delay slot holds a branch.  Only
+ * even words get branches, and overlays are DMA'd to even words.
+ */
+static void make_program(u32* code)
+{
+    unsigned i;
+
+    for (i = 0; i < IMEM_WORDS - 1; i++) {
+        if (sequence[i] == 1)
+            emit_sequence(code, i);
+        if (sequence[i] == 0)
+            code[i] = rnd_instruction(i);
+    }
+    code[IMEM_WORDS - 1] = R_TYPE(000, 0, 0, 0, 0, 015); /* BREAK */
+}
+
+typedef struct {
+    u32 SR[32];
+    i16 VR[32][N << VR_STATIC_WRAPAROUND];
+    i16 VACC[3][N];
+    i16 flags[5][N];
+    s32 DivIn, DivOut;
+    int DPH;
+    u32 regs[32];
+    u8 sp_mem[0x2000];
+} rsp_state;
+
+static void save(rsp_state* s)
+{
+    memcpy(s->SR, SR, sizeof(SR));
+    memcpy(s->VR, VR, sizeof(VR));
+    memcpy(s->VACC, VACC, sizeof(VACC));
+    memcpy(s->flags[0], cf_ne, sizeof(cf_ne));
+    memcpy(s->flags[1], cf_co, sizeof(cf_co));
+    memcpy(s->flags[2], cf_clip, sizeof(cf_clip));
+    memcpy(s->flags[3], cf_comp, sizeof(cf_comp));
+    memcpy(s->flags[4], cf_vce, sizeof(cf_vce));
+    s->DivIn = DivIn;
+    s->DivOut = DivOut;
+    s->DPH = DPH;
+    memcpy(s->regs, regs, sizeof(regs));
+    memcpy(s->sp_mem, sp_mem, sizeof(sp_mem));
+}
+
+static void load(const rsp_state* s)
+{
+    memcpy(SR, s->SR, sizeof(SR));
+    memcpy(VR, s->VR, sizeof(VR));
+    memcpy(VACC, s->VACC, sizeof(VACC));
+    memcpy(cf_ne, s->flags[0], sizeof(cf_ne));
+    memcpy(cf_co, s->flags[1], sizeof(cf_co));
+    memcpy(cf_clip, s->flags[2], sizeof(cf_clip));
+    memcpy(cf_comp, s->flags[3], sizeof(cf_comp));
+    memcpy(cf_vce, s->flags[4], sizeof(cf_vce));
+    DivIn = s->DivIn;
+    DivOut = s->DivOut;
+    DPH = s->DPH;
+    memcpy(regs, s->regs, sizeof(regs));
+    memcpy(sp_mem, s->sp_mem, sizeof(sp_mem));
+}
+
+static void init_rsp(void)
+{
+    RSP_INFO info;
+    unsigned i;
+
+    memset(&info, 0, sizeof(info));
+    info.RDRAM = rdram;
+    info.DMEM = sp_mem;
+    info.IMEM = sp_mem + 0x1000;
+    info.MI_INTR_REG = &regs[0];
+    info.SP_MEM_ADDR_REG = &regs[1];
+    info.SP_DRAM_ADDR_REG = &regs[2];
+    info.SP_RD_LEN_REG = &regs[3];
+    info.SP_WR_LEN_REG = &regs[4];
+    info.SP_STATUS_REG = &regs[5];
+    info.SP_DMA_FULL_REG = &regs[6];
+    info.SP_DMA_BUSY_REG = &regs[7];
+    info.SP_PC_REG = &regs[8];
+    info.SP_SEMAPHORE_REG = &regs[9];
+    info.DPC_START_REG = &regs[10];
+    info.DPC_END_REG = &regs[11];
+    info.DPC_CURRENT_REG = &regs[12];
+    info.DPC_STATUS_REG = &regs[13];
+    info.DPC_CLOCK_REG = &regs[14];
+    info.DPC_BUFBUSY_REG = &regs[15];
+    info.DPC_PIPEBUSY_REG = &regs[16];
+    info.DPC_TMEM_REG = &regs[17];
+    info.CheckInterrupts = check_interrupts;
+    cxd4InitiateRSP(info, NULL);
+
+    for (i = 0; i < sizeof(rdram); i++)
+        rdram[i] = (u8)rnd();
+}
+
+int main(int argc, char** argv)
+{
+    static u32 programs[PROGRAMS][IMEM_WORDS];
+    static rsp_state start, expected, actual;
+    unsigned failures = 0;
+    unsigned task, i;
+
+    init_rsp();
+    for (task = 0; task < TASKS; task++) {
+        u32* overlay = (u32*)(rdram + OVERLAY_DRAM);
+
+        if (task % 64 == 0) {
+            layout_sequences();
+            for (i = 0; i < PROGRAMS; i++)
+                make_program(programs[i]);
+        }
+        make_program(overlay);
+
+        for (i = 0; i < 32; i++)
+            SR[i] = (i == 0) ? 0 : rnd();
+        for (i = 0; i < sizeof(VR) / 2; i++)
+            ((i16*)VR)[i] = (i16)rnd();
+        for (i = 0; i < sizeof(VACC) / 2; i++)
+            ((i16*)VACC)[i] = (i16)rnd();
+        for (i = 0; i < N; i++) {
+            cf_ne[i] = -(rnd() & 1);
+            cf_co[i] = -(rnd() & 1);
+            cf_clip[i] = -(rnd() & 1);
+            cf_comp[i] = -(rnd() & 1);
+            cf_vce[i] = -(rnd() & 1);
+        }
+        for (i = 0; i < 0x1000; i++)
+            sp_mem[i] = (u8)rnd();
+        memcpy(sp_mem + 0x1000, programs[rnd() % PROGRAMS], 0x1000);
+        memset(regs, 0, sizeof(regs));
+        regs[8] = 4 * (rnd() % 8); /* SP_PC_REG, before the first sequence */
+        save(&start);
+
+        run_task_uncached();
+        save(&expected);
+
+        load(&start);
+        run_task();
+        save(&actual);
+
+        if (memcmp(&expected, &actual, sizeof(actual)) != 0) {
+            printf("task %u: state differs, PC %03X / %03X\n", task,
+                expected.regs[8] & 0xFFF, actual.regs[8] & 0xFFF);
+            ++failures;
+        }
+    }
+
+    printf("%u tasks, %u mismatches (%u messages)\n", TASKS, failures, messages);
+    return failures != 0;
+}
@@ -0,0 +1,237 @@
+/******************************************************************************\
+* Project:  Fuzzer for the SSE4.1 Vector Unit Operations                       *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+/*
+ * Feeds the same random operands, accumulator and flags to the SSE2 vector
+ * operations and to their SSE4.1 replacements, and compares the result, the
+ * accumulator and every flags register they leave behind.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -DARCH_MIN_SSE2 -I../mupen64plus-core/src \
+ *      -I../mupen64plus-core/src/api -I../mupen64plus-core/subprojects/md5 \
+ *      -I../libretro-common/include -I../xxHash -DM64P_PLUGIN_API \
+ *      -o rsp-vu-fuzzer rsp_vu_fuzzer.c \
+ *      ../libretro-common/features/features_cpu.c
+ *
+ * `rsp-vu-fuzzer [iterations] [-b]`; -b also times both versions.
+ */
+
+#include "rsp.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef VU_X86_DISPATCH
+#error "build with -DARCH_MIN_SSE2 on x86 and GCC or Clang"
+#endif
+
+pu8 DMEM;
+pu8 IMEM;
+
+void DebugMessage(int level, const char *message, ...)
+{
+}
+
+typedef VECTOR_OPERATION (*vector_op)(v16, v16);
+
+static const struct {
+    const char* name;
+    vector_op sse2, sse41;
+} ops[] = {
+    { "VMACF", VMACF, macf_v_sse41 },
+    { "VMACU", VMACU, macu_v_sse41 },
+    { "VMADL", VMADL, madl_v_sse41 },
+    { "VMADM", VMADM, madm_v_sse41 },
+    { "VMADN", VMADN, madn_v_sse41 },
+    { "VMADH", VMADH, madh_v_sse41 },
+    { "VLT",   VLT,   lt_v_sse41 },
+    { "VEQ",   VEQ,   eq_v_sse41 },
+    { "VNE",   VNE,   ne_v_sse41 },
+    { "VGE",   VGE,   ge_v_sse41 },
+    { "VCL",   VCL,   cl_v_sse41 },
+    { "VCH",   VCH,   ch_v_sse41 },
+    { "VMRG",  VMRG,  mrg_v_sse41 },
+};
+
+typedef struct {
+    ALIGNED i16 result[N];
+    ALIGNED i16 acc[3][N];
+    ALIGNED i16 flags[5][N];
+} vu_state;
+
+static i16* const flags[5] = { cf_ne, cf_co, cf_clip, cf_comp, cf_vce };
+
+static u32 rnd_state = 0x5eed1234;
+
+static u32 rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* Edge cases of the clamps and carries turn up far more often than chance. */
+static i16 rnd_element(void)
+{
+    static const i16 special[] = {
+        0x0000, 0x0001, -0x0001, 0x7FFF, -0x8000, 0x7FFE, -0x7FFF, 0x00FF,
+    };
+
+    if (rnd() % 4 == 0)
+        return special[rnd() % (sizeof(special) / sizeof(special[0]))];
+    return (i16)rnd();
+}
+
+static void randomize(vu_state* s)
+{
+    int i, j;
+
+    for (j = 0; j < 3; j++)
+        for (i = 0; i < N; i++)
+            s->acc[j][i] = rnd_element();
+    for (j = 0; j < 5; j++)
+        for (i = 0; i < N; i++)
+            s->flags[j][i] = rnd() & 1;
+}
+
+static void load(const vu_state* s)
+{
+    memcpy(VACC, s->acc, sizeof(VACC));
+    for (int j = 0; j < 5; j++)
+        memcpy(flags[j], s->flags[j], sizeof(s->flags[j]));
+}
+
+static void save(vu_state* s, v16 result)
+{
+    *(v16 *)s->result = result;
+    memcpy(s->acc, VACC, sizeof(VACC));
+    for (int j = 0; j < 5; j++)
+        memcpy(s->flags[j], flags[j], sizeof(s->flags[j]));
+}
+
+static void dump(const char* label, const vu_state* s)
+{
+    static const char* names[] = { "vd", "acc_hi", "acc_md", "acc_lo",
+        "ne", "co", "clip", "comp", "vce" };
+    const i16* rows[9];
+    int i, j;
+
+    rows[0] = s->result;
+    for (j = 0; j < 3; j++)
+        rows[1 + j] = s->acc[j];
+    for (j = 0; j < 5; j++)
+        rows[4 + j] = s->flags[j];
+    printf("  %s\n", label);
+    for (j = 0; j < 9; j++) {
+        printf("    %-7s", names[j]);
+        for (i = 0; i < N; i++)
+            printf(" %04X", (u16)rows[j][i]);
+        printf("\n");
+    }
+}
+
+static unsigned fuzz(const char* name, vector_op reference, vector_op op,
+                     unsigned iterations)
+{
+    vu_state start, expect, got;
+    ALIGNED i16 vs[N], vt[N];
+    unsigned it, failures = 0;
+    int i;
+
+    for (it = 0; it < iterations; it++) {
+        randomize(&start);
+        for (i = 0; i < N; i++) {
+            vs[i] = rnd_element();
+            vt[i] = (rnd() % 8 == 0) ? vs[i] : rnd_element();
+        }
+
+        load(&start);
+        save(&expect, reference(*(v16 *)vs, *(v16 *)vt));
+        load(&start);
+        save(&got, op(*(v16 *)vs, *(v16 *)vt));
+        if (memcmp(&expect, &got, sizeof(got)) == 0)
+            continue;
+
+        if (failures++ < 3) {
+            printf("%s mismatch at iteration %u\n", name, it);
+            printf("    vs     ");
+            for (i = 0; i < N; i++)
+                printf(" %04X", (u16)vs[i]);
+            printf("\n    vt     ");
+            for (i = 0; i < N; i++)
+                printf(" %04X", (u16)vt[i]);
+            printf("\n");
+            dump("start", &start);
+            dump("expected", &expect);
+            dump("got", &got);
+        }
+    }
+    return (failures);
+}
+
+static double bench(vector_op op)
+{
+    enum { CALLS = 4000000 };
+    ALIGNED i16 vs[N], vt[N];
+    vu_state start;
+    v16 sink;
+    clock_t begin;
+    int i;
+
+    randomize(&start);
+    load(&start);
+    for (i = 0; i < N; i++) {
+        vs[i] = rnd_element();
+        vt[i] = rnd_element();
+    }
+    sink = *(v16 *)vs;
+    begin = clock();
+    for (i = 0; i < CALLS; i++)
+        sink = op(sink, *(v16 *)vt);
+    *(v16 *)VR[0] = sink;
+    return (double)(clock() - begin) * 1e9 / CLOCKS_PER_SEC / CALLS;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = 1000000, failures = 0;
+    int timing = 0;
+    size_t k;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0)
+            timing = 1;
+        else
+            iterations = strtoul(argv[i], NULL, 0);
+    }
+    if (!(cpu_features_get() & RETRO_SIMD_SSE4)) {
+        printf("no SSE4.1 on this CPU, nothing to test\n");
+        return 0;
+    }
+
+    for (k = 0; k < sizeof(ops) / sizeof(ops[0]); k++) {
+        unsigned f;
+
+        f = fuzz(ops[k].name, ops[k].sse2, ops[k].sse41, iterations);
+        printf("%-6s %u mismatches", ops[k].name, f);
+        if (timing)
+            printf(", ns/op: SSE2 %.2f, SSE4.1 %.2f",
+                bench(ops[k].sse2), bench(ops[k].sse41));
+        printf("\n");
+        failures += f;
+    }
+    printf("%u iterations per op, %u mismatches\n", iterations, failures);
+    return (failures != 0);
+}
@@ -21,6 +21,10 @@
  */
 #include "module.h"
 
+#include <string.h>
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 u32 inst_word;
 
 u32 SR[32];
@@ -207,6 +211,12 @@ MT_CMD_START       ,MT_CMD_END         ,MT_READ_ONLY       ,MT_CMD_STATUS,
 MT_CMD_CLOCK       ,MT_READ_ONLY       ,MT_READ_ONLY       ,MT_READ_ONLY
 };
 
+/*
+ * Set when a DMA writes to IMEM, so that the decoded copy of IMEM used by
+ * run_task() gets looked up again.
+ */
+static int IMEM_written;
+
 void SP_DMA_READ(void)
 {
     unsigned int offC, offD; /* SP cache and dynamic DMA pointers */
@@ -235,6 +245,7 @@ void SP_DMA_READ(void)
                 *(pi64)(DRAM + offD)
               & (offD & ~MAX_DRAM_DMA_ADDR ? 0 : ~0) /* 0 if (addr > limit) */
             ;
+            IMEM_written |= offC & 0x1000;
             i += 0x008;
         } while (i < length);
     } while (count);
@@ -1986,7 +1997,689 @@ static INLINE void COP2(u32 inst)
     }
 }
 
+/*** pre-decoded IMEM, used by run_task() ***/
+
+/*
+ * Each IMEM word is decoded once into the handler that executes it and its
+ * operands.  Handlers return 0 to go on with the next instruction, 1 when a
+ * branch was taken (the delay slot runs next) and -1 when the RSP halted,
+ * like the interpreter in run_task_uncached() does.
+ */
+typedef struct rsp_op rsp_op;
+typedef int (*rsp_op_handler)(const rsp_op* op, u32 PC);
+
+struct rsp_op {
+    rsp_op_handler handler;
+    union {
+        mwc2_func mwc2;
+        p_vector_func vector;
+        void (*mt)(unsigned int);
+    } fn;
+    u32 inst;
+    u32 imm; /* extended the way the instruction uses it */
+    u8 rs, rt, rd, sa; /* sa is the element for vector operations */
+};
+
+/*
+ * Most tasks run one of a few microcodes (graphics, audio), some of which
+ * also swap overlays in and out of IMEM, so several decoded copies are kept.
+ */
+#define DECODE_CACHE_ENTRIES    8
+
+typedef struct {
+    u64 hash;
+    u32 last_use;
+    int valid;
+    u32 imem[0x1000 / 4];
+    rsp_op ops[0x1000 / 4];
+} decoded_imem;
+
+static decoded_imem decode_cache[DECODE_CACHE_ENTRIES];
+static decoded_imem* decoded;
+static u32 decode_cache_clock;
+
+static int op_reserved(const rsp_op* op, u32 PC)
+{
+    res_S();
+    return 0;
+}
+
+static int op_SLL(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rt] << op->sa;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SRL(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = (u32)(SR[op->rt]) >> op->sa;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SRA(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = (s32)(SR[op->rt]) >> op->sa;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SLLV(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rt] << MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SRLV(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = (u32)(SR[op->rt]) >> MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SRAV(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = (s32)(SR[op->rt]) >> MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_JR(const rsp_op* op, u32 PC)
+{
+    set_PC(SR[op->rs]);
+    return 1;
+}
+static int op_JALR(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = FIT_IMEM(PC + LINK_OFF);
+    SR[zero] = 0x00000000;
+    set_PC(SR[op->rs]);
+    return 1;
+}
+static int op_BREAK(const rsp_op* op, u32 PC)
+{
+    *CR[0x4] |= SP_STATUS_BROKE | SP_STATUS_HALT;
+    if (*CR[0x4] & SP_STATUS_INTR_BREAK) {
+        GET_RCP_REG(MI_INTR_REG) |= 0x00000001;
+        GET_RSP_INFO(CheckInterrupts)();
+    }
+    return -1;
+}
+static int op_ADDU(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] + SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SUBU(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] - SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_AND(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] & SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_OR(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] | SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_XOR(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] ^ SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_NOR(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = ~(SR[op->rs] | SR[op->rt]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SLT(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = ((s32)(SR[op->rs]) < (s32)(SR[op->rt]));
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SLTU(const rsp_op* op, u32 PC)
+{
+    SR[op->rd] = ((u32)(SR[op->rs]) < (u32)(SR[op->rt]));
+    SR[zero] = 0x00000000;
+    return 0;
+}
+
+static int op_REGIMM_reserved(const rsp_op* op, u32 PC)
+{
+    res_S();
+    return 1; /* as REGIMM() does */
+}
+static int op_BLTZ(const rsp_op* op, u32 PC)
+{
+    if (!((s32)SR[op->rs] < 0))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+static int op_BGEZ(const rsp_op* op, u32 PC)
+{
+    if (!((s32)SR[op->rs] >= 0))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+static int op_BLTZAL(const rsp_op* op, u32 PC)
+{
+    SR[ra] = FIT_IMEM(PC + LINK_OFF);
+    return op_BLTZ(op, PC);
+}
+static int op_BGEZAL(const rsp_op* op, u32 PC)
+{
+    SR[ra] = FIT_IMEM(PC + LINK_OFF);
+    return op_BGEZ(op, PC);
+}
+
+static int op_J(const rsp_op* op, u32 PC)
+{
+    set_PC(op->imm);
+    return 1;
+}
+static int op_JAL(const rsp_op* op, u32 PC)
+{
+    SR[ra] = FIT_IMEM(PC + LINK_OFF);
+    set_PC(op->imm);
+    return 1;
+}
+static int op_BEQ(const rsp_op* op, u32 PC)
+{
+    if (!(SR[op->rs] == SR[op->rt]))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+static int op_BNE(const rsp_op* op, u32 PC)
+{
+    if (!(SR[op->rs] != SR[op->rt]))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+static int op_BLEZ(const rsp_op* op, u32 PC)
+{
+    if (!((s32)SR[op->rs] <= 0))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+static int op_BGTZ(const rsp_op* op, u32 PC)
+{
+    if (!((s32)SR[op->rs] >  0))
+        return 0;
+    set_PC(PC + op->imm + SLOT_OFF);
+    return 1;
+}
+
+static int op_ADDIU(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = SR[op->rs] + op->imm;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SLTI(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = ((s32)(SR[op->rs]) < (s32)(op->imm)) ? 1 : 0;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SLTIU(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = ((u32)(SR[op->rs]) < op->imm) ? 1 : 0;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_ANDI(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = SR[op->rs] & op->imm;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_ORI(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = SR[op->rs] | op->imm;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_XORI(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = SR[op->rs] ^ op->imm;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_LUI(const rsp_op* op, u32 PC)
+{
+    SR[op->rt] = op->imm;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+
+static int op_LB(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    SR[op->rt] = DMEM[BES(addr) & 0x00000FFFul];
+    SR[op->rt] = (s8)SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_LH(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    SR[op->rt] = 0x00000000
+      | DMEM[BES(addr + 0) & 0x00000FFFul] <<  8
+      | DMEM[BES(addr + 1) & 0x00000FFFul] <<  0
+    ;
+    SR[op->rt] = (s16)SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_LW(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    SR_B(op->rt, 0) = DMEM[BES(addr + 0) & 0x00000FFFul];
+    SR_B(op->rt, 1) = DMEM[BES(addr + 1) & 0x00000FFFul];
+    SR_B(op->rt, 2) = DMEM[BES(addr + 2) & 0x00000FFFul];
+    SR_B(op->rt, 3) = DMEM[BES(addr + 3) & 0x00000FFFul];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_LBU(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    SR[op->rt] = DMEM[BES(addr) & 0x00000FFFul];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_LHU(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    SR[op->rt] = 0x00000000
+      | DMEM[BES(addr + 0) & 0x00000FFFul] <<  8
+      | DMEM[BES(addr + 1) & 0x00000FFFul] <<  0
+    ;
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int op_SB(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    DMEM[BES(addr) & 0x00000FFFul] = (u8)(SR[op->rt] & 0xFFu);
+    return 0;
+}
+static int op_SH(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    DMEM[BES(addr + 0) & 0x00000FFFul] = SR_B(op->rt, 2);
+    DMEM[BES(addr + 1) & 0x00000FFFul] = SR_B(op->rt, 3);
+    return 0;
+}
+static int op_SW(const rsp_op* op, u32 PC)
+{
+    const u32 addr = SR[op->rs] + op->imm;
+
+    DMEM[BES(addr + 0) & 0x00000FFFul] = SR_B(op->rt, 0);
+    DMEM[BES(addr + 1) & 0x00000FFFul] = SR_B(op->rt, 1);
+    DMEM[BES(addr + 2) & 0x00000FFFul] = SR_B(op->rt, 2);
+    DMEM[BES(addr + 3) & 0x00000FFFul] = SR_B(op->rt, 3);
+    return 0;
+}
+
+static void decode_imem(void);
+
+static int op_COP0_halt(void)
+{
+    if (IMEM_written)
+        decode_imem();
+    if (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT)
+        return -1;
+    return 0;
+}
+static int op_MFC0(const rsp_op* op, u32 PC)
+{
+    SP_CP0_MF(op->rt, op->rd);
+    return op_COP0_halt();
+}
+static int op_MTC0(const rsp_op* op, u32 PC)
+{
+    op->fn.mt(op->rt);
+    return op_COP0_halt();
+}
+static int op_COP0_reserved(const rsp_op* op, u32 PC)
+{
+    res_S();
+    return op_COP0_halt();
+}
+
+static int op_MFC2(const rsp_op* op, u32 PC)
+{
+    MFC2(op->rt, op->rd, op->sa);
+    return 0;
+}
+static int op_CFC2(const rsp_op* op, u32 PC)
+{
+    CFC2(op->rt, op->rd);
+    return 0;
+}
+static int op_MTC2(const rsp_op* op, u32 PC)
+{
+    MTC2(op->rt, op->rd, op->sa);
+    return 0;
+}
+static int op_CTC2(const rsp_op* op, u32 PC)
+{
+    CTC2(op->rt, op->rd);
+    return 0;
+}
+static int op_COP2(const rsp_op* op, u32 PC)
+{
+    COP2(op->inst);
+    return 0;
+}
+#ifdef ARCH_MIN_SSE2
+static int op_vector(const rsp_op* op, u32 PC)
+{
+    *(v16 *)(VR[op->sa]) = op->fn.vector(*(v16 *)VR[op->rd], *(v16 *)VR[op->rt]);
+    return 0;
+}
+static int op_vector_scalar(const rsp_op* op, u32 PC)
+{
+    *(v16 *)(VR[op->sa]) = op->fn.vector(
+        *(v16 *)VR[op->rd],
+        _mm_set1_epi16(VR[op->rt][op->rs - 0x18])
+    );
+    return 0;
+}
+#endif
+
+static int op_MWC2(const rsp_op* op, u32 PC)
+{
+    op->fn.mwc2(op->rt, op->sa, (s16)op->imm, op->rs);
+    return 0;
+}
+
+static void decode_op(rsp_op* op, u32 inst)
+{
+    static const rsp_op_handler special[64] = {
+        op_SLL,      op_reserved, op_SRL,      op_SRA,
+        op_SLLV,     op_reserved, op_SRLV,     op_SRAV,
+        op_JR,       op_JALR,     op_reserved, op_reserved,
+        op_reserved, op_BREAK,    op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_ADDU,     op_ADDU,     op_SUBU,     op_SUBU,
+        op_AND,      op_OR,       op_XOR,      op_NOR,
+        op_reserved, op_reserved, op_SLT,      op_SLTU,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+        op_reserved, op_reserved, op_reserved, op_reserved,
+    };
+    s16 offset;
+
+    op->inst = inst;
+    op->rs = (inst >> 21) % (1 << 5);
+    op->rt = (inst >> 16) % (1 << 5);
+    op->rd = IW_RD(inst);
+    op->sa = (inst >>  6) % (1 << 5);
+    op->imm = 0;
+    op->fn.mwc2 = NULL;
+    op->handler = op_reserved;
+
+    switch (inst >> 26) {
+    case 000: /* SPECIAL */
+        op->handler = special[inst % 64];
+        break;
+    case 001: /* REGIMM */
+        op->imm = 4*inst;
+        switch (op->rt) {
+        case 000: op->handler = op_BLTZ;    break;
+        case 001: op->handler = op_BGEZ;    break;
+        case 020: op->handler = op_BLTZAL;  break;
+        case 021: op->handler = op_BGEZAL;  break;
+        default:  op->handler = op_REGIMM_reserved;
+        }
+        break;
+    case 002:
+        op->imm = 4*inst;
+        op->handler = op_J;
+        break;
+    case 003:
+        op->imm = 4*inst;
+        op->handler = op_JAL;
+        break;
+    case 004: op->handler = op_BEQ;  goto branch;
+    case 005: op->handler = op_BNE;  goto branch;
+    case 006: op->handler = op_BLEZ; goto branch;
+    case 007: op->handler = op_BGTZ;
+branch:
+        op->imm = 4*inst;
+        break;
+    case 010: /* ADDI:  Traps don't exist on the RCP. */
+    case 011:
+        op->imm = (u32)(s32)(s16)(inst & 0x0000FFFFu);
+        op->handler = op_ADDIU;
+        break;
+    case 012:
+        op->imm = (u32)(s32)(s16)(inst & 0x0000FFFFu);
+        op->handler = op_SLTI;
+        break;
+    case 013:
+        op->imm = (u16)(inst & 0x0000FFFFu);
+        op->handler = op_SLTIU;
+        break;
+    case 014:
+        op->imm = (u16)(inst & 0x0000FFFFu);
+        op->handler = op_ANDI;
+        break;
+    case 015:
+        op->imm = (u16)(inst & 0x0000FFFFu);
+        op->handler = op_ORI;
+        break;
+    case 016:
+        op->imm = (u16)(inst & 0x0000FFFFu);
+        op->handler = op_XORI;
+        break;
+    case 017:
+        op->imm = (u32)(u16)(inst & 0x0000FFFFu) << 16;
+        op->handler = op_LUI;
+        break;
+    case 020:
+        switch (op->rs) {
+        case 000:
+            op->handler = op_MFC0;
+            break;
+        case 004:
+            op->fn.mt = SP_CP0_MT[op->rd % NUMBER_OF_CP0_REGISTERS];
+            op->handler = op_MTC0;
+            break;
+        default:
+            op->handler = op_COP0_reserved;
+        }
+        break;
+    case 022:
+        /* vd in sa, vs in rd and the element in rs, like COP2() decodes them */
+        switch (op->rs) {
+        case 000:
+            op->sa = ((inst >> 6) % (1 << 5)) >> 1;
+            op->handler = op_MFC2;
+            break;
+        case 002:
+            op->handler = op_CFC2;
+            break;
+        case 004:
+            op->sa = ((inst >> 6) % (1 << 5)) >> 1;
+            op->handler = op_MTC2;
+            break;
+        case 006:
+            op->handler = op_CTC2;
+            break;
+#ifdef ARCH_MIN_SSE2
+        case 020:
+        case 021:
+            op->fn.vector = COP2_C2[inst % (1 << 6)];
+            op->handler = op_vector;
+            break;
+        case 030: case 031: case 032: case 033:
+        case 034: case 035: case 036: case 037:
+            op->fn.vector = COP2_C2[inst % (1 << 6)];
+            op->handler = op_vector_scalar;
+            break;
+#endif
+        default:
+            op->handler = op_COP2;
+        }
+        break;
+    case 040: op->handler = op_LB;  goto load_store;
+    case 041: op->handler = op_LH;  goto load_store;
+    case 043: op->handler = op_LW;  goto load_store;
+    case 044: op->handler = op_LBU; goto load_store;
+    case 045: op->handler = op_LHU; goto load_store;
+    case 050: op->handler = op_SB;  goto load_store;
+    case 051: op->handler = op_SH;  goto load_store;
+    case 053: op->handler = op_SW;
+load_store:
+        op->imm = (u32)(s32)(s16)(inst & 0x0000FFFFul);
+        break;
+    case 062: /* LWC2 */
+    case 072: /* SWC2 */
+#if defined(ARCH_MIN_SSE2) && !defined(SSE2NEON)
+        offset   = (s16)inst;
+        offset <<= 5 + 4; /* safe on x86, skips 5-bit rd, 4-bit element */
+        offset >>= 5 + 4;
+#else
+        offset = (inst & 64) ? -(s16)(~inst%64 + 1) : inst % 64;
+#endif
+        op->imm = (u32)(s32)offset;
+        op->sa = (inst >>  7) % (1 << 4);
+        op->fn.mwc2 = (inst >> 26 == 062) ? LWC2[IW_RD(inst)] : SWC2[IW_RD(inst)];
+        op->handler = op_MWC2;
+        break;
+    }
+}
+
+/*
+ * Words are decoded the first time they run, so that a task which swaps in an
+ * overlay only pays for the instructions it actually executes.
+ */
+static int op_decode(const rsp_op* op, u32 PC)
+{
+    rsp_op* self = (rsp_op*)op; /* ops are only const to the handlers */
+
+    decode_op(self, self->inst);
+    return self->handler(self, PC);
+}
+
+/*
+ * Finds the decoded copy of the current IMEM contents, or copies IMEM into the
+ * least recently used cache entry to be decoded as it runs.
+ */
+static void decode_imem(void)
+{
+    decoded_imem* entry;
+    u64 hash;
+    int i;
+
+    IMEM_written = 0;
+    if (decoded != NULL && memcmp(decoded->imem, IMEM, 0x1000) == 0) {
+        decoded->last_use = ++decode_cache_clock;
+        return;
+    }
+
+    hash = XXH64(IMEM, 0x1000, 0);
+    entry = &decode_cache[0];
+    for (i = 0; i < DECODE_CACHE_ENTRIES; i++) {
+        decoded_imem* candidate = &decode_cache[i];
+
+        if (candidate->valid && candidate->hash == hash
+         && memcmp(candidate->imem, IMEM, 0x1000) == 0) {
+            entry = candidate;
+            goto found;
+        }
+        if (!candidate->valid || candidate->last_use < entry->last_use)
+            entry = candidate;
+        if (!entry->valid)
+            break;
+    }
+
+    entry->valid = 1;
+    entry->hash = hash;
+    memcpy(entry->imem, IMEM, 0x1000);
+    for (i = 0; i < 0x1000 / 4; i++) {
+        entry->ops[i].handler = op_decode;
+        entry->ops[i].inst = entry->imem[i];
+    }
+found:
+    entry->last_use = ++decode_cache_clock;
+    decoded = entry;
+}
+
+#ifdef EMULATE_STATIC_PC
 NOINLINE void run_task(void)
+{
+    register u32 PC;
+    const rsp_op* op;
+
+    decode_imem();
+    PC = FIT_IMEM(GET_RCP_REG(SP_PC_REG));
+    for (;;) {
+        op = &decoded->ops[FIT_IMEM(PC) / 4];
+        PC = (PC + 0x004);
+EX:
+        inst_word = op->inst;
+#ifdef SP_EXECUTE_LOG
+        step_SP_commands(inst_word);
+#endif
+        /*
+         * a call through the decoded handler and a switch on what it returns,
+         * rather than threaded dispatch, which would need the computed goto
+         * extension that MSVC does not have
+         */
+        switch (op->handler(op, PC)) {
+        case 0:
+            continue;
+        case 1: /* branch delay slot, then the branch target */
+            op = &decoded->ops[FIT_IMEM(PC) / 4];
+            PC = FIT_IMEM(temp_PC);
+            goto EX;
+        default:
+            goto RSP_halted_CPU_exit_point;
+        }
+    }
+RSP_halted_CPU_exit_point:
+    GET_RCP_REG(SP_PC_REG) = 0x04001000 | FIT_IMEM(PC);
+    return;
+}
+#else
+NOINLINE void run_task(void)
+{
+    run_task_uncached();
+}
+#endif
+
+/*
+ * the plain interpreter, decoding each instruction word as it is fetched
+ * (kept to check the decoded path against)
+ */
+NOINLINE void run_task_uncached(void)
 {
     register u32 PC;
 
@@ -358,5 +358,6 @@ extern void SWV(unsigned vt, unsigned element, signed offset, unsigned base);
 extern void STV(unsigned vt, unsigned element, signed offset, unsigned base);
 
 NOINLINE extern void run_task(void);
+NOINLINE extern void run_task_uncached(void);
 
 #endif
@@ -1311,6 +1311,18 @@ VECTOR_OPERATION VRSQH(v16 vs, v16 vt)
 #endif
 }
 
+/*
+ * Loads the upper halves of the divide latches and the DPH flag, so that
+ * another RSP's state can be handed over between tasks.  The lower halves
+ * are never visible to RSP code once a divide has completed.
+ */
+void set_divide_latches(i16 in_high, i16 out_high, int double_precision)
+{
+    DivIn  = (s32)in_high << 16;
+    DivOut = (s32)out_high << 16;
+    DPH = double_precision ? SP_DIV_PRECISION_DOUBLE : SP_DIV_PRECISION_SINGLE;
+}
+
 VECTOR_OPERATION VNOP(v16 vs, v16 vt)
 {
     const int result = (inst_word & 0x000007FF) >>  6;
@@ -35,4 +35,6 @@ VECTOR_EXTERN
 VECTOR_EXTERN
     VNOP   (v16 vs, v16 vt);
 
+extern void set_divide_latches(i16 in_high, i16 out_high, int double_precision);
+
 #endif
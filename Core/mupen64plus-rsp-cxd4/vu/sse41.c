@@ -0,0 +1,325 @@
+/******************************************************************************\
+* Project:  SSE4.1 Versions of Vector Unit Multiplies and Selects              *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+#include "sse41.h"
+
+#ifdef VU_X86_DISPATCH
+#include <smmintrin.h>
+
+/*
+ * These are only installed into COP2_C2 by select_vector_backend() when the
+ * CPU has SSE4.1, so the rest of the module can stay SSE2-only.  Results and
+ * accumulator/flag side effects must match the SSE2 versions bit for bit;
+ * rsp_vu_fuzzer.c checks that.
+ */
+#define SSE41_FUNC  __attribute__((target("sse4.1")))
+
+/*
+ * unsigned (a < b), with PMAXUW instead of the saturated subtraction and
+ * double compare that SSE2 needs
+ */
+static SSE41_FUNC INLINE v16 cmplt_epu16(v16 a, v16 b)
+{
+    const v16 is_max = _mm_cmpeq_epi16(_mm_max_epu16(a, b), a);
+
+    return _mm_xor_si128(is_max, _mm_cmpeq_epi16(a, a));
+}
+
+/*
+ * The flags registers keep Booleans as 0 or 1 per element, which we turn
+ * into 0 or ~0 masks and back.
+ */
+static SSE41_FUNC INLINE v16 flag_mask(const i16* flags)
+{
+    return _mm_sub_epi16(_mm_setzero_si128(), *(v16 *)flags);
+}
+static SSE41_FUNC INLINE void flag_store(i16* flags, v16 mask)
+{
+    *(v16 *)flags = _mm_srli_epi16(mask, 15);
+}
+
+/* SIGNED_CLAMP_AM() of multiply.c:  acc_47..16 clamped to 16 bits */
+static SSE41_FUNC INLINE v16 clamp_mid(v16 acc_md, v16 acc_hi)
+{
+    return _mm_packs_epi32(
+        _mm_unpacklo_epi16(acc_md, acc_hi),
+        _mm_unpackhi_epi16(acc_md, acc_hi)
+    );
+}
+
+/*
+ * SIGNED_CLAMP_AL() of multiply.c:  acc_15..0 unless acc_47..16 clamps, in
+ * which case the clamped value ^ 0x8000.  Usually nothing clamps at all.
+ */
+static SSE41_FUNC INLINE v16 clamp_low(v16 acc_lo, v16 acc_md, v16 acc_hi)
+{
+    const v16 clamped = clamp_mid(acc_md, acc_hi);
+    const v16 unclamped = _mm_cmpeq_epi16(clamped, acc_md);
+
+    if (_mm_test_all_ones(unclamped))
+        return (acc_lo);
+    return _mm_blendv_epi8(
+        _mm_xor_si128(clamped, _mm_set1_epi16(-32768)), acc_lo, unclamped);
+}
+
+/*
+ * accumulator += a 48-bit (hi:md:lo) addend, carrying between the words
+ */
+static SSE41_FUNC INLINE void accumulate(v16 lo, v16 md, v16 hi)
+{
+    v16 acc_lo, acc_md, acc_hi;
+    v16 carry, wrapped;
+
+    acc_lo = _mm_add_epi16(*(v16 *)VACC_L, lo);
+    carry = cmplt_epu16(acc_lo, lo);
+    *(v16 *)VACC_L = acc_lo;
+
+    md = _mm_sub_epi16(md, carry);
+    wrapped = _mm_and_si128(carry, _mm_cmpeq_epi16(md, _mm_setzero_si128()));
+    acc_md = _mm_add_epi16(*(v16 *)VACC_M, md);
+    carry = _mm_or_si128(wrapped, cmplt_epu16(acc_md, md));
+    *(v16 *)VACC_M = acc_md;
+
+    acc_hi = _mm_add_epi16(*(v16 *)VACC_H, hi);
+    *(v16 *)VACC_H = _mm_sub_epi16(acc_hi, carry);
+}
+
+/*
+ * VMACF and VMACU accumulate 2*s*t:  low word (s*t)<<1, middle (s*t)>>15 and
+ * the sign of s*t for the high word, like do_macf() does.
+ */
+static SSE41_FUNC INLINE void accumulate_fraction(v16 vs, v16 vt)
+{
+    const v16 prod_lo = _mm_mullo_epi16(vs, vt);
+    const v16 prod_hi = _mm_mulhi_epi16(vs, vt);
+
+    accumulate(
+        _mm_add_epi16(prod_lo, prod_lo),
+        _mm_or_si128(_mm_add_epi16(prod_hi, prod_hi), _mm_srli_epi16(prod_lo, 15)),
+        _mm_srai_epi16(prod_hi, 15)
+    );
+}
+
+SSE41_FUNC VECTOR_OPERATION macf_v_sse41(v16 vs, v16 vt)
+{
+    accumulate_fraction(vs, vt);
+    return clamp_mid(*(v16 *)VACC_M, *(v16 *)VACC_H);
+}
+
+SSE41_FUNC VECTOR_OPERATION macu_v_sse41(v16 vs, v16 vt)
+{
+    v16 clamped, acc_md;
+
+    accumulate_fraction(vs, vt);
+    acc_md = *(v16 *)VACC_M;
+    clamped = clamp_mid(acc_md, *(v16 *)VACC_H);
+
+/*
+ * UNSIGNED_CLAMP():  negative results are 0, and those that were clamped
+ * down from above +32767 become 0xFFFF.
+ */
+    vs = _mm_andnot_si128(_mm_srai_epi16(clamped, 15), clamped);
+    return _mm_or_si128(vs, _mm_cmpgt_epi16(clamped, acc_md));
+}
+
+SSE41_FUNC VECTOR_OPERATION madl_v_sse41(v16 vs, v16 vt)
+{
+    v16 acc_lo, acc_md, acc_hi;
+    v16 prod_hi, overflow;
+
+    prod_hi = _mm_mulhi_epu16(vs, vt);
+
+    acc_lo = _mm_add_epi16(*(v16 *)VACC_L, prod_hi);
+    overflow = cmplt_epu16(acc_lo, prod_hi);
+    acc_md = _mm_sub_epi16(*(v16 *)VACC_M, overflow);
+    overflow = _mm_and_si128(overflow, _mm_cmpeq_epi16(acc_md, _mm_setzero_si128()));
+    acc_hi = _mm_sub_epi16(*(v16 *)VACC_H, overflow);
+
+    *(v16 *)VACC_L = acc_lo;
+    *(v16 *)VACC_M = acc_md;
+    *(v16 *)VACC_H = acc_hi;
+    return clamp_low(acc_lo, acc_md, acc_hi);
+}
+
+SSE41_FUNC VECTOR_OPERATION madm_v_sse41(v16 vs, v16 vt)
+{
+    v16 prod_hi, prod_lo;
+
+    prod_lo = _mm_mullo_epi16(vs, vt);
+    prod_hi = _mm_mulhi_epu16(vs, vt);
+    prod_hi = _mm_sub_epi16(prod_hi, _mm_and_si128(vt, _mm_srai_epi16(vs, 15)));
+
+    accumulate(prod_lo, prod_hi, _mm_srai_epi16(prod_hi, 15));
+    return clamp_mid(*(v16 *)VACC_M, *(v16 *)VACC_H);
+}
+
+SSE41_FUNC VECTOR_OPERATION madn_v_sse41(v16 vs, v16 vt)
+{
+    v16 prod_hi, prod_lo;
+
+    prod_lo = _mm_mullo_epi16(vs, vt);
+    prod_hi = _mm_mulhi_epu16(vs, vt);
+    prod_hi = _mm_sub_epi16(prod_hi, _mm_and_si128(vs, _mm_srai_epi16(vt, 15)));
+
+    accumulate(prod_lo, prod_hi, _mm_srai_epi16(prod_hi, 15));
+    return clamp_low(*(v16 *)VACC_L, *(v16 *)VACC_M, *(v16 *)VACC_H);
+}
+
+SSE41_FUNC VECTOR_OPERATION madh_v_sse41(v16 vs, v16 vt)
+{
+    v16 acc_md, acc_hi;
+    v16 prod_hi, prod_lo;
+
+    prod_hi = _mm_mulhi_epi16(vs, vt);
+    prod_lo = _mm_mullo_epi16(vs, vt);
+
+    acc_md = _mm_add_epi16(*(v16 *)VACC_M, prod_lo);
+    acc_hi = _mm_add_epi16(*(v16 *)VACC_H, prod_hi);
+    acc_hi = _mm_sub_epi16(acc_hi, cmplt_epu16(acc_md, prod_lo));
+
+    *(v16 *)VACC_M = acc_md;
+    *(v16 *)VACC_H = acc_hi;
+    return clamp_mid(acc_md, acc_hi);
+}
+
+/*
+ * the selects:  one PBLENDVB for each merge() of select.c
+ *
+ * VCR stays with select.c, whose merge() of the ~0 sign mask picks values
+ * other than VS or ~VT in some elements; a blend could not reproduce that.
+ */
+static SSE41_FUNC INLINE v16 select_result(v16 result)
+{
+    const v16 zero = _mm_setzero_si128();
+
+    *(v16 *)VACC_L = result;
+    *(v16 *)cf_ne = zero;
+    *(v16 *)cf_co = zero;
+    return (result);
+}
+
+SSE41_FUNC VECTOR_OPERATION lt_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq, lt;
+
+    eq = _mm_cmpeq_epi16(vs, vt);
+    eq = _mm_and_si128(eq, _mm_and_si128(flag_mask(cf_ne), flag_mask(cf_co)));
+    lt = _mm_or_si128(_mm_cmplt_epi16(vs, vt), eq);
+
+    flag_store(cf_comp, lt);
+    *(v16 *)cf_clip = _mm_setzero_si128();
+    return select_result(_mm_blendv_epi8(vt, vs, lt));
+}
+
+SSE41_FUNC VECTOR_OPERATION eq_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq;
+
+    eq = _mm_andnot_si128(flag_mask(cf_ne), _mm_cmpeq_epi16(vs, vt));
+
+    flag_store(cf_comp, eq);
+    *(v16 *)cf_clip = _mm_setzero_si128();
+    return select_result(vt);
+}
+
+SSE41_FUNC VECTOR_OPERATION ne_v_sse41(v16 vs, v16 vt)
+{
+    v16 ne;
+
+    ne = _mm_xor_si128(_mm_cmpeq_epi16(vs, vt), _mm_cmpeq_epi16(vs, vs));
+    ne = _mm_or_si128(ne, flag_mask(cf_ne));
+
+    flag_store(cf_comp, ne);
+    *(v16 *)cf_clip = _mm_setzero_si128();
+    return select_result(vs);
+}
+
+SSE41_FUNC VECTOR_OPERATION ge_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq, ge;
+
+    eq = _mm_cmpeq_epi16(vs, vt);
+    eq = _mm_andnot_si128(_mm_and_si128(flag_mask(cf_ne), flag_mask(cf_co)), eq);
+    ge = _mm_or_si128(_mm_cmpgt_epi16(vs, vt), eq);
+
+    flag_store(cf_comp, ge);
+    *(v16 *)cf_clip = _mm_setzero_si128();
+    return select_result(_mm_blendv_epi8(vt, vs, ge));
+}
+
+SSE41_FUNC VECTOR_OPERATION cl_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq, sn, vce;
+    v16 vc, lz, uz;
+    v16 ge, le, gen, len;
+
+    eq = _mm_cmpeq_epi16(*(v16 *)cf_ne, _mm_setzero_si128());
+    sn = flag_mask(cf_co);
+    vce = flag_mask(cf_vce);
+
+    vc = _mm_sub_epi16(_mm_xor_si128(vt, sn), sn); /* conditional negation */
+    lz = _mm_cmpeq_epi16(vs, vc);
+    uz = _mm_add_epi16(vs, vt);
+    uz = _mm_cmpeq_epi16(_mm_max_epu16(uz, vs), uz); /* no carry from vs + vt */
+
+    gen = _mm_and_si128(_mm_or_si128(lz, uz), vce);
+    len = _mm_andnot_si128(vce, _mm_and_si128(lz, uz));
+    len = _mm_or_si128(len, gen);
+    gen = _mm_cmpeq_epi16(_mm_max_epu16(vs, vc), vs); /* unsigned vs >= vc */
+
+    le = _mm_blendv_epi8(flag_mask(cf_comp), len, _mm_and_si128(eq, sn));
+    ge = _mm_blendv_epi8(flag_mask(cf_clip), gen, _mm_andnot_si128(sn, eq));
+
+    flag_store(cf_clip, ge);
+    flag_store(cf_comp, le);
+    *(v16 *)cf_vce = _mm_setzero_si128();
+    return select_result(_mm_blendv_epi8(vs, vc, _mm_blendv_epi8(ge, le, sn)));
+}
+
+SSE41_FUNC VECTOR_OPERATION ch_v_sse41(v16 vs, v16 vt)
+{
+    v16 cch, sn, vc, vce, eq;
+    v16 ge, le, diff;
+    v16 result;
+
+    cch = _mm_cmpeq_epi16(vt, _mm_set1_epi16(-32768));
+    sn = _mm_srai_epi16(_mm_xor_si128(vs, vt), 15);
+    vc = _mm_xor_si128(vt, sn);
+    vce = _mm_and_si128(_mm_cmpeq_epi16(vs, vc), sn);
+    vc = _mm_sub_epi16(vc, _mm_andnot_si128(cch, sn));
+
+    eq = _mm_andnot_si128(cch, _mm_cmpeq_epi16(vs, vc));
+    eq = _mm_or_si128(eq, vce);
+
+    ge = _mm_cmpgt_epi16(vt, _mm_or_si128(sn, vs));
+    ge = _mm_xor_si128(ge, _mm_cmpeq_epi16(vs, vs)); /* (sn | vs) >= vt */
+    diff = _mm_srai_epi16(_mm_sub_epi16(vc, vs), 15); /* (vc - vs) < 0 */
+    le = _mm_blendv_epi8(_mm_srai_epi16(vt, 15), _mm_xor_si128(diff, _mm_cmpeq_epi16(vs, vs)), sn);
+
+    result = _mm_blendv_epi8(vs, vc, _mm_blendv_epi8(ge, le, sn));
+    *(v16 *)VACC_L = result;
+    flag_store(cf_clip, ge);
+    flag_store(cf_comp, le);
+    flag_store(cf_ne, _mm_xor_si128(eq, _mm_cmpeq_epi16(vs, vs)));
+    flag_store(cf_co, sn);
+    flag_store(cf_vce, vce);
+    return (result);
+}
+
+SSE41_FUNC VECTOR_OPERATION mrg_v_sse41(v16 vs, v16 vt)
+{
+    vs = _mm_blendv_epi8(vt, vs, flag_mask(cf_comp));
+    *(v16 *)VACC_L = vs;
+    return (vs);
+}
+#endif
@@ -0,0 +1,36 @@
+/******************************************************************************\
+* Project:  SSE4.1 Versions of Vector Unit Multiplies and Selects              *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+#ifndef _SSE41_H_
+#define _SSE41_H_
+
+#include "vu.h"
+
+#ifdef VU_X86_DISPATCH
+VECTOR_EXTERN macf_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN macu_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN madl_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN madm_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN madn_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN madh_v_sse41(v16 vs, v16 vt);
+
+VECTOR_EXTERN lt_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN eq_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ne_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ge_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN cl_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ch_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN mrg_v_sse41(v16 vs, v16 vt);
+#endif
+
+#endif
@@ -24,6 +24,11 @@
 #include "pack.h"
 #endif
 
+#ifdef VU_X86_DISPATCH
+#include <features/features_cpu.h>
+#include "sse41.h"
+#endif
+
 ALIGNED i16 VR[32][N << VR_STATIC_WRAPAROUND];
 ALIGNED i16 VACC[3][N];
 #ifndef ARCH_MIN_SSE2
@@ -84,6 +89,34 @@ VECTOR_OPERATION (*COP2_C2[8 * 8])(v16, v16) = {
     res_V  ,res_V  ,res_V  ,res_V  ,res_V  ,res_V  ,res_V  ,res_V  , /* 111 */
 }; /* 000     001     010     011     100     101     110     111 */
 
+/*
+ * Only the accumulating multiplies and the selects/clip tests are worth
+ * replacing:  the rest of the matrix is already a handful of SSE2 ops each.
+ * The table is patched once, before the first task is run or decoded.
+ */
+void select_vector_backend(void)
+{
+#ifdef VU_X86_DISPATCH
+    if (cpu_features_get() & RETRO_SIMD_SSE4) {
+        COP2_C2[010] = macf_v_sse41;
+        COP2_C2[011] = macu_v_sse41;
+        COP2_C2[014] = madl_v_sse41;
+        COP2_C2[015] = madm_v_sse41;
+        COP2_C2[016] = madn_v_sse41;
+        COP2_C2[017] = madh_v_sse41;
+
+        COP2_C2[040] = lt_v_sse41;
+        COP2_C2[041] = eq_v_sse41;
+        COP2_C2[042] = ne_v_sse41;
+        COP2_C2[043] = ge_v_sse41;
+        COP2_C2[044] = cl_v_sse41;
+        COP2_C2[045] = ch_v_sse41;
+        COP2_C2[047] = mrg_v_sse41;
+    }
+#endif
+    return;
+}
+
 #ifndef ARCH_MIN_SSE2
 u16 get_VCO(void)
 {
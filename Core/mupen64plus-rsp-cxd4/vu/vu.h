@@ -21,6 +21,16 @@
 
 #include "../my_types.h"
 
+/*
+ * With GCC or Clang on x86, some of the SSE2 operations get SSE4.1
+ * replacements compiled in alongside them, which select_vector_backend()
+ * swaps into the op-code matrix if the host CPU supports them at run time.
+ */
+#if defined(ARCH_MIN_SSE2) && !defined(SSE2NEON) && defined(__GNUC__) \
+ && (defined(__x86_64__) || defined(__i386__))
+#define VU_X86_DISPATCH
+#endif
+
 #define N       8
 /* N:  number of processor elements in SIMD processor */
 
@@ -103,6 +113,8 @@ NOINLINE extern void message(const char* body);
 
 VECTOR_EXTERN (*COP2_C2[8*7 + 8])(v16, v16);
 
+extern void select_vector_backend(void);
+
 #ifdef ARCH_MIN_SSE2
 
 #define vector_copy(vd, vs) { \
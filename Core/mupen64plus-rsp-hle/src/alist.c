@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "alist.h"
+#include "alist_kernels.h"
 #include "arithmetics.h"
 #include "audio.h"
 #include "hle_external.h"
@@ -64,17 +65,126 @@ static int16_t* alist_s16(struct hle_t* hle, uint16_t dmem)
 }
 
 
+/* SIMD kernels process several samples per step, which gives different results
+ * than the sample by sample reference when dst is slightly ahead of src */
+static const struct alist_kernels_t* kernels_for(const void* dst, const void* src)
+{
+    const uint8_t* d = (const uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+
+    return (d > s && d < s + 32) ? &alist_kernels_c : alist_kernels;
+}
+
+static bool disjoint(const void* a, const void* b, size_t size)
+{
+    const uint8_t* pa = (const uint8_t*)a;
+    const uint8_t* pb = (const uint8_t*)b;
+
+    return pa + size <= pb || pb + size <= pa;
+}
+
+/* same for kernels working on blocks of 8 samples: the buffers they access
+ * must either coincide or not share any block */
+static const struct alist_kernels_t* kernels_for_blocks(const int16_t* const* buffers, size_t n)
+{
+    size_t i, j;
+
+    for (i = 0; i < n; ++i)
+        for (j = i + 1; j < n; ++j)
+            if (buffers[i] != buffers[j] && !disjoint(buffers[i], buffers[j], 16))
+                return &alist_kernels_c;
+
+    return alist_kernels;
+}
+
+/* n bytes at DMEM offsets a and b don't overlap, given the swizzling and
+ * wrapping of alist_s16 */
+static bool dmem_disjoint(uint16_t a, uint16_t b, uint16_t n)
+{
+    return ((a - b) & 0xfff) >= n + 8u && ((b - a) & 0xfff) >= n + 8u;
+}
+
 static void sample_mix(int16_t* dst, int16_t src, int16_t gain)
 {
     *dst = clamp_s16(*dst + ((src * gain) >> 15));
 }
 
-static void alist_envmix_mix(size_t n, int16_t** dst, const int16_t* gains, int16_t src)
+/* The ramped envmixes compute the gains of ENVMIX_CHUNK samples, then mix
+ * them buffer by buffer with the mix_gains kernel. That is only the same as
+ * mixing sample by sample when the input doesn't overlap the outputs and the
+ * outputs coincide or are disjoint, otherwise kernels is NULL and the chunk
+ * is mixed in the original order. */
+enum { ENVMIX_CHUNK = 64 };
+
+struct envmix_mixer_t
 {
-    size_t i;
+    const struct alist_kernels_t* kernels;
+    const int16_t* in;
+    int16_t* dst[4];
+    size_t n;
+    size_t len;
+    int16_t gains[4][ENVMIX_CHUNK];
+};
 
-    for(i = 0; i < n; ++i)
-        sample_mix(dst[i], src, gains[i]);
+static void envmix_mixer_init(struct envmix_mixer_t* mixer, size_t n, size_t count,
+        const int16_t* in, int16_t* dl, int16_t* dr, int16_t* wl, int16_t* wr)
+{
+    size_t i, j;
+
+    mixer->kernels = (count & 1) ? NULL : alist_kernels;
+    mixer->in = in;
+    mixer->dst[0] = dl;
+    mixer->dst[1] = dr;
+    mixer->dst[2] = wl;
+    mixer->dst[3] = wr;
+    mixer->n = n;
+    mixer->len = 0;
+
+    for (i = 0; i < n; ++i) {
+        if (!disjoint(in, mixer->dst[i], 2 * count))
+            mixer->kernels = NULL;
+
+        for (j = i + 1; j < n; ++j)
+            if (mixer->dst[i] != mixer->dst[j] && !disjoint(mixer->dst[i], mixer->dst[j], 2 * count))
+                mixer->kernels = NULL;
+    }
+}
+
+static void envmix_mixer_flush(struct envmix_mixer_t* mixer)
+{
+    size_t i, k;
+
+    if (mixer->kernels != NULL) {
+        for (i = 0; i < mixer->n; ++i)
+            mixer->kernels->mix_gains(mixer->dst[i], mixer->in, mixer->gains[i], mixer->len);
+    }
+    else {
+        for (k = 0; k < mixer->len; ++k) {
+            const int16_t src = mixer->in[k^S];
+
+            for (i = 0; i < mixer->n; ++i)
+                sample_mix(mixer->dst[i] + (k^S), src, mixer->gains[i][k^S]);
+        }
+    }
+
+    mixer->in += mixer->len;
+    for (i = 0; i < mixer->n; ++i)
+        mixer->dst[i] += mixer->len;
+    mixer->len = 0;
+}
+
+static void envmix_mixer_push(struct envmix_mixer_t* mixer,
+        int16_t l_vol, int16_t r_vol, int16_t dry, int16_t wet)
+{
+    size_t k = mixer->len ^ S;
+
+    mixer->gains[0][k] = clamp_s16((l_vol * dry + 0x4000) >> 15);
+    mixer->gains[1][k] = clamp_s16((r_vol * dry + 0x4000) >> 15);
+    mixer->gains[2][k] = clamp_s16((l_vol * wet + 0x4000) >> 15);
+    mixer->gains[3][k] = clamp_s16((r_vol * wet + 0x4000) >> 15);
+
+    if (++mixer->len == ENVMIX_CHUNK)
+        envmix_mixer_flush(mixer);
 }
 
 static int16_t ramp_step(struct ramp_t* ramp)
@@ -118,6 +228,75 @@ void alist_process(struct hle_t* hle, const acmd_callback_t abi[], unsigned int
     }
 }
 
+/* Starts the footprint of the current task with the list itself and
+ * returns its commands, which the ucode specific part then walks */
+const uint32_t* alist_footprint_begin(struct hle_t* hle, struct alist_footprint_t* fp, const uint32_t** alist_end)
+{
+    uint32_t address = *dmem_u32(hle, TASK_DATA_PTR);
+    uint32_t size = *dmem_u32(hle, TASK_DATA_SIZE) & ~7;
+
+    fp->count = 0;
+    alist_footprint_add(fp, address, size);
+
+    *alist_end = dram_u32(hle, address) + (size >> 2);
+    return dram_u32(hle, address);
+}
+
+void alist_footprint_add(struct alist_footprint_t* fp, uint32_t address, uint32_t length)
+{
+    /* ranges closer than this are merged, state blocks of consecutive voices
+     * are usually laid out next to each other */
+    enum { MERGE_GAP = 0x40 };
+
+    uint32_t begin = address & 0xffffff;
+    uint32_t end = begin + length;
+    uint32_t best_distance = UINT32_MAX;
+    unsigned int best = 0;
+    unsigned int i;
+
+    if (length == 0)
+        return;
+
+    for (i = 0; i < fp->count; ++i) {
+        struct alist_range_t* r = &fp->ranges[i];
+        uint32_t distance = (end < r->begin) ? r->begin - end
+                          : (begin > r->end) ? begin - r->end
+                          : 0;
+
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = i;
+        }
+    }
+
+    if (best_distance > MERGE_GAP && fp->count < ALIST_FOOTPRINT_MAX_RANGES) {
+        fp->ranges[fp->count].begin = begin;
+        fp->ranges[fp->count].end = end;
+        ++fp->count;
+        return;
+    }
+
+    /* grow the closest range, then fold in the ones it now reaches */
+    if (begin < fp->ranges[best].begin) fp->ranges[best].begin = begin;
+    if (end > fp->ranges[best].end) fp->ranges[best].end = end;
+
+    for (i = 0; i < fp->count; ++i) {
+        struct alist_range_t* r = &fp->ranges[i];
+
+        if (i == best || r->end + MERGE_GAP < fp->ranges[best].begin || r->begin > fp->ranges[best].end + MERGE_GAP)
+            continue;
+
+        if (r->begin < fp->ranges[best].begin) fp->ranges[best].begin = r->begin;
+        if (r->end > fp->ranges[best].end) fp->ranges[best].end = r->end;
+
+        /* i is replaced by the last range, which has to be looked at too */
+        *r = fp->ranges[--fp->count];
+        if (best == fp->count)
+            best = i;
+        i = (unsigned int)-1;
+    }
+}
+
 uint32_t alist_get_address(struct hle_t* hle, uint32_t so, const uint32_t *segments, size_t n)
 {
     uint8_t  segment = (so >> 24) & 0x3f;
@@ -228,28 +407,17 @@ void alist_interleave(struct hle_t* hle, uint16_t dmemo, uint16_t left, uint16_t
     uint16_t       *dst  = (uint16_t*)(hle->alist_buffer + dmemo);
     const uint16_t *srcL = (uint16_t*)(hle->alist_buffer + left);
     const uint16_t *srcR = (uint16_t*)(hle->alist_buffer + right);
+    const struct alist_kernels_t* kernels = alist_kernels;
 
     count >>= 2;
 
-    while(count != 0) {
-        uint16_t l1 = *(srcL++);
-        uint16_t l2 = *(srcL++);
-        uint16_t r1 = *(srcR++);
-        uint16_t r2 = *(srcR++);
-
-#if M64P_BIG_ENDIAN
-        *(dst++) = l1;
-        *(dst++) = r1;
-        *(dst++) = l2;
-        *(dst++) = r2;
-#else
-        *(dst++) = r2;
-        *(dst++) = l2;
-        *(dst++) = r1;
-        *(dst++) = l1;
-#endif
-        --count;
-    }
+    /* in place interleaving relies on the sample by sample order */
+    if (dmemo < left + 4*count && left < dmemo + 8*count)
+        kernels = &alist_kernels_c;
+    if (dmemo < right + 4*count && right < dmemo + 8*count)
+        kernels = &alist_kernels_c;
+
+    kernels->interleave(dst, srcL, srcR, 2*count);
 }
 
 
@@ -277,8 +445,8 @@ void alist_envmix_exp(
     struct ramp_t ramps[2];
     int32_t exp_seq[2];
     int32_t exp_rates[2];
+    struct envmix_mixer_t mixer;
 
-    uint32_t ptr = 0;
     int x, y;
     short save_buffer[40];
 
@@ -309,6 +477,7 @@ void alist_envmix_exp(
     ramps[0].step = ramps[0].target - ramps[0].value;
     ramps[1].step = ramps[1].target - ramps[1].value;
 
+    envmix_mixer_init(&mixer, n, ((count + 15) >> 4) << 3, in, dl, dr, wl, wr);
     for (y = 0; y < count; y += 16) {
 
         if (ramps[0].step != 0)
@@ -324,25 +493,13 @@ void alist_envmix_exp(
         }
 
         for (x = 0; x < 8; ++x) {
-            int16_t  gains[4];
-            int16_t* buffers[4];
             int16_t l_vol = ramp_step(&ramps[0]);
             int16_t r_vol = ramp_step(&ramps[1]);
 
-            buffers[0] = dl + (ptr^S);
-            buffers[1] = dr + (ptr^S);
-            buffers[2] = wl + (ptr^S);
-            buffers[3] = wr + (ptr^S);
-
-            gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-            gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-            gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-            gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-            alist_envmix_mix(n, buffers, gains, in[ptr^S]);
-            ++ptr;
+            envmix_mixer_push(&mixer, l_vol, r_vol, dry, wet);
         }
     }
+    envmix_mixer_flush(&mixer);
 
     *(int16_t *)(save_buffer +  0) = wet;               /* 0-1 */
     *(int16_t *)(save_buffer +  2) = dry;               /* 2-3 */
@@ -380,6 +537,7 @@ void alist_envmix_ge(
     int16_t* const wr = (int16_t*)(hle->alist_buffer + dmem_wr);
 
     struct ramp_t ramps[2];
+    struct envmix_mixer_t mixer;
     short save_buffer[40];
 
     memcpy((uint8_t *)save_buffer, (hle->dram + address), 80);
@@ -404,24 +562,14 @@ void alist_envmix_ge(
     }
 
     count >>= 1;
+    envmix_mixer_init(&mixer, n, count, in, dl, dr, wl, wr);
     for (k = 0; k < count; ++k) {
-        int16_t  gains[4];
-        int16_t* buffers[4];
         int16_t l_vol = ramp_step(&ramps[0]);
         int16_t r_vol = ramp_step(&ramps[1]);
 
-        buffers[0] = dl + (k^S);
-        buffers[1] = dr + (k^S);
-        buffers[2] = wl + (k^S);
-        buffers[3] = wr + (k^S);
-
-        gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-        gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-        gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-        gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-        alist_envmix_mix(n, buffers, gains, in[k^S]);
+        envmix_mixer_push(&mixer, l_vol, r_vol, dry, wet);
     }
+    envmix_mixer_flush(&mixer);
 
     *(int16_t *)(save_buffer +  0) = wet;               /* 0-1 */
     *(int16_t *)(save_buffer +  2) = dry;               /* 2-3 */
@@ -450,6 +598,7 @@ void alist_envmix_lin(
 {
     size_t k;
     struct ramp_t ramps[2];
+    struct envmix_mixer_t mixer;
     int16_t save_buffer[40];
 
     const int16_t * const in = (int16_t*)(hle->alist_buffer + dmemi);
@@ -479,24 +628,14 @@ void alist_envmix_lin(
     }
 
     count >>= 1;
+    envmix_mixer_init(&mixer, 4, count, in, dl, dr, wl, wr);
     for(k = 0; k < count; ++k) {
-        int16_t  gains[4];
-        int16_t* buffers[4];
         int16_t l_vol = ramp_step(&ramps[0]);
         int16_t r_vol = ramp_step(&ramps[1]);
 
-        buffers[0] = dl + (k^S);
-        buffers[1] = dr + (k^S);
-        buffers[2] = wl + (k^S);
-        buffers[3] = wr + (k^S);
-
-        gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-        gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-        gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-        gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-        alist_envmix_mix(4, buffers, gains, in[k^S]);
+        envmix_mixer_push(&mixer, l_vol, r_vol, dry, wet);
     }
+    envmix_mixer_flush(&mixer);
 
     *(int16_t *)(save_buffer +  0) = wet;            /* 0-1 */
     *(int16_t *)(save_buffer +  2) = dry;            /* 2-3 */
@@ -527,6 +666,8 @@ void alist_envmix_nead(
     int16_t *dr = (int16_t*)(hle->alist_buffer + dmem_dr);
     int16_t *wl = (int16_t*)(hle->alist_buffer + dmem_wl);
     int16_t *wr = (int16_t*)(hle->alist_buffer + dmem_wr);
+    int16_t *out[4];
+    const int16_t *buffers[5];
 
     /* make sure count is a multiple of 8 */
     count = align(count, 8);
@@ -534,31 +675,13 @@ void alist_envmix_nead(
     if (swap_wet_LR)
         swap(&wl, &wr);
 
-    while (count != 0) {
-        size_t i;
-        for(i = 0; i < 8; ++i) {
-            int16_t l  = (((int32_t)in[i^S] * (uint32_t)env_values[0]) >> 16) ^ xors[0];
-            int16_t r  = (((int32_t)in[i^S] * (uint32_t)env_values[1]) >> 16) ^ xors[1];
-            int16_t l2 = (((int32_t)l * (uint32_t)env_values[2]) >> 16) ^ xors[2];
-            int16_t r2 = (((int32_t)r * (uint32_t)env_values[2]) >> 16) ^ xors[3];
-
-            dl[i^S] = clamp_s16(dl[i^S] + l);
-            dr[i^S] = clamp_s16(dr[i^S] + r);
-            wl[i^S] = clamp_s16(wl[i^S] + l2);
-            wr[i^S] = clamp_s16(wr[i^S] + r2);
-        }
-
-        env_values[0] += env_steps[0];
-        env_values[1] += env_steps[1];
-        env_values[2] += env_steps[2];
+    buffers[0] = in;
+    buffers[1] = out[0] = dl;
+    buffers[2] = out[1] = dr;
+    buffers[3] = out[2] = wl;
+    buffers[4] = out[3] = wr;
 
-        dl += 8;
-        dr += 8;
-        wl += 8;
-        wr += 8;
-        in += 8;
-        count -= 8;
-    }
+    kernels_for_blocks(buffers, 5)->envmix_nead(out, in, count, env_values, env_steps, xors);
 }
 
 
@@ -567,29 +690,14 @@ void alist_mix(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count
     int16_t       *dst = (int16_t*)(hle->alist_buffer + dmemo);
     const int16_t *src = (int16_t*)(hle->alist_buffer + dmemi);
 
-    count >>= 1;
-
-    while(count != 0) {
-        sample_mix(dst, *src, gain);
-
-        ++dst;
-        ++src;
-        --count;
-    }
+    kernels_for(dst, src)->mix(dst, src, count >> 1, gain);
 }
 
 void alist_multQ44(struct hle_t* hle, uint16_t dmem, uint16_t count, int8_t gain)
 {
     int16_t *dst = (int16_t*)(hle->alist_buffer + dmem);
 
-    count >>= 1;
-
-    while(count != 0) {
-        *dst = clamp_s16(*dst * gain >> 4);
-
-        ++dst;
-        --count;
-    }
+    alist_kernels->mult_q44(dst, count >> 1, gain);
 }
 
 void alist_add(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count)
@@ -597,15 +705,7 @@ void alist_add(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count
     int16_t       *dst = (int16_t*)(hle->alist_buffer + dmemo);
     const int16_t *src = (int16_t*)(hle->alist_buffer + dmemi);
 
-    count >>= 1;
-
-    while(count != 0) {
-        *dst = clamp_s16(*dst + *src);
-
-        ++dst;
-        ++src;
-        --count;
-    }
+    kernels_for(dst, src)->add(dst, src, count >> 1);
 }
 
 static void alist_resample_reset(struct hle_t* hle, uint16_t pos, uint32_t* pitch_accu)
@@ -628,6 +728,38 @@ static void alist_resample_load(struct hle_t* hle, uint32_t address, uint16_t po
     *pitch_accu = *dram_u16(hle, address + 8);
 }
 
+/* The kernel reads the input in logical order and must not see its own output,
+ * so the samples are staged in local buffers. Returns false when they are too
+ * large or overlap, the reference loop is used then. */
+static bool alist_resample_kernel(struct hle_t* hle, uint16_t* ipos, uint16_t opos,
+        uint16_t count, uint32_t pitch, uint32_t* pitch_accu)
+{
+    int16_t in[0x800];
+    int16_t out[0x800];
+    const uint64_t end = *pitch_accu + (uint64_t)count * pitch;
+    const size_t in_count = (size_t)(end >> 16) + 4;
+    size_t k;
+
+    if (end > UINT32_MAX || in_count > 0x800 || count > 0x800)
+        return false;
+
+    /* sample positions wrap at 0x1000 and are swizzled within pairs */
+    if (((opos - *ipos) & 0xfff) < in_count + 2 || ((*ipos - opos) & 0xfff) < count + 2u)
+        return false;
+
+    for (k = 0; k < in_count; ++k)
+        in[k] = *sample(hle, *ipos + k);
+
+    alist_kernels->resample(out, in, count, *pitch_accu, pitch, RESAMPLE_LUT);
+
+    for (k = 0; k < count; ++k)
+        *sample(hle, opos + k) = out[k];
+
+    *ipos += (uint16_t)(end >> 16);
+    *pitch_accu = (uint32_t)end & 0xffff;
+    return true;
+}
+
 static void alist_resample_save(struct hle_t* hle, uint32_t address, uint16_t pos, uint32_t pitch_accu)
 {
     *dram_u16(hle, address + 0) = *sample(hle, pos + 0);
@@ -663,6 +795,9 @@ void alist_resample(
     else
         alist_resample_load(hle, address, ipos, &pitch_accu);
 
+    if (alist_resample_kernel(hle, &ipos, opos, count, pitch, &pitch_accu))
+        count = 0;
+
     while (count != 0) {
         const int16_t* lut = RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8);
 
@@ -778,8 +913,11 @@ void alist_adpcm(
 
         dmemi += predict_frame(hle, frame, dmemi, scale);
 
-        adpcm_compute_residuals(last_frame    , frame    , cb_entry, last_frame + 14, 8);
-        adpcm_compute_residuals(last_frame + 8, frame + 8, cb_entry, last_frame + 6 , 8);
+        /* adpcm_compute_residuals on 8 samples */
+        alist_kernels->pole8(last_frame    , frame    , 1 << 11, cb_entry, cb_entry + 8, cb_entry + 8,
+                             last_frame[14], last_frame[15], 11);
+        alist_kernels->pole8(last_frame + 8, frame + 8, 1 << 11, cb_entry, cb_entry + 8, cb_entry + 8,
+                             last_frame[6], last_frame[7], 11);
 
         for(i = 0; i < 16; ++i, dmemo += 2)
             *alist_s16(hle, dmemo) = last_frame[i];
@@ -800,7 +938,7 @@ void alist_filter(
 {
     int x;
     int16_t outbuff[0x3c0];
-    int16_t *outp = outbuff;
+    const size_t n = ((count + 15) >> 4) << 3;
 
     int16_t* const lutt6 = (int16_t*)(hle->dram + lut_address[0]);
     int16_t* const lutt5 = (int16_t*)(hle->dram + lut_address[1]);
@@ -814,95 +952,9 @@ void alist_filter(
         lutt5[x] = lutt6[x] = v;
     }
 
-    for (x = 0; x < count; x += 16) {
-        int32_t v[8];
-
-        v[1] =  in1[0] * lutt6[6];
-        v[1] += in1[3] * lutt6[7];
-        v[1] += in1[2] * lutt6[4];
-        v[1] += in1[5] * lutt6[5];
-        v[1] += in1[4] * lutt6[2];
-        v[1] += in1[7] * lutt6[3];
-        v[1] += in1[6] * lutt6[0];
-        v[1] += in2[1] * lutt6[1]; /* 1 */
-
-        v[0] =  in1[3] * lutt6[6];
-        v[0] += in1[2] * lutt6[7];
-        v[0] += in1[5] * lutt6[4];
-        v[0] += in1[4] * lutt6[5];
-        v[0] += in1[7] * lutt6[2];
-        v[0] += in1[6] * lutt6[3];
-        v[0] += in2[1] * lutt6[0];
-        v[0] += in2[0] * lutt6[1];
-
-        v[3] =  in1[2] * lutt6[6];
-        v[3] += in1[5] * lutt6[7];
-        v[3] += in1[4] * lutt6[4];
-        v[3] += in1[7] * lutt6[5];
-        v[3] += in1[6] * lutt6[2];
-        v[3] += in2[1] * lutt6[3];
-        v[3] += in2[0] * lutt6[0];
-        v[3] += in2[3] * lutt6[1];
-
-        v[2] =  in1[5] * lutt6[6];
-        v[2] += in1[4] * lutt6[7];
-        v[2] += in1[7] * lutt6[4];
-        v[2] += in1[6] * lutt6[5];
-        v[2] += in2[1] * lutt6[2];
-        v[2] += in2[0] * lutt6[3];
-        v[2] += in2[3] * lutt6[0];
-        v[2] += in2[2] * lutt6[1];
-
-        v[5] =  in1[4] * lutt6[6];
-        v[5] += in1[7] * lutt6[7];
-        v[5] += in1[6] * lutt6[4];
-        v[5] += in2[1] * lutt6[5];
-        v[5] += in2[0] * lutt6[2];
-        v[5] += in2[3] * lutt6[3];
-        v[5] += in2[2] * lutt6[0];
-        v[5] += in2[5] * lutt6[1];
-
-        v[4] =  in1[7] * lutt6[6];
-        v[4] += in1[6] * lutt6[7];
-        v[4] += in2[1] * lutt6[4];
-        v[4] += in2[0] * lutt6[5];
-        v[4] += in2[3] * lutt6[2];
-        v[4] += in2[2] * lutt6[3];
-        v[4] += in2[5] * lutt6[0];
-        v[4] += in2[4] * lutt6[1];
-
-        v[7] =  in1[6] * lutt6[6];
-        v[7] += in2[1] * lutt6[7];
-        v[7] += in2[0] * lutt6[4];
-        v[7] += in2[3] * lutt6[5];
-        v[7] += in2[2] * lutt6[2];
-        v[7] += in2[5] * lutt6[3];
-        v[7] += in2[4] * lutt6[0];
-        v[7] += in2[7] * lutt6[1];
-
-        v[6] =  in2[1] * lutt6[6];
-        v[6] += in2[0] * lutt6[7];
-        v[6] += in2[3] * lutt6[4];
-        v[6] += in2[2] * lutt6[5];
-        v[6] += in2[5] * lutt6[2];
-        v[6] += in2[4] * lutt6[3];
-        v[6] += in2[7] * lutt6[0];
-        v[6] += in2[6] * lutt6[1];
-
-        outp[1] = ((v[1] + 0x4000) >> 15);
-        outp[0] = ((v[0] + 0x4000) >> 15);
-        outp[3] = ((v[3] + 0x4000) >> 15);
-        outp[2] = ((v[2] + 0x4000) >> 15);
-        outp[5] = ((v[5] + 0x4000) >> 15);
-        outp[4] = ((v[4] + 0x4000) >> 15);
-        outp[7] = ((v[7] + 0x4000) >> 15);
-        outp[6] = ((v[6] + 0x4000) >> 15);
-        in1 = in2;
-        in2 += 8;
-        outp += 8;
-    }
+    alist_kernels->filter(outbuff, in1, in2, n, lutt6);
 
-    memcpy(hle->dram + address, in2 - 8, 16);
+    memcpy(hle->dram + address, in2 + n - 8, 16);
     memcpy(hle->alist_buffer + dmem, outbuff, count);
 }
 
@@ -945,14 +997,15 @@ void alist_polef(
     {
         int16_t frame[8];
 
+        int16_t out[8];
+
         for(i = 0; i < 8; ++i, dmemi += 2)
             frame[i] = *alist_s16(hle, dmemi);
 
-        for(i = 0; i < 8; ++i) {
-            int32_t accu = frame[i] * gain;
-            accu += h1[i]*l1 + h2_before[i]*l2 + rdot(i, h2, frame);
-            dst[i^S] = clamp_s16(accu >> 14);
-        }
+        alist_kernels->pole8(out, frame, gain, h1, h2_before, h2, l1, l2, 14);
+
+        for(i = 0; i < 8; ++i)
+            dst[i^S] = out[i];
 
         l1 = dst[6^S];
         l2 = dst[7^S];
@@ -964,7 +1017,8 @@ void alist_polef(
     dram_store_u32(hle, (uint32_t*)(dst - 4), address, 2);
 }
 
-void alist_iirf(
+/* reference iirf, which reads each sample right before writing the previous one */
+static void alist_iirf_interleaved(
         struct hle_t* hle,
         bool init,
         uint16_t dmemo,
@@ -1022,6 +1076,62 @@ void alist_iirf(
     dram_store_u16(hle, (uint16_t*)&ibuf[(index-1)&3], address+10, 1);
 }
 
+void alist_iirf(
+        struct hle_t* hle,
+        bool init,
+        uint16_t dmemo,
+        uint16_t dmemi,
+        uint16_t count,
+        int16_t* table,
+        uint32_t address)
+{
+    int16_t *dst = (int16_t*)(hle->alist_buffer + dmemo);
+    int16_t state[4]; /* x[-2], x[-1], y[-2], y[-1] */
+    unsigned i;
+
+    count = align(count, 16);
+
+    /* the kernel reads 8 samples before writing 8, which only matches the
+     * reference when working in place or on separate buffers */
+    if ((dmemo != dmemi || (dmemi & 3) != 0) && !dmem_disjoint(dmemo, dmemi, count)) {
+        alist_iirf_interleaved(hle, init, dmemo, dmemi, count, table, address);
+        return;
+    }
+
+    if(init)
+    {
+        for(i = 0; i < 4; ++i)
+            state[i] = 0;
+    }
+    else
+    {
+        state[2] = *dram_u16(hle, address + 4);
+        state[3] = *dram_u16(hle, address + 6);
+        state[0] = *dram_u16(hle, address + 8);
+        state[1] = *dram_u16(hle, address + 10);
+    }
+
+    do
+    {
+        int16_t frame[8];
+        int16_t out[8];
+
+        for(i = 0; i < 8; ++i, dmemi += 2)
+            frame[i] = *alist_s16(hle, dmemi);
+
+        alist_kernels->iirf8(out, frame, table, state);
+
+        for(i = 0; i < 8; ++i)
+            dst[i^S] = out[i];
+
+        dst += 8;
+        count -= 0x10;
+    } while (count > 0);
+
+    dram_store_u16(hle, (uint16_t*)&state[2], address + 4, 2);
+    dram_store_u16(hle, (uint16_t*)&state[0], address + 8, 2);
+}
+
 /* Perform a clamped gain, then attenuate it back by an amount */
 void alist_overload(struct hle_t* hle, uint16_t dmem, int16_t count, int16_t gain, uint16_t attenuation)
 {
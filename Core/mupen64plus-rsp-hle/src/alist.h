@@ -30,7 +30,26 @@ struct hle_t;
 
 typedef void (*acmd_callback_t)(struct hle_t* hle, uint32_t w1, uint32_t w2);
 
+/* RDRAM ranges an audio list reads or writes, gathered before running it.
+ * Ranges are kept coalesced; when they don't fit, the closest one is grown,
+ * so the footprint may only be larger than the list accesses. */
+enum { ALIST_FOOTPRINT_MAX_RANGES = 64 };
+
+struct alist_range_t
+{
+    uint32_t begin;
+    uint32_t end;   /* exclusive */
+};
+
+struct alist_footprint_t
+{
+    struct alist_range_t ranges[ALIST_FOOTPRINT_MAX_RANGES];
+    unsigned int count;
+};
+
 void alist_process(struct hle_t* hle, const acmd_callback_t abi[], unsigned int abi_size);
+const uint32_t* alist_footprint_begin(struct hle_t* hle, struct alist_footprint_t* fp, const uint32_t** alist_end);
+void alist_footprint_add(struct alist_footprint_t* fp, uint32_t address, uint32_t length);
 uint32_t alist_get_address(struct hle_t* hle, uint32_t so, const uint32_t *segments, size_t n);
 void alist_set_address(struct hle_t* hle, uint32_t so, uint32_t *segments, size_t n);
 void alist_clear(struct hle_t* hle, uint16_t dmem, uint16_t count);
@@ -266,45 +266,109 @@ static void POLEF(struct hle_t* hle, uint32_t w1, uint32_t w2)
             address);
 }
 
+static const acmd_callback_t ABI_AUDIO[0x10] = {
+    SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+    SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+};
+
+static const acmd_callback_t ABI_AUDIO_GE[0x10] = {
+    SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER_GE,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+    SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+};
+
+static const acmd_callback_t ABI_AUDIO_BC[0x10] = {
+    SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER_GE,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+    SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+};
+
+/* walks the list like alist_process would, tracking the state which
+ * decides what RDRAM the commands touch, commands not listed below
+ * only work on DMEM */
+static void footprint(struct hle_t* hle, const acmd_callback_t abi[], unsigned int abi_size,
+                      struct alist_footprint_t* fp)
+{
+    uint32_t segments[N_SEGMENTS] = { 0 };
+    uint16_t count = hle->alist_audio.count;
+    uint32_t loop  = hle->alist_audio.loop;
+
+    const uint32_t *alist_end;
+    const uint32_t *alist = alist_footprint_begin(hle, fp, &alist_end);
+
+    while (alist != alist_end) {
+        uint32_t w1 = *(alist++);
+        uint32_t w2 = *(alist++);
+        unsigned int acmd = (w1 >> 24) & 0x7f;
+        acmd_callback_t cmd;
+        uint32_t address;
+
+        if (acmd >= abi_size)
+            continue;
+
+        cmd = abi[acmd];
+        address = alist_get_address(hle, w2, segments, N_SEGMENTS);
+
+        if (cmd == ADPCM) {
+            alist_footprint_add(fp, address, 32);
+            if ((w1 >> 16) & A_LOOP)
+                alist_footprint_add(fp, loop, 32);
+        }
+        else if (cmd == ENVMIXER || cmd == ENVMIXER_GE)
+            alist_footprint_add(fp, address, 80);
+        else if (cmd == RESAMPLE)
+            alist_footprint_add(fp, address, 16);
+        else if (cmd == POLEF)
+            alist_footprint_add(fp, address, 8);
+        else if (cmd == LOADBUFF || cmd == SAVEBUFF)
+            alist_footprint_add(fp, address & ~7, align(count, 8));
+        else if (cmd == LOADADPCM)
+            alist_footprint_add(fp, address, align((uint16_t)w1, 8));
+        else if (cmd == SEGMENT)
+            alist_set_address(hle, w2, segments, N_SEGMENTS);
+        else if (cmd == SETLOOP)
+            loop = address;
+        else if (cmd == SETBUFF && !((w1 >> 16) & A_AUX))
+            count = w2;
+    }
+}
+
 /* global functions */
 void alist_process_audio(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
-        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
-    };
-
     clear_segments(hle);
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_AUDIO, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_audio_ge(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER_GE,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
-        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
-    };
-
     clear_segments(hle);
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_AUDIO_GE, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_audio_bc(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM ,         CLEARBUFF,      ENVMIXER_GE,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
-        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
-    };
-
     clear_segments(hle);
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_AUDIO_BC, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
+
+bool alist_footprint_audio(struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp)
+{
+    if (process == alist_process_audio)
+        footprint(hle, ABI_AUDIO, 0x10, fp);
+    else if (process == alist_process_audio_ge)
+        footprint(hle, ABI_AUDIO_GE, 0x10, fp);
+    else if (process == alist_process_audio_bc)
+        footprint(hle, ABI_AUDIO_BC, 0x10, fp);
+    else
+        return false;
+
+    return true;
+}
@@ -0,0 +1,347 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - alist_footprint_test.c                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Check of the alist footprints used by the threaded audio tasks.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -I../../libretro-common/include -o alist-footprint-test \
+ *      alist_footprint_test.c alist.c alist_audio.c alist_naudio.c alist_nead.c \
+ *      alist_kernels.c audio.c memory.c mp3.c ../../libretro-common/features/features_cpu.c
+ *
+ * Random lists of the commands touching RDRAM are run twice, the second time
+ * with everything outside of the footprint overwritten. A task must not
+ * write outside of its footprint and its results must not depend on what
+ * lies outside of it. */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alist.h"
+#include "alist_kernels.h"
+#include "hle_external.h"
+#include "hle_internal.h"
+#include "memory.h"
+#include "ucodes.h"
+
+enum {
+    /* lists live at the top of the window, commands address below ADDRESS_LIMIT */
+    WINDOW = 0x40000,
+    ADDRESS_LIMIT = 0x30000,
+    ALIST_ADDRESS = 0x3c000,
+    MAX_COMMANDS = 64,
+    ITERATIONS = 300
+};
+
+enum { CMD_ADPCM, CMD_RESAMPLE, CMD_ENVMIXER, CMD_POLEF, CMD_FILTER, CMD_LOADBUFF,
+       CMD_SAVEBUFF, CMD_LOADADPCM, CMD_SETLOOP, CMD_SETBUFF, CMD_SEGMENT, CMD_MP3,
+       CMD_NAUDIO_14, CMD_COUNT };
+
+enum { FAMILY_AUDIO, FAMILY_NAUDIO, FAMILY_NEAD };
+
+struct abi_t
+{
+    const char* name;
+    ucode_func_t process;
+    bool (*footprint)(struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp);
+    int family;
+    /* opcode of each command, 0 when the ABI doesn't have it */
+    uint8_t op[CMD_COUNT];
+};
+
+#define AUDIO_OPS  { 1, 5, 3, 14, 0, 4, 6, 11, 15, 8, 7, 0, 0 }
+#define NAUDIO_OPS { 1, 5, 3, 0, 0, 4, 6, 11, 15, 0, 0, 0, 0 }
+#define MP3_OPS    { 1, 5, 3, 0, 0, 4, 6, 11, 15, 0, 0, 7, 14 }
+#define NEAD_OPS(polef, filter, segment) { 1, 5, 0, polef, filter, 20, 21, 11, 15, 8, segment, 0, 0 }
+
+static const struct abi_t abis[] = {
+    { "audio",       alist_process_audio,       alist_footprint_audio,  FAMILY_AUDIO,  AUDIO_OPS },
+    { "audio_ge",    alist_process_audio_ge,    alist_footprint_audio,  FAMILY_AUDIO,  AUDIO_OPS },
+    { "audio_bc",    alist_process_audio_bc,    alist_footprint_audio,  FAMILY_AUDIO,  AUDIO_OPS },
+    { "naudio",      alist_process_naudio,      alist_footprint_naudio, FAMILY_NAUDIO, NAUDIO_OPS },
+    { "naudio_bk",   alist_process_naudio_bk,   alist_footprint_naudio, FAMILY_NAUDIO, NAUDIO_OPS },
+    { "naudio_dk",   alist_process_naudio_dk,   alist_footprint_naudio, FAMILY_NAUDIO, NAUDIO_OPS },
+    { "naudio_mp3",  alist_process_naudio_mp3,  alist_footprint_naudio, FAMILY_NAUDIO, MP3_OPS },
+    { "naudio_cbfd", alist_process_naudio_cbfd, alist_footprint_naudio, FAMILY_NAUDIO, MP3_OPS },
+    { "nead_mk",     alist_process_nead_mk,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(14, 0, 7) },
+    { "nead_sf",     alist_process_nead_sf,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(14, 0, 0) },
+    { "nead_sfj",    alist_process_nead_sfj,    alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(14, 0, 0) },
+    { "nead_fz",     alist_process_nead_fz,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 0, 0) },
+    { "nead_efz",    alist_process_nead_efz,    alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 0, 0) },
+    { "nead_wrjb",   alist_process_nead_wrjb,   alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 27, 0) },
+    { "nead_ys",     alist_process_nead_ys,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+    { "nead_1080",   alist_process_nead_1080,   alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+    { "nead_oot",    alist_process_nead_oot,    alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+    { "nead_mm",     alist_process_nead_mm,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+    { "nead_mmb",    alist_process_nead_mmb,    alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+    { "nead_ac",     alist_process_nead_ac,     alist_footprint_nead,   FAMILY_NEAD,   NEAD_OPS(0, 7, 0) },
+};
+
+static const char* cmd_names[CMD_COUNT] = {
+    "adpcm", "resample", "envmixer", "polef", "filter", "loadbuff", "savebuff",
+    "loadadpcm", "setloop", "setbuff", "segment", "mp3", "naudio_14" };
+
+static uint32_t rnd_state = 0xf00b4;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* the only external functions the alist code uses */
+void HleVerboseMessage(void* UNUSED(user_defined), const char* UNUSED(message), ...) { }
+void HleInfoMessage(void* UNUSED(user_defined), const char* UNUSED(message), ...) { }
+void HleErrorMessage(void* UNUSED(user_defined), const char* UNUSED(message), ...) { }
+void HleWarnMessage(void* UNUSED(user_defined), const char* UNUSED(message), ...) { }
+int HleForwardTask(void* UNUSED(user_defined)) { return -1; }
+void rsp_break(struct hle_t* UNUSED(hle), unsigned int UNUSED(setbits)) { }
+
+static uint32_t rnd_address(const struct abi_t* abi)
+{
+    /* audio ABI addresses go through the segment table, segments stay below 0x10000 */
+    if (abi->family == FAMILY_AUDIO)
+        return ((rnd() & 0xf) << 24) | ((rnd() % 0x20000) & ~7);
+
+    return (rnd() % ADDRESS_LIMIT) & ~7;
+}
+
+/* random DMEM offset and byte count, keeping every command inside DMEM */
+static uint32_t rnd_dmem(uint32_t limit) { return (rnd() % limit) & ~0xf; }
+
+static void rnd_command(const struct abi_t* abi, unsigned int cmd, uint32_t* w1, uint32_t* w2)
+{
+    uint32_t op = (uint32_t)abi->op[cmd] << 24;
+
+    *w1 = op;
+    *w2 = rnd_address(abi);
+
+    switch (cmd)
+    {
+    case CMD_ADPCM:
+        if (abi->family == FAMILY_NAUDIO) {
+            *w1 = op | (*w2 & 0xffffff);
+            *w2 = ((rnd() & 3) << 28) | (rnd_dmem(0x200) << 16) | ((rnd() & 0xf) << 12) | rnd_dmem(0x400);
+        }
+        else
+            *w1 |= (rnd() & ((abi->family == FAMILY_NEAD) ? 7 : 3)) << 16;
+        break;
+    case CMD_RESAMPLE:
+        if (abi->family == FAMILY_NAUDIO) {
+            *w1 = op | (*w2 & 0xffffff);
+            *w2 = ((rnd() & 3) << 30) | ((rnd() & 0xffff) << 14) | (rnd_dmem(0x200) << 2) | (rnd() & 3);
+        }
+        else
+            *w1 |= ((rnd() & 1) << 16) | (rnd() & 0xffff);
+        break;
+    case CMD_ENVMIXER:
+        *w1 |= rnd() & 0xffffff;
+        break;
+    case CMD_POLEF:
+    case CMD_NAUDIO_14:
+        *w1 |= ((rnd() & 1) << 16) | (rnd() & 0xffff);
+        *w2 |= (rnd() & 1) << 24;
+        break;
+    case CMD_FILTER:
+        /* flags > 1 set the count and first lut, otherwise filter dmem */
+        if (rnd() & 1)
+            *w1 |= (2 << 16) | rnd_dmem(0x400);
+        else
+            *w1 |= ((rnd() & 1) << 16) | rnd_dmem(0x800);
+        break;
+    case CMD_LOADBUFF:
+    case CMD_SAVEBUFF:
+        /* DMA alignment is enforced by the commands themselves */
+        *w2 |= rnd() & 6;
+        if (abi->family != FAMILY_AUDIO)
+            *w1 |= (((rnd() % 0x600) & ~1) << 12) | ((rnd() % 0x400) & ~1);
+        break;
+    case CMD_LOADADPCM:
+        *w1 |= ((rnd() % 0x20) + 1) * 8;
+        break;
+    case CMD_SETBUFF:
+        if (abi->family == FAMILY_AUDIO && (rnd() & 3) == 0) {
+            *w1 |= (A_AUX << 16) | rnd_dmem(0x400);
+            *w2 = (rnd_dmem(0x400) << 16) | rnd_dmem(0x400);
+        }
+        else {
+            uint32_t limit = (abi->family == FAMILY_AUDIO) ? 0x400 : 0x800;
+
+            *w1 |= rnd_dmem(limit);
+            *w2 = (rnd_dmem(limit) << 16) | rnd_dmem(0x200);
+        }
+        break;
+    case CMD_SEGMENT:
+        *w2 = ((rnd() & 0xf) << 24) | ((rnd() % 0x10000) & ~7);
+        break;
+    case CMD_MP3:
+        *w1 |= rnd() & 0x1e;
+        break;
+    }
+}
+
+static unsigned int rnd_list(const struct abi_t* abi, struct hle_t* hle)
+{
+    unsigned int n = 1 + rnd() % MAX_COMMANDS;
+    unsigned int i;
+
+    for (i = 0; i < n; ++i) {
+        unsigned int cmd;
+        uint32_t w1, w2;
+
+        do {
+            cmd = rnd() % CMD_COUNT;
+        } while (abi->op[cmd] == 0);
+
+        rnd_command(abi, cmd, &w1, &w2);
+        *dram_u32(hle, ALIST_ADDRESS + 8 * i) = w1;
+        *dram_u32(hle, ALIST_ADDRESS + 8 * i + 4) = w2;
+    }
+
+    *dmem_u32(hle, TASK_DATA_PTR) = ALIST_ADDRESS;
+    *dmem_u32(hle, TASK_DATA_SIZE) = 8 * n;
+
+    return n;
+}
+
+static void dump_list(const struct abi_t* abi, struct hle_t* hle, unsigned int n)
+{
+    unsigned int i, k;
+
+    for (i = 0; i < n; ++i) {
+        uint32_t w1 = *dram_u32(hle, ALIST_ADDRESS + 8 * i);
+        uint32_t w2 = *dram_u32(hle, ALIST_ADDRESS + 8 * i + 4);
+        const char* name = "?";
+
+        for (k = 0; k < CMD_COUNT; ++k)
+            if (abi->op[k] == (w1 >> 24))
+                name = cmd_names[k];
+
+        printf("    %08x %08x %s\n", w1, w2, name);
+    }
+}
+
+static unsigned check_abi(const struct abi_t* abi, struct hle_t* hle, const uint8_t* pool)
+{
+    static uint8_t in1[WINDOW], in2[WINDOW], out1[WINDOW];
+    static uint8_t inside[WINDOW];
+    static struct hle_t state0, state1;
+    struct alist_footprint_t fp;
+    unsigned failures = 0;
+    unsigned i, k;
+    uint32_t j;
+
+    for (i = 0; i < ITERATIONS; ++i)
+    {
+        unsigned int n;
+        bool ok = true;
+
+        memcpy(hle->dram, pool + rnd() % WINDOW, ALIST_ADDRESS);
+        n = rnd_list(abi, hle);
+        memcpy(in1, hle->dram, WINDOW);
+        memcpy(&state0, hle, sizeof(state0));
+
+        if (!abi->footprint(hle, abi->process, &fp)) {
+            printf("%s: no footprint\n", abi->name);
+            return failures + 1;
+        }
+
+        memset(inside, 0, WINDOW);
+        for (k = 0; k < fp.count; ++k) {
+            if (fp.ranges[k].end > WINDOW) {
+                printf("%s: range %06x-%06x out of the test window\n",
+                       abi->name, fp.ranges[k].begin, fp.ranges[k].end);
+                return failures + 1;
+            }
+            memset(inside + fp.ranges[k].begin, 1, fp.ranges[k].end - fp.ranges[k].begin);
+        }
+
+        abi->process(hle);
+        memcpy(out1, hle->dram, WINDOW);
+        memcpy(&state1, hle, sizeof(state1));
+
+        /* same task, everything outside of the footprint replaced */
+        memcpy(hle, &state0, sizeof(state0));
+        memcpy(in2, pool + rnd() % WINDOW, WINDOW);
+        for (j = 0; j < WINDOW; ++j)
+            if (inside[j])
+                in2[j] = in1[j];
+        memcpy(hle->dram, in2, WINDOW);
+
+        abi->process(hle);
+
+        for (j = 0; j < WINDOW && ok; ++j) {
+            if (inside[j] ? out1[j] != hle->dram[j]
+                          : (out1[j] != in1[j] || hle->dram[j] != in2[j])) {
+                printf("%s: byte %06x %s the footprint differs\n",
+                       abi->name, j, inside[j] ? "inside" : "outside");
+                ok = false;
+            }
+        }
+
+        if (ok && memcmp(&state1, hle, sizeof(state1)) != 0) {
+            printf("%s: DMEM or ucode state depends on RDRAM outside of the footprint\n", abi->name);
+            ok = false;
+        }
+
+        if (!ok) {
+            dump_list(abi, hle, n);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+
+int main(void)
+{
+    static uint8_t dram[0x1000000 + 0x1000];
+    static uint8_t dmem[0x1000], imem[0x1000];
+    static uint8_t pool[2 * WINDOW];
+    static struct hle_t hle;
+    unsigned int sp_status = 0, mi_intr = 0;
+    unsigned failures = 0;
+    size_t i;
+
+    alist_kernels_init();
+
+    for (i = 0; i < sizeof(pool); ++i)
+        pool[i] = (uint8_t)rnd();
+
+    hle.dram = dram;
+    hle.dmem = dmem;
+    hle.imem = imem;
+    hle.sp_status = &sp_status;
+    hle.mi_intr = &mi_intr;
+
+    for (i = 0; i < sizeof(abis) / sizeof(abis[0]); ++i) {
+        memset(&hle.alist_buffer, 0, sizeof(hle) - offsetof(struct hle_t, alist_buffer));
+        failures += check_abi(&abis[i], &hle, pool);
+    }
+
+    printf("%u mismatches\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,835 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - alist_kernels.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alist_kernels.h"
+#include "arithmetics.h"
+#include "memory.h"
+
+#if defined(ALIST_KERNELS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(ALIST_KERNELS_AVX2)
+#include <immintrin.h>
+#include <features/features_cpu.h>
+#endif
+#if defined(ALIST_KERNELS_NEON)
+#include <arm_neon.h>
+#endif
+
+/* reference implementation */
+static void mix_c(int16_t* dst, const int16_t* src, size_t n, int16_t gain)
+{
+    while (n != 0) {
+        *dst = clamp_s16(*dst + ((*src * gain) >> 15));
+
+        ++dst;
+        ++src;
+        --n;
+    }
+}
+
+static void add_c(int16_t* dst, const int16_t* src, size_t n)
+{
+    while (n != 0) {
+        *dst = clamp_s16(*dst + *src);
+
+        ++dst;
+        ++src;
+        --n;
+    }
+}
+
+static void mult_q44_c(int16_t* dst, size_t n, int8_t gain)
+{
+    while (n != 0) {
+        *dst = clamp_s16(*dst * gain >> 4);
+
+        ++dst;
+        --n;
+    }
+}
+
+static void interleave_c(uint16_t* dst, const uint16_t* left, const uint16_t* right, size_t n)
+{
+    n >>= 1;
+
+    while (n != 0) {
+        uint16_t l1 = *(left++);
+        uint16_t l2 = *(left++);
+        uint16_t r1 = *(right++);
+        uint16_t r2 = *(right++);
+
+#ifdef M64P_BIG_ENDIAN
+        *(dst++) = l1;
+        *(dst++) = r1;
+        *(dst++) = l2;
+        *(dst++) = r2;
+#else
+        *(dst++) = r2;
+        *(dst++) = l2;
+        *(dst++) = r1;
+        *(dst++) = l1;
+#endif
+        --n;
+    }
+}
+
+static void mix_gains_c(int16_t* dst, const int16_t* src, const int16_t* gains, size_t n)
+{
+    while (n != 0) {
+        *dst = clamp_s16(*dst + ((*src * *gains) >> 15));
+
+        ++dst;
+        ++src;
+        ++gains;
+        --n;
+    }
+}
+
+static void envmix_nead_c(int16_t* const* out, const int16_t* in, size_t n,
+        uint16_t* env_values, const uint16_t* env_steps, const int16_t* xors)
+{
+    int16_t *dl = out[0];
+    int16_t *dr = out[1];
+    int16_t *wl = out[2];
+    int16_t *wr = out[3];
+
+    while (n != 0) {
+        size_t i;
+        for(i = 0; i < 8; ++i) {
+            int16_t l  = (((int32_t)in[i^S] * (uint32_t)env_values[0]) >> 16) ^ xors[0];
+            int16_t r  = (((int32_t)in[i^S] * (uint32_t)env_values[1]) >> 16) ^ xors[1];
+            int16_t l2 = (((int32_t)l * (uint32_t)env_values[2]) >> 16) ^ xors[2];
+            int16_t r2 = (((int32_t)r * (uint32_t)env_values[2]) >> 16) ^ xors[3];
+
+            dl[i^S] = clamp_s16(dl[i^S] + l);
+            dr[i^S] = clamp_s16(dr[i^S] + r);
+            wl[i^S] = clamp_s16(wl[i^S] + l2);
+            wr[i^S] = clamp_s16(wr[i^S] + r2);
+        }
+
+        env_values[0] += env_steps[0];
+        env_values[1] += env_steps[1];
+        env_values[2] += env_steps[2];
+
+        dl += 8;
+        dr += 8;
+        wl += 8;
+        wr += 8;
+        in += 8;
+        n -= 8;
+    }
+}
+
+static void resample_c(int16_t* dst, const int16_t* src, size_t n,
+        uint32_t pitch_accu, uint32_t pitch, const int16_t* lut)
+{
+    while (n != 0) {
+        const int16_t* s = src + (pitch_accu >> 16);
+        const int16_t* l = lut + ((pitch_accu & 0xfc00) >> 8);
+
+        *dst = clamp_s16((s[0] * l[0] + s[1] * l[1] + s[2] * l[2] + s[3] * l[3]) >> 15);
+
+        pitch_accu += pitch;
+        ++dst;
+        --n;
+    }
+}
+
+static void pole8_c(int16_t* dst, const int16_t* src, uint16_t gain,
+        const int16_t* c1, const int16_t* c2, const int16_t* h,
+        int16_t l1, int16_t l2, unsigned shift)
+{
+    size_t i, j;
+
+    for (i = 0; i < 8; ++i) {
+        int32_t accu = src[i] * gain + c1[i] * l1 + c2[i] * l2;
+
+        for (j = 0; j < i; ++j)
+            accu += h[j] * src[i - 1 - j];
+
+        dst[i] = clamp_s16(accu >> shift);
+    }
+}
+
+static void filter_c(int16_t* dst, const int16_t* prev, const int16_t* src, size_t n, const int16_t* lut)
+{
+    const int16_t* in1 = prev;
+    const int16_t* in2 = src;
+
+    for (; n != 0; n -= 8) {
+        int32_t v[8];
+
+        v[1] =  in1[0] * lut[6];
+        v[1] += in1[3] * lut[7];
+        v[1] += in1[2] * lut[4];
+        v[1] += in1[5] * lut[5];
+        v[1] += in1[4] * lut[2];
+        v[1] += in1[7] * lut[3];
+        v[1] += in1[6] * lut[0];
+        v[1] += in2[1] * lut[1]; /* 1 */
+
+        v[0] =  in1[3] * lut[6];
+        v[0] += in1[2] * lut[7];
+        v[0] += in1[5] * lut[4];
+        v[0] += in1[4] * lut[5];
+        v[0] += in1[7] * lut[2];
+        v[0] += in1[6] * lut[3];
+        v[0] += in2[1] * lut[0];
+        v[0] += in2[0] * lut[1];
+
+        v[3] =  in1[2] * lut[6];
+        v[3] += in1[5] * lut[7];
+        v[3] += in1[4] * lut[4];
+        v[3] += in1[7] * lut[5];
+        v[3] += in1[6] * lut[2];
+        v[3] += in2[1] * lut[3];
+        v[3] += in2[0] * lut[0];
+        v[3] += in2[3] * lut[1];
+
+        v[2] =  in1[5] * lut[6];
+        v[2] += in1[4] * lut[7];
+        v[2] += in1[7] * lut[4];
+        v[2] += in1[6] * lut[5];
+        v[2] += in2[1] * lut[2];
+        v[2] += in2[0] * lut[3];
+        v[2] += in2[3] * lut[0];
+        v[2] += in2[2] * lut[1];
+
+        v[5] =  in1[4] * lut[6];
+        v[5] += in1[7] * lut[7];
+        v[5] += in1[6] * lut[4];
+        v[5] += in2[1] * lut[5];
+        v[5] += in2[0] * lut[2];
+        v[5] += in2[3] * lut[3];
+        v[5] += in2[2] * lut[0];
+        v[5] += in2[5] * lut[1];
+
+        v[4] =  in1[7] * lut[6];
+        v[4] += in1[6] * lut[7];
+        v[4] += in2[1] * lut[4];
+        v[4] += in2[0] * lut[5];
+        v[4] += in2[3] * lut[2];
+        v[4] += in2[2] * lut[3];
+        v[4] += in2[5] * lut[0];
+        v[4] += in2[4] * lut[1];
+
+        v[7] =  in1[6] * lut[6];
+        v[7] += in2[1] * lut[7];
+        v[7] += in2[0] * lut[4];
+        v[7] += in2[3] * lut[5];
+        v[7] += in2[2] * lut[2];
+        v[7] += in2[5] * lut[3];
+        v[7] += in2[4] * lut[0];
+        v[7] += in2[7] * lut[1];
+
+        v[6] =  in2[1] * lut[6];
+        v[6] += in2[0] * lut[7];
+        v[6] += in2[3] * lut[4];
+        v[6] += in2[2] * lut[5];
+        v[6] += in2[5] * lut[2];
+        v[6] += in2[4] * lut[3];
+        v[6] += in2[7] * lut[0];
+        v[6] += in2[6] * lut[1];
+
+        dst[1] = ((v[1] + 0x4000) >> 15);
+        dst[0] = ((v[0] + 0x4000) >> 15);
+        dst[3] = ((v[3] + 0x4000) >> 15);
+        dst[2] = ((v[2] + 0x4000) >> 15);
+        dst[5] = ((v[5] + 0x4000) >> 15);
+        dst[4] = ((v[4] + 0x4000) >> 15);
+        dst[7] = ((v[7] + 0x4000) >> 15);
+        dst[6] = ((v[6] + 0x4000) >> 15);
+        in1 = in2;
+        in2 += 8;
+        dst += 8;
+    }
+}
+
+static void iirf8_c(int16_t* dst, const int16_t* src, const int16_t* table, int16_t* state)
+{
+    size_t i;
+
+    for (i = 0; i < 8; ++i) {
+        int32_t accu = vmulf(table[0], src[i]) + vmulf(table[1], state[1]) + vmulf(table[0], state[0]);
+        accu += vmulf(table[8], state[3]) * 2 + vmulf(table[9], state[2]) * 2;
+
+        state[0] = state[1];
+        state[1] = src[i];
+        state[2] = state[3];
+        state[3] = dst[i] = accu;
+    }
+}
+
+const struct alist_kernels_t alist_kernels_c =
+{
+    "c", mix_c, add_c, mult_q44_c, interleave_c,
+    mix_gains_c, envmix_nead_c, resample_c, pole8_c, filter_c, iirf8_c
+};
+
+/* SSE2
+ * Products are widened to 32-bit so that the final pack has the exact same
+ * saturation behavior as clamp_s16 (pmulhrsw rounds and can't be used). */
+#if defined(ALIST_KERNELS_SSE2)
+static void mix_sse2(int16_t* dst, const int16_t* src, size_t n, int16_t gain)
+{
+    const __m128i g = _mm_set1_epi16(gain);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_mullo_epi16(s, g);
+        __m128i hi = _mm_mulhi_epi16(s, g);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+        __m128i d0 = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+        __m128i d1 = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+
+        _mm_storeu_si128((__m128i*)(dst + i),
+                _mm_packs_epi32(_mm_add_epi32(d0, p0), _mm_add_epi32(d1, p1)));
+    }
+
+    mix_c(dst + i, src + i, n - i, gain);
+}
+
+static void add_sse2(int16_t* dst, const int16_t* src, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(d, s));
+    }
+
+    add_c(dst + i, src + i, n - i);
+}
+
+static void mult_q44_sse2(int16_t* dst, size_t n, int8_t gain)
+{
+    const __m128i g = _mm_set1_epi16(gain);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_mullo_epi16(d, g);
+        __m128i hi = _mm_mulhi_epi16(d, g);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 4);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 4);
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(p0, p1));
+    }
+
+    mult_q44_c(dst + i, n - i, gain);
+}
+
+static void interleave_sse2(uint16_t* dst, const uint16_t* left, const uint16_t* right, size_t n)
+{
+    size_t i;
+
+    /* (r1,l1),(r2,l2) pairs are stored swapped, see interleave_c */
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(right + i));
+        __m128i lo = _mm_unpacklo_epi16(r, l);
+        __m128i hi = _mm_unpackhi_epi16(r, l);
+
+        _mm_storeu_si128((__m128i*)(dst + 2*i),
+                _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+        _mm_storeu_si128((__m128i*)(dst + 2*i + 8),
+                _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+
+    interleave_c(dst + 2*i, left + i, right + i, n - i);
+}
+
+static void mix_gains_sse2(int16_t* dst, const int16_t* src, const int16_t* gains, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i g = _mm_loadu_si128((const __m128i*)(gains + i));
+        __m128i lo = _mm_mullo_epi16(s, g);
+        __m128i hi = _mm_mulhi_epi16(s, g);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+        __m128i d0 = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+        __m128i d1 = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+
+        _mm_storeu_si128((__m128i*)(dst + i),
+                _mm_packs_epi32(_mm_add_epi32(d0, p0), _mm_add_epi32(d1, p1)));
+    }
+
+    mix_gains_c(dst + i, src + i, gains + i, n - i);
+}
+
+/* high half of signed a times unsigned b: pmulhw takes b as signed, which is
+ * b - 0x10000 when its top bit is set, so a is added back in that case */
+static inline __m128i mulhi_su_sse2(__m128i a, __m128i b)
+{
+    return _mm_add_epi16(_mm_mulhi_epi16(a, b), _mm_and_si128(a, _mm_srai_epi16(b, 15)));
+}
+
+static void envmix_nead_sse2(int16_t* const* out, const int16_t* in, size_t n,
+        uint16_t* env_values, const uint16_t* env_steps, const int16_t* xors)
+{
+    const __m128i x0 = _mm_set1_epi16(xors[0]);
+    const __m128i x1 = _mm_set1_epi16(xors[1]);
+    const __m128i x2 = _mm_set1_epi16(xors[2]);
+    const __m128i x3 = _mm_set1_epi16(xors[3]);
+    size_t i;
+
+    /* the envelopes are constant over a block and i^S only permutes it,
+     * so raw blocks can be processed as they are */
+    for (i = 0; i < n; i += 8) {
+        __m128i s  = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i e2 = _mm_set1_epi16((int16_t)env_values[2]);
+        __m128i l  = _mm_xor_si128(mulhi_su_sse2(s, _mm_set1_epi16((int16_t)env_values[0])), x0);
+        __m128i r  = _mm_xor_si128(mulhi_su_sse2(s, _mm_set1_epi16((int16_t)env_values[1])), x1);
+        __m128i l2 = _mm_xor_si128(mulhi_su_sse2(l, e2), x2);
+        __m128i r2 = _mm_xor_si128(mulhi_su_sse2(r, e2), x3);
+
+        _mm_storeu_si128((__m128i*)(out[0] + i),
+                _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out[0] + i)), l));
+        _mm_storeu_si128((__m128i*)(out[1] + i),
+                _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out[1] + i)), r));
+        _mm_storeu_si128((__m128i*)(out[2] + i),
+                _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out[2] + i)), l2));
+        _mm_storeu_si128((__m128i*)(out[3] + i),
+                _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out[3] + i)), r2));
+
+        env_values[0] += env_steps[0];
+        env_values[1] += env_steps[1];
+        env_values[2] += env_steps[2];
+    }
+}
+
+static void resample_sse2(int16_t* dst, const int16_t* src, size_t n,
+        uint32_t pitch_accu, uint32_t pitch, const int16_t* lut)
+{
+    size_t k;
+
+    /* 4 outputs per step, each one a pmaddwd of its 4 taps followed by a
+     * sum of the two halves */
+    for (k = 0; k + 4 <= n; k += 4) {
+        const uint32_t p0 = pitch_accu;
+        const uint32_t p1 = p0 + pitch;
+        const uint32_t p2 = p1 + pitch;
+        const uint32_t p3 = p2 + pitch;
+        __m128i s01 = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i*)(src + (p0 >> 16))),
+                _mm_loadl_epi64((const __m128i*)(src + (p1 >> 16))));
+        __m128i s23 = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i*)(src + (p2 >> 16))),
+                _mm_loadl_epi64((const __m128i*)(src + (p3 >> 16))));
+        __m128i l01 = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i*)(lut + ((p0 & 0xfc00) >> 8))),
+                _mm_loadl_epi64((const __m128i*)(lut + ((p1 & 0xfc00) >> 8))));
+        __m128i l23 = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i*)(lut + ((p2 & 0xfc00) >> 8))),
+                _mm_loadl_epi64((const __m128i*)(lut + ((p3 & 0xfc00) >> 8))));
+        __m128i m01 = _mm_shuffle_epi32(_mm_madd_epi16(s01, l01), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i m23 = _mm_shuffle_epi32(_mm_madd_epi16(s23, l23), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i o = _mm_srai_epi32(_mm_add_epi32(
+                _mm_unpacklo_epi64(m01, m23), _mm_unpackhi_epi64(m01, m23)), 15);
+
+        _mm_storel_epi64((__m128i*)(dst + k), _mm_packs_epi32(o, o));
+        pitch_accu = p3 + pitch;
+    }
+
+    resample_c(dst + k, src, n - k, pitch_accu, pitch, lut);
+}
+
+/* One pair of columns of a lower triangular 8x8 matrix whose column j is
+ * diag shifted down by j rows, multiplied by the pair (x[2p], x[2p+1]) */
+#define TRIANGLE_PAIR_SSE2(p) do { \
+        __m128i ca = _mm_slli_si128(diag, 4 * (p)); \
+        __m128i cb = _mm_slli_si128(diag, 4 * (p) + 2); \
+        __m128i b  = _mm_shuffle_epi32(x, 0x55 * (p)); \
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(b, _mm_unpacklo_epi16(ca, cb))); \
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(b, _mm_unpackhi_epi16(ca, cb))); \
+    } while (0)
+
+static void pole8_sse2(int16_t* dst, const int16_t* src, uint16_t gain,
+        const int16_t* c1, const int16_t* c2, const int16_t* h,
+        int16_t l1, int16_t l2, unsigned shift)
+{
+    /* src[i] * gain on the diagonal and h[k] for src[i - 1 - k] below it */
+    const __m128i x = _mm_loadu_si128((const __m128i*)src);
+    const __m128i diag = _mm_insert_epi16(
+            _mm_slli_si128(_mm_loadu_si128((const __m128i*)h), 2), (int16_t)gain, 0);
+    const __m128i c1v = _mm_loadu_si128((const __m128i*)c1);
+    const __m128i c2v = _mm_loadu_si128((const __m128i*)c2);
+    const __m128i l = _mm_set1_epi32((uint16_t)l1 | ((uint32_t)(uint16_t)l2 << 16));
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    __m128i lo = _mm_madd_epi16(l, _mm_unpacklo_epi16(c1v, c2v));
+    __m128i hi = _mm_madd_epi16(l, _mm_unpackhi_epi16(c1v, c2v));
+
+    TRIANGLE_PAIR_SSE2(0);
+    TRIANGLE_PAIR_SSE2(1);
+    TRIANGLE_PAIR_SSE2(2);
+    TRIANGLE_PAIR_SSE2(3);
+
+    /* pmaddwd took gain as signed */
+    if (gain & 0x8000) {
+        lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(_mm_setzero_si128(), x));
+        hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(_mm_setzero_si128(), x));
+    }
+
+    _mm_storeu_si128((__m128i*)dst,
+            _mm_packs_epi32(_mm_sra_epi32(lo, count), _mm_sra_epi32(hi, count)));
+}
+
+#define FILTER_PAIR_SSE2(w, p) do { \
+        __m128i b = _mm_shuffle_epi32(w, 0x55 * ((p) & 3)); \
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(b, cols[p][0])); \
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(b, cols[p][1])); \
+    } while (0)
+
+static void filter_sse2(int16_t* dst, const int16_t* prev, const int16_t* src, size_t n, const int16_t* lut)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i cols[8][2];
+    __m128i w0 = _mm_loadu_si128((const __m128i*)prev);
+    size_t i;
+    unsigned p, r;
+
+    /* In logical order output o is the sum of window[o + 1 + k] * lut[7 - k]
+     * (see filter_c), build the matrix of each raw window sample to each raw
+     * output and pair its columns for pmaddwd. */
+    for (p = 0; p < 16; p += 2) {
+        int16_t ca[8], cb[8];
+
+        for (r = 0; r < 8; ++r) {
+            int ka = 8 + (int)(r ^ S) - (int)(p ^ S);
+            int kb = 8 + (int)(r ^ S) - (int)((p + 1) ^ S);
+            ca[r] = (ka >= 0 && ka < 8) ? lut[ka ^ S] : 0;
+            cb[r] = (kb >= 0 && kb < 8) ? lut[kb ^ S] : 0;
+        }
+
+        cols[p / 2][0] = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)ca), _mm_loadu_si128((const __m128i*)cb));
+        cols[p / 2][1] = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)ca), _mm_loadu_si128((const __m128i*)cb));
+    }
+
+    for (i = 0; i < n; i += 8) {
+        __m128i w1 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = round;
+        __m128i hi = round;
+
+        FILTER_PAIR_SSE2(w0, 0);
+        FILTER_PAIR_SSE2(w0, 1);
+        FILTER_PAIR_SSE2(w0, 2);
+        FILTER_PAIR_SSE2(w0, 3);
+        FILTER_PAIR_SSE2(w1, 4);
+        FILTER_PAIR_SSE2(w1, 5);
+        FILTER_PAIR_SSE2(w1, 6);
+        FILTER_PAIR_SSE2(w1, 7);
+
+        /* outputs are truncated to 16 bits, not saturated */
+        lo = _mm_srai_epi32(_mm_slli_epi32(_mm_srai_epi32(lo, 15), 16), 16);
+        hi = _mm_srai_epi32(_mm_slli_epi32(_mm_srai_epi32(hi, 15), 16), 16);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(lo, hi));
+
+        w0 = w1;
+    }
+}
+
+/* vmulf on 8 lanes, widened to 32 bits */
+static inline void vmulf_sse2(__m128i a, __m128i b, __m128i* lo, __m128i* hi)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i pl = _mm_mullo_epi16(a, b);
+    __m128i ph = _mm_mulhi_epi16(a, b);
+
+    *lo = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(pl, ph), round), 15);
+    *hi = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(pl, ph), round), 15);
+}
+
+static void iirf8_sse2(int16_t* dst, const int16_t* src, const int16_t* table, int16_t* state)
+{
+    const __m128i t0 = _mm_set1_epi16(table[0]);
+    const __m128i t1 = _mm_set1_epi16(table[1]);
+    const __m128i x  = _mm_loadu_si128((const __m128i*)src);
+    const __m128i x1 = _mm_insert_epi16(_mm_slli_si128(x, 2), state[1], 0);
+    const __m128i x2 = _mm_insert_epi16(_mm_slli_si128(x1, 2), state[0], 0);
+    __m128i lo, hi, plo, phi;
+    int32_t fir[8];
+    size_t i;
+
+    vmulf_sse2(x, t0, &lo, &hi);
+    vmulf_sse2(x1, t1, &plo, &phi);
+    lo = _mm_add_epi32(lo, plo);
+    hi = _mm_add_epi32(hi, phi);
+    vmulf_sse2(x2, t0, &plo, &phi);
+    _mm_storeu_si128((__m128i*)fir, _mm_add_epi32(lo, plo));
+    _mm_storeu_si128((__m128i*)(fir + 4), _mm_add_epi32(hi, phi));
+
+    for (i = 0; i < 8; ++i) {
+        int32_t accu = fir[i] + vmulf(table[8], state[3]) * 2 + vmulf(table[9], state[2]) * 2;
+
+        state[2] = state[3];
+        state[3] = dst[i] = accu;
+    }
+
+    state[0] = src[6];
+    state[1] = src[7];
+}
+
+const struct alist_kernels_t alist_kernels_sse2 =
+{
+    "sse2", mix_sse2, add_sse2, mult_q44_sse2, interleave_sse2,
+    mix_gains_sse2, envmix_nead_sse2, resample_sse2, pole8_sse2, filter_sse2, iirf8_sse2
+};
+#endif
+
+/* AVX2, same algorithms as SSE2 on 256-bit vectors.
+ * unpack/pack work within 128-bit lanes so their combination keeps elements in order. */
+#if defined(ALIST_KERNELS_AVX2)
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+AVX2_FUNC static void mix_avx2(int16_t* dst, const int16_t* src, size_t n, int16_t gain)
+{
+    const __m256i g = _mm256_set1_epi16(gain);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i lo = _mm256_mullo_epi16(s, g);
+        __m256i hi = _mm256_mulhi_epi16(s, g);
+        __m256i p0 = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), 15);
+        __m256i p1 = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), 15);
+        __m256i d0 = _mm256_srai_epi32(_mm256_unpacklo_epi16(d, d), 16);
+        __m256i d1 = _mm256_srai_epi32(_mm256_unpackhi_epi16(d, d), 16);
+
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                _mm256_packs_epi32(_mm256_add_epi32(d0, p0), _mm256_add_epi32(d1, p1)));
+    }
+
+    mix_sse2(dst + i, src + i, n - i, gain);
+}
+
+AVX2_FUNC static void add_avx2(int16_t* dst, const int16_t* src, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epi16(d, s));
+    }
+
+    add_sse2(dst + i, src + i, n - i);
+}
+
+AVX2_FUNC static void mult_q44_avx2(int16_t* dst, size_t n, int8_t gain)
+{
+    const __m256i g = _mm256_set1_epi16(gain);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = _mm256_mullo_epi16(d, g);
+        __m256i hi = _mm256_mulhi_epi16(d, g);
+        __m256i p0 = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), 4);
+        __m256i p1 = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), 4);
+
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packs_epi32(p0, p1));
+    }
+
+    mult_q44_sse2(dst + i, n - i, gain);
+}
+
+AVX2_FUNC static void interleave_avx2(uint16_t* dst, const uint16_t* left, const uint16_t* right, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i l = _mm256_loadu_si256((const __m256i*)(left + i));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(right + i));
+        __m256i lo = _mm256_shuffle_epi32(_mm256_unpacklo_epi16(r, l), _MM_SHUFFLE(2, 3, 0, 1));
+        __m256i hi = _mm256_shuffle_epi32(_mm256_unpackhi_epi16(r, l), _MM_SHUFFLE(2, 3, 0, 1));
+
+        _mm256_storeu_si256((__m256i*)(dst + 2*i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + 2*i + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    interleave_sse2(dst + 2*i, left + i, right + i, n - i);
+}
+
+const struct alist_kernels_t alist_kernels_avx2 =
+{
+    "avx2", mix_avx2, add_avx2, mult_q44_avx2, interleave_avx2,
+    /* no gain from 256-bit vectors on 8 sample blocks */
+    mix_gains_sse2, envmix_nead_sse2, resample_sse2, pole8_sse2, filter_sse2, iirf8_sse2
+};
+#endif
+
+/* NEON */
+#if defined(ALIST_KERNELS_NEON)
+static void mix_neon(int16_t* dst, const int16_t* src, size_t n, int16_t gain)
+{
+    const int16x4_t g = vdup_n_s16(gain);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        int16x8_t d = vld1q_s16(dst + i);
+        int16x8_t s = vld1q_s16(src + i);
+        int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(s), g), 15);
+        int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(s), g), 15);
+
+        p0 = vaddw_s16(p0, vget_low_s16(d));
+        p1 = vaddw_s16(p1, vget_high_s16(d));
+
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1)));
+    }
+
+    mix_c(dst + i, src + i, n - i, gain);
+}
+
+static void add_neon(int16_t* dst, const int16_t* src, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+
+    add_c(dst + i, src + i, n - i);
+}
+
+static void mult_q44_neon(int16_t* dst, size_t n, int8_t gain)
+{
+    const int16x4_t g = vdup_n_s16(gain);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        int16x8_t d = vld1q_s16(dst + i);
+        int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(d), g), 4);
+        int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(d), g), 4);
+
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1)));
+    }
+
+    mult_q44_c(dst + i, n - i, gain);
+}
+
+static void interleave_neon(uint16_t* dst, const uint16_t* left, const uint16_t* right, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        uint16x8x2_t rl = vzipq_u16(vld1q_u16(right + i), vld1q_u16(left + i));
+
+        vst1q_u16(dst + 2*i,
+                vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(rl.val[0]))));
+        vst1q_u16(dst + 2*i + 8,
+                vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(rl.val[1]))));
+    }
+
+    interleave_c(dst + 2*i, left + i, right + i, n - i);
+}
+
+static void mix_gains_neon(int16_t* dst, const int16_t* src, const int16_t* gains, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        int16x8_t d = vld1q_s16(dst + i);
+        int16x8_t s = vld1q_s16(src + i);
+        int16x8_t g = vld1q_s16(gains + i);
+        int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(s), vget_low_s16(g)), 15);
+        int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(s), vget_high_s16(g)), 15);
+
+        p0 = vaddw_s16(p0, vget_low_s16(d));
+        p1 = vaddw_s16(p1, vget_high_s16(d));
+
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1)));
+    }
+
+    mix_gains_c(dst + i, src + i, gains + i, n - i);
+}
+
+/* high half of signed a times the unsigned value in b */
+static inline int16x8_t mulhi_su_neon(int16x8_t a, int32x4_t b)
+{
+    int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(a)), b);
+    int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(a)), b);
+
+    return vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16));
+}
+
+static void envmix_nead_neon(int16_t* const* out, const int16_t* in, size_t n,
+        uint16_t* env_values, const uint16_t* env_steps, const int16_t* xors)
+{
+    size_t i;
+
+    for (i = 0; i < n; i += 8) {
+        int16x8_t s  = vld1q_s16(in + i);
+        int32x4_t e2 = vdupq_n_s32(env_values[2]);
+        int16x8_t l  = veorq_s16(mulhi_su_neon(s, vdupq_n_s32(env_values[0])), vdupq_n_s16(xors[0]));
+        int16x8_t r  = veorq_s16(mulhi_su_neon(s, vdupq_n_s32(env_values[1])), vdupq_n_s16(xors[1]));
+        int16x8_t l2 = veorq_s16(mulhi_su_neon(l, e2), vdupq_n_s16(xors[2]));
+        int16x8_t r2 = veorq_s16(mulhi_su_neon(r, e2), vdupq_n_s16(xors[3]));
+
+        vst1q_s16(out[0] + i, vqaddq_s16(vld1q_s16(out[0] + i), l));
+        vst1q_s16(out[1] + i, vqaddq_s16(vld1q_s16(out[1] + i), r));
+        vst1q_s16(out[2] + i, vqaddq_s16(vld1q_s16(out[2] + i), l2));
+        vst1q_s16(out[3] + i, vqaddq_s16(vld1q_s16(out[3] + i), r2));
+
+        env_values[0] += env_steps[0];
+        env_values[1] += env_steps[1];
+        env_values[2] += env_steps[2];
+    }
+}
+
+/* resample, pole8, filter and iirf8 have no NEON version yet */
+const struct alist_kernels_t alist_kernels_neon =
+{
+    "neon", mix_neon, add_neon, mult_q44_neon, interleave_neon,
+    mix_gains_neon, envmix_nead_neon, resample_c, pole8_c, filter_c, iirf8_c
+};
+#endif
+
+const struct alist_kernels_t* alist_kernels = &alist_kernels_c;
+
+void alist_kernels_init(void)
+{
+#if defined(ALIST_KERNELS_SSE2)
+    alist_kernels = &alist_kernels_sse2;
+#if defined(ALIST_KERNELS_AVX2)
+    {
+        /* AVX is also checked, as it implies OS support for ymm registers */
+        uint64_t avx2 = RETRO_SIMD_AVX | RETRO_SIMD_AVX2;
+        if ((cpu_features_get() & avx2) == avx2)
+            alist_kernels = &alist_kernels_avx2;
+    }
+#endif
+#elif defined(ALIST_KERNELS_NEON)
+    alist_kernels = &alist_kernels_neon;
+#endif
+}
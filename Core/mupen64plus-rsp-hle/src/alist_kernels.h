@@ -0,0 +1,101 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - alist_kernels.h                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef ALIST_KERNELS_H
+#define ALIST_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+
+/* Element-wise alist primitives working on raw DMEM samples.
+ * All implementations must give bit-exact results (see alist_kernels_test.c).
+ * Lengths are expressed in 16-bit elements. */
+struct alist_kernels_t
+{
+    const char* name;
+
+    /* dst[i] = clamp_s16(dst[i] + ((src[i] * gain) >> 15)) */
+    void (*mix)(int16_t* dst, const int16_t* src, size_t n, int16_t gain);
+
+    /* dst[i] = clamp_s16(dst[i] + src[i]) */
+    void (*add)(int16_t* dst, const int16_t* src, size_t n);
+
+    /* dst[i] = clamp_s16((dst[i] * gain) >> 4) */
+    void (*mult_q44)(int16_t* dst, size_t n, int8_t gain);
+
+    /* interleave n samples of left and right into dst (n must be even) */
+    void (*interleave)(uint16_t* dst, const uint16_t* left, const uint16_t* right, size_t n);
+
+    /* dst[i] = clamp_s16(dst[i] + ((src[i] * gains[i]) >> 15)) */
+    void (*mix_gains)(int16_t* dst, const int16_t* src, const int16_t* gains, size_t n);
+
+    /* nead envmix of n samples (multiple of 8) into out = { dl, dr, wl, wr }:
+     *   l  = ((in * env[0]) >> 16) ^ xors[0]    r  = ((in * env[1]) >> 16) ^ xors[1]
+     *   l2 = ((l  * env[2]) >> 16) ^ xors[2]    r2 = ((r  * env[2]) >> 16) ^ xors[3]
+     * are added with saturation to out[0..3]. The unsigned envelopes advance by
+     * env_steps every 8 samples and are updated in place. */
+    void (*envmix_nead)(int16_t* const* out, const int16_t* in, size_t n,
+                        uint16_t* env_values, const uint16_t* env_steps, const int16_t* xors);
+
+    /* 4-tap interpolation of n samples, src and dst in logical order:
+     *   pos = pitch_accu + k * pitch  (Q16.16, must not overflow)
+     *   dst[k] = clamp_s16(dot4(src + (pos >> 16), lut + ((pos & 0xfc00) >> 8)) >> 15) */
+    void (*resample)(int16_t* dst, const int16_t* src, size_t n,
+                     uint32_t pitch_accu, uint32_t pitch, const int16_t* lut);
+
+    /* 8 samples of the 2-pole filter of adpcm and polef, in logical order:
+     *   dst[i] = clamp_s16((src[i] * gain + c1[i] * l1 + c2[i] * l2 + rdot(i, h, src)) >> shift) */
+    void (*pole8)(int16_t* dst, const int16_t* src, uint16_t gain,
+                  const int16_t* c1, const int16_t* c2, const int16_t* h,
+                  int16_t l1, int16_t l2, unsigned shift);
+
+    /* 8-tap FIR of the nead filter on n samples (multiple of 8), raw order.
+     * Each block of 8 outputs reads the previous block of src (prev for the
+     * first one) and the current one. */
+    void (*filter)(int16_t* dst, const int16_t* prev, const int16_t* src, size_t n, const int16_t* lut);
+
+    /* 8 samples of iirf in logical order. state = { x[-2], x[-1], y[-2], y[-1] }
+     * is updated. Only the feed-forward taps run in parallel, the feedback
+     * taps depend on the previous output. */
+    void (*iirf8)(int16_t* dst, const int16_t* src, const int16_t* table, int16_t* state);
+};
+
+extern const struct alist_kernels_t alist_kernels_c;
+
+#if defined(HLE_SSE2)
+#define ALIST_KERNELS_SSE2 1
+extern const struct alist_kernels_t alist_kernels_sse2;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ALIST_KERNELS_AVX2 1
+extern const struct alist_kernels_t alist_kernels_avx2;
+#endif
+#elif defined(HLE_NEON)
+#define ALIST_KERNELS_NEON 1
+extern const struct alist_kernels_t alist_kernels_neon;
+#endif
+
+/* best implementation for the host, selected by alist_kernels_init */
+extern const struct alist_kernels_t* alist_kernels;
+
+void alist_kernels_init(void);
+
+#endif
@@ -0,0 +1,261 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - alist_kernels_test.c                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Bit-exactness check of the SIMD alist kernels against the reference ones.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -I../../libretro-common/include -o alist-kernels-test \
+ *      alist_kernels_test.c alist_kernels.c ../../libretro-common/features/features_cpu.c
+ *
+ * Each argument is a raw 4KB DMEM dump (eg. taken with ENABLE_TASK_DUMP or from
+ * a debugger at an alist command boundary). Without arguments random DMEM
+ * contents are used. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alist_kernels.h"
+
+enum { DMEM_SIZE = 0x1000, ITERATIONS = 100000 };
+
+static const struct alist_kernels_t* simd_kernels[4];
+
+static uint32_t rnd_state = 0xf00b4;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* random even offset and length (multiple of 4) within a (DMEM_SIZE/4) bytes window */
+static uint16_t rnd_offset(void) { return (rnd() % (DMEM_SIZE / 4)) & ~1; }
+static uint16_t rnd_count(void) { return (rnd() % (DMEM_SIZE / 4)) & ~3; }
+
+enum { OP_MIX, OP_ADD, OP_MULT_Q44, OP_INTERLEAVE, OP_MIX_GAINS, OP_ENVMIX_NEAD,
+       OP_RESAMPLE, OP_POLE8, OP_FILTER, OP_IIRF8, OP_COUNT };
+
+static const char* const op_names[] = { "mix", "add", "multQ44", "interleave", "mix_gains",
+    "envmix_nead", "resample", "pole8", "filter", "iirf8" };
+
+/* everything an operation draws at random, so that every implementation
+ * runs with the same arguments */
+struct op_args
+{
+    unsigned op;
+    uint16_t dmemo, dmemi, dmemr, count;
+    int16_t gain;
+    uint32_t pitch_accu, pitch;
+    uint16_t env_values[3], env_steps[3];
+    int16_t xors[4], state[4];
+    int16_t lut[256];
+    unsigned shift;
+    int alias;
+};
+
+static void rnd_args(struct op_args* a, unsigned i)
+{
+    unsigned k;
+
+    a->op = rnd() % OP_COUNT;
+    /* keep regions disjoint, alist.c falls back to the reference kernels otherwise.
+     * interleave writes twice as many bytes as it reads from each side and
+     * mix_gains reads as many gains as samples. */
+    a->dmemo = 0x000 + rnd_offset();
+    a->dmemi = 0x800 + rnd_offset();
+    a->dmemr = 0xc00 + (rnd_offset() & 0x1fe);
+    a->count = rnd_count() & ((a->op == OP_INTERLEAVE || a->op == OP_MIX_GAINS) ? 0x1fc : 0x3fc);
+    a->gain = (i & 7) == 0 ? (int16_t)0x8000 : (int16_t)rnd();
+
+    switch (a->op)
+    {
+    case OP_ENVMIX_NEAD:
+        a->dmemo &= 0xfe;
+        a->count &= 0xf0;
+        for (k = 0; k < 3; ++k) {
+            a->env_values[k] = (uint16_t)rnd();
+            a->env_steps[k] = (uint16_t)rnd();
+        }
+        for (k = 0; k < 4; ++k)
+            a->xors[k] = (rnd() & 1) ? -1 : 0;
+        /* alist.c also uses the kernels when outputs coincide */
+        a->alias = rnd() % 3;
+        break;
+    case OP_RESAMPLE:
+        a->dmemi = 0x600 + (a->dmemi & 0x1fe);
+        a->count &= 0x1fc;
+        a->pitch_accu = rnd() & 0xffff;
+        a->pitch = rnd() % 0x30000;
+        for (k = 0; k < 256; ++k)
+            a->lut[k] = (i & 15) == 0 ? (int16_t)0x8000 : (int16_t)rnd();
+        break;
+    case OP_POLE8:
+        a->shift = (rnd() & 1) ? 11 : 14;
+        a->gain = (i & 3) == 0 ? 2048 : (int16_t)rnd();
+        a->state[0] = (int16_t)rnd();
+        a->state[1] = (int16_t)rnd();
+        break;
+    case OP_FILTER:
+        for (k = 0; k < 8; ++k)
+            a->lut[k] = (int16_t)rnd();
+        break;
+    case OP_IIRF8:
+        for (k = 0; k < 4; ++k)
+            a->state[k] = (int16_t)rnd();
+        break;
+    }
+}
+
+static void run_kernel(const struct alist_kernels_t* k, uint8_t* dmem, const struct op_args* a)
+{
+    int16_t* dst = (int16_t*)(dmem + a->dmemo);
+    const int16_t* src = (const int16_t*)(dmem + a->dmemi);
+    const int16_t* r = (const int16_t*)(dmem + a->dmemr);
+    /* results kept outside of the buffers are appended to the DMEM image */
+    int16_t* extra = (int16_t*)(dmem + DMEM_SIZE);
+    uint16_t env_values[3];
+    int16_t state[4];
+    int16_t* out[4];
+
+    switch (a->op)
+    {
+    case OP_MIX: k->mix(dst, src, a->count >> 1, a->gain); break;
+    case OP_ADD: k->add(dst, src, a->count >> 1); break;
+    case OP_MULT_Q44: k->mult_q44(dst, a->count >> 1, (int8_t)a->gain); break;
+    case OP_INTERLEAVE: k->interleave((uint16_t*)dst, (const uint16_t*)src,
+                          (const uint16_t*)r, (a->count >> 2) << 1); break;
+    case OP_MIX_GAINS: k->mix_gains(dst, src, r, a->count >> 1); break;
+    case OP_ENVMIX_NEAD:
+        out[0] = dst;
+        out[1] = (a->alias == 1) ? dst : dst + 0x80;
+        out[2] = dst + 0x100;
+        out[3] = (a->alias == 2) ? dst + 0x100 : dst + 0x180;
+        memcpy(env_values, a->env_values, sizeof(env_values));
+        k->envmix_nead(out, src, a->count >> 1, env_values, a->env_steps, a->xors);
+        memcpy(extra, env_values, sizeof(env_values));
+        break;
+    case OP_RESAMPLE:
+        k->resample(dst, src, a->count >> 1, a->pitch_accu, a->pitch, a->lut);
+        break;
+    case OP_POLE8:
+        k->pole8(dst, src, (uint16_t)a->gain, r, r + 8, r + 16,
+                 a->state[0], a->state[1], a->shift);
+        break;
+    case OP_FILTER:
+        k->filter(dst, r, src, (a->count >> 1) & ~7, a->lut);
+        break;
+    case OP_IIRF8:
+        memcpy(state, a->state, sizeof(state));
+        k->iirf8(dst, src, r, state);
+        memcpy(extra, state, sizeof(state));
+        break;
+    }
+}
+
+static unsigned check_dmem(const uint8_t* ref_dmem)
+{
+    static uint8_t ref[DMEM_SIZE + 16], out[DMEM_SIZE + 16];
+    static struct op_args args;
+    unsigned failures = 0;
+    unsigned i, k;
+
+    for (i = 0; i < ITERATIONS; ++i)
+    {
+        rnd_args(&args, i);
+
+        memset(ref + DMEM_SIZE, 0, 16);
+        memcpy(ref, ref_dmem, DMEM_SIZE);
+        run_kernel(&alist_kernels_c, ref, &args);
+
+        for (k = 0; simd_kernels[k] != NULL; ++k)
+        {
+            memset(out + DMEM_SIZE, 0, 16);
+            memcpy(out, ref_dmem, DMEM_SIZE);
+            run_kernel(simd_kernels[k], out, &args);
+
+            if (memcmp(ref, out, DMEM_SIZE + 16) != 0)
+            {
+                printf("%s: %s mismatch (dmemo=%04x dmemi=%04x dmemr=%04x count=%04x gain=%d)\n",
+                       simd_kernels[k]->name, op_names[args.op], args.dmemo, args.dmemi,
+                       args.dmemr, args.count, args.gain);
+                ++failures;
+            }
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char** argv)
+{
+    static uint8_t dmem[DMEM_SIZE];
+    unsigned failures = 0;
+    int i;
+
+#if defined(ALIST_KERNELS_SSE2)
+    simd_kernels[0] = &alist_kernels_sse2;
+#elif defined(ALIST_KERNELS_NEON)
+    simd_kernels[0] = &alist_kernels_neon;
+#endif
+    /* alist_kernels_init only selects AVX2 on capable hosts */
+    alist_kernels_init();
+    if (alist_kernels != simd_kernels[0])
+        simd_kernels[1] = alist_kernels;
+
+    if (simd_kernels[0] == NULL)
+    {
+        printf("no SIMD alist kernels for this target\n");
+        return 0;
+    }
+
+    if (argc < 2)
+    {
+        for (i = 0; i < DMEM_SIZE; ++i)
+            dmem[i] = (uint8_t)rnd();
+        /* make sure saturation is hit */
+        memset(dmem + 0x100, 0x7f, 0x40);
+        memset(dmem + 0x900, 0x80, 0x40);
+
+        failures += check_dmem(dmem);
+    }
+
+    for (i = 1; i < argc; ++i)
+    {
+        FILE* f = fopen(argv[i], "rb");
+
+        if (f == NULL || fread(dmem, 1, DMEM_SIZE, f) != DMEM_SIZE)
+        {
+            fprintf(stderr, "can't read DMEM dump %s\n", argv[i]);
+            if (f != NULL)
+                fclose(f);
+            return 2;
+        }
+        fclose(f);
+
+        failures += check_dmem(dmem);
+    }
+
+    printf("%u mismatches\n", failures);
+    return failures != 0;
+}
@@ -273,82 +273,144 @@ static void OVERLOAD(struct hle_t* hle, uint32_t w1, uint32_t w2)
     alist_overload(hle, dmem, NAUDIO_COUNT, gain, attenuation);
 }
 
+static const acmd_callback_t ABI_NAUDIO[0x10] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       NAUDIO_0000,
+    NAUDIO_0000,    SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
+};
+
+/* TODO: see what differs from ABI_NAUDIO */
+static const acmd_callback_t ABI_NAUDIO_BK[0x10] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       NAUDIO_0000,
+    NAUDIO_0000,    SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
+};
+
+/* TODO: see what differs from ABI_NAUDIO */
+static const acmd_callback_t ABI_NAUDIO_DK[0x10] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       MIXER,
+    MIXER,          SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
+};
+
+static const acmd_callback_t ABI_NAUDIO_MP3[0x10] = {
+    OVERLOAD,       ADPCM,          CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       MP3,
+    MP3ADDY,        SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     NAUDIO_14,      SETLOOP
+};
+
+/* What differs from ABI_NAUDIO_MP3?
+ *
+ * JoshW: It appears that despite being a newer game, CBFD appears to have a slightly older ucode version
+ * compared to JFG, B.T. et al.
+ * For naudio_mp3, the functions DMEM parameters have an additional protective AND on them
+ * (basically dmem & 0xffff).
+ * But there are minor differences are in the RESAMPLE and ENVMIXER functions.
+ * I don't think it is making any noticeable difference, as it could be just a simplification of the logic.
+ *
+ * bsmiles32: The only difference I could remember between mp3 and cbfd variants is in the MP3ADDY command.
+ * And the MP3 overlay is also different.
+ */
+static const acmd_callback_t ABI_NAUDIO_CBFD[0x10] = {
+    OVERLOAD,       ADPCM,          CLEARBUFF,      ENVMIXER,
+    LOADBUFF,       RESAMPLE,       SAVEBUFF,       MP3,
+    MP3ADDY,        SETVOL,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     NAUDIO_14,      SETLOOP
+};
+
+/* walks the list like alist_process would, tracking the state which
+ * decides what RDRAM the commands touch, commands not listed below
+ * only work on DMEM */
+static void footprint(struct hle_t* hle, const acmd_callback_t abi[], unsigned int abi_size,
+                      struct alist_footprint_t* fp)
+{
+    uint32_t loop = hle->alist_naudio.loop;
+
+    const uint32_t *alist_end;
+    const uint32_t *alist = alist_footprint_begin(hle, fp, &alist_end);
+
+    while (alist != alist_end) {
+        uint32_t w1 = *(alist++);
+        uint32_t w2 = *(alist++);
+        unsigned int acmd = (w1 >> 24) & 0x7f;
+        acmd_callback_t cmd;
+
+        if (acmd >= abi_size)
+            continue;
+
+        cmd = abi[acmd];
+
+        if (cmd == ADPCM) {
+            alist_footprint_add(fp, w1, 32);
+            if ((w2 >> 28) & A_LOOP)
+                alist_footprint_add(fp, loop, 32);
+        }
+        else if (cmd == RESAMPLE)
+            alist_footprint_add(fp, w1, 16);
+        else if (cmd == ENVMIXER)
+            alist_footprint_add(fp, w2, 80);
+        else if (cmd == LOADBUFF || cmd == SAVEBUFF)
+            alist_footprint_add(fp, w2 & ~7, align((w1 >> 12) & 0xfff, 8));
+        else if (cmd == LOADADPCM)
+            alist_footprint_add(fp, w2, (uint16_t)w1);
+        else if (cmd == NAUDIO_14)
+            alist_footprint_add(fp, w2, 16);
+        else if (cmd == MP3)
+            alist_footprint_add(fp, w2, 8 + 0x480);
+        else if (cmd == SETLOOP)
+            loop = w2 & 0xffffff;
+    }
+}
+
 /* global functions */
 void alist_process_naudio(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       NAUDIO_0000,
-        NAUDIO_0000,    SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
-    };
-
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_NAUDIO, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_naudio_bk(struct hle_t* hle)
 {
-    /* TODO: see what differs from alist_process_naudio */
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       NAUDIO_0000,
-        NAUDIO_0000,    SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
-    };
-
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_NAUDIO_BK, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_naudio_dk(struct hle_t* hle)
 {
-    /* TODO: see what differs from alist_process_naudio */
-    static const acmd_callback_t ABI[0x10] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       MIXER,
-        MIXER,          SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     NAUDIO_02B0,    SETLOOP
-    };
-
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_NAUDIO_DK, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_naudio_mp3(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x10] = {
-        OVERLOAD,       ADPCM,          CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       MP3,
-        MP3ADDY,        SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     NAUDIO_14,      SETLOOP
-    };
-
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_NAUDIO_MP3, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_naudio_cbfd(struct hle_t* hle)
 {
-    /* What differs from alist_process_naudio_mp3?
-     *
-     * JoshW: It appears that despite being a newer game, CBFD appears to have a slightly older ucode version
-     * compared to JFG, B.T. et al.
-     * For naudio_mp3, the functions DMEM parameters have an additional protective AND on them
-     * (basically dmem & 0xffff).
-     * But there are minor differences are in the RESAMPLE and ENVMIXER functions.
-     * I don't think it is making any noticeable difference, as it could be just a simplification of the logic.
-     *
-     * bsmiles32: The only difference I could remember between mp3 and cbfd variants is in the MP3ADDY command.
-     * And the MP3 overlay is also different.
-     */
-    static const acmd_callback_t ABI[0x10] = {
-        OVERLOAD,       ADPCM,          CLEARBUFF,      ENVMIXER,
-        LOADBUFF,       RESAMPLE,       SAVEBUFF,       MP3,
-        MP3ADDY,        SETVOL,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     NAUDIO_14,      SETLOOP
-    };
-
-    alist_process(hle, ABI, 0x10);
+    alist_process(hle, ABI_NAUDIO_CBFD, 0x10);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
+
+bool alist_footprint_naudio(struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp)
+{
+    if (process == alist_process_naudio)
+        footprint(hle, ABI_NAUDIO, 0x10, fp);
+    else if (process == alist_process_naudio_bk)
+        footprint(hle, ABI_NAUDIO_BK, 0x10, fp);
+    else if (process == alist_process_naudio_dk)
+        footprint(hle, ABI_NAUDIO_DK, 0x10, fp);
+    else if (process == alist_process_naudio_mp3)
+        footprint(hle, ABI_NAUDIO_MP3, 0x10, fp);
+    else if (process == alist_process_naudio_cbfd)
+        footprint(hle, ABI_NAUDIO_CBFD, 0x10, fp);
+    else
+        return false;
+
+    return true;
+}
@@ -358,178 +358,228 @@ static void POLEF(struct hle_t* hle, uint32_t w1, uint32_t w2)
 }
 
 
+static const acmd_callback_t ABI_NEAD_MK[0x20] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
+    SPNOOP,         RESAMPLE,       SPNOOP,         SEGMENT,
+    SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1_MK,   ENVMIXER_MK,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      SPNOOP,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
+};
+
+static const acmd_callback_t ABI_NEAD_SF[0x20] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
+    SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      SPNOOP,
+    HILOGAIN,       UNKNOWN,        DUPLICATE,      SPNOOP,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
+};
+
+static const acmd_callback_t ABI_NEAD_SFJ[0x20] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
+    SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
+    HILOGAIN,       UNKNOWN,        DUPLICATE,      SPNOOP,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
+};
+
+static const acmd_callback_t ABI_NEAD_FZ[0x20] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       SPNOOP,         SPNOOP,
+    SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     SPNOOP,         SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
+    SPNOOP,         UNKNOWN,        DUPLICATE,      SPNOOP,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
+};
+
+static const acmd_callback_t ABI_NEAD_WRJB[0x20] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      UNKNOWN,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
+    SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     SPNOOP,         SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
+    HILOGAIN,       UNKNOWN,        DUPLICATE,      FILTER,
+    SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
+};
+
+static const acmd_callback_t ABI_NEAD_YS[0x18] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+static const acmd_callback_t ABI_NEAD_1080[0x18] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+static const acmd_callback_t ABI_NEAD_OOT[0x18] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+static const acmd_callback_t ABI_NEAD_MM[0x18] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+static const acmd_callback_t ABI_NEAD_MMB[0x18] = {
+    SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+static const acmd_callback_t ABI_NEAD_AC[0x18] = {
+    UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
+    ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
+    SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
+    MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
+    NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
+    LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
+};
+
+/* walks the list like alist_process would, tracking the state which
+ * decides what RDRAM the commands touch, commands not listed below
+ * only work on DMEM */
+static void footprint(struct hle_t* hle, const acmd_callback_t abi[], unsigned int abi_size,
+                      struct alist_footprint_t* fp)
+{
+    uint32_t loop = hle->alist_nead.loop;
+    uint32_t lut_address = hle->alist_nead.filter_lut_address[0];
+
+    const uint32_t *alist_end;
+    const uint32_t *alist = alist_footprint_begin(hle, fp, &alist_end);
+
+    while (alist != alist_end) {
+        uint32_t w1 = *(alist++);
+        uint32_t w2 = *(alist++);
+        unsigned int acmd = (w1 >> 24) & 0x7f;
+        acmd_callback_t cmd;
+
+        if (acmd >= abi_size)
+            continue;
+
+        cmd = abi[acmd];
+
+        if (cmd == ADPCM) {
+            alist_footprint_add(fp, w2, 32);
+            if ((w1 >> 16) & 0x2)
+                alist_footprint_add(fp, loop, 32);
+        }
+        else if (cmd == RESAMPLE)
+            alist_footprint_add(fp, w2, 16);
+        else if (cmd == POLEF)
+            alist_footprint_add(fp, w2, 8);
+        else if (cmd == LOADBUFF || cmd == SAVEBUFF)
+            alist_footprint_add(fp, w2 & ~7, align((w1 >> 12) & 0xfff, 8));
+        else if (cmd == LOADADPCM)
+            alist_footprint_add(fp, w2, (uint16_t)w1);
+        else if (cmd == FILTER) {
+            if ((uint8_t)(w1 >> 16) > 1)
+                lut_address = w2 & 0xffffff;
+            else {
+                /* previous samples, then the second lut right after them */
+                alist_footprint_add(fp, lut_address, 16);
+                alist_footprint_add(fp, w2, 32);
+            }
+        }
+        else if (cmd == SETLOOP)
+            loop = w2 & 0xffffff;
+    }
+}
+
 void alist_process_nead_mk(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x20] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
-        SPNOOP,         RESAMPLE,       SPNOOP,         SEGMENT,
-        SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1_MK,   ENVMIXER_MK,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      SPNOOP,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
-    };
-
-    alist_process(hle, ABI, 0x20);
+    alist_process(hle, ABI_NEAD_MK, 0x20);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_sf(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x20] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
-        SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      SPNOOP,
-        HILOGAIN,       UNKNOWN,        DUPLICATE,      SPNOOP,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
-    };
-
-    alist_process(hle, ABI, 0x20);
+    alist_process(hle, ABI_NEAD_SF, 0x20);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_sfj(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x20] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
-        SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE_MK,  POLEF,          SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
-        HILOGAIN,       UNKNOWN,        DUPLICATE,      SPNOOP,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
-    };
-
-    alist_process(hle, ABI, 0x20);
+    alist_process(hle, ABI_NEAD_SFJ, 0x20);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_fz(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x20] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       SPNOOP,         SPNOOP,
-        SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     SPNOOP,         SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
-        SPNOOP,         UNKNOWN,        DUPLICATE,      SPNOOP,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
-    };
-
-    alist_process(hle, ABI, 0x20);
+    alist_process(hle, ABI_NEAD_FZ, 0x20);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_wrjb(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x20] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      UNKNOWN,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   SPNOOP,
-        SETBUFF,        SPNOOP,         DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     SPNOOP,         SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN,
-        HILOGAIN,       UNKNOWN,        DUPLICATE,      FILTER,
-        SPNOOP,         SPNOOP,         SPNOOP,         SPNOOP
-    };
-
-    alist_process(hle, ABI, 0x20);
+    alist_process(hle, ABI_NEAD_WRJB, 0x20);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_ys(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_YS, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_1080(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_1080, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_oot(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      UNKNOWN,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_OOT, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_mm(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_MM, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_mmb(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        SPNOOP,         ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_MMB, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
 void alist_process_nead_ac(struct hle_t* hle)
 {
-    static const acmd_callback_t ABI[0x18] = {
-        UNKNOWN,        ADPCM,          CLEARBUFF,      SPNOOP,
-        ADDMIXER,       RESAMPLE,       RESAMPLE_ZOH,   FILTER,
-        SETBUFF,        DUPLICATE,      DMEMMOVE,       LOADADPCM,
-        MIXER,          INTERLEAVE,     HILOGAIN,       SETLOOP,
-        NEAD_16,        INTERL,         ENVSETUP1,      ENVMIXER,
-        LOADBUFF,       SAVEBUFF,       ENVSETUP2,      UNKNOWN
-    };
-
-    alist_process(hle, ABI, 0x18);
+    alist_process(hle, ABI_NEAD_AC, 0x18);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
@@ -554,3 +604,35 @@ void alist_process_nead_efz(struct hle_t* hle)
         alist_process_nead_fz(hle);
     }
 }
+
+bool alist_footprint_nead(struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp)
+{
+    if (process == alist_process_nead_mk)
+        footprint(hle, ABI_NEAD_MK, 0x20, fp);
+    else if (process == alist_process_nead_sf)
+        footprint(hle, ABI_NEAD_SF, 0x20, fp);
+    else if (process == alist_process_nead_sfj)
+        footprint(hle, ABI_NEAD_SFJ, 0x20, fp);
+    else if (process == alist_process_nead_fz)
+        footprint(hle, ABI_NEAD_FZ, 0x20, fp);
+    else if (process == alist_process_nead_wrjb)
+        footprint(hle, ABI_NEAD_WRJB, 0x20, fp);
+    else if (process == alist_process_nead_ys)
+        footprint(hle, ABI_NEAD_YS, 0x18, fp);
+    else if (process == alist_process_nead_1080)
+        footprint(hle, ABI_NEAD_1080, 0x18, fp);
+    else if (process == alist_process_nead_oot)
+        footprint(hle, ABI_NEAD_OOT, 0x18, fp);
+    else if (process == alist_process_nead_mm)
+        footprint(hle, ABI_NEAD_MM, 0x18, fp);
+    else if (process == alist_process_nead_mmb)
+        footprint(hle, ABI_NEAD_MMB, 0x18, fp);
+    else if (process == alist_process_nead_ac)
+        footprint(hle, ABI_NEAD_AC, 0x18, fp);
+    else if (process == alist_process_nead_efz)
+        footprint(hle, ABI_NEAD_FZ, 0x20, fp);
+    else
+        return false;
+
+    return true;
+}
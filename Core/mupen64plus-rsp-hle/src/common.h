@@ -34,5 +34,15 @@
 #define inline __inline
 #endif
 
+/* SIMD instruction sets available without runtime detection.
+ * SIMD code paths assume the little endian DMEM/RDRAM layout. */
+#ifndef M64P_BIG_ENDIAN
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLE_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define HLE_NEON 1
+#endif
+#endif
+
 #endif
 
@@ -28,6 +28,8 @@
 #include <stdio.h>
 #endif
 
+#include "alist.h"
+#include "alist_kernels.h"
 #include "hle_external.h"
 #include "hle_internal.h"
 #include "memory.h"
@@ -47,7 +49,8 @@ static void send_dlist_to_gfx_plugin(struct hle_t* hle);
 static ucode_func_t try_audio_task_detection(struct hle_t* hle);
 static ucode_func_t try_normal_task_detection(struct hle_t* hle);
 static ucode_func_t non_task_detection(struct hle_t* hle);
-static ucode_func_t task_detection(struct hle_t* hle);
+static ucode_func_t task_detection(struct hle_t* hle, int* is_audio);
+static struct ucode_info_t* lookup_ucode(struct hle_t* hle);
 
 #ifdef ENABLE_TASK_DUMP
 static void dump_binary(struct hle_t* hle, const char *const filename,
@@ -104,9 +107,38 @@ void hle_init(struct hle_t* hle,
     hle->dpc_pipebusy = dpc_pipebusy;
     hle->dpc_tmem     = dpc_tmem;
     hle->user_defined = user_defined;
+
+    alist_kernels_init();
 }
 
 void hle_execute(struct hle_t* hle)
+{
+    struct ucode_info_t *info = lookup_ucode(hle);
+
+    if (info->uc_audio && hle->skip_aud) {
+        rsp_break(hle, SP_STATUS_TASKDONE);
+        return;
+    }
+
+    info->uc_pfunc(hle);
+}
+
+/* Gathers the RDRAM ranges the pending task reads or writes,
+ * returns false if it is not an audio list we know how to walk */
+bool hle_audio_footprint(struct hle_t* hle, struct alist_footprint_t* fp)
+{
+    struct ucode_info_t *info = lookup_ucode(hle);
+
+    if (!info->uc_audio || hle->skip_aud)
+        return false;
+
+    return alist_footprint_audio(hle, info->uc_pfunc, fp)
+        || alist_footprint_naudio(hle, info->uc_pfunc, fp)
+        || alist_footprint_nead(hle, info->uc_pfunc, fp);
+}
+
+/* local functions */
+static struct ucode_info_t* lookup_ucode(struct hle_t* hle)
 {
     uint32_t uc_start = *dmem_u32(hle, TASK_UCODE);
     uint32_t uc_dstart = *dmem_u32(hle, TASK_UCODE_DATA);
@@ -133,16 +165,15 @@ void hle_execute(struct hle_t* hle)
         info->uc_start = uc_start;
         info->uc_dstart = uc_dstart;
         info->uc_dsize = uc_dsize;
-        info->uc_pfunc = task_detection(hle);
+        info->uc_pfunc = task_detection(hle, &info->uc_audio);
         cached_ucodes->count++;
         assert(cached_ucodes->count <= CACHED_UCODES_MAX_SIZE);
         assert(info->uc_pfunc != NULL);
     }
 
-    info->uc_pfunc(hle);
+    return info;
 }
 
-/* local functions */
 static unsigned int sum_bytes(const unsigned char *bytes, unsigned int size)
 {
     unsigned int sum = 0;
@@ -393,19 +424,23 @@ static ucode_func_t non_task_detection(struct hle_t* hle)
     return &unknown_ucode;
 }
 
-static ucode_func_t task_detection(struct hle_t* hle)
+static ucode_func_t task_detection(struct hle_t* hle, int* is_audio)
 {
+    *is_audio = 0;
+
     if (is_task(hle)) {
         ucode_func_t uc_pfunc;
         uint32_t type = *dmem_u32(hle, TASK_TYPE);
 
         if (type == 2) {
+            *is_audio = 1;
             if (hle->hle_aud) {
                 return &send_alist_to_audio_plugin;
             }
             uc_pfunc = try_audio_task_detection(hle);
             if (uc_pfunc)
                 return uc_pfunc;
+            *is_audio = 0;
         }
 
         uc_pfunc = try_normal_task_detection(hle);
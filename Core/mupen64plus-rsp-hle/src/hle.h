@@ -22,8 +22,12 @@
 #ifndef HLE_H
 #define HLE_H
 
+#include <stdbool.h>
+
 #include "hle_internal.h"
 
+struct alist_footprint_t;
+
 void hle_init(struct hle_t* hle,
     unsigned char* dram,
     unsigned char* dmem,
@@ -49,6 +53,7 @@ void hle_init(struct hle_t* hle,
     void* user_defined);
 
 void hle_execute(struct hle_t* hle);
+bool hle_audio_footprint(struct hle_t* hle, struct alist_footprint_t* fp);
 
 #endif
 
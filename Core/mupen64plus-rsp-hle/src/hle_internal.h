@@ -60,6 +60,9 @@ struct hle_t
     int hle_gfx;
     int hle_aud;
 
+    /* audio output is discarded, don't bother processing audio tasks */
+    int skip_aud;
+
     /* alist.c */
     uint8_t alist_buffer[0x1000];
 
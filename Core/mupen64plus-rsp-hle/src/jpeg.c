@@ -22,8 +22,10 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include <assert.h>
+#include <float.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "arithmetics.h"
 #include "hle_external.h"
@@ -32,6 +34,24 @@
 
 #define SUBBLOCK_SIZE 64
 
+/* The SIMD IDCT performs the exact same float operations as the scalar one,
+ * which only gives identical results without excess precision. */
+#if defined(HLE_SSE2)
+#include <emmintrin.h>
+#define JPEG_COLOR_SSE2 1
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define JPEG_IDCT_SSE2 1
+#endif
+#endif
+
+/* scalar implementations are kept as reference for ENABLE_SIMD_CHECK builds */
+#if !defined(JPEG_COLOR_SSE2) || defined(ENABLE_SIMD_CHECK)
+#define JPEG_COLOR_SCALAR 1
+#endif
+#if !defined(JPEG_IDCT_SSE2) || defined(ENABLE_SIMD_CHECK)
+#define JPEG_IDCT_SCALAR 1
+#endif
+
 typedef void (*tile_line_emitter_t)(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
 typedef void (*subblock_transform_t)(int16_t *dst, const int16_t *src);
 
@@ -43,17 +63,26 @@ static void jpeg_decode_std(struct hle_t* hle,
                             const tile_line_emitter_t emit_line);
 
 /* helper functions */
-static uint8_t clamp_u8(int16_t x);
 static int16_t clamp_s12(int16_t x);
+
+#if defined(JPEG_COLOR_SCALAR)
+static uint8_t clamp_u8(int16_t x);
 static uint16_t clamp_RGBA_component(int16_t x);
 
 /* pixel conversion & formatting */
 static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v);
 static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v);
+#endif
 
 /* tile line emitters */
 static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
 static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
+static void GetYUVTileLine(uint32_t *uyvy, const int16_t *y, const int16_t *u);
+static void GetRGBATileLine(uint16_t *rgba, const int16_t *y, const int16_t *u);
+
+#ifdef ENABLE_SIMD_CHECK
+static void check_simd(const char *what, const void *simd, const void *ref, size_t size);
+#endif
 
 /* macroblocks operations */
 static void decode_macroblock_ob(int16_t *macroblock, int32_t *y_dc, int32_t *u_dc, int32_t *v_dc, const int16_t *qtable);
@@ -72,8 +101,11 @@ static void ReorderSubBlock(int16_t *dst, const int16_t *src, const unsigned int
 static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2, unsigned int shift);
 static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale);
 static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift);
-static void InverseDCT1D(const float *const x, float *dst, unsigned int stride);
 static void InverseDCTSubBlock(int16_t *dst, const int16_t *src);
+#if defined(JPEG_IDCT_SCALAR)
+static void InverseDCT1D(const float *const x, float *dst, unsigned int stride);
+static void InverseDCTSubBlockScalar(int16_t *dst, const int16_t *src);
+#endif
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src);
 static void RescaleUVSubBlock(int16_t *dst, const int16_t *src);
 
@@ -268,11 +300,6 @@ static void jpeg_decode_std(struct hle_t* hle,
     }
 }
 
-static uint8_t clamp_u8(int16_t x)
-{
-    return (x & (0xff00)) ? ((-x) >> 15) & 0xff : x;
-}
-
 static int16_t clamp_s12(int16_t x)
 {
     if (x < -0x800)
@@ -282,6 +309,12 @@ static int16_t clamp_s12(int16_t x)
     return x;
 }
 
+#if defined(JPEG_COLOR_SCALAR)
+static uint8_t clamp_u8(int16_t x)
+{
+    return (x & (0xff00)) ? ((-x) >> 15) & 0xff : x;
+}
+
 static uint16_t clamp_RGBA_component(int16_t x)
 {
     if (x > 0xff0)
@@ -312,10 +345,8 @@ static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v)
     return (r << 4) | (g >> 1) | (b >> 6) | 1;
 }
 
-static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+static void GetYUVTileLineScalar(uint32_t *uyvy, const int16_t *y, const int16_t *u)
 {
-    uint32_t uyvy[8];
-
     const int16_t *const v  = u + SUBBLOCK_SIZE;
     const int16_t *const y2 = y + SUBBLOCK_SIZE;
 
@@ -327,14 +358,10 @@ static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *
     uyvy[5] = GetUYVY(y2[2], y2[3], u[5], v[5]);
     uyvy[6] = GetUYVY(y2[4], y2[5], u[6], v[6]);
     uyvy[7] = GetUYVY(y2[6], y2[7], u[7], v[7]);
-
-    dram_store_u32(hle, uyvy, address, 8);
 }
 
-static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+static void GetRGBATileLineScalar(uint16_t *rgba, const int16_t *y, const int16_t *u)
 {
-    uint16_t rgba[16];
-
     const int16_t *const v  = u + SUBBLOCK_SIZE;
     const int16_t *const y2 = y + SUBBLOCK_SIZE;
 
@@ -354,6 +381,132 @@ static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t
     rgba[13] = GetRGBA(y2[5], u[6], v[6]);
     rgba[14] = GetRGBA(y2[6], u[7], v[7]);
     rgba[15] = GetRGBA(y2[7], u[7], v[7]);
+}
+#endif
+
+#if defined(JPEG_COLOR_SSE2)
+/* clamp_u8 of 16 values, including its (-0x8000 -> 1) quirk */
+static __m128i ClampU8SSE2(__m128i lo, __m128i hi)
+{
+    const __m128i min = _mm_set1_epi16(INT16_MIN);
+    __m128i quirk = _mm_packs_epi16(_mm_cmpeq_epi16(lo, min), _mm_cmpeq_epi16(hi, min));
+
+    return _mm_sub_epi8(_mm_packus_epi16(lo, hi), quirk);
+}
+
+static void GetYUVTileLineSSE2(uint32_t *uyvy, const int16_t *y, const int16_t *u)
+{
+    __m128i ys = ClampU8SSE2(_mm_loadu_si128((const __m128i *)y),
+                             _mm_loadu_si128((const __m128i *)(y + SUBBLOCK_SIZE)));
+    __m128i uv = ClampU8SSE2(_mm_loadu_si128((const __m128i *)u),
+                             _mm_loadu_si128((const __m128i *)(u + SUBBLOCK_SIZE)));
+    __m128i vu;
+
+    /* uyvy words are stored as y2, v, y1, u bytes */
+    ys = _mm_or_si128(_mm_slli_epi16(ys, 8), _mm_srli_epi16(ys, 8));
+    vu = _mm_unpacklo_epi8(_mm_srli_si128(uv, 8), uv);
+
+    _mm_storeu_si128((__m128i *)uyvy, _mm_unpacklo_epi8(ys, vu));
+    _mm_storeu_si128((__m128i *)(uyvy + 4), _mm_unpackhi_epi8(ys, vu));
+}
+
+/* (int16_t) conversion of 2x2 doubles, sign extended to 32-bit */
+static __m128i TruncateToS16SSE2(__m128d lo, __m128d hi)
+{
+    __m128i x = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+    return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+static __m128i ClampRGBAComponentSSE2(__m128i x)
+{
+    x = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(0xff0));
+    return _mm_and_si128(x, _mm_set1_epi16(0xf80));
+}
+
+/* GetRGBA on 8 pixels sharing 4 (u,v) pairs, using the same double precision arithmetic */
+static __m128i GetRGBA8SSE2(const int16_t *y, const int16_t *u, const int16_t *v)
+{
+    const __m128d bias = _mm_set1_pd(2048.0);
+    __m128d r[4], g[4], b[4];
+    __m128i rgba;
+    unsigned int k;
+
+    for (k = 0; k < 4; ++k) {
+        const __m128d fY = _mm_add_pd(_mm_cvtepi32_pd(_mm_setr_epi32(y[2 * k], y[2 * k + 1], 0, 0)), bias);
+        const __m128d fU = _mm_set1_pd((double)u[k]);
+        const __m128d fV = _mm_set1_pd((double)v[k]);
+
+        r[k] = _mm_add_pd(fY, _mm_mul_pd(_mm_set1_pd(1.4025), fV));
+        g[k] = _mm_sub_pd(_mm_sub_pd(fY, _mm_mul_pd(_mm_set1_pd(0.3443), fU)),
+                          _mm_mul_pd(_mm_set1_pd(0.7144), fV));
+        b[k] = _mm_add_pd(fY, _mm_mul_pd(_mm_set1_pd(1.7729), fU));
+    }
+
+    rgba = _mm_slli_epi16(ClampRGBAComponentSSE2(_mm_packs_epi32(
+                    TruncateToS16SSE2(r[0], r[1]), TruncateToS16SSE2(r[2], r[3]))), 4);
+    rgba = _mm_or_si128(rgba, _mm_srli_epi16(ClampRGBAComponentSSE2(_mm_packs_epi32(
+                    TruncateToS16SSE2(g[0], g[1]), TruncateToS16SSE2(g[2], g[3]))), 1));
+    rgba = _mm_or_si128(rgba, _mm_srli_epi16(ClampRGBAComponentSSE2(_mm_packs_epi32(
+                    TruncateToS16SSE2(b[0], b[1]), TruncateToS16SSE2(b[2], b[3]))), 6));
+
+    return _mm_or_si128(rgba, _mm_set1_epi16(1));
+}
+
+static void GetRGBATileLineSSE2(uint16_t *rgba, const int16_t *y, const int16_t *u)
+{
+    const int16_t *const v = u + SUBBLOCK_SIZE;
+
+    _mm_storeu_si128((__m128i *)rgba, GetRGBA8SSE2(y, u, v));
+    _mm_storeu_si128((__m128i *)(rgba + 8), GetRGBA8SSE2(y + SUBBLOCK_SIZE, u + 4, v + 4));
+}
+#endif
+
+static void GetYUVTileLine(uint32_t *uyvy, const int16_t *y, const int16_t *u)
+{
+#if defined(JPEG_COLOR_SSE2)
+    GetYUVTileLineSSE2(uyvy, y, u);
+#ifdef ENABLE_SIMD_CHECK
+    {
+        uint32_t ref[8];
+        GetYUVTileLineScalar(ref, y, u);
+        check_simd("jpeg yuv", uyvy, ref, sizeof(ref));
+    }
+#endif
+#else
+    GetYUVTileLineScalar(uyvy, y, u);
+#endif
+}
+
+static void GetRGBATileLine(uint16_t *rgba, const int16_t *y, const int16_t *u)
+{
+#if defined(JPEG_COLOR_SSE2)
+    GetRGBATileLineSSE2(rgba, y, u);
+#ifdef ENABLE_SIMD_CHECK
+    {
+        uint16_t ref[16];
+        GetRGBATileLineScalar(ref, y, u);
+        check_simd("jpeg rgba", rgba, ref, sizeof(ref));
+    }
+#endif
+#else
+    GetRGBATileLineScalar(rgba, y, u);
+#endif
+}
+
+static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint32_t uyvy[8];
+
+    GetYUVTileLine(uyvy, y, u);
+
+    dram_store_u32(hle, uyvy, address, 8);
+}
+
+static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint16_t rgba[16];
+
+    GetRGBATileLine(rgba, y, u);
 
     dram_store_u16(hle, rgba, address, 16);
 }
@@ -515,6 +668,7 @@ static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift)
  * Implementation based on Wikipedia :
  * http://fr.wikipedia.org/wiki/Transform%C3%A9e_en_cosinus_discr%C3%A8te
  **************************************************************************/
+#if defined(JPEG_IDCT_SCALAR)
 static void InverseDCT1D(const float *const x, float *dst, unsigned int stride)
 {
     float e[4];
@@ -555,7 +709,7 @@ static void InverseDCT1D(const float *const x, float *dst, unsigned int stride)
     *dst = f[0] + f[2] - e[0];
 }
 
-static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
+static void InverseDCTSubBlockScalar(int16_t *dst, const int16_t *src)
 {
     float x[8];
     float block[SUBBLOCK_SIZE];
@@ -578,6 +732,113 @@ static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
             dst[i + j * 8] = (int16_t)x[j] >> 3;
     }
 }
+#endif
+
+#if defined(JPEG_IDCT_SSE2)
+/* InverseDCT1D on 4 independent inputs (one per lane) */
+static void InverseDCT1DSSE2(const __m128 *x, __m128 *dst)
+{
+    __m128 e[4];
+    __m128 f[4];
+    __m128 x26, x1357, x15, x37, x17, x35;
+
+#define K(n) _mm_set1_ps(IDCT_K[n])
+    x15   = _mm_mul_ps(K(2), _mm_add_ps(x[1], x[5]));
+    x37   = _mm_mul_ps(K(3), _mm_add_ps(x[3], x[7]));
+    x17   = _mm_mul_ps(K(8), _mm_add_ps(x[1], x[7]));
+    x35   = _mm_mul_ps(K(9), _mm_add_ps(x[3], x[5]));
+    x1357 = _mm_mul_ps(_mm_set1_ps(IDCT_C3),
+                       _mm_add_ps(_mm_add_ps(_mm_add_ps(x[1], x[3]), x[5]), x[7]));
+    x26   = _mm_mul_ps(_mm_set1_ps(IDCT_C6), _mm_add_ps(x[2], x[6]));
+
+    f[0] = _mm_add_ps(x[0], x[4]);
+    f[1] = _mm_sub_ps(x[0], x[4]);
+    f[2] = _mm_add_ps(x26, _mm_mul_ps(K(0), x[2]));
+    f[3] = _mm_add_ps(x26, _mm_mul_ps(K(1), x[6]));
+
+    e[0] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x1357, x15), _mm_mul_ps(K(4), x[1])), x17);
+    e[1] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x1357, x37), _mm_mul_ps(K(6), x[3])), x35);
+    e[2] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x1357, x15), _mm_mul_ps(K(5), x[5])), x35);
+    e[3] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x1357, x37), _mm_mul_ps(K(7), x[7])), x17);
+#undef K
+
+    dst[0] = _mm_add_ps(_mm_add_ps(f[0], f[2]), e[0]);
+    dst[1] = _mm_add_ps(_mm_add_ps(f[1], f[3]), e[1]);
+    dst[2] = _mm_add_ps(_mm_sub_ps(f[1], f[3]), e[2]);
+    dst[3] = _mm_add_ps(_mm_sub_ps(f[0], f[2]), e[3]);
+    dst[4] = _mm_sub_ps(_mm_sub_ps(f[0], f[2]), e[3]);
+    dst[5] = _mm_sub_ps(_mm_sub_ps(f[1], f[3]), e[2]);
+    dst[6] = _mm_sub_ps(_mm_add_ps(f[1], f[3]), e[1]);
+    dst[7] = _mm_sub_ps(_mm_add_ps(f[0], f[2]), e[0]);
+}
+
+/* x[j] = column j of rows [row, row+4) of a row major 8x8 block */
+static void LoadColumnsSSE2(__m128 *x, const float *block, unsigned int row)
+{
+    unsigned int j;
+
+    for (j = 0; j < 8; j += 4) {
+        x[j + 0] = _mm_loadu_ps(&block[(row + 0) * 8 + j]);
+        x[j + 1] = _mm_loadu_ps(&block[(row + 1) * 8 + j]);
+        x[j + 2] = _mm_loadu_ps(&block[(row + 2) * 8 + j]);
+        x[j + 3] = _mm_loadu_ps(&block[(row + 3) * 8 + j]);
+        _MM_TRANSPOSE4_PS(x[j + 0], x[j + 1], x[j + 2], x[j + 3]);
+    }
+}
+
+static void InverseDCTSubBlockSSE2(int16_t *dst, const int16_t *src)
+{
+    float input[SUBBLOCK_SIZE];
+    float block[SUBBLOCK_SIZE];
+    __m128 x[8], y[2][8];
+    unsigned int i, j;
+
+    for (i = 0; i < 8; ++i) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[i * 8]);
+        _mm_storeu_ps(&input[i * 8],     _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)));
+        _mm_storeu_ps(&input[i * 8 + 4], _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)));
+    }
+
+    /* idct 1d on rows (+transposition) */
+    for (i = 0; i < 8; i += 4) {
+        LoadColumnsSSE2(x, input, i);
+        InverseDCT1DSSE2(x, y[0]);
+
+        for (j = 0; j < 8; ++j)
+            _mm_storeu_ps(&block[j * 8 + i], y[0][j]);
+    }
+
+    /* idct 1d on columns (thanks to previous transposition) */
+    for (i = 0; i < 2; ++i) {
+        LoadColumnsSSE2(x, block, 4 * i);
+        InverseDCT1DSSE2(x, y[i]);
+    }
+
+    /* C4 = 1 normalization implies a division by 8 */
+    for (j = 0; j < 8; ++j) {
+        __m128i lo = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(y[0][j]), 16), 16 + 3);
+        __m128i hi = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(y[1][j]), 16), 16 + 3);
+        _mm_storeu_si128((__m128i *)&dst[j * 8], _mm_packs_epi32(lo, hi));
+    }
+}
+#endif
+
+static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
+{
+#if defined(JPEG_IDCT_SSE2)
+#ifdef ENABLE_SIMD_CHECK
+    /* src and dst may be the same subblock */
+    int16_t ref[SUBBLOCK_SIZE];
+    InverseDCTSubBlockScalar(ref, src);
+#endif
+    InverseDCTSubBlockSSE2(dst, src);
+#ifdef ENABLE_SIMD_CHECK
+    check_simd("jpeg idct", dst, ref, sizeof(ref));
+#endif
+#else
+    InverseDCTSubBlockScalar(dst, src);
+#endif
+}
 
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src)
 {
@@ -595,3 +856,10 @@ static void RescaleUVSubBlock(int16_t *dst, const int16_t *src)
         dst[i] = (((int)clamp_s12(src[i]) * 0xe00) >> 16) + 0x80;
 }
 
+#ifdef ENABLE_SIMD_CHECK
+static void check_simd(const char *what, const void *simd, const void *ref, size_t size)
+{
+    if (memcmp(simd, ref, size) != 0)
+        HleWarnMessage(NULL, "%s: SIMD and scalar results differ", what);
+}
+#endif
@@ -0,0 +1,210 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - jpeg_mp3_test.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Bit-exactness check of the SIMD jpeg and mp3 kernels against the scalar
+ * ones.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -o jpeg-mp3-test jpeg_mp3_test.c memory.c
+ *
+ * The kernels are static, so jpeg.c and mp3.c are included here with
+ * ENABLE_SIMD_CHECK, which keeps the scalar references next to the SIMD
+ * code.  Inputs are random and cover the whole int16 range, so every
+ * clamp is hit. */
+
+#define ENABLE_SIMD_CHECK 1
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "jpeg.c"
+#include "mp3.c"
+
+enum { ITERATIONS = 100000 };
+
+static uint32_t rnd_state = 0xf00b4;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* random value in [-range, range) */
+static int16_t rnd_s16(int range)
+{
+    return (int16_t)((int)(rnd() % (2 * range)) - range);
+}
+
+/* the jpeg and mp3 tasks themselves are not run */
+void HleVerboseMessage(void* user_defined, const char *message, ...) { (void)user_defined; (void)message; }
+void HleWarnMessage(void* user_defined, const char *message, ...) { (void)user_defined; (void)message; }
+void rsp_break(struct hle_t* hle, unsigned int setbits) { (void)hle; (void)setbits; }
+
+#if defined(JPEG_IDCT_SSE2)
+/* dequantized coefficients stay well within 12 bits, the full range is
+ * checked as well since the scalar code does not clamp them */
+static unsigned check_idct(int range)
+{
+    int16_t src[SUBBLOCK_SIZE], ref[SUBBLOCK_SIZE], out[SUBBLOCK_SIZE];
+    unsigned failures = 0;
+    unsigned i, k;
+
+    for (i = 0; i < ITERATIONS; ++i)
+    {
+        for (k = 0; k < SUBBLOCK_SIZE; ++k)
+            src[k] = rnd_s16(range);
+        /* sparse blocks, as most of them are after quantization */
+        if (i & 1)
+            for (k = 1 + (rnd() % 16); k < SUBBLOCK_SIZE; ++k)
+                src[k] = 0;
+
+        InverseDCTSubBlockScalar(ref, src);
+        InverseDCTSubBlockSSE2(out, src);
+
+        if (memcmp(ref, out, sizeof(ref)) != 0)
+        {
+            if (failures == 0)
+                printf("jpeg idct: mismatch (range %d, iteration %u)\n", range, i);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+#endif
+
+#if defined(JPEG_COLOR_SSE2)
+static unsigned check_color(void)
+{
+    /* two luma subblocks and the u and v subblocks, one line is used */
+    int16_t y[2 * SUBBLOCK_SIZE], u[2 * SUBBLOCK_SIZE];
+    uint32_t uyvy_ref[8], uyvy[8];
+    uint16_t rgba_ref[16], rgba[16];
+    unsigned failures = 0;
+    unsigned i, k;
+
+    for (i = 0; i < ITERATIONS; ++i)
+    {
+        /* half of the lines around the range the rescaling produces */
+        const int range = (i & 1) ? 0x8000 : 0x200;
+
+        for (k = 0; k < 2 * SUBBLOCK_SIZE; ++k)
+        {
+            y[k] = rnd_s16(range);
+            u[k] = rnd_s16(range);
+        }
+
+        GetYUVTileLineScalar(uyvy_ref, y, u);
+        GetYUVTileLineSSE2(uyvy, y, u);
+        if (memcmp(uyvy_ref, uyvy, sizeof(uyvy)) != 0)
+        {
+            if (failures == 0)
+                printf("jpeg yuv: mismatch (iteration %u)\n", i);
+            ++failures;
+        }
+
+        GetRGBATileLineScalar(rgba_ref, y, u);
+        GetRGBATileLineSSE2(rgba, y, u);
+        if (memcmp(rgba_ref, rgba, sizeof(rgba)) != 0)
+        {
+            if (failures == 0)
+                printf("jpeg rgba: mismatch (iteration %u)\n", i);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+#endif
+
+#if defined(HLE_SSE2) || defined(HLE_NEON)
+static unsigned check_dewindow(void)
+{
+    int16_t samples[8];
+    uint16_t lut[8];
+    unsigned failures = 0;
+    unsigned i, k;
+
+    for (i = 0; i < ITERATIONS; ++i)
+    {
+        const int alternate = i & 1;
+        int32_t ref, out;
+
+        for (k = 0; k < 8; ++k)
+        {
+            samples[k] = (int16_t)rnd();
+            lut[k] = (uint16_t)rnd();
+        }
+        /* make sure the extreme products are hit */
+        if ((i & 0xff) == 0)
+            for (k = 0; k < 8; ++k)
+            {
+                samples[k] = (k & 2) ? -0x8000 : 0x7fff;
+                lut[k] = (k & 4) ? 0x8000 : 0x7fff;
+            }
+
+        ref = Dewindow8Scalar(samples, lut, alternate);
+#if defined(HLE_SSE2)
+        out = Dewindow8SSE2(samples, lut, alternate);
+#else
+        out = Dewindow8NEON(samples, lut, alternate);
+#endif
+
+        if (ref != out)
+        {
+            if (failures == 0)
+                printf("mp3 dewindow: mismatch (iteration %u, %d != %d)\n", i, out, ref);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+#endif
+
+int main(void)
+{
+    unsigned failures = 0;
+
+#if defined(JPEG_IDCT_SSE2)
+    failures += check_idct(0x800);
+    failures += check_idct(0x8000);
+#else
+    printf("no SIMD jpeg idct for this target\n");
+#endif
+
+#if defined(JPEG_COLOR_SSE2)
+    failures += check_color();
+#else
+    printf("no SIMD jpeg colour conversion for this target\n");
+#endif
+
+#if defined(HLE_SSE2) || defined(HLE_NEON)
+    failures += check_dewindow();
+#else
+    printf("no SIMD mp3 dewindowing for this target\n");
+#endif
+
+    printf("%u mismatches\n", failures);
+    return failures != 0;
+}
@@ -25,12 +25,25 @@
 #include <string.h>
 
 #include "arithmetics.h"
+#include "hle_external.h"
 #include "hle_internal.h"
 #include "memory.h"
 
+#if defined(HLE_SSE2)
+#include <emmintrin.h>
+#elif defined(HLE_NEON)
+#include <arm_neon.h>
+#endif
+
+/* scalar implementation is kept as reference for ENABLE_SIMD_CHECK builds */
+#if !(defined(HLE_SSE2) || defined(HLE_NEON)) || defined(ENABLE_SIMD_CHECK)
+#define MP3_DEWINDOW_SCALAR 1
+#endif
+
 static void InnerLoop(struct hle_t* hle,
                       uint32_t outPtr, uint32_t inPtr,
                       uint32_t t6, uint32_t t5, uint32_t t4);
+static int32_t Dewindow8(const uint8_t *samples, const uint16_t *lut, int alternate);
 
 static const uint16_t DeWindowLUT [0x420] = {
     0x0000, 0xFFF3, 0x005D, 0xFF38, 0x037A, 0xF736, 0x0B37, 0xC00E,
@@ -167,6 +180,93 @@ static const uint16_t DeWindowLUT [0x420] = {
     0x0B37, 0xF736, 0x037A, 0xFF38, 0x005D, 0xFFF3, 0x0000, 0x0000
 };
 
+#if defined(MP3_DEWINDOW_SCALAR)
+/* Sum of the 8 rounded products of samples and dewindowing coefficients,
+ * odd products being subtracted when alternate is set */
+static int32_t Dewindow8Scalar(const int16_t *samples, const uint16_t *lut, int alternate)
+{
+    int32_t sum = 0;
+    int k;
+
+    for (k = 0; k < 8; ++k) {
+        int32_t p = ((int)samples[k] * (short)lut[k] + 0x4000) >> 0xF;
+        sum += (alternate && (k & 1)) ? -p : p;
+    }
+
+    return sum;
+}
+#endif
+
+#if defined(HLE_SSE2)
+static int32_t Dewindow8SSE2(const int16_t *samples, const uint16_t *lut, int alternate)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i a = _mm_loadu_si128((const __m128i *)samples);
+    __m128i b = _mm_loadu_si128((const __m128i *)lut);
+    __m128i lo = _mm_mullo_epi16(a, b);
+    __m128i hi = _mm_mulhi_epi16(a, b);
+    __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15);
+    __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15);
+    __m128i sum;
+
+    if (alternate) {
+        const __m128i odd = _mm_setr_epi32(0, -1, 0, -1);
+        p0 = _mm_sub_epi32(_mm_xor_si128(p0, odd), odd);
+        p1 = _mm_sub_epi32(_mm_xor_si128(p1, odd), odd);
+    }
+
+    sum = _mm_add_epi32(p0, p1);
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(sum);
+}
+#elif defined(HLE_NEON)
+static int32_t Dewindow8NEON(const int16_t *samples, const uint16_t *lut, int alternate)
+{
+    int16x8_t a = vld1q_s16(samples);
+    int16x8_t b = vreinterpretq_s16_u16(vld1q_u16(lut));
+    int32x4_t p0 = vrshrq_n_s32(vmull_s16(vget_low_s16(a), vget_low_s16(b)), 15);
+    int32x4_t p1 = vrshrq_n_s32(vmull_s16(vget_high_s16(a), vget_high_s16(b)), 15);
+    int32x4_t sum;
+    int32x2_t sum2;
+
+    if (alternate) {
+        static const int32_t odd[4] = { 1, -1, 1, -1 };
+        const int32x4_t sign = vld1q_s32(odd);
+        p0 = vmulq_s32(p0, sign);
+        p1 = vmulq_s32(p1, sign);
+    }
+
+    sum = vaddq_s32(p0, p1);
+    sum2 = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+    sum2 = vpadd_s32(sum2, sum2);
+
+    return vget_lane_s32(sum2, 0);
+}
+#endif
+
+static int32_t Dewindow8(const uint8_t *samples, const uint16_t *lut, int alternate)
+{
+    const int16_t *s = (const int16_t *)samples;
+    int32_t sum;
+
+#if defined(HLE_SSE2)
+    sum = Dewindow8SSE2(s, lut, alternate);
+#elif defined(HLE_NEON)
+    sum = Dewindow8NEON(s, lut, alternate);
+#else
+    sum = Dewindow8Scalar(s, lut, alternate);
+#endif
+
+#if defined(ENABLE_SIMD_CHECK) && (defined(HLE_SSE2) || defined(HLE_NEON))
+    if (sum != Dewindow8Scalar(s, lut, alternate))
+        HleWarnMessage(NULL, "mp3 dewindow: SIMD and scalar results differ");
+#endif
+
+    return sum;
+}
+
 static void MP3AB0(int32_t* v)
 {
     /* Part 2 - 100% Accurate */
@@ -579,16 +679,15 @@ static void InnerLoop(struct hle_t* hle,
     for (x = 0; x < 8; x++) {
         int32_t v0;
         int32_t v18;
-        v2 = v4 = v6 = v8 = 0;
-
-        for (i = 7; i >= 0; i--) {
-            v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-            v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-            v6 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x20) * (short)DeWindowLUT[offset + 0x20] + 0x4000) >> 0xF;
-            v8 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x30) * (short)DeWindowLUT[offset + 0x28] + 0x4000) >> 0xF;
-            addptr += 2;
-            offset++;
-        }
+
+        /* 8 taps per accumulator */
+        v2 = Dewindow8(hle->mp3_buffer + addptr + 0x00, &DeWindowLUT[offset + 0x00], 0);
+        v4 = Dewindow8(hle->mp3_buffer + addptr + 0x10, &DeWindowLUT[offset + 0x08], 0);
+        v6 = Dewindow8(hle->mp3_buffer + addptr + 0x20, &DeWindowLUT[offset + 0x20], 0);
+        v8 = Dewindow8(hle->mp3_buffer + addptr + 0x30, &DeWindowLUT[offset + 0x28], 0);
+        addptr += 0x10;
+        offset += 8;
+
         v0  = v2 + v4;
         v18 = v6 + v8;
         /* Clamp(v0); */
@@ -628,22 +727,16 @@ static void InnerLoop(struct hle_t* hle,
     for (x = 0; x < 8; x++) {
         int32_t v0;
         int32_t v18;
-        v2 = v4 = v6 = v8 = 0;
 
         offset = (0x22F - (t4 >> 1) + x * 0x40);
 
-        for (i = 0; i < 4; i++) {
-            v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x20) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-            v2 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x20) * (short)DeWindowLUT[offset + 0x01] + 0x4000) >> 0xF;
-            v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x30) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-            v4 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x30) * (short)DeWindowLUT[offset + 0x09] + 0x4000) >> 0xF;
-            v6 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x20] + 0x4000) >> 0xF;
-            v6 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x00) * (short)DeWindowLUT[offset + 0x21] + 0x4000) >> 0xF;
-            v8 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x28] + 0x4000) >> 0xF;
-            v8 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x10) * (short)DeWindowLUT[offset + 0x29] + 0x4000) >> 0xF;
-            addptr += 4;
-            offset += 2;
-        }
+        /* 8 taps per accumulator, odd taps being subtracted */
+        v2 = Dewindow8(hle->mp3_buffer + addptr + 0x20, &DeWindowLUT[offset + 0x00], 1);
+        v4 = Dewindow8(hle->mp3_buffer + addptr + 0x30, &DeWindowLUT[offset + 0x08], 1);
+        v6 = Dewindow8(hle->mp3_buffer + addptr + 0x00, &DeWindowLUT[offset + 0x20], 1);
+        v8 = Dewindow8(hle->mp3_buffer + addptr + 0x10, &DeWindowLUT[offset + 0x28], 1);
+        addptr += 0x10;
+
         v0  = v2 + v4;
         v18 = v6 + v8;
         /* Clamp(v0); */
@@ -21,10 +21,13 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "alist.h"
 #include "common.h"
 #include "hle.h"
 #include "hle_internal.h"
@@ -55,6 +58,63 @@ static void (*l_DebugCallback)(void *, int, const char *) = NULL;
 static void *l_DebugCallContext = NULL;
 static int l_PluginInit = 0;
 
+/* asynchronous audio task execution */
+static pthread_t l_AudioThread;
+static pthread_mutex_t l_AudioLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t l_AudioCond = PTHREAD_COND_INITIALIZER;
+static int l_AudioThreadRunning = 0;
+static int l_AudioTaskPending = 0;
+static int l_AudioThreadQuit = 0;
+static int l_AudioTaskStarted = 0;
+
+/* the worker runs on a private copy of DMEM/IMEM and of the registers
+ * written by rsp_break, RDRAM is shared and fenced by the core */
+static unsigned char l_AudioSpMem[0x2000];
+static unsigned int l_AudioSpStatus;
+static unsigned int l_AudioMiIntr;
+static unsigned char* l_SavedDmem;
+static unsigned char* l_SavedImem;
+static unsigned int* l_SavedSpStatus;
+static unsigned int* l_SavedMiIntr;
+
+static void* audio_thread_loop(void* UNUSED(arg))
+{
+    pthread_mutex_lock(&l_AudioLock);
+    for (;;)
+    {
+        while (!l_AudioTaskPending && !l_AudioThreadQuit)
+            pthread_cond_wait(&l_AudioCond, &l_AudioLock);
+
+        if (l_AudioThreadQuit)
+            break;
+
+        pthread_mutex_unlock(&l_AudioLock);
+        hle_execute(&g_hle);
+        pthread_mutex_lock(&l_AudioLock);
+
+        l_AudioTaskPending = 0;
+        pthread_cond_broadcast(&l_AudioCond);
+    }
+    pthread_mutex_unlock(&l_AudioLock);
+
+    return NULL;
+}
+
+static void stop_audio_thread(void)
+{
+    if (!l_AudioThreadRunning)
+        return;
+
+    pthread_mutex_lock(&l_AudioLock);
+    l_AudioThreadQuit = 1;
+    pthread_cond_broadcast(&l_AudioCond);
+    pthread_mutex_unlock(&l_AudioLock);
+
+    pthread_join(l_AudioThread, NULL);
+    l_AudioThreadRunning = 0;
+    l_AudioThreadQuit = 0;
+}
+
 EXPORT m64p_error CALL hlePluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion, int *APIVersion, const char **PluginNamePtr, int *Capabilities)
 {
     /* set version info */
@@ -177,14 +237,98 @@ EXPORT m64p_error CALL hlePluginShutdown(void)
     return M64ERR_SUCCESS;
 }
 
+/* Wait for the audio worker and merge the task results back into DMEM */
+EXPORT void CALL hleWaitAsyncTask(void)
+{
+    if (!l_AudioTaskStarted)
+        return;
+
+    pthread_mutex_lock(&l_AudioLock);
+    while (l_AudioTaskPending)
+        pthread_cond_wait(&l_AudioCond, &l_AudioLock);
+    pthread_mutex_unlock(&l_AudioLock);
+
+    memcpy(l_SavedDmem, l_AudioSpMem, 0x1000);
+
+    g_hle.dmem = l_SavedDmem;
+    g_hle.imem = l_SavedImem;
+    g_hle.sp_status = l_SavedSpStatus;
+    g_hle.mi_intr = l_SavedMiIntr;
+
+    l_AudioTaskStarted = 0;
+}
+
+/* Start the current task on the audio worker if it is an audio list whose
+ * RDRAM accesses are known up front. The ranges it may read or write are
+ * returned in Ranges, the core must call hleWaitAsyncTask before touching
+ * them, DMEM/IMEM or starting another task.
+ * The SP status / MI interrupt changes an audio list ends with are applied
+ * immediately, so the caller can schedule the task completion as usual.
+ * Returns -1 if the task has to be executed synchronously. */
+EXPORT int CALL hleStartAsyncTask(RSP_DRAM_RANGE* Ranges, int MaxRanges)
+{
+    struct alist_footprint_t fp;
+    unsigned int i;
+
+    hleWaitAsyncTask();
+
+    if (!hle_audio_footprint(&g_hle, &fp) || (int)fp.count > MaxRanges)
+        return -1;
+
+    if (!l_AudioThreadRunning)
+    {
+        if (pthread_create(&l_AudioThread, NULL, audio_thread_loop, NULL) != 0)
+            return -1;
+        l_AudioThreadRunning = 1;
+    }
+
+    for (i = 0; i < fp.count; ++i) {
+        Ranges[i].address = fp.ranges[i].begin;
+        Ranges[i].length = fp.ranges[i].end - fp.ranges[i].begin;
+    }
+
+    memcpy(l_AudioSpMem, g_hle.dmem, 0x1000);
+    memcpy(l_AudioSpMem + 0x1000, g_hle.imem, 0x1000);
+    l_AudioSpStatus = *g_hle.sp_status & ~SP_STATUS_INTR_ON_BREAK;
+    l_AudioMiIntr = 0;
+
+    rsp_break(&g_hle, SP_STATUS_TASKDONE);
+
+    l_SavedDmem = g_hle.dmem;
+    l_SavedImem = g_hle.imem;
+    l_SavedSpStatus = g_hle.sp_status;
+    l_SavedMiIntr = g_hle.mi_intr;
+
+    g_hle.dmem = l_AudioSpMem;
+    g_hle.imem = l_AudioSpMem + 0x1000;
+    g_hle.sp_status = &l_AudioSpStatus;
+    g_hle.mi_intr = &l_AudioMiIntr;
+
+    pthread_mutex_lock(&l_AudioLock);
+    l_AudioTaskPending = 1;
+    pthread_cond_signal(&l_AudioCond);
+    pthread_mutex_unlock(&l_AudioLock);
+
+    l_AudioTaskStarted = 1;
+    return (int)fp.count;
+}
+
 EXPORT unsigned int CALL hleDoRspCycles(unsigned int Cycles)
 {
+    hleWaitAsyncTask();
     hle_execute(&g_hle);
     return Cycles;
 }
 
+EXPORT void CALL hleSetSkipAudio(int Skip)
+{
+    g_hle.skip_aud = Skip;
+}
+
 EXPORT void CALL hleInitiateRSP(RSP_INFO Rsp_Info, unsigned int* CycleCount)
 {
+    hleWaitAsyncTask();
+
     hle_init(&g_hle,
              Rsp_Info.RDRAM,
              Rsp_Info.DMEM,
@@ -230,6 +374,9 @@ EXPORT void CALL hleInitiateRSP(RSP_INFO Rsp_Info, unsigned int* CycleCount)
 
 EXPORT void CALL hleRomClosed(void)
 {
+     hleWaitAsyncTask();
+     stop_audio_thread();
+
      g_hle.cached_ucodes.count = 0;
      
     /* notify fallback plugin */
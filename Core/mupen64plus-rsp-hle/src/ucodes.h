@@ -22,11 +22,13 @@
 #ifndef UCODES_H
 #define UCODES_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #define CACHED_UCODES_MAX_SIZE 16
 
 struct hle_t;
+struct alist_footprint_t;
 
 typedef void(*ucode_func_t)(struct hle_t* hle);
 
@@ -35,6 +37,7 @@ struct ucode_info_t {
     uint32_t     uc_dstart;
     uint16_t     uc_dsize;
     ucode_func_t uc_pfunc;
+    int          uc_audio;
 };
 
 struct cached_ucodes_t {
@@ -81,6 +84,7 @@ struct alist_audio_t {
 void alist_process_audio   (struct hle_t* hle);
 void alist_process_audio_ge(struct hle_t* hle);
 void alist_process_audio_bc(struct hle_t* hle);
+bool alist_footprint_audio (struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp);
 
 
 /* audio list ucodes - naudio */
@@ -106,6 +110,7 @@ void alist_process_naudio_bk  (struct hle_t* hle);
 void alist_process_naudio_dk  (struct hle_t* hle);
 void alist_process_naudio_mp3 (struct hle_t* hle);
 void alist_process_naudio_cbfd(struct hle_t* hle);
+bool alist_footprint_naudio   (struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp);
 
 
 /* audio list ucodes - nead */
@@ -143,6 +148,7 @@ void alist_process_nead_mmb (struct hle_t* hle);
 void alist_process_nead_ac  (struct hle_t* hle);
 void alist_process_nead_mats(struct hle_t* hle);
 void alist_process_nead_efz (struct hle_t* hle);
+bool alist_footprint_nead   (struct hle_t* hle, ucode_func_t process, struct alist_footprint_t* fp);
 
 /* mp3 ucode */
 void mp3_task(struct hle_t* hle, unsigned int index, uint32_t address);
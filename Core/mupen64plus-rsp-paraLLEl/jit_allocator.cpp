@@ -63,14 +63,68 @@ static bool commit_execute(void *ptr, size_t size)
 #endif
 }
 
+static void decommit(void *ptr, size_t size)
+{
+#ifdef _WIN32
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+	madvise(ptr, size, MADV_DONTNEED);
+	mprotect(ptr, size, PROT_NONE);
+#endif
+}
+
 bool Allocator::commit_code(void *code, size_t size)
 {
 	return commit_execute(code, size);
 }
 
+void Allocator::free_code(void *code, size_t size)
+{
+	size = align_page(size);
+	decommit(code, size);
+
+	auto *ptr = static_cast<uint8_t *>(code);
+	auto itr = std::lower_bound(free_ranges.begin(), free_ranges.end(), ptr,
+	                            [](const Range &range, const uint8_t *p) { return range.code < p; });
+	itr = free_ranges.insert(itr, { ptr, size });
+
+	auto next = itr + 1;
+	if (next != free_ranges.end() && itr->code + itr->size == next->code)
+	{
+		itr->size += next->size;
+		free_ranges.erase(next);
+	}
+	if (itr != free_ranges.begin())
+	{
+		auto prev = itr - 1;
+		if (prev->code + prev->size == itr->code)
+		{
+			prev->size += itr->size;
+			free_ranges.erase(itr);
+		}
+	}
+}
+
 void *Allocator::allocate_code(size_t size)
 {
 	size = align_page(size);
+
+	for (auto itr = free_ranges.begin(); itr != free_ranges.end(); ++itr)
+	{
+		if (itr->size < size)
+			continue;
+
+		void *ret = itr->code;
+		itr->code += size;
+		itr->size -= size;
+		if (!itr->size)
+			free_ranges.erase(itr);
+
+		if (!commit_read_write(ret, size))
+			return nullptr;
+		return ret;
+	}
+
 	if (blocks.empty())
 		blocks.push_back(reserve_block(std::max(size, block_size)));
 
@@ -18,6 +18,9 @@ public:
 	void *allocate_code(size_t size);
 	static bool commit_code(void *code, size_t size);
 
+	// Returns the pages of an allocation, which later allocations may reuse.
+	void free_code(void *code, size_t size);
+
 private:
 	struct Block
 	{
@@ -27,6 +30,14 @@ private:
 	};
 	std::vector<Block> blocks;
 
+	// Freed ranges, sorted by address, with neighbours merged.
+	struct Range
+	{
+		uint8_t *code;
+		size_t size;
+	};
+	std::vector<Range> free_ranges;
+
 	static Block reserve_block(size_t size);
 };
 }
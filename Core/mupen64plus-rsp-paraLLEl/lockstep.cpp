@@ -0,0 +1,214 @@
+#include "lockstep.hpp"
+
+#ifdef PARALLEL_RSP_LOCKSTEP
+#include "rsp_jit.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+extern "C"
+{
+	// cxd4 and its register file, linked into the same core with LLE=1.
+	EXPORT void CALL cxd4InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+	EXPORT unsigned int CALL cxd4DoRspCycles(unsigned int Cycles);
+
+	extern uint32_t SR[32];
+	extern int16_t VR[32][16];
+	extern int16_t VACC[3][8];
+
+	uint16_t get_VCO(void);
+	uint16_t get_VCC(void);
+	uint8_t get_VCE(void);
+	void set_VCO(uint16_t vco);
+	void set_VCC(uint16_t vcc);
+	void set_VCE(uint8_t vce);
+	void set_divide_latches(int16_t in_high, int16_t out_high, int double_precision);
+}
+
+namespace RSP
+{
+extern RSP_INFO rsp;
+extern JIT::CPU cpu;
+
+namespace Lockstep
+{
+bool enabled;
+
+// Both engines DMA against the full 8 MiB the core always allocates.
+enum { RDRAM_SIZE = 0x800000, SP_MEM_SIZE = 0x1000, PAGE_SIZE = 0x1000 };
+
+// Registers the RSP itself owns.  The DPC status and counters also move
+// with whatever the RDP did on the JIT's side, so they are not compared.
+static unsigned int *RSP_INFO::*const registers[] = {
+	&RSP_INFO::MI_INTR_REG,      &RSP_INFO::SP_MEM_ADDR_REG, &RSP_INFO::SP_DRAM_ADDR_REG,
+	&RSP_INFO::SP_RD_LEN_REG,    &RSP_INFO::SP_WR_LEN_REG,   &RSP_INFO::SP_STATUS_REG,
+	&RSP_INFO::SP_DMA_FULL_REG,  &RSP_INFO::SP_DMA_BUSY_REG, &RSP_INFO::SP_PC_REG,
+	&RSP_INFO::SP_SEMAPHORE_REG, &RSP_INFO::DPC_START_REG,   &RSP_INFO::DPC_END_REG,
+	&RSP_INFO::DPC_CURRENT_REG,  &RSP_INFO::DPC_STATUS_REG,  &RSP_INFO::DPC_CLOCK_REG,
+	&RSP_INFO::DPC_BUFBUSY_REG,  &RSP_INFO::DPC_PIPEBUSY_REG, &RSP_INFO::DPC_TMEM_REG,
+};
+static const char *const register_names[] = {
+	"MI_INTR", "SP_MEM_ADDR", "SP_DRAM_ADDR", "SP_RD_LEN", "SP_WR_LEN", "SP_STATUS",
+	"SP_DMA_FULL", "SP_DMA_BUSY", "SP_PC", "SP_SEMAPHORE", "DPC_START", "DPC_END",
+};
+enum { NUM_REGISTERS = sizeof(registers) / sizeof(registers[0]),
+	   NUM_COMPARED_REGISTERS = sizeof(register_names) / sizeof(register_names[0]) };
+
+static RSP_INFO shadow;
+static uint32_t shadow_registers[NUM_REGISTERS];
+static uint8_t shadow_dmem[SP_MEM_SIZE];
+static uint8_t shadow_imem[SP_MEM_SIZE];
+static std::vector<uint8_t> shadow_rdram;
+static std::vector<uint8_t> rdram_before;
+
+static unsigned tasks;
+static unsigned bad_tasks;
+static unsigned reports;
+
+static void ignore_callback()
+{
+}
+
+void init(const RSP_INFO &info)
+{
+	const char *env = getenv("PARALLEL_RSP_LOCKSTEP");
+	enabled = env && strtol(env, nullptr, 0) != 0;
+	if (!enabled)
+		return;
+
+	shadow_rdram.resize(RDRAM_SIZE);
+	rdram_before.resize(RDRAM_SIZE);
+
+	shadow = info;
+	shadow.RDRAM = shadow_rdram.data();
+	shadow.DMEM = shadow_dmem;
+	shadow.IMEM = shadow_imem;
+	for (unsigned i = 0; i < NUM_REGISTERS; i++)
+		shadow.*registers[i] = &shadow_registers[i];
+
+	// cxd4 must not reach the RDP, the interrupt controller or HLE.
+	shadow.CheckInterrupts = ignore_callback;
+	shadow.ProcessDlistList = ignore_callback;
+	shadow.ProcessAlistList = ignore_callback;
+	shadow.ProcessRdpList = ignore_callback;
+	shadow.ShowCFB = ignore_callback;
+	cxd4InitiateRSP(shadow, nullptr);
+
+	fprintf(stderr, "[paraLLEl RSP] Lock-step check against cxd4 enabled.\n");
+}
+
+void run_reference(unsigned int cycles)
+{
+	auto &state = cpu.get_state();
+
+	memcpy(shadow_rdram.data(), rsp.RDRAM, RDRAM_SIZE);
+	memcpy(rdram_before.data(), rsp.RDRAM, RDRAM_SIZE);
+	memcpy(shadow_dmem, rsp.DMEM, SP_MEM_SIZE);
+	memcpy(shadow_imem, rsp.IMEM, SP_MEM_SIZE);
+	for (unsigned i = 0; i < NUM_REGISTERS; i++)
+		shadow_registers[i] = *(rsp.*registers[i]);
+
+	// Start cxd4 from the JIT's registers, so a difference in one task is
+	// not reported again for every task after it.
+	memcpy(SR, state.sr, sizeof(SR));
+	for (unsigned i = 0; i < 32; i++)
+		memcpy(VR[i], state.cp2.regs[i].e, sizeof(state.cp2.regs[i].e));
+	memcpy(VACC, state.cp2.acc.e, sizeof(VACC));
+	set_VCO(rsp_get_flags(state.cp2.flags[RSP_VCO].e));
+	set_VCC(rsp_get_flags(state.cp2.flags[RSP_VCC].e));
+	set_VCE(rsp_get_flags(state.cp2.flags[RSP_VCE].e));
+	set_divide_latches(state.cp2.div_in, state.cp2.div_out, state.cp2.dp_flag & 1);
+
+	cxd4DoRspCycles(cycles);
+}
+
+static bool report(const char *what, unsigned index, uint32_t jit, uint32_t reference)
+{
+	if (reports < 64)
+	{
+		fprintf(stderr, "[paraLLEl RSP] task %u: %s[0x%x] is 0x%x, cxd4 has 0x%x\n", tasks, what, index,
+		        jit, reference);
+		if (++reports == 64)
+			fprintf(stderr, "[paraLLEl RSP] Further lock-step differences are only counted.\n");
+	}
+	return false;
+}
+
+static bool compare_bytes(const char *what, const uint8_t *jit, const uint8_t *reference, size_t size)
+{
+	if (memcmp(jit, reference, size) == 0)
+		return true;
+	for (size_t i = 0; i < size; i++)
+		if (jit[i] != reference[i])
+			return report(what, i, jit[i], reference[i]);
+	return true;
+}
+
+// The RDP may have drawn into RDRAM while the JIT ran, so only the bytes
+// cxd4 wrote by DMA are checked.
+static bool compare_rdram()
+{
+	const uint8_t *jit = rsp.RDRAM;
+	bool match = true;
+
+	for (size_t page = 0; page < RDRAM_SIZE; page += PAGE_SIZE)
+	{
+		if (memcmp(&shadow_rdram[page], &rdram_before[page], PAGE_SIZE) == 0)
+			continue;
+		for (size_t i = page; i < page + PAGE_SIZE; i++)
+		{
+			if (shadow_rdram[i] != rdram_before[i] && jit[i] != shadow_rdram[i])
+			{
+				match = report("RDRAM", i, jit[i], shadow_rdram[i]);
+				break;
+			}
+		}
+	}
+	return match;
+}
+
+void compare()
+{
+	auto &state = cpu.get_state();
+	bool match = true;
+
+	tasks++;
+	match &= compare_bytes("DMEM", rsp.DMEM, shadow_dmem, SP_MEM_SIZE);
+	match &= compare_bytes("IMEM", rsp.IMEM, shadow_imem, SP_MEM_SIZE);
+	match &= compare_rdram();
+
+	for (unsigned i = 0; i < NUM_COMPARED_REGISTERS; i++)
+	{
+		// Of MI_INTR, only the SP interrupt is the RSP's to raise.
+		const uint32_t mask = (registers[i] == &RSP_INFO::MI_INTR_REG) ? 0x1 : ~0u;
+		if ((*(rsp.*registers[i]) ^ shadow_registers[i]) & mask)
+			match = report(register_names[i], 0, *(rsp.*registers[i]), shadow_registers[i]);
+	}
+
+	for (unsigned i = 1; i < 32; i++)
+		if (state.sr[i] != SR[i])
+			match = report("SR", i, state.sr[i], SR[i]);
+	for (unsigned i = 0; i < 32; i++)
+		for (unsigned e = 0; e < 8; e++)
+			if (int16_t(state.cp2.regs[i].e[e]) != VR[i][e])
+				match = report("VR", i * 8 + e, state.cp2.regs[i].e[e], uint16_t(VR[i][e]));
+	for (unsigned i = 0; i < 24; i++)
+		if (int16_t(state.cp2.acc.e[i]) != VACC[i / 8][i % 8])
+			match = report("VACC", i, state.cp2.acc.e[i], uint16_t(VACC[i / 8][i % 8]));
+
+	if (uint16_t(rsp_get_flags(state.cp2.flags[RSP_VCO].e)) != get_VCO())
+		match = report("VCO", 0, uint16_t(rsp_get_flags(state.cp2.flags[RSP_VCO].e)), get_VCO());
+	if (uint16_t(rsp_get_flags(state.cp2.flags[RSP_VCC].e)) != get_VCC())
+		match = report("VCC", 0, uint16_t(rsp_get_flags(state.cp2.flags[RSP_VCC].e)), get_VCC());
+	if (uint8_t(rsp_get_flags(state.cp2.flags[RSP_VCE].e)) != get_VCE())
+		match = report("VCE", 0, uint8_t(rsp_get_flags(state.cp2.flags[RSP_VCE].e)), get_VCE());
+
+	if (match)
+		return;
+	bad_tasks++;
+	if ((bad_tasks & (bad_tasks - 1)) == 0)
+		fprintf(stderr, "[paraLLEl RSP] %u of %u tasks differ from cxd4.\n", bad_tasks, tasks);
+}
+} // namespace Lockstep
+} // namespace RSP
+#endif
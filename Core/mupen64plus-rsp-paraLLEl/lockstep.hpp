@@ -0,0 +1,31 @@
+#ifndef RSP_LOCKSTEP_HPP__
+#define RSP_LOCKSTEP_HPP__
+
+#include "m64p_plugin.h"
+
+// Self-check of the JIT against cxd4, when both are built into the core.
+// Set PARALLEL_RSP_LOCKSTEP=1 in the environment to enable it.
+#if defined(HAVE_LLE) && !defined(DEBUG_JIT)
+#define PARALLEL_RSP_LOCKSTEP
+#endif
+
+namespace RSP
+{
+namespace Lockstep
+{
+#ifdef PARALLEL_RSP_LOCKSTEP
+extern bool enabled;
+
+// Hands cxd4 a shadow copy of the RSP memory map.
+void init(const RSP_INFO &info);
+
+// Runs the task on cxd4 from the JIT's current state, on the shadow copy.
+void run_reference(unsigned int cycles);
+
+// Compares what the JIT left behind with what cxd4 did and logs differences.
+void compare();
+#endif
+} // namespace Lockstep
+} // namespace RSP
+
+#endif
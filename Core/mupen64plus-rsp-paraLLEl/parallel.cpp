@@ -5,11 +5,14 @@
 #endif
 #include <stdint.h>
 
+#include "m64p_config.h"
 #include "m64p_plugin.h"
 #include "rsp_1.1.h"
+#include "lockstep.hpp"
 
 #define RSP_PARALLEL_VERSION 0x0101
 #define RSP_PLUGIN_API_VERSION 0x020000
+#define RSP_BLOCK_CACHE_FILE "parallel-rsp-blocks.bin"
 
 namespace RSP
 {
@@ -50,11 +53,8 @@ extern "C"
 	}
 #endif
 
-	EXPORT unsigned int CALL parallelRSPDoRspCycles(unsigned int cycles)
+	static unsigned int run_task(unsigned int cycles)
 	{
-		if (*RSP::rsp.SP_STATUS_REG & SP_STATUS_HALT)
-			return 0;
-
 		// We don't know if Mupen from the outside invalidated our IMEM.
 		RSP::cpu.invalidate_imem();
 
@@ -95,6 +95,23 @@ extern "C"
 		return cycles;
 	}
 
+	EXPORT unsigned int CALL parallelRSPDoRspCycles(unsigned int cycles)
+	{
+		if (*RSP::rsp.SP_STATUS_REG & SP_STATUS_HALT)
+			return 0;
+
+#ifdef PARALLEL_RSP_LOCKSTEP
+		if (RSP::Lockstep::enabled)
+		{
+			RSP::Lockstep::run_reference(cycles);
+			cycles = run_task(cycles);
+			RSP::Lockstep::compare();
+			return cycles;
+		}
+#endif
+		return run_task(cycles);
+	}
+
 	EXPORT m64p_error CALL parallelRSPPluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion,
 	                                                   int *APIVersion, const char **PluginNamePtr, int *Capabilities)
 	{
@@ -117,6 +134,10 @@ extern "C"
 	EXPORT void CALL parallelRSPRomClosed(void)
 	{
 		*RSP::rsp.SP_PC_REG = 0x00000000;
+
+#ifndef DEBUG_JIT
+		RSP::cpu.save_block_cache(ConfigGetSharedDataFilepath(RSP_BLOCK_CACHE_FILE));
+#endif
 	}
 
 	EXPORT void CALL parallelRSPInitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount)
@@ -157,5 +178,18 @@ extern "C"
 		RSP::cpu.set_dmem(reinterpret_cast<uint32_t *>(Rsp_Info.DMEM));
 		RSP::cpu.set_imem(reinterpret_cast<uint32_t *>(Rsp_Info.IMEM));
 		RSP::cpu.set_rdram(reinterpret_cast<uint32_t *>(Rsp_Info.RDRAM));
+
+#ifndef DEBUG_JIT
+		static bool block_cache_loaded;
+		if (!block_cache_loaded)
+		{
+			RSP::cpu.load_block_cache(ConfigGetSharedDataFilepath(RSP_BLOCK_CACHE_FILE));
+			block_cache_loaded = true;
+		}
+#endif
+
+#ifdef PARALLEL_RSP_LOCKSTEP
+		RSP::Lockstep::init(Rsp_Info);
+#endif
 	}
 }
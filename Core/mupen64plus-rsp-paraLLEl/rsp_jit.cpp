@@ -1,7 +1,9 @@
 #include "rsp_jit.hpp"
 #include "rsp_disasm.hpp"
+#include <algorithm>
 #include <utility>
 #include <assert.h>
+#include <stdio.h>
 
 using namespace std;
 
@@ -57,6 +59,12 @@ void CPU::invalidate_code()
 	{
 		if (state.dirty_blocks & (1 << i))
 		{
+			// The blocks dropped here were in use until now.
+			for (unsigned pc = i * CODE_BLOCK_WORDS; pc < (i + 1) * CODE_BLOCK_WORDS; pc++)
+				if (blocks[pc])
+					for (auto &cached : cached_blocks[pc])
+						if (cached.second.code == blocks[pc])
+							cached.second.last_use = ++block_use_counter;
 			memset(blocks + i * CODE_BLOCK_WORDS, 0, CODE_BLOCK_WORDS * sizeof(blocks[0]));
 			memcpy(cached_imem + i * CODE_BLOCK_WORDS, state.imem + i * CODE_BLOCK_WORDS, CODE_BLOCK_SIZE);
 		}
@@ -459,15 +467,147 @@ Func CPU::get_jit_block(uint32_t pc)
 		end = analyze_static_end(word_pc, end);
 
 		uint64_t hash = hash_imem(word_pc, end - word_pc);
-		auto &ptr = cached_blocks[word_pc][hash];
-		if (ptr)
-			block = ptr;
+		auto itr = cached_blocks[word_pc].find(hash);
+		if (itr != cached_blocks[word_pc].end())
+		{
+			itr->second.last_use = ++block_use_counter;
+			block = itr->second.code;
+		}
 		else
-			block = ptr = jit_region(hash, word_pc, end - word_pc);
+		{
+			block = compile_block(hash, word_pc, end - word_pc).code;
+			if (cached_code_size > CODE_CACHE_BUDGET)
+				evict_blocks(CODE_CACHE_BUDGET / 4 * 3);
+		}
 	}
 	return block;
 }
 
+CPU::CachedBlock &CPU::compile_block(uint64_t hash, unsigned pc_word, unsigned instruction_count)
+{
+	auto &cached = cached_blocks[pc_word][hash];
+	cached.code = jit_region(hash, pc_word, instruction_count, cached.code_size);
+	cached.last_use = ++block_use_counter;
+	cached.pc_word = pc_word;
+	cached.words.assign(state.imem + pc_word, state.imem + pc_word + instruction_count);
+	cached_code_size += cached.code_size;
+	return cached;
+}
+
+void CPU::evict_blocks(size_t target_size)
+{
+	// Blocks are only looked up here, when no JIT code is on the stack, and
+	// those the current IMEM links to in blocks[] are never candidates.
+	struct Candidate
+	{
+		uint64_t last_use;
+		unsigned pc_word;
+		uint64_t hash;
+	};
+	std::vector<Candidate> candidates;
+	for (unsigned pc = 0; pc < IMEM_WORDS; pc++)
+		for (auto &cached : cached_blocks[pc])
+			if (cached.second.code != blocks[pc])
+				candidates.push_back({ cached.second.last_use, pc, cached.first });
+
+	sort(candidates.begin(), candidates.end(),
+	     [](const Candidate &a, const Candidate &b) { return a.last_use < b.last_use; });
+
+	for (auto &candidate : candidates)
+	{
+		if (cached_code_size <= target_size)
+			break;
+		auto itr = cached_blocks[candidate.pc_word].find(candidate.hash);
+		allocator.free_code(reinterpret_cast<void *>(itr->second.code), itr->second.code_size);
+		cached_code_size -= itr->second.code_size;
+		cached_blocks[candidate.pc_word].erase(itr);
+	}
+}
+
+// Records each block by its position and instruction words, which is all
+// that is needed to compile it again.  Code itself holds absolute addresses
+// of the thunks and helpers, which move from one run to the next.
+enum { BLOCK_CACHE_VERSION = 1 };
+static const char block_cache_magic[8] = { 'P', 'R', 'S', 'P', 'J', 'I', 'T', 'C' };
+
+struct BlockCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+};
+
+void CPU::load_block_cache(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return;
+
+	BlockCacheHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, block_cache_magic, sizeof(header.magic)) ||
+	    header.version != BLOCK_CACHE_VERSION)
+	{
+		fclose(file);
+		return;
+	}
+
+	// Blocks are compiled from a scratch IMEM, since jit_region() reads its
+	// instructions from state.imem.
+	uint32_t *imem = state.imem;
+	std::vector<uint32_t> scratch(IMEM_WORDS);
+	state.imem = scratch.data();
+
+	for (uint32_t i = 0; i < header.count && cached_code_size < CODE_CACHE_BUDGET / 2; i++)
+	{
+		uint16_t block[2];
+		if (fread(block, sizeof(block), 1, file) != 1)
+			break;
+		unsigned pc_word = block[0];
+		unsigned count = block[1];
+		if (!count || count > CODE_BLOCK_WORDS * 2 || pc_word + count > IMEM_WORDS)
+			break;
+		if (fread(scratch.data() + pc_word, sizeof(uint32_t), count, file) != count)
+			break;
+
+		uint64_t hash = hash_imem(pc_word, count);
+		if (!cached_blocks[pc_word].count(hash))
+			compile_block(hash, pc_word, count);
+	}
+
+	state.imem = imem;
+	fclose(file);
+}
+
+void CPU::save_block_cache(const char *path) const
+{
+	std::vector<const CachedBlock *> order;
+	for (auto &pc_blocks : cached_blocks)
+		for (auto &cached : pc_blocks)
+			order.push_back(&cached.second);
+	sort(order.begin(), order.end(),
+	     [](const CachedBlock *a, const CachedBlock *b) { return a->last_use > b->last_use; });
+	if (order.empty())
+		return;
+
+	FILE *file = fopen(path, "wb");
+	if (!file)
+		return;
+
+	BlockCacheHeader header;
+	memcpy(header.magic, block_cache_magic, sizeof(header.magic));
+	header.version = BLOCK_CACHE_VERSION;
+	header.count = uint32_t(order.size());
+	fwrite(&header, sizeof(header), 1, file);
+
+	for (auto *cached : order)
+	{
+		uint16_t block[2] = { uint16_t(cached->pc_word), uint16_t(cached->words.size()) };
+		fwrite(block, sizeof(block), 1, file);
+		fwrite(cached->words.data(), sizeof(uint32_t), cached->words.size(), file);
+	}
+	fclose(file);
+}
+
 int CPU::enter(uint32_t pc)
 {
 	// Top level enter.
@@ -1789,7 +1929,7 @@ void CPU::jit_handle_latent_delay_slot(jit_state_t *_jit, const InstructionInfo
 	}
 }
 
-Func CPU::jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count)
+Func CPU::jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count, size_t &code_size)
 {
 	regs.reset();
 
@@ -1891,14 +2031,16 @@ Func CPU::jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count
 		jit_patch_at(b.node, branch_targets[b.local_index]);
 
 	jit_realize();
-	jit_word_t code_size;
-	jit_get_code(&code_size);
+	jit_word_t jit_code_size;
+	jit_get_code(&jit_code_size);
+	code_size = jit_code_size;
 	auto *block_code = allocator.allocate_code(code_size);
 	if (!block_code)
 		abort();
 	jit_set_code(block_code, code_size);
 
 	auto ret = reinterpret_cast<Func>(jit_emit());
+	assert(ret == block_code);
 
 #ifdef TRACE_DISASM
 	printf(" === DISASM ===\n");
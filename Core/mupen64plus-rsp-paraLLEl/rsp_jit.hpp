@@ -120,6 +120,11 @@ public:
 
 	Func get_jit_block(uint32_t pc);
 
+	// Compiles the blocks recorded by an earlier run, most recently used first,
+	// so that microcode seen before does not have to be compiled mid-frame.
+	void load_block_cache(const char *path);
+	void save_block_cache(const char *path) const;
+
 private:
 	CPUState state;
 	Func blocks[IMEM_WORDS] = {};
@@ -130,9 +135,27 @@ private:
 
 	alignas(64) uint32_t cached_imem[IMEM_WORDS] = {};
 
-	std::unordered_map<uint64_t, Func> cached_blocks[IMEM_WORDS];
+	// Compiled blocks outlive the IMEM contents they were compiled from, so
+	// that switching back and forth between microcodes does not recompile.
+	// Once the code exceeds CODE_CACHE_BUDGET, the least recently used blocks
+	// which the current IMEM does not reference are freed.
+	enum { CODE_CACHE_BUDGET = 64 * 1024 * 1024 };
+	struct CachedBlock
+	{
+		Func code = nullptr;
+		size_t code_size = 0;
+		uint64_t last_use = 0;
+		unsigned pc_word = 0;
+		std::vector<uint32_t> words;
+	};
+	std::unordered_map<uint64_t, CachedBlock> cached_blocks[IMEM_WORDS];
+	size_t cached_code_size = 0;
+	uint64_t block_use_counter = 0;
+
+	CachedBlock &compile_block(uint64_t hash, unsigned pc_word, unsigned instruction_count);
+	void evict_blocks(size_t target_size);
 
-	Func jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count);
+	Func jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count, size_t &code_size);
 
 	int enter(uint32_t pc);
 
@@ -27,3 +27,15 @@
 #else
 #define STRICTINLINE inline
 #endif
+
+// SIMD instruction sets available without runtime detection, the SIMD code
+// paths assume a little endian host
+#ifndef MSB_FIRST
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANGRYLION_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define ANGRYLION_NEON
+#include <arm_neon.h>
+#endif
+#endif
@@ -237,6 +237,38 @@ void angrylion_set_synclevel(unsigned value)
    }
 }
 
+void angrylion_set_async(unsigned value)
+{
+   if(config.dp.async != (bool)value)
+   {
+      config.dp.async = (bool)value;
+      if (angrylion_init)
+      {
+         n64video_close();
+         n64video_init(&config);
+      }
+   }
+}
+
+void angrylion_set_binning(unsigned value)
+{
+   if(config.dp.binning != (bool)value)
+   {
+      config.dp.binning = (bool)value;
+      if (angrylion_init)
+      {
+         n64video_close();
+         n64video_init(&config);
+      }
+   }
+}
+
+void angrylion_sync(void)
+{
+   if (angrylion_init)
+      n64video_sync();
+}
+
 unsigned angrylion_get_synclevel()
 {
     return config.dp.compat;
@@ -384,9 +416,33 @@ void angrylionViWidthChanged (void) { }
 
 void angrylionFBWrite(unsigned int addr, unsigned int size) { }
 
-void angrylionFBRead(unsigned int addr) { }
+void angrylionFBRead(unsigned int addr)
+{
+   n64video_sync();
+}
+
+void angrylionFBGetFrameBufferInfo(void *pinfo)
+{
+   FrameBufferInfo *info = (FrameBufferInfo*)pinfo;
+   struct n64video_frame_buffer fbs[2];
+   uint32_t i, count;
+
+   memset(info, 0, sizeof(FrameBufferInfo) * 6);
 
-void angrylionFBGetFrameBufferInfo(void *pinfo) { }
+   /* reads only need to wait for the workers when they run in the
+    * background, don't make the core trap frame buffer accesses otherwise */
+   if (!config.parallel || !config.dp.async)
+      return;
+
+   count = n64video_frame_buffers(fbs, 2);
+   for (i = 0; i < count; i++)
+   {
+      info[i].addr   = fbs[i].address;
+      info[i].size   = fbs[i].size;
+      info[i].width  = fbs[i].width;
+      info[i].height = fbs[i].height;
+   }
+}
 
 m64p_error angrylionPluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion, int *APIVersion, const char **PluginNamePtr, int *Capabilities)
 {
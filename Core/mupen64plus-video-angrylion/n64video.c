@@ -3,6 +3,7 @@
 #include "msg.h"
 #include "vdac.h"
 #include "parallel_al.h"
+#include "main/trace.h"
 
 #include <memory.h>
 #include <string.h>
@@ -41,6 +42,10 @@ void angrylion_set_vi(unsigned value);
 // maximum number of commands to buffer for parallel processing
 #define CMD_BUFFER_SIZE 1024
 
+// scanlines worth of buffered work per thread that runs them, batches
+// below that use fewer threads
+#define CMD_LINES_PER_THREAD 16
+
 // maximum data size of a single command in bytes
 #define CMD_MAX_SIZE 176
 
@@ -118,6 +123,13 @@ static STRICTINLINE uint32_t irand(uint32_t* state)
 
 static uint32_t rdp_cmd_buf[CMD_BUFFER_SIZE][CMD_MAX_INTS];
 static uint32_t rdp_cmd_buf_pos;
+static uint32_t rdp_cmd_buf_lines;
+
+// binning mode: bins touched by each buffered command (none if first > last),
+// the workers that have to run it and the estimated work per bin
+static uint8_t rdp_cmd_buf_bins[CMD_BUFFER_SIZE][2];
+static uint64_t rdp_cmd_buf_workers[CMD_BUFFER_SIZE];
+static uint32_t rdp_bin_work[RDP_NUM_BINS];
 
 static uint32_t rdp_cmd_pos;
 static uint32_t rdp_cmd_id;
@@ -127,21 +139,180 @@ static uint32_t rdp_cmd_len;
 // multithreaded mode
 static bool rdp_cmd_sync[64];
 
+// color image, depth image and scissor as last submitted, tracked on the
+// emulation thread since the workers may still be behind
+static uint32_t fb_color_image[2];
+static uint32_t fb_mask_image;
+static uint32_t fb_scissor_yl;
+
+#ifdef ANGRYLION_CMD_DUMP
+// Captures RDRAM and all following commands for rdp_span_test.c. Format:
+// "ALCMD001", RDRAM size (u32), RDRAM image, then for each command its
+// length in words (u32) followed by its words, all in host byte order.
+static FILE* cmd_dump_file;
+
+static void cmd_dump(const uint32_t* cmd, uint32_t len)
+{
+    if (!cmd_dump_file) {
+        cmd_dump_file = fopen("angrylion_cmds.bin", "wb");
+        if (!cmd_dump_file) {
+            return;
+        }
+        fwrite("ALCMD001", 1, 8, cmd_dump_file);
+        fwrite(&config.gfx.rdram_size, sizeof(uint32_t), 1, cmd_dump_file);
+        fwrite(config.gfx.rdram, 1, config.gfx.rdram_size, cmd_dump_file);
+    }
+
+    fwrite(&len, sizeof(uint32_t), 1, cmd_dump_file);
+    fwrite(cmd, sizeof(uint32_t), len, cmd_dump_file);
+}
+#endif
+
 static void cmd_run_buffered(uint32_t worker_id)
 {
     uint32_t pos;
-    for (pos = 0; pos < rdp_cmd_buf_pos; pos++)
+    for (pos = 0; pos < rdp_cmd_buf_pos; pos++) {
+        // in binning mode, skip primitives outside of the worker's bins
+        if (rdp_binning && !((rdp_cmd_buf_workers[pos] >> worker_id) & 1)) {
+            continue;
+        }
         rdp_cmd(worker_id, rdp_cmd_buf[pos]);
+    }
+}
+
+// gets the vertical extent of a primitive in quarter scanlines, returns false
+// for commands that don't render anything
+static bool cmd_yrange(const uint32_t* cmd, int32_t* yh, int32_t* yl)
+{
+    switch (CMD_ID(cmd)) {
+        case CMD_ID_FILL_TRIANGLE:
+        case CMD_ID_FILL_ZBUFFER_TRIANGLE:
+        case CMD_ID_TEXTURE_TRIANGLE:
+        case CMD_ID_TEXTURE_ZBUFFER_TRIANGLE:
+        case CMD_ID_SHADE_TRIANGLE:
+        case CMD_ID_SHADE_ZBUFFER_TRIANGLE:
+        case CMD_ID_SHADE_TEXTURE_TRIANGLE:
+        case CMD_ID_SHADE_TEXTURE_Z_BUFFER_TRIANGLE:
+            // s11.2 coordinates
+            *yl = SIGN(cmd[0], 14);
+            *yh = SIGN(cmd[1], 14);
+            return true;
+        case CMD_ID_TEXTURE_RECTANGLE:
+        case CMD_ID_TEXTURE_RECTANGLE_FLIP:
+        case CMD_ID_FILL_RECTANGLE:
+            // u10.2 coordinates
+            *yl = cmd[0] & 0xfff;
+            *yh = cmd[1] & 0xfff;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// rough estimate of the number of scanlines a command renders
+static uint32_t cmd_lines(const uint32_t* cmd)
+{
+    int32_t yl, yh;
+
+    if (!cmd_yrange(cmd, &yh, &yl)) {
+        return 0;
+    }
+
+    return yl > yh ? (yl - yh + 3) >> 2 : 0;
+}
+
+// records the bins a buffered command touches and adds its work to them
+static void cmd_bin(uint32_t pos)
+{
+    int32_t yl, yh, first, last, bin;
+
+    if (!cmd_yrange(rdp_cmd_buf[pos], &yh, &yl)) {
+        rdp_cmd_buf_bins[pos][0] = 1;
+        rdp_cmd_buf_bins[pos][1] = 0;
+        return;
+    }
+
+    // conservative, the scissor box may clip it further
+    first = CLAMP(yh >> 2, 0, 1023) >> RDP_BIN_SHIFT;
+    last = CLAMP(yl >> 2, 0, 1023) >> RDP_BIN_SHIFT;
+    if (last < first) {
+        last = first;
+    }
+
+    rdp_cmd_buf_bins[pos][0] = (uint8_t)first;
+    rdp_cmd_buf_bins[pos][1] = (uint8_t)last;
+
+    // the edge walk of a primitive costs about as much as a few scanlines
+    rdp_bin_work[first] += 4;
+    for (bin = first; bin <= last; bin++) {
+        int32_t top = MAX(yh >> 2, bin << RDP_BIN_SHIFT);
+        int32_t bottom = MIN(yl >> 2, ((bin + 1) << RDP_BIN_SHIFT) - 1);
+        if (bottom >= top) {
+            rdp_bin_work[bin] += bottom - top + 1;
+        }
+    }
+}
+
+// splits the bins into runs of consecutive bins with roughly the same amount
+// of work, one per thread, and finds the workers that run each buffered
+// command. Done here rather than by the workers taking bins at run time, so
+// the output (eg. of noise dithering) doesn't depend on thread timing.
+static void cmd_assign_bins(uint32_t num_threads)
+{
+    uint32_t total = 0, sum = 0, wid = 0;
+    uint32_t bin, pos;
+
+    for (bin = 0; bin < RDP_NUM_BINS; bin++) {
+        total += rdp_bin_work[bin];
+    }
+
+    for (bin = 0; bin < RDP_NUM_BINS; bin++) {
+        rdp_bin_owner[bin] = (uint8_t)wid;
+        sum += rdp_bin_work[bin];
+        rdp_bin_work[bin] = 0;
+
+        if (wid + 1 < num_threads && (uint64_t)sum * num_threads >= (uint64_t)total * (wid + 1)) {
+            wid++;
+        }
+    }
+
+    for (pos = 0; pos < rdp_cmd_buf_pos; pos++) {
+        uint64_t workers = ~UINT64_C(0);
+        uint32_t first = rdp_cmd_buf_bins[pos][0];
+        uint32_t last = rdp_cmd_buf_bins[pos][1];
+
+        // non-primitive commands update the state of all workers
+        if (first <= last) {
+            workers = 0;
+            for (bin = first; bin <= last; bin++) {
+                workers |= UINT64_C(1) << rdp_bin_owner[bin];
+            }
+        }
+
+        rdp_cmd_buf_workers[pos] = workers;
+    }
 }
 
 static void cmd_flush(void)
 {
     // only run if there's something buffered
     if (rdp_cmd_buf_pos) {
-        // let workers run all buffered commands in parallel
-        parallel_run(cmd_run_buffered);
+        TRACE_BEGIN(zone_start);
+
+        // let workers run all buffered commands in parallel, without waking
+        // up more threads than the amount of work is worth
+        uint32_t num_threads = MIN(1 + rdp_cmd_buf_lines / CMD_LINES_PER_THREAD, parallel_num_workers());
+
+        if (rdp_binning) {
+            cmd_assign_bins(num_threads);
+        }
+
+        parallel_run_threads(cmd_run_buffered, num_threads);
         // reset buffer by starting from the beginning
         rdp_cmd_buf_pos = 0;
+        rdp_cmd_buf_lines = 0;
+
+        TRACE_END(zone_start, "angrylion flush");
     }
 }
 
@@ -210,6 +381,15 @@ void n64video_init(struct n64video_config* xconfig)
     rdp_pipeline_crashed = 0;
     memset(&onetimewarnings, 0, sizeof(onetimewarnings));
 
+    memset(fb_color_image, 0, sizeof(fb_color_image));
+    fb_mask_image = 0;
+    fb_scissor_yl = 0;
+
+    // bins are assigned per batch of buffered commands, so they're not used
+    // by the asynchronous command ring
+    rdp_binning = config.parallel && config.dp.binning && !config.dp.async;
+    memset(rdp_bin_work, 0, sizeof(rdp_bin_work));
+
     if (config.parallel)
     {
        uint32_t i;
@@ -222,6 +402,10 @@ void n64video_init(struct n64video_config* xconfig)
 
        // init workers
        parallel_run(rdp_init_worker);
+
+       // let workers run commands in the background
+       if (config.dp.async)
+          parallel_ring_init(rdp_cmd, CMD_MAX_INTS);
     }
     else
         rdp_init(0, 1);
@@ -243,7 +427,14 @@ void n64video_process_list(void)
         uint32_t i, toload;
         bool xbus_dma = (*dp_reg[DP_STATUS] & DP_STATUS_XBUS_DMA) != 0;
         uint32_t* dmem = (uint32_t*)config.gfx.dmem;
-        uint32_t* cmd_buf = rdp_cmd_buf[rdp_cmd_buf_pos];
+        uint32_t* cmd_buf;
+
+        // in async mode, commands are assembled directly in the ring
+        if (config.parallel && config.dp.async) {
+            cmd_buf = parallel_ring_slot();
+        } else {
+            cmd_buf = rdp_cmd_buf[rdp_cmd_buf_pos];
+        }
 
         // when reading the first int, extract the command ID and update the buffer length
         if (rdp_cmd_pos == 0) {
@@ -272,8 +463,23 @@ void n64video_process_list(void)
 
         // if there's enough data for the current command...
         if (rdp_cmd_pos == rdp_cmd_len) {
+#ifdef ANGRYLION_CMD_DUMP
+            cmd_dump(cmd_buf, rdp_cmd_len);
+#endif
+
             // check if parallel processing is enabled
-            if (config.parallel) {
+            if (config.parallel && config.dp.async) {
+                // sync_full raises the DP interrupt, after which the CPU
+                // expects all RDRAM writes to be visible
+                if (rdp_cmd_id == CMD_ID_SYNC_FULL) {
+                    parallel_ring_sync();
+                    rdp_sync_full(0, NULL);
+                } else {
+                    // commands that require a sync become a barrier
+                    // between workers, the emulation thread keeps going
+                    parallel_ring_push(rdp_cmd_sync[rdp_cmd_id]);
+                }
+            } else if (config.parallel) {
                 // special case: sync_full always needs to be run in main thread
                 if (rdp_cmd_id == CMD_ID_SYNC_FULL) {
                     // first, run all pending commands
@@ -282,8 +488,13 @@ void n64video_process_list(void)
                     // parameters are unused, so NULL is fine
                     rdp_sync_full(0, NULL);
                 } else {
+                    if (rdp_binning) {
+                        cmd_bin(rdp_cmd_buf_pos);
+                    }
+
                     // increment buffer position
                     rdp_cmd_buf_pos++;
+                    rdp_cmd_buf_lines += cmd_lines(cmd_buf);
 
                     // flush buffer when it is full or when the current command requires a sync
                     if (rdp_cmd_buf_pos >= CMD_BUFFER_SIZE || rdp_cmd_sync[rdp_cmd_id]) {
@@ -298,6 +509,12 @@ void n64video_process_list(void)
             // send Z-buffer address to VI for "depth" output mode
             if (rdp_cmd_id == CMD_ID_SET_MASK_IMAGE) {
                 vi_set_zbuffer_address(cmd_buf[1] & 0x0ffffff);
+                fb_mask_image = cmd_buf[1] & 0x0ffffff;
+            } else if (rdp_cmd_id == CMD_ID_SET_COLOR_IMAGE) {
+                fb_color_image[0] = cmd_buf[0];
+                fb_color_image[1] = cmd_buf[1];
+            } else if (rdp_cmd_id == CMD_ID_SET_SCISSOR) {
+                fb_scissor_yl = cmd_buf[1] & 0xfff;
             }
 
             // reset current command buffer to prepare for the next one
@@ -309,8 +526,50 @@ void n64video_process_list(void)
     *dp_reg[DP_START] = *dp_reg[DP_CURRENT] = *dp_reg[DP_END];
 }
 
+uint32_t n64video_frame_buffers(struct n64video_frame_buffer* fbs, uint32_t max)
+{
+    uint32_t count = 0;
+    uint32_t size = (fb_color_image[0] >> 19) & 3;
+    uint32_t width = (fb_color_image[0] & 0x3ff) + 1;
+    uint32_t height = fb_scissor_yl >> 2;
+    uint32_t i;
+
+    // the color image comes first, the core ignores the list if the first
+    // entry is empty
+    struct n64video_frame_buffer images[2] = {
+        { fb_color_image[1] & 0x0ffffff, size ? 1 << (size - 1) : 1, width, height },
+        { fb_mask_image, 2, width, height },
+    };
+
+    if (!fb_color_image[1] || !height) {
+        return 0;
+    }
+
+    for (i = 0; i < 2 && count < max; i++) {
+        struct n64video_frame_buffer* fb = &images[i];
+        if (fb->address && fb->address + fb->width * fb->height * fb->size <= config.gfx.rdram_size) {
+            fbs[count++] = *fb;
+        }
+    }
+
+    return count;
+}
+
+void n64video_sync(void)
+{
+    // wait until all commands sent to the workers have been executed
+    parallel_ring_sync();
+}
+
 void n64video_close(void)
 {
+#ifdef ANGRYLION_CMD_DUMP
+    if (cmd_dump_file) {
+        fclose(cmd_dump_file);
+        cmd_dump_file = NULL;
+    }
+#endif
+
     vi_close();
     parallel_close();
 }
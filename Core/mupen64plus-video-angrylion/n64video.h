@@ -86,14 +86,26 @@ struct n64video_config
     } vi;
     struct {
         enum dp_compat_profile compat;  // multithreading compatibility mode
+        bool async;                     // run commands in the background if true
+        bool binning;                   // split work between workers by screen bins if true
     } dp;
     bool parallel;                  // use multithreaded renderer if true
     bool dithering;                 // enable dithering
     uint32_t num_workers;           // number of rendering workers
 };
 
+struct n64video_frame_buffer
+{
+    uint32_t address;   // RDRAM address
+    uint32_t size;      // bytes per pixel
+    uint32_t width;     // width in pixels
+    uint32_t height;    // height in lines
+};
+
 void n64video_config_init(struct n64video_config* config);
 void n64video_init(struct n64video_config* config);
 void n64video_update_screen(void);
 void n64video_process_list(void);
+void n64video_sync(void);
+uint32_t n64video_frame_buffers(struct n64video_frame_buffer* fbs, uint32_t max);
 void n64video_close(void);
@@ -458,6 +458,19 @@ static const struct
 
 static void deduce_derivatives(uint32_t wid);
 
+// span level fast paths, can be turned off to compare them against the
+// per-pixel code
+static bool rdp_span_fastpath = true;
+
+// in binning mode, scanlines are owned by workers in bins of
+// (1 << RDP_BIN_SHIFT) lines instead of being interleaved, the owners are
+// assigned for each batch of buffered commands
+#define RDP_BIN_SHIFT 3
+#define RDP_NUM_BINS (1024 >> RDP_BIN_SHIFT)
+
+static bool rdp_binning;
+static uint8_t rdp_bin_owner[RDP_NUM_BINS];
+
 #include "rdp/rdram.c"
 #include "rdp/dither.c"
 #include "rdp/blender.c"
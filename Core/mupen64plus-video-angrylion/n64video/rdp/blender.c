@@ -87,40 +87,18 @@ static STRICTINLINE int alpha_compare(uint32_t wid, int32_t comb_alpha)
     }
 }
 
-static STRICTINLINE void blender_equation_cycle0(uint32_t wid, int* r, int* g, int* b)
+// c1 * blend1a + c2 * mulb for the color channels of a cycle, divided through
+// the hardware accurate table with the given sum, or shifted down if sum is 0
+static STRICTINLINE void blender_mul(uint32_t wid, int cycle, int blend1a, int mulb, int sum, int* r, int* g, int* b)
 {
-    int blend1a, blend2a;
-    int blr, blg, blb, sum;
-    blend1a = *state[wid].blender1b_a[0] >> 3;
-    blend2a = *state[wid].blender2b_a[0] >> 3;
+    int blr, blg, blb;
 
-    int mulb;
+    blr = (*state[wid].blender1a_r[cycle]) * blend1a + (*state[wid].blender2a_r[cycle]) * mulb;
+    blg = (*state[wid].blender1a_g[cycle]) * blend1a + (*state[wid].blender2a_g[cycle]) * mulb;
+    blb = (*state[wid].blender1a_b[cycle]) * blend1a + (*state[wid].blender2a_b[cycle]) * mulb;
 
-
-
-    if (state[wid].blender2b_a[0] == &state[wid].memory_color.a)
+    if (sum)
     {
-        blend1a = (blend1a >> state[wid].blshifta) & 0x3C;
-        blend2a = (blend2a >> state[wid].blshiftb) | 3;
-    }
-
-    mulb = blend2a + 1;
-
-
-    blr = (*state[wid].blender1a_r[0]) * blend1a + (*state[wid].blender2a_r[0]) * mulb;
-    blg = (*state[wid].blender1a_g[0]) * blend1a + (*state[wid].blender2a_g[0]) * mulb;
-    blb = (*state[wid].blender1a_b[0]) * blend1a + (*state[wid].blender2a_b[0]) * mulb;
-
-
-
-    if (!state[wid].other_modes.force_blend)
-    {
-
-
-
-
-
-        sum = ((blend1a & ~3) + (blend2a & ~3) + 4) << 9;
         *r = bldiv_hwaccurate_table[sum | ((blr >> 2) & 0x7ff)];
         *g = bldiv_hwaccurate_table[sum | ((blg >> 2) & 0x7ff)];
         *b = bldiv_hwaccurate_table[sum | ((blb >> 2) & 0x7ff)];
@@ -133,6 +111,25 @@ static STRICTINLINE void blender_equation_cycle0(uint32_t wid, int* r, int* g, i
     }
 }
 
+static STRICTINLINE void blender_equation_cycle0(uint32_t wid, int* r, int* g, int* b)
+{
+    int blend1a, blend2a;
+    int sum = 0;
+    blend1a = *state[wid].blender1b_a[0] >> 3;
+    blend2a = *state[wid].blender2b_a[0] >> 3;
+
+    if (state[wid].blender2b_a[0] == &state[wid].memory_color.a)
+    {
+        blend1a = (blend1a >> state[wid].blshifta) & 0x3C;
+        blend2a = (blend2a >> state[wid].blshiftb) | 3;
+    }
+
+    if (!state[wid].other_modes.force_blend)
+        sum = ((blend1a & ~3) + (blend2a & ~3) + 4) << 9;
+
+    blender_mul(wid, 0, blend1a, blend2a + 1, sum, r, g, b);
+}
+
 static STRICTINLINE void blender_equation_cycle0_2(uint32_t wid, int* r, int* g, int* b)
 {
     int blend1a, blend2a;
@@ -145,44 +142,26 @@ static STRICTINLINE void blender_equation_cycle0_2(uint32_t wid, int* r, int* g,
         blend2a = (blend2a >> state[wid].pastblshiftb) | 3;
     }
 
-    blend2a += 1;
-    *r = (((*state[wid].blender1a_r[0]) * blend1a + (*state[wid].blender2a_r[0]) * blend2a) >> 5) & 0xff;
-    *g = (((*state[wid].blender1a_g[0]) * blend1a + (*state[wid].blender2a_g[0]) * blend2a) >> 5) & 0xff;
-    *b = (((*state[wid].blender1a_b[0]) * blend1a + (*state[wid].blender2a_b[0]) * blend2a) >> 5) & 0xff;
+    blender_mul(wid, 0, blend1a, blend2a + 1, 0, r, g, b);
 }
 
 static STRICTINLINE void blender_equation_cycle1(uint32_t wid, int* r, int* g, int* b)
 {
     int blend1a, blend2a;
-    int blr, blg, blb, sum;
+    int sum = 0;
     blend1a = *state[wid].blender1b_a[1] >> 3;
     blend2a = *state[wid].blender2b_a[1] >> 3;
 
-    int mulb;
     if (state[wid].blender2b_a[1] == &state[wid].memory_color.a)
     {
         blend1a = (blend1a >> state[wid].blshifta) & 0x3C;
         blend2a = (blend2a >> state[wid].blshiftb) | 3;
     }
 
-    mulb = blend2a + 1;
-    blr = (*state[wid].blender1a_r[1]) * blend1a + (*state[wid].blender2a_r[1]) * mulb;
-    blg = (*state[wid].blender1a_g[1]) * blend1a + (*state[wid].blender2a_g[1]) * mulb;
-    blb = (*state[wid].blender1a_b[1]) * blend1a + (*state[wid].blender2a_b[1]) * mulb;
-
     if (!state[wid].other_modes.force_blend)
-    {
         sum = ((blend1a & ~3) + (blend2a & ~3) + 4) << 9;
-        *r = bldiv_hwaccurate_table[sum | ((blr >> 2) & 0x7ff)];
-        *g = bldiv_hwaccurate_table[sum | ((blg >> 2) & 0x7ff)];
-        *b = bldiv_hwaccurate_table[sum | ((blb >> 2) & 0x7ff)];
-    }
-    else
-    {
-        *r = (blr >> 5) & 0xff;
-        *g = (blg >> 5) & 0xff;
-        *b = (blb >> 5) & 0xff;
-    }
+
+    blender_mul(wid, 1, blend1a, blend2a + 1, sum, r, g, b);
 }
 
 static STRICTINLINE int blender_1cycle(uint32_t wid, uint32_t* fr, uint32_t* fg, uint32_t* fb, int dith, uint32_t blend_en, uint32_t prewrap, uint32_t curpixel_cvg, uint32_t curpixel_cvbit)
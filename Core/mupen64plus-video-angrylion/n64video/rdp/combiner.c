@@ -168,6 +168,41 @@ static STRICTINLINE int32_t chroma_key_min(uint32_t wid, struct color* col)
     return keyalpha;
 }
 
+// combined_color = the color and alpha combiner equations of a cycle, the
+// color channels are left unshifted
+static STRICTINLINE void combiner_equation(uint32_t wid, int cycle)
+{
+    if (state[wid].combiner_rgbmul_r[cycle] != &zero_color)
+    {
+        state[wid].combined_color.r = color_combiner_equation(*state[wid].combiner_rgbsub_a_r[cycle],*state[wid].combiner_rgbsub_b_r[cycle],*state[wid].combiner_rgbmul_r[cycle],*state[wid].combiner_rgbadd_r[cycle]);
+        state[wid].combined_color.g = color_combiner_equation(*state[wid].combiner_rgbsub_a_g[cycle],*state[wid].combiner_rgbsub_b_g[cycle],*state[wid].combiner_rgbmul_g[cycle],*state[wid].combiner_rgbadd_g[cycle]);
+        state[wid].combined_color.b = color_combiner_equation(*state[wid].combiner_rgbsub_a_b[cycle],*state[wid].combiner_rgbsub_b_b[cycle],*state[wid].combiner_rgbmul_b[cycle],*state[wid].combiner_rgbadd_b[cycle]);
+    }
+    else
+    {
+        state[wid].combined_color.r = ((special_9bit_exttable[*state[wid].combiner_rgbadd_r[cycle]] << 8) + 0x80) & 0x1ffff;
+        state[wid].combined_color.g = ((special_9bit_exttable[*state[wid].combiner_rgbadd_g[cycle]] << 8) + 0x80) & 0x1ffff;
+        state[wid].combined_color.b = ((special_9bit_exttable[*state[wid].combiner_rgbadd_b[cycle]] << 8) + 0x80) & 0x1ffff;
+    }
+
+    if (state[wid].combiner_alphamul[cycle] != &zero_color)
+        state[wid].combined_color.a = alpha_combiner_equation(*state[wid].combiner_alphasub_a[cycle],*state[wid].combiner_alphasub_b[cycle],*state[wid].combiner_alphamul[cycle],*state[wid].combiner_alphaadd[cycle]);
+    else
+        state[wid].combined_color.a = special_9bit_exttable[*state[wid].combiner_alphaadd[cycle]] & 0x1ff;
+}
+
+// shifts the color channels of combined_color down to 9 bits and clamps them
+// into pixel_color, the alpha channels are left alone
+static STRICTINLINE void combiner_clamp_rgb(uint32_t wid)
+{
+    state[wid].combined_color.r >>= 8;
+    state[wid].combined_color.g >>= 8;
+    state[wid].combined_color.b >>= 8;
+    state[wid].pixel_color.r = special_9bit_clamptable[state[wid].combined_color.r];
+    state[wid].pixel_color.g = special_9bit_clamptable[state[wid].combined_color.g];
+    state[wid].pixel_color.b = special_9bit_clamptable[state[wid].combined_color.b];
+}
+
 static STRICTINLINE void combiner_1cycle(uint32_t wid, int adseed, uint32_t* curpixel_cvg)
 {
 
@@ -186,39 +221,7 @@ static STRICTINLINE void combiner_1cycle(uint32_t wid, int adseed, uint32_t* cur
 
 
 
-    if (state[wid].combiner_rgbmul_r[1] != &zero_color)
-    {
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-        state[wid].combined_color.r = color_combiner_equation(*state[wid].combiner_rgbsub_a_r[1],*state[wid].combiner_rgbsub_b_r[1],*state[wid].combiner_rgbmul_r[1],*state[wid].combiner_rgbadd_r[1]);
-        state[wid].combined_color.g = color_combiner_equation(*state[wid].combiner_rgbsub_a_g[1],*state[wid].combiner_rgbsub_b_g[1],*state[wid].combiner_rgbmul_g[1],*state[wid].combiner_rgbadd_g[1]);
-        state[wid].combined_color.b = color_combiner_equation(*state[wid].combiner_rgbsub_a_b[1],*state[wid].combiner_rgbsub_b_b[1],*state[wid].combiner_rgbmul_b[1],*state[wid].combiner_rgbadd_b[1]);
-    }
-    else
-    {
-        state[wid].combined_color.r = ((special_9bit_exttable[*state[wid].combiner_rgbadd_r[1]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.g = ((special_9bit_exttable[*state[wid].combiner_rgbadd_g[1]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.b = ((special_9bit_exttable[*state[wid].combiner_rgbadd_b[1]] << 8) + 0x80) & 0x1ffff;
-    }
-
-    if (state[wid].combiner_alphamul[1] != &zero_color)
-        state[wid].combined_color.a = alpha_combiner_equation(*state[wid].combiner_alphasub_a[1],*state[wid].combiner_alphasub_b[1],*state[wid].combiner_alphamul[1],*state[wid].combiner_alphaadd[1]);
-    else
-        state[wid].combined_color.a = special_9bit_exttable[*state[wid].combiner_alphaadd[1]] & 0x1ff;
+    combiner_equation(wid, 1);
 
     state[wid].pixel_color.a = special_9bit_clamptable[state[wid].combined_color.a];
     if (state[wid].pixel_color.a == 0xff)
@@ -226,13 +229,7 @@ static STRICTINLINE void combiner_1cycle(uint32_t wid, int adseed, uint32_t* cur
 
     if (!state[wid].other_modes.key_en)
     {
-
-        state[wid].combined_color.r >>= 8;
-        state[wid].combined_color.g >>= 8;
-        state[wid].combined_color.b >>= 8;
-        state[wid].pixel_color.r = special_9bit_clamptable[state[wid].combined_color.r];
-        state[wid].pixel_color.g = special_9bit_clamptable[state[wid].combined_color.g];
-        state[wid].pixel_color.b = special_9bit_clamptable[state[wid].combined_color.b];
+        combiner_clamp_rgb(wid);
     }
     else
     {
@@ -285,23 +282,7 @@ static STRICTINLINE void combiner_1cycle(uint32_t wid, int adseed, uint32_t* cur
 
 static STRICTINLINE void combiner_2cycle_cycle0(uint32_t wid, int adseed, uint32_t cvg, uint32_t* acalpha)
 {
-    if (state[wid].combiner_rgbmul_r[0] != &zero_color)
-    {
-        state[wid].combined_color.r = color_combiner_equation(*state[wid].combiner_rgbsub_a_r[0],*state[wid].combiner_rgbsub_b_r[0],*state[wid].combiner_rgbmul_r[0],*state[wid].combiner_rgbadd_r[0]);
-        state[wid].combined_color.g = color_combiner_equation(*state[wid].combiner_rgbsub_a_g[0],*state[wid].combiner_rgbsub_b_g[0],*state[wid].combiner_rgbmul_g[0],*state[wid].combiner_rgbadd_g[0]);
-        state[wid].combined_color.b = color_combiner_equation(*state[wid].combiner_rgbsub_a_b[0],*state[wid].combiner_rgbsub_b_b[0],*state[wid].combiner_rgbmul_b[0],*state[wid].combiner_rgbadd_b[0]);
-    }
-    else
-    {
-        state[wid].combined_color.r = ((special_9bit_exttable[*state[wid].combiner_rgbadd_r[0]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.g = ((special_9bit_exttable[*state[wid].combiner_rgbadd_g[0]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.b = ((special_9bit_exttable[*state[wid].combiner_rgbadd_b[0]] << 8) + 0x80) & 0x1ffff;
-    }
-
-    if (state[wid].combiner_alphamul[0] != &zero_color)
-        state[wid].combined_color.a = alpha_combiner_equation(*state[wid].combiner_alphasub_a[0],*state[wid].combiner_alphasub_b[0],*state[wid].combiner_alphamul[0],*state[wid].combiner_alphaadd[0]);
-    else
-        state[wid].combined_color.a = special_9bit_exttable[*state[wid].combiner_alphaadd[0]] & 0x1ff;
+    combiner_equation(wid, 0);
 
 
 
@@ -367,34 +348,11 @@ static STRICTINLINE void combiner_2cycle_cycle1(uint32_t wid, int adseed, uint32
         chromabypass.b = *state[wid].combiner_rgbsub_a_b[1];
     }
 
-    if (state[wid].combiner_rgbmul_r[1] != &zero_color)
-    {
-        state[wid].combined_color.r = color_combiner_equation(*state[wid].combiner_rgbsub_a_r[1],*state[wid].combiner_rgbsub_b_r[1],*state[wid].combiner_rgbmul_r[1],*state[wid].combiner_rgbadd_r[1]);
-        state[wid].combined_color.g = color_combiner_equation(*state[wid].combiner_rgbsub_a_g[1],*state[wid].combiner_rgbsub_b_g[1],*state[wid].combiner_rgbmul_g[1],*state[wid].combiner_rgbadd_g[1]);
-        state[wid].combined_color.b = color_combiner_equation(*state[wid].combiner_rgbsub_a_b[1],*state[wid].combiner_rgbsub_b_b[1],*state[wid].combiner_rgbmul_b[1],*state[wid].combiner_rgbadd_b[1]);
-    }
-    else
-    {
-        state[wid].combined_color.r = ((special_9bit_exttable[*state[wid].combiner_rgbadd_r[1]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.g = ((special_9bit_exttable[*state[wid].combiner_rgbadd_g[1]] << 8) + 0x80) & 0x1ffff;
-        state[wid].combined_color.b = ((special_9bit_exttable[*state[wid].combiner_rgbadd_b[1]] << 8) + 0x80) & 0x1ffff;
-    }
-
-    if (state[wid].combiner_alphamul[1] != &zero_color)
-        state[wid].combined_color.a = alpha_combiner_equation(*state[wid].combiner_alphasub_a[1],*state[wid].combiner_alphasub_b[1],*state[wid].combiner_alphamul[1],*state[wid].combiner_alphaadd[1]);
-    else
-        state[wid].combined_color.a = special_9bit_exttable[*state[wid].combiner_alphaadd[1]] & 0x1ff;
+    combiner_equation(wid, 1);
 
     if (!state[wid].other_modes.key_en)
     {
-
-        state[wid].combined_color.r >>= 8;
-        state[wid].combined_color.g >>= 8;
-        state[wid].combined_color.b >>= 8;
-
-        state[wid].pixel_color.r = special_9bit_clamptable[state[wid].combined_color.r];
-        state[wid].pixel_color.g = special_9bit_clamptable[state[wid].combined_color.g];
-        state[wid].pixel_color.b = special_9bit_clamptable[state[wid].combined_color.b];
+        combiner_clamp_rgb(wid);
     }
     else
     {
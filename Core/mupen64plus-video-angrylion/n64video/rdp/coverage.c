@@ -27,6 +27,32 @@ static STRICTINLINE uint32_t leftcvghex(uint32_t x, uint32_t fmask)
 
 
 
+// clears mask bits in cvgbuf[start] to cvgbuf[end]
+static STRICTINLINE void cvgbuf_clear(uint8_t* cvgbuf, int start, int end, uint8_t mask)
+{
+    int k = start;
+
+#if defined(ANGRYLION_SSE2)
+    if (rdp_span_fastpath) {
+        const __m128i vmask = _mm_set1_epi8((char)~mask);
+        for (; k + 15 <= end; k += 16) {
+            __m128i v = _mm_loadu_si128((__m128i*)&cvgbuf[k]);
+            _mm_storeu_si128((__m128i*)&cvgbuf[k], _mm_and_si128(v, vmask));
+        }
+    }
+#elif defined(ANGRYLION_NEON)
+    if (rdp_span_fastpath) {
+        const uint8x16_t vmask = vdupq_n_u8((uint8_t)~mask);
+        for (; k + 15 <= end; k += 16) {
+            vst1q_u8(&cvgbuf[k], vandq_u8(vld1q_u8(&cvgbuf[k]), vmask));
+        }
+    }
+#endif
+
+    for (; k <= end; k++)
+        cvgbuf[k] &= ~mask;
+}
+
 static STRICTINLINE void compute_cvg_flip(uint32_t wid, int32_t scanline)
 {
     int32_t purgestart, purgeend;
@@ -58,17 +84,14 @@ static STRICTINLINE void compute_cvg_flip(uint32_t wid, int32_t scanline)
 
                 if (!state[wid].span[scanline].invalyscan[i])
                 {
-                   int k;
                     minorcur = state[wid].span[scanline].minorx[i];
                     majorcur = state[wid].span[scanline].majorx[i];
                     minorcurint = minorcur >> 3;
                     majorcurint = majorcur >> 3;
 
 
-                    for (k = purgestart; k <= majorcurint; k++)
-                        state[wid].cvgbuf[k] &= ~fmaskshifted;
-                    for (k = minorcurint; k <= purgeend; k++)
-                        state[wid].cvgbuf[k] &= ~fmaskshifted;
+                    cvgbuf_clear(state[wid].cvgbuf, purgestart, majorcurint, fmaskshifted);
+                    cvgbuf_clear(state[wid].cvgbuf, minorcurint, purgeend, fmaskshifted);
 
 
 
@@ -91,9 +114,7 @@ static STRICTINLINE void compute_cvg_flip(uint32_t wid, int32_t scanline)
                 }
                 else
                 {
-                    int k;
-                    for (k = purgestart; k <= purgeend; k++)
-                        state[wid].cvgbuf[k] &= ~fmaskshifted;
+                    cvgbuf_clear(state[wid].cvgbuf, purgestart, purgeend, fmaskshifted);
                 }
 
         }
@@ -124,16 +145,13 @@ static STRICTINLINE void compute_cvg_noflip(uint32_t wid, int32_t scanline)
 
             if (!state[wid].span[scanline].invalyscan[i])
             {
-               int k;
                 minorcur = state[wid].span[scanline].minorx[i];
                 majorcur = state[wid].span[scanline].majorx[i];
                 minorcurint = minorcur >> 3;
                 majorcurint = majorcur >> 3;
 
-                for (k = purgestart; k <= minorcurint; k++)
-                    state[wid].cvgbuf[k] &= ~fmaskshifted;
-                for (k = majorcurint; k <= purgeend; k++)
-                    state[wid].cvgbuf[k] &= ~fmaskshifted;
+                cvgbuf_clear(state[wid].cvgbuf, purgestart, minorcurint, fmaskshifted);
+                cvgbuf_clear(state[wid].cvgbuf, majorcurint, purgeend, fmaskshifted);
 
                 if (majorcurint > minorcurint)
                 {
@@ -148,9 +166,7 @@ static STRICTINLINE void compute_cvg_noflip(uint32_t wid, int32_t scanline)
             }
             else
             {
-                int k;
-                for (k = purgestart; k <= purgeend; k++)
-                    state[wid].cvgbuf[k] &= ~fmaskshifted;
+                cvgbuf_clear(state[wid].cvgbuf, purgestart, purgeend, fmaskshifted);
             }
         }
     }
@@ -115,6 +115,47 @@ static void fbfill_32(uint32_t wid, uint32_t curpixel)
     PAIRWRITE32(fb, state[wid].fill_color, (state[wid].fill_color & 0x10000) ? 3 : 0, (state[wid].fill_color & 0x1) ? 3 : 0);
 }
 
+// fills count pixels starting at curpixel with whole words at a time, returns
+// false if the pixels have to be filled one by one instead
+static bool fbfill_span(uint32_t wid, uint32_t curpixel, uint32_t count)
+{
+    uint32_t fill_color = state[wid].fill_color;
+    uint8_t hval0 = (fill_color & 0x10000) ? 3 : 0;
+    uint8_t hval1 = (fill_color & 0x1) ? 3 : 0;
+    uint32_t fb;
+
+    switch (state[wid].fb_size) {
+        case PIXEL_SIZE_16BIT:
+            // a pair of 16-bit pixels on an even index is written with
+            // the same word and hidden bits as a 32-bit pixel
+            fb = (state[wid].fb_address >> 1) + curpixel;
+            if (!rdram_valid_idx16(fb) || count - 1 > idxlim16 - fb) {
+                return false;
+            }
+
+            if (fb & 1) {
+                fbfill_16(wid, curpixel);
+                fb++;
+                curpixel++;
+                count--;
+            }
+
+            if (count & 1) {
+                fbfill_16(wid, curpixel + count - 1);
+                count--;
+            }
+
+            return rdram_fill_pair32(fb >> 1, count >> 1, fill_color, hval0, hval1);
+
+        case PIXEL_SIZE_32BIT:
+            fb = (state[wid].fb_address >> 2) + curpixel;
+            return rdram_fill_pair32(fb, count, fill_color, hval0, hval1);
+
+        default:
+            return false;
+    }
+}
+
 static void fbread_4(uint32_t wid, uint32_t curpixel, uint32_t* curpixel_memcvg)
 {
     state[wid].memory_color.r = state[wid].memory_color.g = state[wid].memory_color.b = 0;
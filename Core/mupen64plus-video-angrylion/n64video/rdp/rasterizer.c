@@ -1630,7 +1630,14 @@ static void render_spans_fill(uint32_t wid, int start, int end, int flip)
 
 
 
-            for (j = 0; j <= length; j++)
+            j = 0;
+
+            // all pixels get the same value, so the direction doesn't matter
+            if (rdp_span_fastpath && length >= 0 &&
+                fbfill_span(wid, flip ? curpixel : curpixel - length, length + 1))
+                j = length + 1;
+
+            for (; j <= length; j++)
             {
 
                 switch(state[wid].fb_size)
@@ -1821,6 +1828,15 @@ static void render_spans_copy(uint32_t wid, int start, int end, int tilenum, int
     }
 }
 
+// whether scanline j is rendered by this worker
+static STRICTINLINE bool line_owned(uint32_t wid, int j)
+{
+    if (rdp_binning)
+        return rdp_bin_owner[j >> RDP_BIN_SHIFT] == wid;
+
+    return !state[wid].stride || j % state[wid].stride == state[wid].offset;
+}
+
 static void edgewalker_for_prims(uint32_t wid, int32_t* ewdata)
 {
     int j = 0;
@@ -2174,7 +2190,7 @@ static void edgewalker_for_prims(uint32_t wid, int32_t* ewdata)
             {
                 state[wid].span[j].lx = maxxmx;
                 state[wid].span[j].rx = minxhx;
-                state[wid].span[j].validline  = !allinval && !allover && !allunder && (!state[wid].scfield || (state[wid].scfield && !(state[wid].sckeepodd ^ (j & 1)))) && (!state[wid].stride || j % state[wid].stride == state[wid].offset);
+                state[wid].span[j].validline  = !allinval && !allover && !allunder && (!state[wid].scfield || (state[wid].scfield && !(state[wid].sckeepodd ^ (j & 1)))) && line_owned(wid, j);
 
             }
 
@@ -2261,7 +2277,7 @@ static void edgewalker_for_prims(uint32_t wid, int32_t* ewdata)
             {
                 state[wid].span[j].lx = minxmx;
                 state[wid].span[j].rx = maxxhx;
-                state[wid].span[j].validline  = !allinval && !allover && !allunder && (!state[wid].scfield || (state[wid].scfield && !(state[wid].sckeepodd ^ (j & 1)))) && (!state[wid].stride || j % state[wid].stride == state[wid].offset);
+                state[wid].span[j].validline  = !allinval && !allover && !allunder && (!state[wid].scfield || (state[wid].scfield && !(state[wid].sckeepodd ^ (j & 1)))) && line_owned(wid, j);
             }
 
         }
@@ -156,3 +156,57 @@ static STRICTINLINE void rdram_write_pair32(uint32_t in, uint32_t rval, uint8_t
         rdram_hidden[(in << 1) + 1] = hval1;
     }
 }
+
+// same as rdram_write_pair32 on count consecutive indices, returns false
+// without writing anything if the range doesn't fit in RDRAM
+static bool rdram_fill_pair32(uint32_t in, uint32_t count, uint32_t rval, uint8_t hval0, uint8_t hval1)
+{
+    uint32_t* dst;
+    uint8_t* hdst;
+    uint32_t i = 0;
+
+    if (count == 0) {
+        return true;
+    }
+
+    if (!rdram_valid_idx32(in) || count - 1 > idxlim32 - in) {
+        return false;
+    }
+
+    dst = &rdram32[in];
+    hdst = &rdram_hidden[in << 1];
+
+#if defined(ANGRYLION_SSE2)
+    {
+        const __m128i vval = _mm_set1_epi32((int32_t)rval);
+        const __m128i vhval = _mm_set1_epi16((int16_t)(hval0 | (hval1 << 8)));
+
+        // 8 pixels per iteration
+        for (; i + 8 <= count; i += 8) {
+            _mm_storeu_si128((__m128i*)&dst[i], vval);
+            _mm_storeu_si128((__m128i*)&dst[i + 4], vval);
+            _mm_storeu_si128((__m128i*)&hdst[i << 1], vhval);
+        }
+    }
+#elif defined(ANGRYLION_NEON)
+    {
+        const uint32x4_t vval = vdupq_n_u32(rval);
+        const uint8x16_t vhval = vreinterpretq_u8_u16(vdupq_n_u16(hval0 | (hval1 << 8)));
+
+        // 8 pixels per iteration
+        for (; i + 8 <= count; i += 8) {
+            vst1q_u32(&dst[i], vval);
+            vst1q_u32(&dst[i + 4], vval);
+            vst1q_u8(&hdst[i << 1], vhval);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        dst[i] = rval;
+        hdst[i << 1] = hval0;
+        hdst[(i << 1) + 1] = hval1;
+    }
+
+    return true;
+}
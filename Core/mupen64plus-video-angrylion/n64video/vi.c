@@ -618,6 +618,9 @@ void vi_set_zbuffer_address(uint32_t address)
 
 void n64video_update_screen(void)
 {
+    // the frame buffer must be complete before it is read
+    parallel_ring_sync();
+
     // check for configuration errors
     if (config.vi.mode >= VI_MODE_NUM) {
         msg_error("Invalid VI mode: %d", config.vi.mode);
@@ -1,4 +1,5 @@
 #include "parallel_al.h"
+#include "main/trace.h"
 
 #include <stdlib.h>
 
@@ -8,69 +9,111 @@
 #include <cstdint>
 #include <functional>
 #include <mutex>
-#include <stdexcept>
 #include <thread>
 #include <vector>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() std::this_thread::yield()
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__) && !defined(__ANDROID__)
+#include <pthread.h>
+#include <sched.h>
+#define HAVE_THREAD_AFFINITY
+#endif
+
+// counter that has a cache line for itself, so that threads polling
+// different counters don't invalidate each other's cache lines
+struct PaddedCounter {
+    std::atomic<std::uint32_t> value;
+    char padding[64 - sizeof(std::atomic<std::uint32_t>)];
+};
+
+static void pin_thread(std::thread& thread, std::uint32_t cpu)
+{
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (cpu % (sizeof(DWORD_PTR) * 8)));
+#elif defined(HAVE_THREAD_AFFINITY)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
 class Parallel
 {
 public:
-    Parallel(std::uint32_t num_workers) :
-        m_num_workers(std::min(num_workers, PARALLEL_MAX_WORKERS))
+    Parallel(std::uint32_t num_workers, bool pin_threads) :
+        m_num_workers(std::min(std::max(num_workers, 1u), PARALLEL_MAX_WORKERS))
     {
-        // mask for m_tasks_done when all workers have finished their task
-        // except for worker 0, which runs in the main thread
-        if (m_num_workers == 64)
-            m_all_tasks_done = (~(0LL)) & ~(1LL);
-        else
-            m_all_tasks_done = ((1LL << m_num_workers) - 1) & ~(1LL);
+        // spinning only pays off if every thread has a core for itself,
+        // otherwise it just steals time from the thread it waits for
+        m_spin_count = m_num_workers <= std::thread::hardware_concurrency() ? SPIN_COUNT : 0;
+
+        m_work = 0;
+        m_parked_workers = 0;
+        m_main_parked = false;
+        for (auto& done : m_done) {
+            done.value = 0;
+        }
 
         // give workers an empty task
         m_task = [](std::uint32_t) {};
-        m_accept_work = true;
-        start_work();
 
-        // create worker threads
-        for (std::uint32_t worker_id = 1; worker_id < m_num_workers; worker_id++) {
-            m_workers.emplace_back(std::thread(&Parallel::do_work, this, worker_id));
+        // create worker threads, thread 0 is the main thread
+        for (std::uint32_t thread_id = 1; thread_id < m_num_workers; thread_id++) {
+            m_threads.emplace_back(std::thread(&Parallel::do_work, this, thread_id));
         }
 
-        // synchronize workers to prepare them for real tasks
-        wait();
+        if (pin_threads) {
+            const std::uint32_t num_cpus = std::max(std::thread::hardware_concurrency(), 1u);
+            for (std::uint32_t i = 0; i < m_threads.size(); i++) {
+                pin_thread(m_threads[i], (i + 1) % num_cpus);
+            }
+        }
     }
 
     ~Parallel() {
-        // wait for all workers to finish their current work
-        wait();
-
-        // exit worker main loops
-        m_accept_work = false;
-        start_work();
+        // an empty thread count makes worker main loops exit
+        start_work(0);
 
         // join worker threads to make sure they have finished
-        for (auto& thread : m_workers) {
+        for (auto& thread : m_threads) {
             thread.join();
         }
 
         // destroy all worker threads
-        m_workers.clear();
+        m_threads.clear();
     }
 
-    void run(std::function<void(std::uint32_t)>&& task) {
-        // don't allow more tasks if workers are stopping
-        if (!m_accept_work) {
-            throw std::runtime_error("Workers are exiting and no longer accept work");
-        }
+    void run(std::function<void(std::uint32_t)>&& task, std::uint32_t num_threads) {
+        num_threads = std::min(std::max(num_threads, 1u), m_num_workers);
 
         // prepare task for workers and send signal so they start working
         m_task = std::move(task);
-        start_work();
+        std::uint32_t seq = start_work(num_threads);
 
-        // run worker 0 directly on main thread
-        m_task(0);
+        // run first share directly on main thread
+        run_share(0, num_threads);
 
-        // wait for all workers to finish
-        wait();
+        // wait for the other threads to finish
+        for (std::uint32_t thread_id = 1; thread_id < num_threads; thread_id++) {
+            wait_done(thread_id, seq);
+        }
     }
 
     std::uint32_t num_workers() {
@@ -78,64 +121,369 @@ public:
     }
 
 private:
+    // number of polls before a thread blocks on a condition variable
+    static const int SPIN_COUNT = 4096;
+
+    // work sequence number in the upper bits, number of threads taking
+    // part in the current run in the lower bits
+    static const std::uint32_t WORK_THREAD_BITS = 8;
+    static const std::uint32_t WORK_THREAD_MASK = (1 << WORK_THREAD_BITS) - 1;
+
     std::function<void(std::uint32_t)> m_task;
-    std::vector<std::thread> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::uint32_t> m_work;
+    PaddedCounter m_done[PARALLEL_MAX_WORKERS];
     std::mutex m_signal_mutex;
     std::condition_variable m_signal_work;
     std::condition_variable m_signal_done;
-    std::atomic<uint64_t> m_tasks_done;
-    std::uint64_t m_all_tasks_done;
-    std::atomic<bool> m_accept_work;
+    std::atomic<std::uint32_t> m_parked_workers;
+    std::atomic<bool> m_main_parked;
+    int m_spin_count;
     const std::uint32_t m_num_workers;
 
-    void start_work() {
+    // run all workers that belong to a thread, each worker stays on the
+    // same thread for the whole run so that its commands run in order
+    void run_share(std::uint32_t thread_id, std::uint32_t num_threads) {
+        for (std::uint32_t worker_id = thread_id; worker_id < m_num_workers; worker_id += num_threads) {
+            m_task(worker_id);
+        }
+    }
+
+    std::uint32_t start_work(std::uint32_t num_threads) {
+        std::uint32_t seq = (m_work.load(std::memory_order_relaxed) >> WORK_THREAD_BITS) + 1;
+        m_work = (seq << WORK_THREAD_BITS) | num_threads;
+
+        // only take the slow path if some workers went to sleep
+        if (m_parked_workers) {
+            std::unique_lock<std::mutex> ul(m_signal_mutex);
+            m_signal_work.notify_all();
+        }
+
+        return seq & (~0u >> WORK_THREAD_BITS);
+    }
+
+    void wait_done(std::uint32_t thread_id, std::uint32_t seq) {
+        std::atomic<std::uint32_t>& done = m_done[thread_id].value;
+
+        for (int i = 0; i < m_spin_count; i++) {
+            if (done.load(std::memory_order_acquire) == seq) {
+                return;
+            }
+            cpu_relax();
+        }
+
         std::unique_lock<std::mutex> ul(m_signal_mutex);
+        m_main_parked = true;
+        m_signal_done.wait(ul, [&done, seq] {
+            return done.load() == seq;
+        });
+        m_main_parked = false;
+    }
+
+    std::uint32_t wait_work(std::uint32_t last_work) {
+        std::uint32_t work;
+
+        for (int i = 0; i < m_spin_count; i++) {
+            work = m_work.load(std::memory_order_acquire);
+            if (work != last_work) {
+                return work;
+            }
+            cpu_relax();
+        }
 
-        // clear task bits for all workers
-        m_tasks_done = 0;
+        std::unique_lock<std::mutex> ul(m_signal_mutex);
+        m_parked_workers++;
+        m_signal_work.wait(ul, [this, &work, last_work] {
+            work = m_work.load();
+            return work != last_work;
+        });
+        m_parked_workers--;
 
-        // wake up all workers
-        m_signal_work.notify_all();
+        return work;
     }
 
-    void do_work(std::uint32_t worker_id) {
-        const std::uint64_t worker_mask = 1LL << worker_id;
+    void do_work(std::uint32_t thread_id) {
+        std::uint32_t work = 0;
 
-        while (m_accept_work) {
-            // do the work
-            m_task(worker_id);
+        trace_set_thread_name("angrylion worker");
+
+        while (true) {
+            work = wait_work(work);
+
+            const std::uint32_t num_threads = work & WORK_THREAD_MASK;
+            if (num_threads == 0) {
+                break;
+            }
+
+            // threads that don't take part in this run just wait for the
+            // next one, the main thread doesn't wait for them either
+            if (thread_id >= num_threads) {
+                continue;
+            }
 
             {
+                TRACE_SCOPE("angrylion worker share");
+                run_share(thread_id, num_threads);
+            }
+
+            // mark task as done and notify main thread if it went to sleep
+            m_done[thread_id].value = work >> WORK_THREAD_BITS;
+            if (m_main_parked) {
                 std::unique_lock<std::mutex> ul(m_signal_mutex);
+                m_signal_done.notify_one();
+            }
+        }
+    }
 
-                // mark task as done
-                m_tasks_done |= worker_mask;
+    void operator=(const Parallel&) = delete;
+    Parallel(const Parallel&) = delete;
+};
 
-                // notify main thread
-                m_signal_done.notify_one();
+// Single producer ring of fixed size commands. Every worker executes every
+// command, so each one has its own read position and the producer may only
+// reuse an entry once the slowest worker is done with it. The workers run on
+// background threads between sync() calls, which lets the producer keep going
+// while commands are being executed.
+class CommandRing
+{
+public:
+    typedef void (*Command)(std::uint32_t, const std::uint32_t*);
+
+    CommandRing(Parallel& parallel, Command cmd, std::uint32_t cmd_ints) :
+        m_parallel(parallel),
+        m_cmd(cmd),
+        m_cmd_ints(cmd_ints),
+        m_data(PARALLEL_RING_SIZE * cmd_ints),
+        m_barrier(PARALLEL_RING_SIZE)
+    {
+        static_assert((PARALLEL_RING_SIZE & (PARALLEL_RING_SIZE - 1)) == 0, "ring size must be a power of two");
 
-                // take a break and wait for more work
-                m_signal_work.wait(ul, [worker_mask, this] {
-                    return (m_tasks_done & worker_mask) == 0;
-                });
-            }
+        m_head = 0;
+        m_tail_min = 0;
+        for (auto& tail : m_tails) {
+            tail.value = 0;
         }
+        m_sleepers = 0;
+        m_producer_waiting = false;
+        m_stop = false;
+        m_running = false;
+        m_exit = false;
+
+        m_dispatcher = std::thread(&CommandRing::dispatch, this);
     }
 
-    void wait() {
-        // wait for all workers to set their task bits
-        std::unique_lock<std::mutex> ul(m_signal_mutex);
+    ~CommandRing() {
+        // let workers finish all pending commands
+        sync();
+
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            m_exit = true;
+            m_signal_run.notify_one();
+        }
+
+        m_dispatcher.join();
+    }
+
+    std::uint32_t* slot() {
+        const std::uint32_t head = m_head.load(std::memory_order_relaxed);
+
+        // wait until the slowest worker has executed the entry that is
+        // about to be overwritten
+        if (head - m_tail_min >= PARALLEL_RING_SIZE) {
+            wait_space(head);
+        }
+
+        return &m_data[(head & (PARALLEL_RING_SIZE - 1)) * m_cmd_ints];
+    }
+
+    void push(bool barrier) {
+        const std::uint32_t head = m_head.load(std::memory_order_relaxed);
+
+        m_barrier[head & (PARALLEL_RING_SIZE - 1)] = barrier;
+        m_head.store(head + 1);
+
+        if (!m_running) {
+            start();
+        } else if (m_sleepers) {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            m_signal_data.notify_all();
+        }
+    }
+
+    void sync() {
+        if (!m_running) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> ul(m_mutex);
+
+        // workers return as soon as they run out of commands
+        m_stop = true;
+        m_signal_data.notify_all();
         m_signal_done.wait(ul, [this] {
-            return m_tasks_done == m_all_tasks_done;
+            return !m_running;
         });
+
+        m_tail_min = m_head.load(std::memory_order_relaxed);
     }
 
-    void operator=(const Parallel&) = delete;
-    Parallel(const Parallel&) = delete;
+private:
+    Parallel& m_parallel;
+    const Command m_cmd;
+    const std::uint32_t m_cmd_ints;
+    std::vector<std::uint32_t> m_data;
+    std::vector<std::uint8_t> m_barrier;
+    std::atomic<std::uint32_t> m_head;
+    PaddedCounter m_tails[PARALLEL_MAX_WORKERS];
+    std::uint32_t m_tail_min;
+    std::atomic<std::uint32_t> m_sleepers;
+    std::atomic<bool> m_producer_waiting;
+    std::thread m_dispatcher;
+    std::mutex m_mutex;
+    std::condition_variable m_signal_run;
+    std::condition_variable m_signal_done;
+    std::condition_variable m_signal_data;
+    std::condition_variable m_signal_space;
+    bool m_stop;
+    std::atomic<bool> m_running;
+    bool m_exit;
+
+    // number of polls before a thread goes to sleep
+    static const int SPIN_COUNT = 256;
+
+    void start() {
+        std::unique_lock<std::mutex> ul(m_mutex);
+        m_stop = false;
+        m_running = true;
+        m_signal_run.notify_one();
+    }
+
+    void dispatch() {
+        std::unique_lock<std::mutex> ul(m_mutex);
+
+        while (true) {
+            m_signal_run.wait(ul, [this] {
+                return m_running || m_exit;
+            });
+
+            if (m_exit) {
+                break;
+            }
+
+            // worker 0 runs on this thread instead of the emulation thread
+            ul.unlock();
+            // every worker needs its own thread here, as they wait for
+            // each other at barriers
+            m_parallel.run([this](std::uint32_t worker_id) {
+                consume(worker_id);
+            }, m_parallel.num_workers());
+            ul.lock();
+
+            m_running = false;
+            m_signal_done.notify_all();
+        }
+    }
+
+    std::uint32_t min_tail() {
+        std::uint32_t head = m_head.load(std::memory_order_relaxed);
+        std::uint32_t min_pos = head;
+
+        for (std::uint32_t i = 0; i < m_parallel.num_workers(); i++) {
+            std::uint32_t pos = m_tails[i].value.load();
+            if (head - pos > head - min_pos) {
+                min_pos = pos;
+            }
+        }
+
+        return min_pos;
+    }
+
+    void wait_space(std::uint32_t head) {
+        auto has_space = [this, head] {
+            m_tail_min = min_tail();
+            return head - m_tail_min < PARALLEL_RING_SIZE;
+        };
+
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            if (has_space()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> ul(m_mutex);
+        m_producer_waiting = true;
+        m_signal_space.wait(ul, has_space);
+        m_producer_waiting = false;
+    }
+
+    // returns false once the ring is drained and workers should stop
+    bool wait_data(std::uint32_t pos) {
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            if (m_head.load(std::memory_order_acquire) != pos) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> ul(m_mutex);
+        m_sleepers++;
+        m_signal_data.wait(ul, [this, pos] {
+            return m_head.load() != pos || m_stop;
+        });
+        m_sleepers--;
+
+        return m_head.load() != pos;
+    }
+
+    void wait_barrier(std::uint32_t pos) {
+        for (std::uint32_t i = 0; i < m_parallel.num_workers(); i++) {
+            while (static_cast<std::int32_t>(m_tails[i].value.load() - pos) < 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void consume(std::uint32_t worker_id) {
+        std::atomic<std::uint32_t>& tail = m_tails[worker_id].value;
+        std::uint32_t pos = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            if (m_head.load(std::memory_order_acquire) == pos) {
+                if (!wait_data(pos)) {
+                    break;
+                }
+                continue;
+            }
+
+            // the entry may be reused as soon as the new position is
+            // visible, so don't touch it afterwards
+            const std::uint32_t index = pos & (PARALLEL_RING_SIZE - 1);
+            const bool barrier = m_barrier[index] != 0;
+            m_cmd(worker_id, &m_data[index * m_cmd_ints]);
+            tail.store(++pos);
+
+            if (m_producer_waiting) {
+                std::unique_lock<std::mutex> ul(m_mutex);
+                m_signal_space.notify_one();
+            }
+
+            // all workers must be done with this command before any of
+            // them continues with the next one
+            if (barrier) {
+                wait_barrier(pos);
+            }
+        }
+    }
+
+    void operator=(const CommandRing&) = delete;
+    CommandRing(const CommandRing&) = delete;
 };
 
-// C interface for the Parallel class
+// C interface for the Parallel and CommandRing classes
 static std::unique_ptr<Parallel> parallel;
+static std::unique_ptr<CommandRing> ring;
 
 template<typename T, typename... Args>
 std::unique_ptr<T> make_unique(Args&&... args) {
@@ -145,20 +493,29 @@ std::unique_ptr<T> make_unique(Args&&... args) {
 void parallel_alinit(uint32_t num)
 {
     // auto-select number of workers based on the number of cores
-    if (num == 0) {
-        const char *env = getenv("ANGRYLION_NUM_THREADS");
-        if (env)
-            num = atoi(env);
-        else
-            num = std::thread::hardware_concurrency();
-    }
+    if (num == 0)
+        num = std::thread::hardware_concurrency();
+
+    // the environment can put an upper bound on it
+    const char *env = getenv("ANGRYLION_NUM_THREADS");
+    if (env && atoi(env) > 0)
+        num = std::min(num, (uint32_t)atoi(env));
 
-    parallel = make_unique<Parallel>(num);
+    // optionally bind worker threads to one core each
+    env = getenv("ANGRYLION_PIN_THREADS");
+    bool pin_threads = env && atoi(env) != 0;
+
+    parallel = make_unique<Parallel>(num, pin_threads);
 }
 
 void parallel_run(void task(uint32_t))
 {
-    parallel->run(task);
+    parallel->run(task, parallel->num_workers());
+}
+
+void parallel_run_threads(void task(uint32_t), uint32_t num_threads)
+{
+    parallel->run(task, num_threads);
 }
 
 uint32_t parallel_num_workers(void)
@@ -168,5 +525,28 @@ uint32_t parallel_num_workers(void)
 
 void parallel_close(void)
 {
+    ring.reset();
     parallel.reset();
 }
+
+void parallel_ring_init(void cmd(uint32_t, const uint32_t*), uint32_t cmd_ints)
+{
+    ring = make_unique<CommandRing>(*parallel, cmd, cmd_ints);
+}
+
+uint32_t* parallel_ring_slot(void)
+{
+    return ring->slot();
+}
+
+void parallel_ring_push(bool barrier)
+{
+    ring->push(barrier);
+}
+
+void parallel_ring_sync(void)
+{
+    if (ring) {
+        ring->sync();
+    }
+}
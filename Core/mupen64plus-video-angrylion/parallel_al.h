@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define PARALLEL_MAX_WORKERS 64u
 
@@ -12,10 +13,24 @@ void parallel_alinit(uint32_t num);
 
 void parallel_run(void task(uint32_t));
 
+// like parallel_run, but spreads the workers over fewer threads
+void parallel_run_threads(void task(uint32_t), uint32_t num_threads);
+
 uint32_t parallel_num_workers(void);
 
 void parallel_close(void);
 
+// asynchronous command ring, executed by all workers on background threads
+#define PARALLEL_RING_SIZE 2048u
+
+void parallel_ring_init(void cmd(uint32_t, const uint32_t*), uint32_t cmd_ints);
+
+uint32_t* parallel_ring_slot(void);
+
+void parallel_ring_push(bool barrier);
+
+void parallel_ring_sync(void);
+
 #ifdef __cplusplus
 }
 #endif
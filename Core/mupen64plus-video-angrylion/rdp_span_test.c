@@ -0,0 +1,469 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-video-angrylion - rdp_span_test.c                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Checks that the span fast paths (rdp_span_fastpath) leave RDRAM and the
+ * hidden bits exactly as the per-pixel code does, and that splitting the work
+ * between workers by bins gives the same result as scanline interleaving.
+ *
+ * Standalone program, not part of the core build:
+ *   cc -O2 -I../mupen64plus-core/src -o rdp-span-test rdp_span_test.c
+ *
+ * Each argument is a command capture written by a build with
+ * ANGRYLION_CMD_DUMP defined. Without arguments random fill rectangles and
+ * triangles are used, every other list with random combiner, blender and
+ * texture settings as well. The workers run one after the other, and only the
+ * random fill lists are used to compare worker splits: the noise dithering,
+ * and the texels and colors carried over from one pixel to the next in the 1
+ * and 2 cycle modes depend on which worker renders a pixel. */
+
+#include <stdarg.h>
+
+#include "n64video.c"
+
+enum { ITERATIONS = 2000, CMDS_PER_LIST = 64, SPLIT_WORKERS = 5 };
+
+void msg_error(const char* err, ...)
+{
+    va_list arg;
+    va_start(arg, err);
+    vfprintf(stderr, err, arg);
+    va_end(arg);
+    fputc('\n', stderr);
+    exit(2);
+}
+
+void msg_warning(const char* err, ...) { (void)err; }
+void msg_debug(const char* err, ...) { (void)err; }
+
+osal_atomic_int g_trace_enabled;
+int64_t trace_now(void) { return 0; }
+void trace_zone(const char* name, int64_t start) { (void)name; (void)start; }
+
+void vdac_init(struct n64video_config* config) { (void)config; }
+void vdac_read(struct frame_buffer* fb, bool alpha) { (void)fb; (void)alpha; }
+void vdac_write(struct frame_buffer* fb) { (void)fb; }
+void vdac_sync(bool invaid) { (void)invaid; }
+void vdac_close(void) { }
+
+/* workers run one after the other on the calling thread */
+static uint32_t num_workers = 1;
+
+void parallel_alinit(uint32_t num) { num_workers = num; }
+uint32_t parallel_num_workers(void) { return num_workers; }
+void parallel_close(void) { }
+
+void parallel_run(void task(uint32_t))
+{
+    uint32_t i;
+    for (i = 0; i < num_workers; i++)
+        task(i);
+}
+
+void parallel_run_threads(void task(uint32_t), uint32_t num_threads)
+{
+    (void)num_threads;
+    parallel_run(task);
+}
+
+void parallel_ring_init(void cmd(uint32_t, const uint32_t*), uint32_t cmd_ints) { (void)cmd; (void)cmd_ints; }
+uint32_t* parallel_ring_slot(void) { return NULL; }
+void parallel_ring_push(bool barrier) { (void)barrier; }
+void parallel_ring_sync(void) { }
+
+static void mi_intr(void) { }
+
+struct run_mode
+{
+    const char* name;
+    bool fastpath;
+    uint32_t num_workers;
+    bool binning;
+};
+
+static const struct run_mode ref_mode = { "reference", false, 0, false };
+static const struct run_mode fastpath_mode = { "fast path", true, 0, false };
+static const struct run_mode interleave_mode = { "interleave", true, SPLIT_WORKERS, false };
+static const struct run_mode binning_mode = { "binning", true, SPLIT_WORKERS, true };
+
+static struct n64video_config cfg;
+static uint32_t dmem[0x400];
+static uint32_t dp_regs[DP_NUM_REG];
+
+static uint8_t rdram_image[RDRAM_MAX_SIZE];
+static uint8_t rdram_ref[RDRAM_MAX_SIZE];
+static uint8_t hidden_ref[sizeof(rdram_hidden)];
+static struct rdp_state state_init;
+
+static uint32_t rnd_state = 0xa1c0de;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* commands are sent through DMEM like the RSP does */
+static void flush_dmem(void)
+{
+    n64video_process_list();
+    dp_regs[DP_START] = dp_regs[DP_CURRENT] = dp_regs[DP_END] = 0;
+}
+
+static void send_words(const uint32_t* words, uint32_t count)
+{
+    while (count--) {
+        dmem[dp_regs[DP_END] >> 2] = *words++;
+        dp_regs[DP_END] += 4;
+        if (dp_regs[DP_END] == sizeof(dmem))
+            flush_dmem();
+    }
+}
+
+/* runs a command list from a clean state */
+static void run_list(const uint32_t* cmds, size_t num_words, const struct run_mode* mode)
+{
+    static const uint32_t sync_full[2] = { CMD_ID_SYNC_FULL << 24, 0 };
+    size_t pos = 0;
+
+    memcpy(cfg.gfx.rdram, rdram_image, cfg.gfx.rdram_size);
+    state[0] = state_init;
+    rdp_span_fastpath = mode->fastpath;
+
+    cfg.parallel = mode->num_workers != 0;
+    cfg.num_workers = mode->num_workers;
+    cfg.dp.binning = mode->binning;
+    n64video_init(&cfg);
+
+    while (pos < num_words) {
+        uint32_t len = cmds[pos++];
+        if (len > CMD_MAX_INTS || len > num_words - pos) {
+            msg_error("corrupt command list at word %u", (unsigned)pos);
+        }
+        send_words(&cmds[pos], len);
+        pos += len;
+    }
+
+    /* makes sure buffered commands are run */
+    send_words(sync_full, 2);
+    flush_dmem();
+}
+
+static unsigned compare_runs(const uint32_t* cmds, size_t num_words, const char* name,
+                             const struct run_mode* ref, const struct run_mode* mode)
+{
+    run_list(cmds, num_words, ref);
+    memcpy(rdram_ref, cfg.gfx.rdram, cfg.gfx.rdram_size);
+    memcpy(hidden_ref, rdram_hidden, sizeof(rdram_hidden));
+
+    run_list(cmds, num_words, mode);
+
+    if (memcmp(rdram_ref, cfg.gfx.rdram, cfg.gfx.rdram_size) != 0 ||
+        memcmp(hidden_ref, rdram_hidden, sizeof(rdram_hidden)) != 0) {
+        printf("%s: RDRAM mismatch between %s and %s\n", name, ref->name, mode->name);
+        return 1;
+    }
+
+    return 0;
+}
+
+static unsigned check_list(const uint32_t* cmds, size_t num_words, const char* name, bool splits)
+{
+    unsigned failures = compare_runs(cmds, num_words, name, &ref_mode, &fastpath_mode);
+
+    if (splits) {
+        failures += compare_runs(cmds, num_words, name, &interleave_mode, &binning_mode);
+    }
+
+    return failures;
+}
+
+static size_t put_cmd(uint32_t* list, size_t pos, const uint32_t* cmd, uint32_t len)
+{
+    list[pos++] = len;
+    memcpy(&list[pos], cmd, len * sizeof(uint32_t));
+    return pos + len;
+}
+
+/* color image with a random size, width and address, sometimes close to the
+ * end of RDRAM so that the range checks are hit */
+static size_t put_random_target(uint32_t* list, size_t pos)
+{
+    uint32_t size = 1 + rnd() % 3;
+    uint32_t width = 1 + rnd() % 640;
+    uint32_t address = (rnd() & 3) == 0 ? RDRAM_MAX_SIZE - (rnd() & 0x3ffff) : rnd() & 0x3fffff;
+    uint32_t cmd[2];
+
+    cmd[0] = (CMD_ID_SET_COLOR_IMAGE << 24) | (size << 19) | (width - 1);
+    cmd[1] = address;
+    pos = put_cmd(list, pos, cmd, 2);
+
+    /* keep spans within the image width, or lines would overlap in memory
+     * and the result would depend on the order workers write them in */
+    cmd[0] = (CMD_ID_SET_SCISSOR << 24) | (rnd() & 0x3f) << 12 | (rnd() & 0x3f);
+    cmd[1] = (rnd() % (4 * width - 3)) << 12 | (rnd() & 0x7ff) | (rnd() & 0x3000000);
+    pos = put_cmd(list, pos, cmd, 2);
+
+    cmd[0] = CMD_ID_SET_MASK_IMAGE << 24;
+    cmd[1] = rnd() & 0x7fffff;
+    return put_cmd(list, pos, cmd, 2);
+}
+
+/* modes, combiner, blender and texture state for the 1 and 2 cycle modes */
+static size_t put_random_pipeline_state(uint32_t* list, size_t pos)
+{
+    static const uint32_t color_cmds[] = {
+        CMD_ID_SET_FOG_COLOR, CMD_ID_SET_BLEND_COLOR, CMD_ID_SET_PRIM_COLOR,
+        CMD_ID_SET_ENV_COLOR, CMD_ID_SET_CONVERT, CMD_ID_SET_KEY_GB, CMD_ID_SET_KEY_R
+    };
+    static const uint32_t tile_cmds[] = {
+        CMD_ID_SET_TILE, CMD_ID_SET_TILE_SIZE, CMD_ID_LOAD_TILE, CMD_ID_LOAD_BLOCK, CMD_ID_LOAD_TLUT
+    };
+    uint32_t cmd[2];
+
+    switch (rnd() % 5) {
+        case 0:
+            cmd[0] = (CMD_ID_SET_OTHER_MODES << 24) | (rnd() & 0xdfffff);
+            cmd[1] = rnd();
+            break;
+        case 1:
+            cmd[0] = (CMD_ID_SET_COMBINE << 24) | (rnd() & 0xffffff);
+            cmd[1] = rnd();
+            break;
+        case 2:
+            cmd[0] = color_cmds[rnd() % (sizeof(color_cmds) / sizeof(color_cmds[0]))] << 24 | (rnd() & 0xffffff);
+            cmd[1] = rnd();
+            break;
+        case 3:
+            cmd[0] = (CMD_ID_SET_TEXTURE_IMAGE << 24) | (rnd() & 0xf80fff);
+            cmd[1] = rnd() & 0x7fffff;
+            break;
+        default:
+            cmd[0] = tile_cmds[rnd() % (sizeof(tile_cmds) / sizeof(tile_cmds[0]))] << 24 | (rnd() & 0xffffff);
+            cmd[1] = rnd();
+            break;
+    }
+
+    return put_cmd(list, pos, cmd, 2);
+}
+
+/* random tiles that wrap or mirror instead of clamping, clamping zeroes the
+ * fractions the texture filter works with */
+static size_t put_random_wrapping_tiles(uint32_t* list, size_t pos)
+{
+    uint32_t cmd[2];
+    uint32_t i;
+
+    for (i = 0; i < 8; i++) {
+        cmd[0] = (CMD_ID_SET_TILE << 24) | (rnd() & 0xffffff);
+        cmd[1] = i << 24 | (rnd() & 0xf43d0f) | (1 + rnd() % 15) << 14 | (1 + rnd() % 15) << 4;
+        pos = put_cmd(list, pos, cmd, 2);
+    }
+
+    return pos;
+}
+
+/* fill rectangles and triangles, with pipeline set texture rectangles and
+ * triangles of all kinds with random shade, texture and depth coefficients */
+static size_t put_random_prim(uint32_t* list, size_t pos, bool pipeline)
+{
+    uint32_t cmd[44];
+    uint32_t i;
+
+    switch (pipeline ? rnd() % 3 : (rnd() & 1) * 2) {
+        case 0: {
+            uint32_t yh = rnd() & 0x7ff;
+            uint32_t xh = rnd() & 0xfff;
+
+            cmd[0] = (CMD_ID_FILL_RECTANGLE << 24) | ((xh + (rnd() & 0x7ff)) & 0xfff) << 12 |
+                     ((yh + (rnd() & 0xff)) & 0xfff);
+            cmd[1] = xh << 12 | yh;
+            return put_cmd(list, pos, cmd, 2);
+        }
+        case 1: {
+            uint32_t yh = rnd() & 0x7ff;
+            uint32_t xh = rnd() & 0xfff;
+
+            cmd[0] = (CMD_ID_TEXTURE_RECTANGLE + (rnd() & 1)) << 24 |
+                     ((xh + (rnd() & 0x3ff)) & 0xfff) << 12 | ((yh + (rnd() & 0xff)) & 0xfff);
+            cmd[1] = (rnd() & 0x7000000) | xh << 12 | yh;
+            cmd[2] = rnd();
+            cmd[3] = rnd();
+            return put_cmd(list, pos, cmd, 4);
+        }
+        default: {
+            uint32_t type = pipeline ? rnd() & 7 : 0;
+            uint32_t len = 8 + ((type & 4) ? 16 : 0) + ((type & 2) ? 16 : 0) + ((type & 1) ? 4 : 0);
+            int32_t yh = (int32_t)(rnd() & 0x7ff) - 0x100;
+            int32_t ym = yh + (int32_t)(rnd() & 0x1ff);
+            int32_t yl = ym + (int32_t)(rnd() & 0x1ff);
+
+            cmd[0] = (CMD_ID_FILL_TRIANGLE + type) << 24 | (rnd() & 0x870000) | (yl & 0x3fff);
+            cmd[1] = (ym & 0x3fff) << 16 | (yh & 0x3fff);
+            cmd[2] = (rnd() & 0x3ffffff) - 0x400000;
+            cmd[3] = (int32_t)rnd() >> 12;
+            cmd[4] = (rnd() & 0x3ffffff) - 0x400000;
+            cmd[5] = (int32_t)rnd() >> 12;
+            cmd[6] = (rnd() & 0x3ffffff) - 0x400000;
+            cmd[7] = (int32_t)rnd() >> 12;
+            for (i = 8; i < len; i++)
+                cmd[i] = rnd();
+            return put_cmd(list, pos, cmd, len);
+        }
+    }
+}
+
+static unsigned check_random(void)
+{
+    static uint32_t list[8 * 3 + CMDS_PER_LIST * 48];
+    unsigned failures = 0;
+    unsigned i, j;
+
+    for (i = 0; i < ITERATIONS; i++) {
+        bool pipeline = (i & 1) != 0;
+        size_t pos = pipeline ? put_random_wrapping_tiles(list, 0) : 0;
+        char name[32];
+
+        for (j = 0; j < CMDS_PER_LIST; j++) {
+            uint32_t cmd[2];
+
+            switch (rnd() % 10) {
+                case 0:
+                    pos = put_random_target(list, pos);
+                    break;
+                case 1:
+                    /* fill mode, or 1 cycle mode with random coverage and
+                     * blender settings */
+                    /* no noise dithering, the noise depends on the worker */
+                    cmd[0] = (CMD_ID_SET_OTHER_MODES << 24) |
+                        ((rnd() & 1) ? (CYCLE_TYPE_FILL << 20) : ((rnd() & 0xcfff0f) | 0xf0));
+                    cmd[1] = rnd() & ~0x32u;
+                    pos = put_cmd(list, pos, cmd, 2);
+                    break;
+                case 2:
+                    cmd[0] = CMD_ID_SET_FILL_COLOR << 24;
+                    cmd[1] = rnd();
+                    pos = put_cmd(list, pos, cmd, 2);
+                    break;
+                case 3:
+                case 4:
+                    if (pipeline) {
+                        pos = put_random_pipeline_state(list, pos);
+                        break;
+                    }
+                    /* fall through */
+                default:
+                    pos = put_random_prim(list, pos, pipeline);
+                    break;
+            }
+        }
+
+        /* few loads hit TMEM with random commands, start from random
+         * texels instead */
+        if (pipeline) {
+            for (j = 0; j < sizeof(state_init.tmem); j++)
+                state_init.tmem[j] = (uint8_t)rnd();
+        }
+
+        snprintf(name, sizeof(name), "random list %u", i);
+        failures += check_list(list, pos, name, !pipeline);
+    }
+
+    return failures;
+}
+
+static unsigned check_capture(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    uint32_t* cmds = NULL;
+    uint32_t rdram_size;
+    char magic[8];
+    long start, end;
+    unsigned failures;
+
+    if (f == NULL || fread(magic, 1, 8, f) != 8 || memcmp(magic, "ALCMD001", 8) != 0 ||
+        fread(&rdram_size, sizeof(rdram_size), 1, f) != 1 || rdram_size > RDRAM_MAX_SIZE ||
+        fread(rdram_image, 1, rdram_size, f) != rdram_size) {
+        fprintf(stderr, "can't read command capture %s\n", path);
+        exit(2);
+    }
+
+    start = ftell(f);
+    fseek(f, 0, SEEK_END);
+    end = ftell(f);
+    fseek(f, start, SEEK_SET);
+
+    cmds = malloc(end - start + sizeof(uint32_t));
+    if (cmds == NULL || fread(cmds, 1, end - start, f) != (size_t)(end - start)) {
+        fprintf(stderr, "can't read command capture %s\n", path);
+        exit(2);
+    }
+    fclose(f);
+
+    memset(rdram_image + rdram_size, 0, RDRAM_MAX_SIZE - rdram_size);
+    failures = check_list(cmds, (end - start) / sizeof(uint32_t), path, false);
+    free(cmds);
+
+    return failures;
+}
+
+int main(int argc, char** argv)
+{
+    static uint8_t rdram[RDRAM_MAX_SIZE];
+    static uint32_t vi_regs[VI_NUM_REG], mi_intr_reg;
+    static uint32_t* dp_reg[DP_NUM_REG];
+    static uint32_t* vi_reg[VI_NUM_REG];
+    unsigned failures = 0;
+    int i;
+
+    for (i = 0; i < DP_NUM_REG; i++)
+        dp_reg[i] = &dp_regs[i];
+    for (i = 0; i < VI_NUM_REG; i++)
+        vi_reg[i] = &vi_regs[i];
+
+    n64video_config_init(&cfg);
+    cfg.gfx.rdram = rdram;
+    cfg.gfx.rdram_size = RDRAM_MAX_SIZE;
+    cfg.gfx.dmem = (uint8_t*)dmem;
+    cfg.gfx.dp_reg = dp_reg;
+    cfg.gfx.vi_reg = vi_reg;
+    cfg.gfx.mi_intr_reg = &mi_intr_reg;
+    cfg.gfx.mi_intr_cb = mi_intr;
+    cfg.parallel = false;
+    dp_regs[DP_STATUS] = DP_STATUS_XBUS_DMA;
+    n64video_init(&cfg);
+    state_init = state[0];
+
+    if (argc < 2) {
+        for (i = 0; i < RDRAM_MAX_SIZE; i++)
+            rdram_image[i] = (uint8_t)rnd();
+
+        failures += check_random();
+    }
+
+    for (i = 1; i < argc; i++)
+        failures += check_capture(argv[i]);
+
+    n64video_close();
+
+    printf("%u mismatches\n", failures);
+    return failures != 0;
+}
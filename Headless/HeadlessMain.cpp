@@ -0,0 +1,883 @@
+// Headless benchmark runner.
+//
+// Drives the core through the libretro API without a window or an audio
+// device: a ROM is loaded, an optional input file is replayed frame by
+// frame, and after the run the frame rate, per-frame time percentiles and
+// hashes of the video and audio output are printed.  Two runs with the same
+// ROM, options and input must print the same hashes; a change in hashes
+// between two builds means emulation output changed.
+//
+// Software renderers (angrylion) are hashed straight from the frame the core
+// hands over.  Hardware renderers (GLideN64) get an offscreen OpenGL context
+// from EGL, so they run on Mesa's llvmpipe as well as on a GPU; the frame is
+// read back with glReadPixels.  Hashing happens after retro_run returns and is
+// not counted in the frame times.
+//
+// Input file format, one event per line, '#' starts a comment:
+//
+//     <frame> <port> <buttons> [<left x> <left y> <right x> <right y>]
+//
+// <buttons> is a number (bit n is RETRO_DEVICE_ID_JOYPAD n), '-' for none,
+// or button names joined with '+', e.g. "A+START".  Analog values are
+// -32768..32767.  An event takes effect on its frame and holds until the
+// next event for the same port.  Events must be ordered by frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "libretro.h"
+
+#ifdef HAVE_EGL
+#include "SDL/glad.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#define MAX_PORTS 4
+
+// ============================================================================
+// State
+// ============================================================================
+struct option_override {
+    std::string key;
+    std::string value;
+    bool used;
+};
+
+struct input_event {
+    unsigned frame;
+    unsigned port;
+    uint16_t buttons;
+    int16_t analog[4];
+};
+
+struct port_state {
+    uint16_t buttons;
+    int16_t analog[4];
+};
+
+static struct {
+    const char *rom_path;
+    const char *input_path;
+    const char *hash_log_path;
+    const char *save_dir;
+    const char *system_dir;
+    unsigned frames;
+    unsigned warmup;
+    bool hash;
+    bool verbose;
+} g_args = { NULL, NULL, NULL, ".", ".", 3600, 0, true, false };
+
+static std::vector<option_override> g_overrides;
+static std::vector<retro_variable> g_vars;
+static std::vector<input_event> g_events;
+static size_t g_next_event = 0;
+static port_state g_ports[MAX_PORTS];
+
+static struct retro_frame_time_callback g_frame_time;
+static struct retro_audio_callback g_audio_callback;
+static struct retro_hw_render_callback g_hw;
+static bool g_hw_requested = false;
+static unsigned g_bpp = sizeof(uint32_t);
+
+// The last frame handed to video_refresh, hashed once retro_run returns.
+static struct {
+    const void *data;
+    unsigned width;
+    unsigned height;
+    size_t pitch;
+    bool presented;
+} g_frame;
+
+static uint64_t g_video_hash;
+static uint64_t g_audio_hash;
+static uint64_t g_audio_frames;
+static unsigned g_dupes;
+static FILE *g_hash_log = NULL;
+
+static void die(const char *fmt, ...) {
+    va_list va;
+
+    va_start(va, fmt);
+    fputs("nn6644-headless: ", stderr);
+    vfprintf(stderr, fmt, va);
+    fputc('\n', stderr);
+    va_end(va);
+
+    exit(EXIT_FAILURE);
+}
+
+// ============================================================================
+// Hashing
+// ============================================================================
+#define FNV_OFFSET UINT64_C(0xcbf29ce484222325)
+#define FNV_PRIME  UINT64_C(0x100000001b3)
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// ============================================================================
+// Offscreen OpenGL
+// ============================================================================
+#ifdef HAVE_EGL
+static struct {
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+    GLuint tex_id;
+    GLuint fbo_id;
+    GLuint rbo_id;
+    std::vector<uint8_t> pixels;
+} g_gl = { EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_CONTEXT, 0, 0, 0, {} };
+
+static uintptr_t core_get_current_framebuffer() {
+    return g_gl.fbo_id;
+}
+
+static retro_proc_address_t core_get_proc_address(const char *sym) {
+    return (retro_proc_address_t)eglGetProcAddress(sym);
+}
+
+static EGLDisplay open_egl_display() {
+    // The surfaceless platform needs neither X11 nor a DRM master, which is
+    // what a CI machine usually lacks.
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    return display;
+}
+
+static void create_gl_context() {
+    bool gles = g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES2 ||
+                g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES3 ||
+                g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES_VERSION;
+    EGLint major, minor;
+
+    switch (g_hw.context_type) {
+    case RETRO_HW_CONTEXT_OPENGL:
+    case RETRO_HW_CONTEXT_OPENGL_CORE:
+    case RETRO_HW_CONTEXT_OPENGLES2:
+    case RETRO_HW_CONTEXT_OPENGLES3:
+    case RETRO_HW_CONTEXT_OPENGLES_VERSION:
+        break;
+    default:
+        die("Unsupported hw context %i (only OpenGL and OpenGL ES are supported)", g_hw.context_type);
+    }
+
+    g_gl.display = open_egl_display();
+    if (g_gl.display == EGL_NO_DISPLAY || !eglInitialize(g_gl.display, &major, &minor))
+        die("Failed to initialize EGL");
+    if (!eglBindAPI(gles ? EGL_OPENGL_ES_API : EGL_OPENGL_API))
+        die("EGL has no %s support", gles ? "OpenGL ES" : "OpenGL");
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, gles ? (g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES2 ?
+                                     EGL_OPENGL_ES2_BIT : EGL_OPENGL_ES3_BIT_KHR) : EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+
+    if (!eglChooseConfig(g_gl.display, config_attribs, &config, 1, &num_configs) || num_configs == 0) {
+        // Surfaceless displays may have no pbuffer configs; the core only
+        // renders into the framebuffer object below, so any config will do.
+        const EGLint *any_surface = config_attribs + 2;
+        if (!eglChooseConfig(g_gl.display, any_surface, &config, 1, &num_configs) || num_configs == 0)
+            die("No usable EGL config");
+    }
+
+    EGLint context_attribs[16];
+    int n = 0;
+
+    if (gles) {
+        context_attribs[n++] = EGL_CONTEXT_MAJOR_VERSION;
+        context_attribs[n++] = g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES2 ? 2 :
+                               g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES3 ? 3 : g_hw.version_major;
+        if (g_hw.context_type == RETRO_HW_CONTEXT_OPENGLES_VERSION) {
+            context_attribs[n++] = EGL_CONTEXT_MINOR_VERSION;
+            context_attribs[n++] = g_hw.version_minor;
+        }
+    } else if (g_hw.context_type == RETRO_HW_CONTEXT_OPENGL_CORE || g_hw.version_major >= 3) {
+        context_attribs[n++] = EGL_CONTEXT_MAJOR_VERSION;
+        context_attribs[n++] = g_hw.version_major;
+        context_attribs[n++] = EGL_CONTEXT_MINOR_VERSION;
+        context_attribs[n++] = g_hw.version_minor;
+        context_attribs[n++] = EGL_CONTEXT_OPENGL_PROFILE_MASK;
+        context_attribs[n++] = g_hw.context_type == RETRO_HW_CONTEXT_OPENGL_CORE ?
+                               EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT :
+                               EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT;
+    }
+    context_attribs[n] = EGL_NONE;
+
+    g_gl.context = eglCreateContext(g_gl.display, config, EGL_NO_CONTEXT, context_attribs);
+    if (g_gl.context == EGL_NO_CONTEXT)
+        die("Failed to create OpenGL context (EGL error 0x%x)", eglGetError());
+
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+    g_gl.surface = eglCreatePbufferSurface(g_gl.display, config, pbuffer_attribs);
+    if (!eglMakeCurrent(g_gl.display, g_gl.surface, g_gl.surface, g_gl.context))
+        die("Failed to make the OpenGL context current (EGL error 0x%x)", eglGetError());
+
+    if (gles) {
+        if (!gladLoadGLES2Loader((GLADloadproc)eglGetProcAddress))
+            die("Failed to initialize glad.");
+    } else {
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+            die("Failed to initialize glad.");
+    }
+
+    fprintf(stderr, "GL_RENDERER: %s\n", glGetString(GL_RENDERER));
+    fprintf(stderr, "GL_VERSION: %s\n", glGetString(GL_VERSION));
+}
+
+static void create_gl_framebuffer(unsigned width, unsigned height) {
+    glGenTextures(1, &g_gl.tex_id);
+    glBindTexture(GL_TEXTURE_2D, g_gl.tex_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &g_gl.fbo_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_gl.fbo_id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_gl.tex_id, 0);
+
+    if (g_hw.depth) {
+        glGenRenderbuffers(1, &g_gl.rbo_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, g_gl.rbo_id);
+        glRenderbufferStorage(GL_RENDERBUFFER, g_hw.stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24,
+                              width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, g_hw.stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER, g_gl.rbo_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        die("Offscreen framebuffer is incomplete");
+
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static uint64_t hash_gl_frame(uint64_t hash, unsigned width, unsigned height) {
+    GLint read_fbo = 0, pack_buffer = 0, pack_alignment = 4;
+
+    // The core caches GL state across frames, so whatever is touched here
+    // is put back as it was.
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+
+    g_gl.pixels.resize((size_t)width * height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_gl.fbo_id);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, g_gl.pixels.data());
+
+    glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+
+    return fnv1a(hash, g_gl.pixels.data(), g_gl.pixels.size());
+}
+
+static void destroy_gl() {
+    if (g_gl.context == EGL_NO_CONTEXT)
+        return;
+
+    if (g_gl.rbo_id)
+        glDeleteRenderbuffers(1, &g_gl.rbo_id);
+    if (g_gl.fbo_id)
+        glDeleteFramebuffers(1, &g_gl.fbo_id);
+    if (g_gl.tex_id)
+        glDeleteTextures(1, &g_gl.tex_id);
+
+    eglMakeCurrent(g_gl.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (g_gl.surface != EGL_NO_SURFACE)
+        eglDestroySurface(g_gl.display, g_gl.surface);
+    eglDestroyContext(g_gl.display, g_gl.context);
+    eglTerminate(g_gl.display);
+    g_gl.context = EGL_NO_CONTEXT;
+}
+#endif // HAVE_EGL
+
+// ============================================================================
+// Core callbacks
+// ============================================================================
+static void core_log(enum retro_log_level level, const char *fmt, ...) {
+    static const char *levelstr[] = { "dbg", "inf", "wrn", "err" };
+    char buffer[4096];
+    va_list va;
+
+    if (level < RETRO_LOG_WARN && !g_args.verbose)
+        return;
+
+    va_start(va, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, va);
+    va_end(va);
+
+    fprintf(stderr, "[%s] %s", levelstr[level], buffer);
+    fflush(stderr);
+
+    if (level == RETRO_LOG_ERROR)
+        exit(EXIT_FAILURE);
+}
+
+/* RetroArch extension (see mupen64plus-next_common.h), the core calls it
+ * unconditionally when stopping the threaded GLideN64 renderer. There is no
+ * frontend thread waiting on the core here, so there is nothing to cancel. */
+#ifndef RETRO_ENVIRONMENT_GET_CLEAR_ALL_THREAD_WAITS_CB
+#define RETRO_ENVIRONMENT_GET_CLEAR_ALL_THREAD_WAITS_CB (3 | 0x800000)
+#endif
+
+static bool core_clear_thread_waits(unsigned clear, void *data) {
+    (void)clear;
+    (void)data;
+    return true;
+}
+
+static retro_time_t core_get_time_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t core_get_cpu_features() {
+    return 0;
+}
+
+static retro_perf_tick_t core_get_perf_counter() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+static void core_perf_register(struct retro_perf_counter *counter) {
+    counter->registered = true;
+}
+
+static void core_perf_start(struct retro_perf_counter *counter) {
+    if (counter->registered)
+        counter->start = core_get_perf_counter();
+}
+
+static void core_perf_stop(struct retro_perf_counter *counter) {
+    counter->total += core_get_perf_counter() - counter->start;
+    counter->call_cnt++;
+}
+
+static void core_perf_log() {
+}
+
+static void set_variables(const struct retro_variable *vars) {
+    g_vars.clear();
+
+    for (const struct retro_variable *v = vars; v->key; ++v) {
+        // "Description; default|other|..." - the default is the first value
+        const char *value = strchr(v->value, ';');
+        if (!value)
+            continue;
+        value++;
+        while (isspace((unsigned char)*value))
+            value++;
+
+        const char *pipe = strchr(value, '|');
+        std::string def = pipe ? std::string(value, pipe - value) : std::string(value);
+
+        for (option_override &o : g_overrides) {
+            if (o.key == v->key) {
+                def = o.value;
+                o.used = true;
+            }
+        }
+
+        struct retro_variable var = { strdup(v->key), strdup(def.c_str()) };
+        g_vars.push_back(var);
+    }
+
+    for (const option_override &o : g_overrides) {
+        if (!o.used)
+            fprintf(stderr, "warning: the core has no option %s\n", o.key.c_str());
+    }
+}
+
+static bool core_environment(unsigned cmd, void *data) {
+    switch (cmd) {
+    case RETRO_ENVIRONMENT_SET_VARIABLES:
+        set_variables((const struct retro_variable *)data);
+        return true;
+    case RETRO_ENVIRONMENT_GET_VARIABLE: {
+        struct retro_variable *var = (struct retro_variable *)data;
+        var->value = NULL;
+        for (const retro_variable &v : g_vars) {
+            if (strcmp(var->key, v.key) == 0) {
+                var->value = v.value;
+                return true;
+            }
+        }
+        return false;
+    }
+    case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+        *(bool *)data = false;
+        return true;
+    case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+        ((struct retro_log_callback *)data)->log = core_log;
+        return true;
+    case RETRO_ENVIRONMENT_GET_PERF_INTERFACE: {
+        struct retro_perf_callback *perf = (struct retro_perf_callback *)data;
+        perf->get_time_usec = core_get_time_usec;
+        perf->get_cpu_features = core_get_cpu_features;
+        perf->get_perf_counter = core_get_perf_counter;
+        perf->perf_register = core_perf_register;
+        perf->perf_start = core_perf_start;
+        perf->perf_stop = core_perf_stop;
+        perf->perf_log = core_perf_log;
+        return true;
+    }
+    case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+        *(bool *)data = true;
+        return true;
+    case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+        switch (*(const enum retro_pixel_format *)data) {
+        case RETRO_PIXEL_FORMAT_XRGB8888:
+            g_bpp = sizeof(uint32_t);
+            return true;
+        case RETRO_PIXEL_FORMAT_0RGB1555:
+        case RETRO_PIXEL_FORMAT_RGB565:
+            g_bpp = sizeof(uint16_t);
+            return true;
+        default:
+            return false;
+        }
+    case RETRO_ENVIRONMENT_SET_HW_RENDER: {
+#ifdef HAVE_EGL
+        struct retro_hw_render_callback *hw = (struct retro_hw_render_callback *)data;
+        if (hw->context_type == RETRO_HW_CONTEXT_VULKAN)
+            return false;
+        hw->get_current_framebuffer = core_get_current_framebuffer;
+        hw->get_proc_address = core_get_proc_address;
+        g_hw = *hw;
+        g_hw_requested = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+    case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+        g_frame_time = *(const struct retro_frame_time_callback *)data;
+        return true;
+    case RETRO_ENVIRONMENT_SET_AUDIO_CALLBACK:
+        g_audio_callback = *(const struct retro_audio_callback *)data;
+        return true;
+    case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+        *(const char **)data = g_args.save_dir;
+        return true;
+    case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+        *(const char **)data = g_args.system_dir;
+        return true;
+    case RETRO_ENVIRONMENT_SET_GEOMETRY:
+        return true;
+    case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+        core_log(RETRO_LOG_INFO, "Audio rate changed to %.0f Hz\n",
+                 ((const struct retro_system_av_info *)data)->timing.sample_rate);
+        return true;
+    case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+        *(int *)data = 1 << 0 | 1 << 1;
+        return true;
+    case RETRO_ENVIRONMENT_GET_CLEAR_ALL_THREAD_WAITS_CB:
+        *(retro_environment_t *)data = core_clear_thread_waits;
+        return true;
+    default:
+        core_log(RETRO_LOG_DEBUG, "Unhandled env #%u\n", cmd);
+        return false;
+    }
+}
+
+static void core_video_refresh(const void *data, unsigned width, unsigned height, size_t pitch) {
+    g_frame.presented = true;
+    if (!data) {
+        g_dupes++;
+        return;
+    }
+    g_frame.data = data;
+    g_frame.width = width;
+    g_frame.height = height;
+    g_frame.pitch = pitch;
+}
+
+static void core_input_poll(void) {
+}
+
+static int16_t core_input_state(unsigned port, unsigned device, unsigned index, unsigned id) {
+    if (port >= MAX_PORTS)
+        return 0;
+
+    switch (device) {
+    case RETRO_DEVICE_JOYPAD:
+        if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+            return (int16_t)g_ports[port].buttons;
+        return id < 16 ? (g_ports[port].buttons >> id) & 1 : 0;
+    case RETRO_DEVICE_ANALOG:
+        if (index > RETRO_DEVICE_INDEX_ANALOG_RIGHT || id > RETRO_DEVICE_ID_ANALOG_Y)
+            return 0;
+        return g_ports[port].analog[index * 2 + id];
+    default:
+        return 0;
+    }
+}
+
+static size_t core_audio_sample_batch(const int16_t *data, size_t frames) {
+    g_audio_hash = fnv1a(g_audio_hash, data, frames * 2 * sizeof(int16_t));
+    g_audio_frames += frames;
+    return frames;
+}
+
+static void core_audio_sample(int16_t left, int16_t right) {
+    int16_t buf[2] = { left, right };
+    core_audio_sample_batch(buf, 1);
+}
+
+// ============================================================================
+// Input replay
+// ============================================================================
+static const char *g_button_names[16] = {
+    "B", "Y", "SELECT", "START", "UP", "DOWN", "LEFT", "RIGHT",
+    "A", "X", "L", "R", "L2", "R2", "L3", "R3"
+};
+
+static bool parse_buttons(const char *s, uint16_t *buttons) {
+    char *end;
+
+    *buttons = 0;
+    if (strcmp(s, "-") == 0)
+        return true;
+    if (isdigit((unsigned char)*s)) {
+        unsigned long mask = strtoul(s, &end, 0);
+        *buttons = (uint16_t)mask;
+        return *end == '\0' && mask <= 0xffff;
+    }
+
+    while (*s) {
+        size_t len = strcspn(s, "+");
+        unsigned i;
+
+        for (i = 0; i < 16; i++) {
+            if (strlen(g_button_names[i]) == len && strncmp(s, g_button_names[i], len) == 0)
+                break;
+        }
+        if (i == 16)
+            return false;
+        *buttons |= 1 << i;
+
+        s += len;
+        if (*s == '+')
+            s++;
+    }
+    return true;
+}
+
+static void load_input(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    unsigned lineno = 0, last_frame = 0;
+
+    if (!f)
+        die("Failed to open input file %s", path);
+
+    while (fgets(line, sizeof(line), f)) {
+        char buttons[128];
+        int analog[4] = { 0, 0, 0, 0 };
+        input_event ev;
+        char *comment;
+        int fields;
+
+        lineno++;
+        if ((comment = strchr(line, '#')) != NULL)
+            *comment = '\0';
+
+        fields = sscanf(line, "%u %u %127s %d %d %d %d", &ev.frame, &ev.port, buttons,
+                        &analog[0], &analog[1], &analog[2], &analog[3]);
+        if (fields <= 0)
+            continue;
+        if (fields != 3 && fields != 7)
+            die("%s:%u: expected <frame> <port> <buttons> [<lx> <ly> <rx> <ry>]", path, lineno);
+        if (ev.port >= MAX_PORTS)
+            die("%s:%u: port must be below %d", path, lineno, MAX_PORTS);
+        if (ev.frame < last_frame)
+            die("%s:%u: events are not ordered by frame", path, lineno);
+        if (!parse_buttons(buttons, &ev.buttons))
+            die("%s:%u: bad buttons '%s'", path, lineno, buttons);
+
+        for (int i = 0; i < 4; i++)
+            ev.analog[i] = (int16_t)std::max(-32768, std::min(32767, analog[i]));
+
+        last_frame = ev.frame;
+        g_events.push_back(ev);
+    }
+
+    fclose(f);
+}
+
+static void apply_input(unsigned frame) {
+    while (g_next_event < g_events.size() && g_events[g_next_event].frame <= frame) {
+        const input_event &ev = g_events[g_next_event++];
+        g_ports[ev.port].buttons = ev.buttons;
+        memcpy(g_ports[ev.port].analog, ev.analog, sizeof(ev.analog));
+    }
+}
+
+// ============================================================================
+// Main Entry Point
+// ============================================================================
+static void usage() {
+    fprintf(stderr,
+        "usage: nn6644-headless [options] <rom>\n"
+        "  --frames N         frames to run (default 3600)\n"
+        "  --warmup N         leading frames left out of the timing (default 0)\n"
+        "  --input FILE       input events to replay\n"
+        "  --cpu CORE         pure_interpreter, cached_interpreter or dynamic_recompiler\n"
+        "  --rsp PLUGIN       hle, cxd4 or parallel\n"
+        "  --rdp PLUGIN       gliden64 or angrylion\n"
+        "  --set KEY=VALUE    set any core option, e.g. mupen64plus-ThreadedRenderer=False\n"
+        "  --hash-log FILE    write the video and audio hash of every frame\n"
+        "  --no-hash          skip framebuffer readback and hashing\n"
+        "  --save-dir DIR     directory for save files (default .)\n"
+        "  --system-dir DIR   directory for system files (default .)\n"
+        "  --verbose          show the core's info and debug messages\n");
+    exit(EXIT_FAILURE);
+}
+
+static void add_override(const char *key, const char *value) {
+    option_override o = { key, value, false };
+    g_overrides.push_back(o);
+}
+
+static void parse_args(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (arg[0] != '-') {
+            if (g_args.rom_path)
+                usage();
+            g_args.rom_path = arg;
+            continue;
+        }
+
+        if (strcmp(arg, "--no-hash") == 0) {
+            g_args.hash = false;
+            continue;
+        }
+        if (strcmp(arg, "--verbose") == 0) {
+            g_args.verbose = true;
+            continue;
+        }
+        if (!next)
+            usage();
+        i++;
+
+        if (strcmp(arg, "--frames") == 0)
+            g_args.frames = strtoul(next, NULL, 10);
+        else if (strcmp(arg, "--warmup") == 0)
+            g_args.warmup = strtoul(next, NULL, 10);
+        else if (strcmp(arg, "--input") == 0)
+            g_args.input_path = next;
+        else if (strcmp(arg, "--cpu") == 0)
+            add_override("mupen64plus-cpucore", next);
+        else if (strcmp(arg, "--rsp") == 0)
+            add_override("mupen64plus-rsp-plugin", next);
+        else if (strcmp(arg, "--rdp") == 0)
+            add_override("mupen64plus-rdp-plugin", next);
+        else if (strcmp(arg, "--set") == 0) {
+            const char *eq = strchr(next, '=');
+            if (!eq)
+                usage();
+            add_override(std::string(next, eq - next).c_str(), eq + 1);
+        }
+        else if (strcmp(arg, "--hash-log") == 0)
+            g_args.hash_log_path = next;
+        else if (strcmp(arg, "--save-dir") == 0)
+            g_args.save_dir = next;
+        else if (strcmp(arg, "--system-dir") == 0)
+            g_args.system_dir = next;
+        else
+            usage();
+    }
+
+    if (!g_args.rom_path || g_args.frames == 0 || g_args.warmup >= g_args.frames)
+        usage();
+}
+
+static void load_game(struct retro_system_av_info *av) {
+    struct retro_system_info system = { 0 };
+    struct retro_game_info info = { g_args.rom_path, NULL, 0, "" };
+    std::vector<uint8_t> data;
+
+    retro_get_system_info(&system);
+    if (!system.need_fullpath) {
+        FILE *f = fopen(g_args.rom_path, "rb");
+        long size;
+
+        if (!f)
+            die("Failed to open %s", g_args.rom_path);
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (size <= 0)
+            die("%s is empty", g_args.rom_path);
+
+        data.resize(size);
+        if (fread(data.data(), 1, size, f) != (size_t)size)
+            die("Failed to read %s", g_args.rom_path);
+        fclose(f);
+
+        info.data = data.data();
+        info.size = data.size();
+    }
+
+    if (!retro_load_game(&info))
+        die("The core failed to load the content.");
+
+    retro_get_system_av_info(av);
+
+    if (g_hw_requested) {
+#ifdef HAVE_EGL
+        create_gl_context();
+        create_gl_framebuffer(av->geometry.max_width, av->geometry.max_height);
+        g_hw.context_reset();
+#endif
+    }
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+int main(int argc, char *argv[]) {
+    struct retro_system_av_info av = { { 0 } };
+    std::vector<double> frame_ms;
+
+    parse_args(argc, argv);
+    if (g_args.input_path)
+        load_input(g_args.input_path);
+    if (g_args.hash_log_path) {
+        g_hash_log = fopen(g_args.hash_log_path, "w");
+        if (!g_hash_log)
+            die("Failed to open %s", g_args.hash_log_path);
+    }
+
+    retro_set_environment(core_environment);
+    retro_set_video_refresh(core_video_refresh);
+    retro_set_input_poll(core_input_poll);
+    retro_set_input_state(core_input_state);
+    retro_set_audio_sample(core_audio_sample);
+    retro_set_audio_sample_batch(core_audio_sample_batch);
+    retro_init();
+
+    load_game(&av);
+    for (unsigned port = 0; port < MAX_PORTS; port++)
+        retro_set_controller_port_device(port, RETRO_DEVICE_JOYPAD);
+
+    g_video_hash = FNV_OFFSET;
+    g_audio_hash = FNV_OFFSET;
+    frame_ms.reserve(g_args.frames - g_args.warmup);
+
+    auto run_start = std::chrono::steady_clock::now();
+    for (unsigned frame = 0; frame < g_args.frames; frame++) {
+        if (frame == g_args.warmup)
+            run_start = std::chrono::steady_clock::now();
+
+        apply_input(frame);
+        g_frame.presented = false;
+
+        auto start = std::chrono::steady_clock::now();
+        // A fixed frame delta keeps cores that pace themselves on it
+        // deterministic.
+        if (g_frame_time.callback)
+            g_frame_time.callback(g_frame_time.reference);
+        if (g_audio_callback.callback)
+            g_audio_callback.callback();
+        retro_run();
+        auto end = std::chrono::steady_clock::now();
+
+        if (frame >= g_args.warmup)
+            frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        if (g_args.hash && g_frame.presented && g_frame.data) {
+            if (g_frame.data == RETRO_HW_FRAME_BUFFER_VALID) {
+#ifdef HAVE_EGL
+                g_video_hash = hash_gl_frame(g_video_hash, g_frame.width, g_frame.height);
+#endif
+            } else {
+                const uint8_t *row = (const uint8_t *)g_frame.data;
+                for (unsigned y = 0; y < g_frame.height; y++, row += g_frame.pitch)
+                    g_video_hash = fnv1a(g_video_hash, row, (size_t)g_frame.width * g_bpp);
+            }
+        }
+
+        if (g_hash_log)
+            fprintf(g_hash_log, "%u %016llx %016llx\n", frame,
+                    (unsigned long long)g_video_hash, (unsigned long long)g_audio_hash);
+    }
+    auto run_end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(run_end - run_start).count();
+    unsigned timed = g_args.frames - g_args.warmup;
+    std::sort(frame_ms.begin(), frame_ms.end());
+
+    printf("frames: %u (%u timed, %u duplicated)\n", g_args.frames, timed, g_dupes);
+    printf("seconds: %.3f\n", seconds);
+    printf("fps: %.2f\n", timed / seconds);
+    printf("frame ms: p50 %.3f p90 %.3f p99 %.3f max %.3f\n",
+           percentile(frame_ms, 50), percentile(frame_ms, 90),
+           percentile(frame_ms, 99), frame_ms.back());
+    if (g_args.hash)
+        printf("video hash: %016llx\n", (unsigned long long)g_video_hash);
+    printf("audio hash: %016llx (%llu frames)\n",
+           (unsigned long long)g_audio_hash, (unsigned long long)g_audio_frames);
+
+    if (g_hash_log)
+        fclose(g_hash_log);
+
+    /* keep the results if the core goes down while shutting down */
+    fflush(stdout);
+    retro_unload_game();
+    retro_deinit();
+#ifdef HAVE_EGL
+    destroy_gl();
+#endif
+
+    for (const retro_variable &v : g_vars) {
+        free((char *)v.key);
+        free((char *)v.value);
+    }
+
+    return EXIT_SUCCESS;
+}